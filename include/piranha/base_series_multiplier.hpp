@@ -47,8 +47,6 @@ see https://www.gnu.org/licenses/. */
 #include <mp++/rational.hpp>
 
 #include <piranha/config.hpp>
-#include <piranha/detail/atomic_flag_array.hpp>
-#include <piranha/detail/atomic_lock_guard.hpp>
 #include <piranha/detail/init.hpp>
 #include <piranha/exceptions.hpp>
 #include <piranha/integer.hpp>
@@ -56,6 +54,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/math.hpp>
 #include <piranha/math/gcd3.hpp>
 #include <piranha/math/is_one.hpp>
+#include <piranha/parallel.hpp>
 #include <piranha/rational.hpp>
 #include <piranha/safe_cast.hpp>
 #include <piranha/series.hpp>
@@ -71,6 +70,30 @@ namespace piranha
 namespace detail
 {
 
+// Fill v with pointers to the terms of the container c, which has a pending incremental rehash, in the order of
+// the bucket-by-bucket traversal after the completion of the rehash: by destination bucket and, if possible, by key
+// within each bucket.
+// NOTE: c is a const operand, possibly shared among threads, hence the migration cannot be completed here. The
+// terms are collected via the iterators, which span both bucket arrays.
+template <typename Container, typename Term>
+inline void fill_pending_term_pointers(const Container &c, std::vector<Term const *> &v)
+{
+    std::vector<std::pair<typename Container::size_type, Term const *>> tmp;
+    for (const auto &t : c) {
+        tmp.emplace_back(c._bucket(t), &t);
+    }
+    std::stable_sort(tmp.begin(), tmp.end(), [](const auto &p1, const auto &p2) {
+        if constexpr (is_less_than_comparable<typename Term::key_type>::value) {
+            return p1.first < p2.first || (p1.first == p2.first && p1.second->m_key < p2.second->m_key);
+        } else {
+            return p1.first < p2.first;
+        }
+    });
+    for (const auto &p : tmp) {
+        v.push_back(p.second);
+    }
+}
+
 template <typename Series, typename Derived, typename = void>
 struct base_series_multiplier_impl {
     using term_type = typename Series::term_type;
@@ -94,63 +117,55 @@ struct base_series_multiplier_impl {
         // Fetch the number of threads from the derived class.
         const unsigned n_threads = static_cast<Derived *>(this)->m_n_threads;
         piranha_assert(n_threads > 0u);
-        // Threading functor.
-        auto thread_func
-            = [n_threads](unsigned thread_idx, const container_type *c, std::vector<term_type const *> *v) {
-                  piranha_assert(thread_idx < n_threads);
-                  // Total bucket count.
-                  const auto b_count = c->bucket_count();
-                  // Buckets per thread.
-                  const auto bpt = b_count / n_threads;
-                  // End index.
-                  const auto end
-                      = static_cast<c_size_type>((thread_idx == n_threads - 1u) ? b_count : (bpt * (thread_idx + 1u)));
-                  // Sorter.
-                  auto sorter = [](term_type const *p1, term_type const *p2) { return p1->m_key < p2->m_key; };
-                  v_size_type j = 0u;
-                  for (auto start = static_cast<c_size_type>(bpt * thread_idx); start < end; ++start) {
-                      const auto &b = c->_get_bucket_list(start);
-                      v_size_type tmp = 0u;
-                      for (const auto &t : b) {
-                          v->push_back(&t);
-                          ++tmp;
-                      }
-                      std::stable_sort(v->data() + j, v->data() + j + tmp, sorter);
-                      j += tmp;
-                  }
-              };
-        if (n_threads == 1u) {
-            thread_func(0u, &c1, &v1);
-            thread_func(0u, &c2, &v2);
-            return;
-        }
-        auto thread_wrapper = [&thread_func, n_threads](const container_type *c, std::vector<term_type const *> *v) {
-            // In the multi-threaded case, each thread needs to work on a separate vector.
-            // We will merge the vectors later.
-            using vv_t = std::vector<std::vector<Term const *>>;
-            using vv_size_t = typename vv_t::size_type;
-            vv_t vv(piranha::safe_cast<vv_size_t>(n_threads));
-            // Go with the threads.
-            future_list<void> ff_list;
-            try {
-                for (unsigned i = 0u; i < n_threads; ++i) {
-                    ff_list.push_back(thread_pool::enqueue(i, thread_func, i, c, &(vv[static_cast<vv_size_t>(i)])));
+        // Threading functor, processing the buckets in the [start, end) range.
+        auto thread_func = [](c_size_type start, c_size_type end, const container_type *c,
+                              std::vector<term_type const *> *v) {
+            // Sorter.
+            auto sorter = [](term_type const *p1, term_type const *p2) { return p1->m_key < p2->m_key; };
+            v_size_type j = 0u;
+            for (; start < end; ++start) {
+                const auto &b = c->_get_bucket_list(start);
+                v_size_type tmp = 0u;
+                for (const auto &t : b) {
+                    v->push_back(&t);
+                    ++tmp;
                 }
-                // First let's wait for everything to finish.
-                ff_list.wait_all();
-                // Then, let's handle the exceptions.
-                ff_list.get_all();
-            } catch (...) {
-                ff_list.wait_all();
-                throw;
+                std::stable_sort(v->data() + j, v->data() + j + tmp, sorter);
+                j += tmp;
             }
+        };
+        auto thread_wrapper = [&thread_func, n_threads](const container_type *c, std::vector<term_type const *> *v) {
+            // In the multi-threaded case, each range of buckets needs to be processed into a separate vector.
+            // We will merge the vectors later, in the order of the ranges.
+            // NOTE: the ranges are claimed dynamically, so that the threads dealing with sparse regions
+            // of the table can help with the dense ones.
+            std::mutex mutex;
+            std::vector<std::pair<c_size_type, std::vector<term_type const *>>> vv;
+            parallel_for(n_threads, c_size_type(0u), c->bucket_count(),
+                         [&thread_func, c, &mutex, &vv](const c_size_type &start, const c_size_type &end) {
+                             std::vector<term_type const *> tmp;
+                             thread_func(start, end, c, &tmp);
+                             std::lock_guard<std::mutex> lock(mutex);
+                             vv.emplace_back(start, std::move(tmp));
+                         });
+            std::sort(vv.begin(), vv.end(), [](const auto &p1, const auto &p2) { return p1.first < p2.first; });
             // Last, we need to merge everything into v.
-            for (const auto &vi : vv) {
-                v->insert(v->end(), vi.begin(), vi.end());
+            for (const auto &p : vv) {
+                v->insert(v->end(), p.second.begin(), p.second.end());
             }
         };
-        thread_wrapper(&c1, &v1);
-        thread_wrapper(&c2, &v2);
+        auto fill = [&thread_func, &thread_wrapper, n_threads](const container_type &c,
+                                                               std::vector<term_type const *> &v) {
+            if (c.rehash_in_progress()) {
+                fill_pending_term_pointers(c, v);
+            } else if (n_threads == 1u) {
+                thread_func(0u, c.bucket_count(), &c, &v);
+            } else {
+                thread_wrapper(&c, &v);
+            }
+        };
+        fill(c1, v1);
+        fill(c2, v2);
     }
 };
 
@@ -206,6 +221,113 @@ struct base_series_multiplier_impl<
 };
 }
 
+/// Prepared series operand.
+/**
+ * This class stores a reference to a series together with data that the series multipliers would otherwise compute
+ * anew for each multiplication in which the series is involved: the vector of pointers to the terms of the series,
+ * ordered as in base_series_multiplier, and, for the series types supporting it, the bounds of the exponents of
+ * the terms (which are computed by the static <tt>_prepare()</tt> method of the piranha::series_multiplier
+ * specialisation, if available).
+ *
+ * A prepared operand can be passed to piranha::batch_multiply() and to the constructors of the series multipliers
+ * supporting it. The series used in the construction must not be destroyed or modified while the prepared
+ * operand is in use.
+ *
+ * ## Type requirements ##
+ *
+ * \p Series must satisfy piranha::is_series.
+ */
+template <typename Series>
+class prepared_operand
+{
+    PIRANHA_TT_CHECK(is_series, Series);
+    using term_type = typename Series::term_type;
+    // Detect the _prepare() method in the multiplier.
+    template <typename T>
+    using prepare_t = decltype(series_multiplier<T>::_prepare(std::declval<prepared_operand<T> &>()));
+
+public:
+    /// Alias for a vector of const pointers to series terms.
+    using v_ptr = std::vector<term_type const *>;
+    /// Alias for the vector of exponent bounds.
+    using bounds_type = std::vector<std::pair<integer, integer>>;
+    /// Constructor.
+    /**
+     * @param s the series to be prepared.
+     *
+     * @throws unspecified any exception thrown by memory errors in standard containers or by the <tt>_prepare()</tt>
+     * method of the piranha::series_multiplier specialisation for \p Series.
+     */
+    explicit prepared_operand(const Series &s) : m_series(&s)
+    {
+        const auto &c = s._container();
+        m_v.reserve(static_cast<typename v_ptr::size_type>(c.size()));
+        // NOTE: this is the same ordering established by base_series_multiplier: bucket by bucket, with the
+        // terms within each bucket sorted by key if possible.
+        if (c.rehash_in_progress()) {
+            detail::fill_pending_term_pointers(c, m_v);
+        } else {
+            for (decltype(c.bucket_count()) i = 0u; i < c.bucket_count(); ++i) {
+                const auto start = m_v.size();
+                for (const auto &t : c._get_bucket_list(i)) {
+                    m_v.push_back(&t);
+                }
+                if constexpr (is_less_than_comparable<typename term_type::key_type>::value) {
+                    std::stable_sort(m_v.begin() + static_cast<typename v_ptr::difference_type>(start), m_v.end(),
+                                     [](term_type const *p1, term_type const *p2) { return p1->m_key < p2->m_key; });
+                }
+            }
+        }
+        if constexpr (is_detected<prepare_t, Series>::value) {
+            series_multiplier<Series>::_prepare(*this);
+        }
+    }
+    /// Deleted copy constructor.
+    prepared_operand(const prepared_operand &) = delete;
+    /// Deleted copy assignment.
+    prepared_operand &operator=(const prepared_operand &) = delete;
+    /// Get the prepared series.
+    /**
+     * @return a const reference to the series used in the construction of \p this.
+     */
+    const Series &get_series() const
+    {
+        return *m_series;
+    }
+    /// Get the term pointers.
+    /**
+     * @return a const reference to the vector of pointers to the terms of the prepared series.
+     */
+    const v_ptr &_term_pointers() const
+    {
+        return m_v;
+    }
+    /// Get the exponent bounds.
+    /**
+     * The bounds are stored as pairs of minimum and maximum exponent for each symbol. An empty vector signals
+     * that the bounds have not been computed.
+     *
+     * @return a reference to the exponent bounds.
+     */
+    bounds_type &_bounds()
+    {
+        return m_bounds;
+    }
+    /// Get the exponent bounds (const version).
+    /**
+     * @return a const reference to the exponent bounds.
+     */
+    const bounds_type &_bounds() const
+    {
+        return m_bounds;
+    }
+
+private:
+    Series const *m_series;
+    v_ptr m_v;
+    bounds_type m_bounds;
+};
+
 /// Base series multiplier.
 /**
  * This is a class that provides functionality useful to define a piranha::series_multiplier specialisation. Note that
@@ -258,6 +380,58 @@ private:
         }
         const size_type m_size2;
     };
+    // Combiner for the concurrent insertion of terms, accumulating the coefficient of the new term
+    // into the coefficient of the existing one. The buckets of the terms which become zero are recorded
+    // in m_zeros (see sanitise_accumulation()).
+    struct cf_accumulator {
+        template <typename Term>
+        void operator()(const Term &t, const Term &new_t) const
+        {
+            t.m_cf += new_t.m_cf;
+            if (t.is_zero(m_args)) [[unlikely]] {
+                m_zeros.push_back(m_container._bucket(t));
+            }
+        }
+        const container_type &m_container;
+        const symbol_fset &m_args;
+        std::vector<bucket_size_type> &m_zeros;
+    };
+    // Accumulate the term t into the bucket bucket_idx (corresponding to the hash value h) of the container c
+    // of an accumulation target, via the low-level interface of c. The insertion of a new term is counted in n_new,
+    // and the bucket is recorded in zeros if the resulting term is zero (see sanitise_accumulation()).
+    template <typename Term>
+    static void accumulate_term(container_type &c, Term &&t, const bucket_size_type &bucket_idx, const std::size_t &h,
+                                const symbol_fset &args, bucket_size_type &n_new,
+                                std::vector<bucket_size_type> &zeros)
+    {
+        const auto it = c._find(t, bucket_idx, h);
+        if (it == c.end()) {
+            const bool zero = t.is_zero(args);
+            c._unique_insert(std::forward<Term>(t), bucket_idx, h);
+            ++n_new;
+            if (zero) [[unlikely]] {
+                zeros.push_back(bucket_idx);
+            }
+        } else {
+            it->m_cf += t.m_cf;
+            if (it->is_zero(args)) [[unlikely]] {
+                zeros.push_back(bucket_idx);
+            }
+        }
+    }
+    // Concurrent counterpart of the other overload, inserting t into c via the concurrent inserter ins.
+    // The insertion of a new term is counted by ins.
+    template <typename Term>
+    static void accumulate_term(typename container_type::_concurrent_inserter &ins, const container_type &c, Term &&t,
+                                const symbol_fset &args, std::vector<bucket_size_type> &zeros)
+    {
+        // NOTE: the bucket is computed beforehand, as t might be moved into the container.
+        const bool zero = t.is_zero(args);
+        const auto bucket_idx = zero ? c._bucket(t) : bucket_size_type(0u);
+        if (ins.insert(std::forward<Term>(t), cf_accumulator{c, args, zeros}) && zero) [[unlikely]] {
+            zeros.push_back(bucket_idx);
+        }
+    }
     // The purpose of this helper is to move in a coefficient series during insertion. For series,
     // we know that moves leave the series in a valid state, and series multiplications do not benefit
     // from an already-constructed destination - hence it is convenient to move them rather than copy.
@@ -274,15 +448,16 @@ private:
     // Implementation of finalise().
     template <typename T,
               typename std::enable_if<mppp::detail::is_rational<typename T::term_type::cf_type>::value, int>::type = 0>
-    void finalise_impl(T &s) const
+    void finalise_impl(T &s, unsigned d) const
     {
-        // Nothing to do if the lcm is unitary.
-        if (piranha::is_one(this->m_lcm)) {
+        piranha_assert(d > 0u);
+        // Nothing to do if the lcm and the extra factor are unitary.
+        if (d == 1u && piranha::is_one(this->m_lcm)) {
             return;
         }
         // NOTE: this has to be the square of the lcm, as in addition to uniformising
         // the denominators in each series we are also multiplying the two series.
-        const auto l2 = this->m_lcm * this->m_lcm;
+        const auto l2 = this->m_lcm * this->m_lcm * d;
         auto &container = s._container();
         // Single thread implementation.
         if (m_n_threads == 1u) {
@@ -292,42 +467,134 @@ private:
             }
             return;
         }
-        // Multi-thread implementation.
-        // Buckets per thread.
-        const bucket_size_type bpt = static_cast<bucket_size_type>(container.bucket_count() / m_n_threads);
-        auto thread_func = [l2, &container, this, bpt](unsigned t_idx) {
-            bucket_size_type start_idx = static_cast<bucket_size_type>(t_idx * bpt);
-            // Special handling for the last thread.
-            const bucket_size_type end_idx = t_idx == (this->m_n_threads - 1u)
-                                                 ? container.bucket_count()
-                                                 : static_cast<bucket_size_type>((t_idx + 1u) * bpt);
-            for (; start_idx != end_idx; ++start_idx) {
-                auto &list = container._get_bucket_list(start_idx);
-                for (const auto &t : list) {
-                    t.m_cf._get_den() = l2;
-                    t.m_cf.canonicalise();
+        // Multi-thread implementation. The buckets are claimed dynamically by the threads.
+        container.complete_rehash();
+        parallel_for(m_n_threads, bucket_size_type(0u), container.bucket_count(),
+                     [l2, &container](bucket_size_type start_idx, const bucket_size_type &end_idx) {
+                         for (; start_idx != end_idx; ++start_idx) {
+                             auto &list = container._get_bucket_list(start_idx);
+                             for (const auto &t : list) {
+                                 t.m_cf._get_den() = l2;
+                                 t.m_cf.canonicalise();
+                             }
+                         }
+                     });
+    }
+    template <typename T,
+              typename std::enable_if<!mppp::detail::is_rational<typename T::term_type::cf_type>::value, int>::type = 0>
+    void finalise_impl(T &, unsigned) const
+    {
+    }
+    // Multi-threaded multiplication with per-thread private accumulation (see tuning::get_private_accumulation()).
+    // The thread of index idx processes the rows [bounds[idx],bounds[idx + 1][ of the first series, calling
+    // mult(tmp_t, i, j) to store in tmp_t the product of the i-th term of the first series by the j-th term of the
+    // second series (mult returns false if the product must be skipped). The products are accumulated in a private
+    // table with the same bucket count as retval, so that the bucket i of each private table maps to the bucket i
+    // of retval, and the tables are then merged into retval, each thread taking care of a range of buckets.
+    // retval is sanitised at the end of the merge, or recovered via recover_accumulation() in case of errors.
+    template <typename Mult, typename LimitFunctor>
+    void private_accumulation(Series &retval, const std::vector<size_type> &bounds, const Mult &mult,
+                              const LimitFunctor &lf) const
+    {
+        using term_type = typename Series::term_type;
+        using key_type = typename term_type::key_type;
+        const unsigned n_threads = m_n_threads;
+        piranha_assert(n_threads > 1u && bounds.size() == n_threads + 1u);
+        auto &container = retval._container();
+        piranha_assert(!container.rehash_in_progress());
+        const auto b_count = container.bucket_count();
+        std::vector<container_type> tables(n_threads);
+        // Run func(idx) for each thread index idx in the thread pool.
+        auto run_threads = [n_threads](const auto &func) {
+            task_group t_group;
+            try {
+                for (unsigned i = 0u; i < n_threads; ++i) {
+                    t_group.run(i, func, i);
                 }
+                t_group.wait_all();
+                t_group.get_all();
+            } catch (...) {
+                t_group.wait_all();
+                throw;
             }
         };
-        // Go with the threads.
-        future_list<decltype(thread_func(0u))> ff_list;
-        try {
-            for (unsigned i = 0u; i < m_n_threads; ++i) {
-                ff_list.push_back(thread_pool::enqueue(i, thread_func, i));
+        // Accumulate the products into the private tables.
+        run_threads([this, &tables, &bounds, &mult, &lf, b_count](unsigned idx) {
+            auto &table = tables[idx];
+            // NOTE: the table is rehashed from the thread that will use it.
+            table.rehash(b_count);
+            piranha_assert(table.bucket_count() == b_count);
+            std::array<term_type, key_type::multiply_arity> tmp_t;
+            const auto t_end = table.end();
+            // Number of terms inserted in the table.
+            bucket_size_type count = 0u;
+            auto f = [&tmp_t, &table, &mult, &count, t_end](const size_type &i, const size_type &j) {
+                if (!mult(tmp_t, i, j)) {
+                    return;
+                }
+                for (auto &tmp_term : tmp_t) {
+                    const auto h = table._hash(tmp_term);
+                    const auto bucket_idx = table._bucket_from_hash(h);
+                    const auto it = table._find(tmp_term, bucket_idx, h);
+                    if (it == t_end) {
+                        table._unique_insert(term_insertion(tmp_term), bucket_idx, h);
+                        ++count;
+                    } else {
+                        it->m_cf += tmp_term.m_cf;
+                    }
+                }
+            };
+            // NOTE: the size of the table has to be updated also in case of errors, so that the table
+            // is left in a consistent state when it is destroyed.
+            try {
+                this->blocked_multiplication(f, bounds[idx], bounds[idx + 1u], lf);
+            } catch (...) {
+                table._update_size(count);
+                throw;
             }
-            // First let's wait for everything to finish.
-            ff_list.wait_all();
-            // Then, let's handle the exceptions.
-            ff_list.get_all();
+            table._update_size(count);
+        });
+        // Merge the private tables into retval, bucket range by bucket range. Each thread records the number of
+        // terms it inserts and the buckets in which zero terms might be present (see sanitise_accumulation()).
+        const auto bpt = static_cast<bucket_size_type>(b_count / n_threads);
+        const auto &args = retval.get_symbol_set();
+        std::vector<bucket_size_type> n_new(n_threads);
+        std::vector<std::vector<bucket_size_type>> zeros(n_threads);
+        auto sanitise = [&retval, &n_new, &zeros]() {
+            for (decltype(zeros.size()) i = 0u; i < zeros.size(); ++i) {
+                sanitise_accumulation(retval, n_new[i], zeros[i]);
+            }
+        };
+        try {
+            run_threads([&container, &tables, &args, &n_new, &zeros, bpt, b_count, n_threads](unsigned idx) {
+                const auto end = (idx == n_threads - 1u) ? b_count : static_cast<bucket_size_type>((idx + 1u) * bpt);
+                bucket_size_type count = 0u;
+                try {
+                    for (auto b = static_cast<bucket_size_type>(idx * bpt); b != end; ++b) {
+                        for (const auto &table : tables) {
+                            for (const auto &t : table._get_bucket_list(b)) {
+                                // NOTE: the coefficient of a term is a mutable member, so it can be moved out
+                                // via a const reference. The private tables are not used anymore after the merge.
+                                static_assert(!std::is_const<std::remove_reference_t<decltype((t.m_cf))>>::value,
+                                              "The coefficient of a term must be mutable.");
+                                accumulate_term(container, term_type{std::move(t.m_cf), t.m_key}, b,
+                                                container._hash(t), args, count, zeros[idx]);
+                            }
+                        }
+                    }
+                } catch (...) {
+                    n_new[idx] = count;
+                    throw;
+                }
+                n_new[idx] = count;
+            });
+            sanitise();
         } catch (...) {
-            ff_list.wait_all();
+            recover_accumulation(retval, sanitise);
             throw;
         }
-    }
-    template <typename T,
-              typename std::enable_if<!mppp::detail::is_rational<typename T::term_type::cf_type>::value, int>::type = 0>
-    void finalise_impl(T &) const
-    {
+        // Destroy the private tables in parallel.
+        run_threads([&tables](unsigned idx) { tables[idx] = container_type{}; });
     }
 
 public:
@@ -350,6 +617,9 @@ public:
      * that a multiplication by a null series results in multiplications by a zero coefficient, which may not
      * necessarily lead to a zero result (e.g., with IEEE floats inf times zero gives NaN).
      *
+     * If \p s1 and \p s2 are the same object, the protected member base_series_multiplier::m_square will be set to
+     * \p true.
+     *
      * @param s1 first series.
      * @param s2 second series.
      *
@@ -360,15 +630,38 @@ public:
      * - the construction of the term, coefficient and key types of \p Series,
      * - the public interface of piranha::hash_set.
      */
-    explicit base_series_multiplier(const Series &s1, const Series &s2) : m_ss(s1.get_symbol_set())
+    explicit base_series_multiplier(const Series &s1, const Series &s2) : base_series_multiplier(s1, s2, nullptr) {}
+    /// Constructor from a prepared operand.
+    /**
+     * This constructor is equivalent to the other constructor, with the series of \p p as first operand. The
+     * vector of term pointers of the first operand is copied from \p p rather than being recomputed (unless
+     * the coefficient type of \p Series is an mp++ rational, in which case the terms need to be renormalised
+     * for each multiplication). A pointer to \p p is stored in either base_series_multiplier::m_prep1 or
+     * base_series_multiplier::m_prep2, depending on which side the first operand ends up.
+     *
+     * @param p the prepared first operand.
+     * @param s2 second series.
+     *
+     * @throws unspecified any exception thrown by the other constructor.
+     */
+    explicit base_series_multiplier(const prepared_operand<Series> &p, const Series &s2)
+        : base_series_multiplier(p.get_series(), s2, &p)
+    {
+    }
+
+private:
+    explicit base_series_multiplier(const Series &s1, const Series &s2, const prepared_operand<Series> *prep)
+        : m_ss(s1.get_symbol_set()), m_square(&s1 == &s2)
     {
         if (s1.get_symbol_set() != s2.get_symbol_set()) [[unlikely]] {
             piranha_throw(std::invalid_argument, "incompatible arguments sets");
         }
         // The largest series goes first.
         const Series *p1 = &s1, *p2 = &s2;
+        const prepared_operand<Series> *prep1 = prep, *prep2 = nullptr;
         if (s1.size() < s2.size()) {
             std::swap(p1, p2);
+            std::swap(prep1, prep2);
         }
         // This is just an optimisation, no troubles if there is a truncation due to static_cast.
         m_v1.reserve(static_cast<size_type>(p1->size()));
@@ -386,17 +679,35 @@ public:
             if (p1->empty()) {
                 m_zero_f1.insert(term_type{cf_type(0), key_type(s1.get_symbol_set())});
                 ctr1 = &m_zero_f1;
+                prep1 = nullptr;
             }
             if (p2->empty()) {
                 m_zero_f2.insert(term_type{cf_type(0), key_type(s1.get_symbol_set())});
                 ctr2 = &m_zero_f2;
+                prep2 = nullptr;
             }
         }
+        m_prep1 = prep1;
+        m_prep2 = prep2;
         // Set the number of threads.
         m_n_threads = (ctr1->size() && ctr2->size())
                           ? thread_pool::use_threads(integer(ctr1->size()) * ctr2->size(),
                                                      integer(settings::get_min_work_per_thread()))
                           : 1u;
+        if constexpr (!mppp::detail::is_rational<typename Series::term_type::cf_type>::value) {
+            if (prep1 || prep2) {
+                // Compute the term pointers only for the operand which was not prepared.
+                const container_type empty_c;
+                this->fill_term_pointers(prep1 ? empty_c : *ctr1, prep2 ? empty_c : *ctr2, m_v1, m_v2);
+                if (prep1) {
+                    m_v1 = prep1->_term_pointers();
+                }
+                if (prep2) {
+                    m_v2 = prep2->_term_pointers();
+                }
+                return;
+            }
+        }
         this->fill_term_pointers(*ctr1, *ctr2, m_v1, m_v2);
     }
 
@@ -557,8 +868,7 @@ protected:
      * - memory errors in standard containers,
      * - the conversion operator of piranha::integer,
      * - standard threading primitives,
-     * - thread_pool::enqueue(),
-     * - future_list::push_back().
+     * - task_group::run().
      */
     template <std::size_t MultArity, typename MultFunctor, typename LimitFunctor>
     bucket_size_type estimate_final_series_size(const LimitFunctor &lf) const
@@ -700,17 +1010,17 @@ protected:
         if (n_threads == 1u) {
             estimator(0u);
         } else {
-            future_list<void> f_list;
+            task_group t_group;
             try {
                 for (unsigned i = 0u; i < n_threads; ++i) {
-                    f_list.push_back(thread_pool::enqueue(i, estimator, i));
+                    t_group.run(i, estimator, i);
                 }
                 // First let's wait for everything to finish.
-                f_list.wait_all();
+                t_group.wait_all();
                 // Then, let's handle the exceptions.
-                f_list.get_all();
+                t_group.get_all();
             } catch (...) {
-                f_list.wait_all();
+                t_group.wait_all();
                 throw;
             }
         }
@@ -803,10 +1113,11 @@ protected:
                 if (FastMode) {
                     auto &container = m_retval._container();
                     // Try to locate the term into retval.
-                    auto bucket_idx = container._bucket(tmp_term);
-                    const auto it = container._find(tmp_term, bucket_idx);
+                    const auto h = container._hash(tmp_term);
+                    auto bucket_idx = container._bucket_from_hash(h);
+                    const auto it = container._find(tmp_term, bucket_idx, h);
                     if (it == m_c_end) {
-                        container._unique_insert(term_insertion(tmp_term), bucket_idx);
+                        container._unique_insert(term_insertion(tmp_term), bucket_idx, h);
                     } else {
                         it->m_cf += tmp_term.m_cf;
                     }
@@ -848,9 +1159,8 @@ protected:
      * base_series_multiplier::bucket_size_type.
      * @throws unspecified any exception thrown by:
      * - the cast operator of piranha::integer,
-     * - standard threading primitives,
-     * - thread_pool::enqueue(),
-     * - future_list::push_back(),
+     * - piranha::hash_set::complete_rehash(),
+     * - piranha::parallel_reduce(),
      * - piranha::term::is_zero(),
      * - piranha::term::is_compatible().
      */
@@ -863,6 +1173,8 @@ protected:
         }
         auto &container = retval._container();
         const auto &args = retval.get_symbol_set();
+        // The multi-threaded implementation accesses the buckets directly.
+        container.complete_rehash();
         // Reset the size to zero before doing anything.
         container._update_size(static_cast<bucket_size_type>(0u));
         // Single-thread implementation.
@@ -889,10 +1201,7 @@ protected:
         }
         // Multi-thread implementation.
         const auto b_count = container.bucket_count();
-        std::mutex m;
-        integer global_count(0);
-        auto eraser = [b_count, &container, &m, &args, &global_count](const bucket_size_type &start,
-                                                                      const bucket_size_type &end) {
+        auto eraser = [b_count, &container, &args](const bucket_size_type &start, const bucket_size_type &end) {
             piranha_assert(start <= end && end <= b_count);
             (void)b_count;
             bucket_size_type count = 0u;
@@ -930,32 +1239,96 @@ protected:
                     count = static_cast<bucket_size_type>(count - 1u);
                 }
             }
-            // Update the global count.
-            std::lock_guard<std::mutex> lock(m);
-            global_count += count;
+            return integer(count);
         };
-        future_list<decltype(eraser(bucket_size_type(), bucket_size_type()))> f_list;
-        try {
-            for (unsigned i = 0u; i < n_threads; ++i) {
-                const auto start = static_cast<bucket_size_type>((b_count / n_threads) * i),
-                           end = static_cast<bucket_size_type>(
-                               (i == n_threads - 1u) ? b_count : (b_count / n_threads) * (i + 1u));
-                f_list.push_back(thread_pool::enqueue(i, eraser, start, end));
-            }
-            // First let's wait for everything to finish.
-            f_list.wait_all();
-            // Then, let's handle the exceptions.
-            f_list.get_all();
-        } catch (...) {
-            f_list.wait_all();
-            // NOTE: there's not need to clear retval here - it was already in an inconsistent
-            // state coming into this method. We rather need to make sure sanitise_series() is always
-            // called in a try/catch block that clears retval in case of errors.
-            throw;
-        }
+        // NOTE: the buckets are claimed dynamically by the threads, so that the load is balanced even if
+        // the terms are unevenly distributed among the buckets.
+        // NOTE: there's not need to clear retval in case of errors - it was already in an inconsistent
+        // state coming into this method. We rather need to make sure sanitise_series() is always
+        // called in a try/catch block that clears retval in case of errors.
+        const auto global_count = parallel_reduce(n_threads, bucket_size_type(0u), b_count, integer(0), eraser,
+                                                  [](integer a, const integer &b) {
+                                                      a += b;
+                                                      return a;
+                                                  });
         // Final update of the total count.
         container._update_size(static_cast<bucket_size_type>(global_count));
     }
+    /// Sanitise an accumulation target.
+    /**
+     * This method is meant to be called after the terms of a product have been accumulated into \p retval via the
+     * low-level interface of its container. It will first add \p n_new, the number of terms inserted in the
+     * container during the accumulation, to the number of terms of \p retval, and it will then reset \p n_new to
+     * zero. Afterwards, the terms with a zero coefficient will be removed from the buckets of \p retval whose indices
+     * are listed in \p buckets.
+     *
+     * \p buckets must contain the indices of all the buckets of \p retval in which a term with a zero coefficient
+     * might be present, possibly with repetitions, and it will be sorted and deduplicated by this method. Only the
+     * listed buckets are examined, hence, contrary to sanitise_series(), the cost of this method does not depend
+     * on the number of terms of \p retval.
+     *
+     * @param retval the series to be sanitised.
+     * @param n_new the number of terms inserted in \p retval.
+     * @param buckets the indices of the buckets which might contain terms with a zero coefficient.
+     *
+     * @throws std::overflow_error if the number of terms in \p retval overflows the maximum value representable by
+     * base_series_multiplier::bucket_size_type.
+     * @throws unspecified any exception thrown by piranha::term::is_zero() or piranha::hash_set::complete_rehash().
+     */
+    static void sanitise_accumulation(Series &retval, bucket_size_type &n_new, std::vector<bucket_size_type> &buckets)
+    {
+        using term_type = typename Series::term_type;
+        auto &container = retval._container();
+        const auto &args = retval.get_symbol_set();
+        // The listed buckets are accessed directly.
+        container.complete_rehash();
+        if (n_new > std::numeric_limits<bucket_size_type>::max() - container.size()) [[unlikely]] {
+            piranha_throw(std::overflow_error, "overflow error in the number of terms of a series");
+        }
+        container._update_size(static_cast<bucket_size_type>(container.size() + n_new));
+        n_new = 0u;
+        std::sort(buckets.begin(), buckets.end());
+        buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+        for (const auto &b : buckets) {
+            while (true) {
+                const auto &bl = container._get_bucket_list(b);
+                const auto it
+                    = std::find_if(bl.begin(), bl.end(), [&args](const term_type &t) { return t.is_zero(args); });
+                if (it == bl.end()) {
+                    break;
+                }
+                // NOTE: _erase() does not update the number of elements.
+                container._erase(container._find(*it, b));
+                container._update_size(static_cast<bucket_size_type>(container.size() - 1u));
+            }
+        }
+        buckets.clear();
+    }
+    /// Recover an accumulation target.
+    /**
+     * This method is meant to be called when an error occurs during the accumulation of the terms of a product into
+     * \p retval. It will call \p f, which is expected to restore the invariants of \p retval (e.g., by terminating
+     * a concurrent insertion session and calling sanitise_accumulation()). If \p f throws, \p retval will be cleared.
+     *
+     * If the coefficient type of \p Series is an mp++ rational, \p f is not called and \p retval is always cleared:
+     * products with rational coefficients are accumulated directly only into empty series, and the accumulated
+     * coefficients are not yet normalised.
+     *
+     * @param retval the series to be recovered.
+     * @param f the recovery functor.
+     */
+    template <typename F>
+    static void recover_accumulation(Series &retval, const F &f) noexcept
+    {
+        if constexpr (!mppp::detail::is_rational<typename Series::term_type::cf_type>::value) {
+            try {
+                f();
+                return;
+            } catch (...) {
+            }
+        }
+        retval._container().clear();
+    }
     /// A plain series multiplication routine.
     /**
      * \note
@@ -974,6 +1347,12 @@ protected:
      * The \p lf functor will be forwarded as limit functor to base_series_multiplier::blocked_multiplication()
      * and base_series_multiplier::estimate_final_series_size().
      *
+     * In multithreaded mode, the threads accumulate the term-by-term products directly into the output series,
+     * via the concurrent insertion interface of its container (which locks the destination bucket for each
+     * insertion), unless tuning::get_private_accumulation() returns
+     * \p true: in that case, each thread accumulates into a private table, and the private tables are then merged
+     * in parallel into the output series.
+     *
      * Note that, in multithreaded mode, \p lf will be shared among (and called concurrently from) all the threads.
      *
      * @param lf the limit functor (see base_series_multiplier::blocked_multiplication()).
@@ -986,15 +1365,52 @@ protected:
      * - <tt>boost::numeric_cast()</tt>,
      * - the public interface of piranha::hash_set,
      * - base_series_multiplier::blocked_multiplication(),
-     * - base_series_multiplier::sanitise_series(),
+     * - base_series_multiplier::sanitise_accumulation(),
      * - the <tt>multiply()</tt> method of the key type of \p Series,
-     * - thread_pool::enqueue(),
-     * - future_list::push_back(),
+     * - task_group::run(),
      * - the construction of terms,
      * - in-place addition of coefficients.
      */
     template <typename LimitFunctor>
     Series plain_multiplication(const LimitFunctor &lf) const
+    {
+        // Setup the return value with the merged symbol set.
+        Series retval;
+        retval.set_symbol_set(m_ss);
+        plain_multiply_accumulate(retval, lf);
+        return retval;
+    }
+    /// A plain series multiply-accumulate routine.
+    /**
+     * \note
+     * The requirements on \p Series and \p LimitFunctor are the same as in plain_multiplication().
+     *
+     * This method will add to \p retval the result of the multiplication of the two series used to construct
+     * \p this, using the same algorithm as plain_multiplication(). The terms of the product are accumulated
+     * directly into the container of \p retval, which is rehashed at most once according to the estimated size
+     * of the result, thus avoiding the creation of a temporary series for the product.
+     *
+     * If the coefficient type of \p Series is an mp++ rational and \p retval is not empty, the product will be
+     * computed via plain_multiplication() and then added to \p retval (the normalisation of the rational
+     * coefficients of the product is not compatible with the direct accumulation).
+     *
+     * Only the buckets of \p retval touched by the accumulation are sanitised (see sanitise_accumulation()), hence
+     * the cost of the accumulation does not depend on the number of terms initially present in \p retval.
+     *
+     * In case of exceptions, \p retval will be left in a valid state: it will contain its original terms, to which
+     * an unspecified subset of the term-by-term products has been added. If the coefficient type of \p Series is an
+     * mp++ rational, or in the unlikely event of a failure while restoring the invariants of \p retval,
+     * \p retval will be cleared instead (in the former case, \p retval was empty on input).
+     *
+     * @param retval the series into which the product will be accumulated.
+     * @param lf the limit functor (see base_series_multiplier::blocked_multiplication()).
+     *
+     * @throws std::invalid_argument if the symbol set of \p retval differs from base_series_multiplier::m_ss.
+     * @throws unspecified any exception thrown by plain_multiplication() or by the in-place addition
+     * of series.
+     */
+    template <typename LimitFunctor>
+    void plain_multiply_accumulate(Series &retval, const LimitFunctor &lf) const
     {
         // Shortcuts.
         using term_type = typename Series::term_type;
@@ -1002,13 +1418,19 @@ protected:
         using key_type = typename term_type::key_type;
         PIRANHA_TT_CHECK(key_is_multipliable, cf_type, key_type);
         constexpr std::size_t m_arity = key_type::multiply_arity;
-        // Setup the return value with the merged symbol set.
-        Series retval;
-        retval.set_symbol_set(m_ss);
+        if (retval.get_symbol_set() != m_ss) [[unlikely]] {
+            piranha_throw(std::invalid_argument, "incompatible symbol sets in series multiply-accumulate");
+        }
         // Do not do anything if one of the two series is empty.
         if (m_v1.empty() || m_v2.empty()) [[unlikely]]
         {
-            return retval;
+            return;
+        }
+        if constexpr (mppp::detail::is_rational<cf_type>::value) {
+            if (!retval.empty()) {
+                retval += plain_multiplication(lf);
+                return;
+            }
         }
         const size_type size1 = m_v1.size(), size2 = m_v2.size();
         (void)size2;
@@ -1016,6 +1438,9 @@ protected:
         // Convert n_threads to size_type for convenience.
         const size_type n_threads = piranha::safe_cast<size_type>(m_n_threads);
         piranha_assert(n_threads);
+        // retval is accessed via the low-level interface below, which does not deal with a pending incremental
+        // rehash.
+        retval._container().complete_rehash();
         // Determine if we should estimate the size. We check the threshold, but we always
         // need to estimate in multithreaded mode.
         bool estimate = true;
@@ -1029,66 +1454,113 @@ protected:
             // NOTE: use numeric cast here as safe_cast is expensive, going through an integer-double conversion,
             // and in this case the behaviour of numeric_cast is appropriate.
             const auto n_buckets = boost::numeric_cast<bucket_size_type>(
-                std::ceil(static_cast<double>(est) / retval._container().max_load_factor()));
+                std::ceil(static_cast<double>(est + retval.size()) / retval._container().max_load_factor()));
             piranha_assert(n_buckets > 0u);
             // Check if we want to use the parallel memory set.
             // NOTE: it is important here that we use the same n_threads for multiplication and memset as
             // we tie together pinned threads with potentially different NUMA regions.
             const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? static_cast<unsigned>(n_threads) : 1u;
-            retval._container().rehash(n_buckets, n_threads_rehash);
+            // NOTE: when accumulating, retval might already be large enough.
+            if (n_buckets > retval._container().bucket_count()) {
+                retval._container().rehash(n_buckets, n_threads_rehash);
+            }
         }
         if (n_threads == 1u) {
+            // Number of inserted terms and buckets which might contain zero terms (see sanitise_accumulation()).
+            bucket_size_type n_new = 0u;
+            std::vector<bucket_size_type> zeros;
             try {
                 // Single-thread case.
                 if (estimate) {
-                    blocked_multiplication(plain_multiplier<true>(*this, retval), 0u, size1, lf);
-                    // If we estimated beforehand, we need to sanitise the series.
-                    sanitise_series(retval, static_cast<unsigned>(n_threads));
+                    // If we estimated beforehand, the terms are accumulated via the low-level interface
+                    // of the container, and the touched part of the series is sanitised afterwards.
+                    auto &container = retval._container();
+                    const auto &args = retval.get_symbol_set();
+                    std::array<term_type, m_arity> tmp_t;
+                    auto f = [&tmp_t, &container, &args, &n_new, &zeros, this](const size_type &i, const size_type &j) {
+                        key_type::multiply(tmp_t, *(this->m_v1[i]), *(this->m_v2[j]), args);
+                        for (auto &tmp_term : tmp_t) {
+                            const auto h = container._hash(tmp_term);
+                            accumulate_term(container, term_insertion(tmp_term), container._bucket_from_hash(h), h,
+                                            args, n_new, zeros);
+                        }
+                    };
+                    blocked_multiplication(f, 0u, size1, lf);
+                    sanitise_accumulation(retval, n_new, zeros);
                 } else {
                     blocked_multiplication(plain_multiplier<false>(*this, retval), 0u, size1, lf);
                 }
                 finalise_series(retval);
-                return retval;
+                return;
             } catch (...) {
-                retval._container().clear();
+                recover_accumulation(retval,
+                                     [&retval, &n_new, &zeros]() { sanitise_accumulation(retval, n_new, zeros); });
                 throw;
             }
         }
         // Multi-threaded case.
         piranha_assert(estimate);
-        // Init the vector of spinlocks.
-        detail::atomic_flag_array sl_array(piranha::safe_cast<std::size_t>(retval._container().bucket_count()));
-        // Init the future list.
-        future_list<void> f_list;
         // Thread block size.
         const auto block_size = size1 / n_threads;
+        if (tuning::get_private_accumulation()) {
+            std::vector<size_type> bounds;
+            for (size_type idx = 0u; idx < n_threads; ++idx) {
+                bounds.push_back(static_cast<size_type>(idx * block_size));
+            }
+            bounds.push_back(size1);
+            try {
+                private_accumulation(retval, bounds,
+                                     [this](std::array<term_type, m_arity> &tmp_t, const size_type &i,
+                                            const size_type &j) {
+                                         key_type::multiply(tmp_t, *(this->m_v1[i]), *(this->m_v2[j]), this->m_ss);
+                                         return true;
+                                     },
+                                     lf);
+                finalise_series(retval);
+            } catch (...) {
+                // NOTE: private_accumulation() takes care of sanitising retval.
+                recover_accumulation(retval, []() {});
+                throw;
+            }
+            return;
+        }
+        // Init the task group.
+        task_group t_group;
+        // Per-thread lists of the buckets which might contain zero terms (see sanitise_accumulation()).
+        std::vector<std::vector<bucket_size_type>> zeros(n_threads);
+        // End the concurrent insertion session (if active) and sanitise retval.
+        bool session = false;
+        auto sanitise = [&retval, &zeros, &session]() {
+            if (session) {
+                session = false;
+                retval._container()._concurrent_end();
+            }
+            // NOTE: the inserted terms have been counted by the concurrent inserters.
+            bucket_size_type n_new = 0u;
+            for (auto &z : zeros) {
+                sanitise_accumulation(retval, n_new, z);
+            }
+        };
         try {
+            // Start the concurrent insertion of the terms into retval.
+            retval._container()._concurrent_begin();
+            session = true;
             for (size_type idx = 0u; idx < n_threads; ++idx) {
                 // Thread functor.
-                auto tf = [idx, this, block_size, n_threads, &sl_array, &retval, &lf]() {
+                auto tf = [idx, this, block_size, n_threads, &retval, &lf, &zeros]() {
+                    auto &container = retval._container();
+                    const auto &args = retval.get_symbol_set();
+                    auto &z = zeros[idx];
                     // Used to store the result of term multiplication.
                     std::array<term_type, key_type::multiply_arity> tmp_t;
-                    // End of retval container (thread-safe).
-                    const auto c_end = retval._container().end();
+                    // The inserter of this thread, locking the destination buckets.
+                    typename container_type::_concurrent_inserter ins(container);
                     // Block functor.
-                    // NOTE: this is very similar to the plain functor, but it does the bucket locking
-                    // additionally.
-                    auto f = [&c_end, &tmp_t, this, &retval, &sl_array](const size_type &i, const size_type &j) {
+                    auto f = [&tmp_t, &ins, &container, &args, &z, this](const size_type &i, const size_type &j) {
                         // Run the term multiplication.
-                        key_type::multiply(tmp_t, *(this->m_v1[i]), *(this->m_v2[j]), retval.get_symbol_set());
-                        for (std::size_t n = 0u; n < key_type::multiply_arity; ++n) {
-                            auto &container = retval._container();
-                            auto &tmp_term = tmp_t[n];
-                            // Try to locate the term into retval.
-                            auto bucket_idx = container._bucket(tmp_term);
-                            // Lock the bucket.
-                            detail::atomic_lock_guard alg(sl_array[static_cast<std::size_t>(bucket_idx)]);
-                            const auto it = container._find(tmp_term, bucket_idx);
-                            if (it == c_end) {
-                                container._unique_insert(term_insertion(tmp_term), bucket_idx);
-                            } else {
-                                it->m_cf += tmp_term.m_cf;
-                            }
+                        key_type::multiply(tmp_t, *(this->m_v1[i]), *(this->m_v2[j]), args);
+                        for (auto &tmp_term : tmp_t) {
+                            accumulate_term(ins, container, term_insertion(tmp_term), args, z);
                         }
                     };
                     // Thread block limit.
@@ -1096,19 +1568,18 @@ protected:
                         = (idx == n_threads - 1u) ? this->m_v1.size() : static_cast<size_type>((idx + 1u) * block_size);
                     this->blocked_multiplication(f, static_cast<size_type>(idx * block_size), e1, lf);
                 };
-                f_list.push_back(thread_pool::enqueue(static_cast<unsigned>(idx), tf));
+                t_group.run(static_cast<unsigned>(idx), tf);
             }
-            f_list.wait_all();
-            f_list.get_all();
-            sanitise_series(retval, static_cast<unsigned>(n_threads));
+            t_group.wait_all();
+            t_group.get_all();
+            sanitise();
             finalise_series(retval);
         } catch (...) {
-            f_list.wait_all();
-            // Clean up retval as it might be in an inconsistent state.
-            retval._container().clear();
+            t_group.wait_all();
+            // Restore the invariants of retval, terminating the concurrent insertion session.
+            recover_accumulation(retval, sanitise);
             throw;
         }
-        return retval;
     }
     /// A plain series multiplication routine (convenience overload).
     /**
@@ -1121,6 +1592,236 @@ protected:
     {
         return plain_multiplication(default_limit_functor{*this});
     }
+    /// A plain series multiply-accumulate routine (convenience overload).
+    /**
+     * This method will call the other overload of plain_multiply_accumulate(), with a limit
+     * functor whose call operator will always return the size of the second series unconditionally.
+     *
+     * @param retval the series into which the product will be accumulated.
+     *
+     * @throws unspecified any exception thrown by the other overload of plain_multiply_accumulate().
+     */
+    void plain_multiply_accumulate(Series &retval) const
+    {
+        plain_multiply_accumulate(retval, default_limit_functor{*this});
+    }
+    /// Plain series squaring.
+    /**
+     * \note
+     * This method can be called only if the key and coefficient types of \p Series satisfy
+     * piranha::key_is_multipliable, otherwise a compile-time error will be produced.
+     *
+     * This method computes the same result as plain_multiplication() (with the default limit functor), and it can be
+     * used when the two operands passed to the constructor are the same object (i.e., when
+     * base_series_multiplier::m_square is \p true). Since the product of the terms of index \f$ i \f$ and \f$ j \f$
+     * is equal to the product of the terms of index \f$ j \f$ and \f$ i \f$, only the pairs with \f$ i \leq j \f$
+     * are multiplied, and the cross products are computed using the doubled coefficient of the term of index
+     * \f$ i \f$. The number of term-by-term multiplications is thus roughly halved with respect to
+     * plain_multiplication().
+     *
+     * The estimation and parallelisation strategies are the same as in plain_multiplication(). In multithreaded mode,
+     * the rows are distributed among the threads so that each thread performs roughly the same number of
+     * term-by-term multiplications.
+     *
+     * @return the square of the operand passed to the constructor.
+     *
+     * @throws unspecified any exception thrown by plain_square_accumulate().
+     */
+    Series plain_squaring() const
+    {
+        Series retval;
+        retval.set_symbol_set(m_ss);
+        plain_square_accumulate(retval);
+        return retval;
+    }
+    /// Plain series square-accumulate.
+    /**
+     * \note
+     * The requirements on \p Series are the same as in plain_squaring().
+     *
+     * This method will add to \p retval the result of plain_squaring(), accumulating the terms directly
+     * into the container of \p retval as explained in plain_multiply_accumulate(). The behaviour in case of
+     * exceptions is the same as in plain_multiply_accumulate().
+     *
+     * @param retval the series into which the square will be accumulated.
+     *
+     * @throws std::invalid_argument if base_series_multiplier::m_square is \p false, or if the symbol set
+     * of \p retval differs from base_series_multiplier::m_ss.
+     * @throws unspecified any exception thrown by:
+     * - plain_multiply_accumulate(),
+     * - the addition of coefficients,
+     * - the arithmetic operations of piranha::integer.
+     */
+    void plain_square_accumulate(Series &retval) const
+    {
+        // Shortcuts.
+        using term_type = typename Series::term_type;
+        using cf_type = typename term_type::cf_type;
+        using key_type = typename term_type::key_type;
+        PIRANHA_TT_CHECK(key_is_multipliable, cf_type, key_type);
+        constexpr std::size_t m_arity = key_type::multiply_arity;
+        if (!m_square) [[unlikely]] {
+            piranha_throw(std::invalid_argument, "cannot use the squaring algorithm on distinct operands");
+        }
+        if (retval.get_symbol_set() != m_ss) [[unlikely]] {
+            piranha_throw(std::invalid_argument, "incompatible symbol sets in series multiply-accumulate");
+        }
+        if (m_v1.empty()) [[unlikely]] {
+            return;
+        }
+        if constexpr (mppp::detail::is_rational<cf_type>::value) {
+            if (!retval.empty()) {
+                retval += plain_squaring();
+                return;
+            }
+        }
+        const size_type size = m_v1.size();
+        piranha_assert(size == m_v2.size());
+        const size_type n_threads = piranha::safe_cast<size_type>(m_n_threads);
+        piranha_assert(n_threads);
+        // See plain_multiply_accumulate().
+        retval._container().complete_rehash();
+        const default_limit_functor lf{*this};
+        // Same estimation logic as in plain_multiplication().
+        bool estimate = true;
+        const auto e_thr = tuning::get_estimate_threshold();
+        if (integer(size) * size < integer(e_thr) * e_thr && n_threads == 1u) {
+            estimate = false;
+        }
+        if (estimate) {
+            const auto est = estimate_final_series_size<m_arity, plain_multiplier<false>>(lf);
+            const auto n_buckets = boost::numeric_cast<bucket_size_type>(
+                std::ceil(static_cast<double>(est + retval.size()) / retval._container().max_load_factor()));
+            piranha_assert(n_buckets > 0u);
+            const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? static_cast<unsigned>(n_threads) : 1u;
+            if (n_buckets > retval._container().bucket_count()) {
+                retval._container().rehash(n_buckets, n_threads_rehash);
+            }
+        }
+        // The terms of the operand with doubled coefficients, used for the cross products.
+        std::vector<term_type> dbl;
+        dbl.reserve(static_cast<typename std::vector<term_type>::size_type>(size));
+        for (const auto ptr : m_v1) {
+            dbl.emplace_back(cf_type(ptr->m_cf + ptr->m_cf), ptr->m_key);
+        }
+        // Multiply the i-th term by the j-th term, if j is not less than i. Returns false if
+        // the product was skipped.
+        auto sq_mult = [this, &dbl](std::array<term_type, m_arity> &tmp_t, const size_type &i, const size_type &j) {
+            if (j < i) {
+                return false;
+            }
+            key_type::multiply(tmp_t, i == j ? *(this->m_v1[i]) : dbl[static_cast<decltype(dbl.size())>(i)],
+                               *(this->m_v2[j]), this->m_ss);
+            return true;
+        };
+        if (n_threads == 1u) {
+            bucket_size_type n_new = 0u;
+            std::vector<bucket_size_type> zeros;
+            try {
+                std::array<term_type, m_arity> tmp_t;
+                auto &container = retval._container();
+                const auto &args = retval.get_symbol_set();
+                auto f = [&sq_mult, &tmp_t, &container, &args, &n_new, &zeros, &retval, estimate](const size_type &i,
+                                                                                              const size_type &j) {
+                    if (!sq_mult(tmp_t, i, j)) {
+                        return;
+                    }
+                    for (auto &tmp_term : tmp_t) {
+                        if (estimate) {
+                            const auto h = container._hash(tmp_term);
+                            accumulate_term(container, term_insertion(tmp_term), container._bucket_from_hash(h), h,
+                                            args, n_new, zeros);
+                        } else {
+                            retval.insert(term_insertion(tmp_term));
+                        }
+                    }
+                };
+                blocked_multiplication(f, 0u, size, lf);
+                sanitise_accumulation(retval, n_new, zeros);
+                finalise_series(retval);
+                return;
+            } catch (...) {
+                recover_accumulation(retval,
+                                     [&retval, &n_new, &zeros]() { sanitise_accumulation(retval, n_new, zeros); });
+                throw;
+            }
+        }
+        // Multi-threaded case.
+        piranha_assert(estimate);
+        // The row of index i involves size - i term multiplications: establish the row ranges
+        // so that the threads are assigned roughly the same amount of work.
+        std::vector<size_type> bounds{size_type(0u)};
+        {
+            const integer tot = integer(size) * (integer(size) + 1) / 2;
+            integer cur(0);
+            size_type i = 0u;
+            for (size_type k = 1u; k < n_threads; ++k) {
+                const integer target = tot * k / n_threads;
+                while (i < size && cur < target) {
+                    cur += size - i;
+                    ++i;
+                }
+                bounds.push_back(i);
+            }
+            bounds.push_back(size);
+        }
+        if (tuning::get_private_accumulation()) {
+            try {
+                private_accumulation(retval, bounds, sq_mult, lf);
+                finalise_series(retval);
+            } catch (...) {
+                recover_accumulation(retval, []() {});
+                throw;
+            }
+            return;
+        }
+        // Same logic as in plain_multiply_accumulate().
+        task_group t_group;
+        std::vector<std::vector<bucket_size_type>> zeros(n_threads);
+        bool session = false;
+        auto sanitise = [&retval, &zeros, &session]() {
+            if (session) {
+                session = false;
+                retval._container()._concurrent_end();
+            }
+            bucket_size_type n_new = 0u;
+            for (auto &z : zeros) {
+                sanitise_accumulation(retval, n_new, z);
+            }
+        };
+        try {
+            retval._container()._concurrent_begin();
+            session = true;
+            for (size_type idx = 0u; idx < n_threads; ++idx) {
+                auto tf = [idx, this, &bounds, &sq_mult, &retval, &lf, &zeros]() {
+                    auto &container = retval._container();
+                    const auto &args = retval.get_symbol_set();
+                    auto &z = zeros[idx];
+                    std::array<term_type, m_arity> tmp_t;
+                    typename container_type::_concurrent_inserter ins(container);
+                    auto f = [&tmp_t, &ins, &container, &args, &z, &sq_mult](const size_type &i, const size_type &j) {
+                        if (!sq_mult(tmp_t, i, j)) {
+                            return;
+                        }
+                        for (auto &tmp_term : tmp_t) {
+                            accumulate_term(ins, container, term_insertion(tmp_term), args, z);
+                        }
+                    };
+                    this->blocked_multiplication(f, bounds[static_cast<decltype(bounds.size())>(idx)],
+                                                 bounds[static_cast<decltype(bounds.size())>(idx + 1u)], lf);
+                };
+                t_group.run(static_cast<unsigned>(idx), tf);
+            }
+            t_group.wait_all();
+            t_group.get_all();
+            sanitise();
+            finalise_series(retval);
+        } catch (...) {
+            t_group.wait_all();
+            recover_accumulation(retval, sanitise);
+            throw;
+        }
+    }
     /// Finalise series.
     /**
      * This method will finalise the output \p s of a series multiplication undertaken via
@@ -1131,13 +1832,32 @@ protected:
      *
      * @param s the \p Series to be finalised.
      *
-     * @throws unspecified any exception thrown by:
-     * - thread_pool::enqueue(),
-     * - future_list::push_back().
+     * @throws unspecified any exception thrown by piranha::parallel_for().
      */
     void finalise_series(Series &s) const
     {
-        finalise_impl(s);
+        finalise_impl(s, 1u);
+    }
+    /// Finalise series with an extra denominator.
+    /**
+     * This method is equivalent to the other overload, but, if the coefficient type of \p Series is an mp++
+     * rational, the coefficients of \p s will also be divided by \p d as part of the normalisation. This allows
+     * to fold into the finalisation an exact division that would otherwise need a separate pass over \p s
+     * (e.g., the halving implied by Werner's formulae in the multiplication of trigonometric series). If the
+     * coefficient type of \p Series is not an mp++ rational, \p d is ignored.
+     *
+     * @param s the \p Series to be finalised.
+     * @param d the extra denominator.
+     *
+     * @throws std::invalid_argument if \p d is zero.
+     * @throws unspecified any exception thrown by the other overload.
+     */
+    void finalise_series(Series &s, unsigned d) const
+    {
+        if (d == 0u) [[unlikely]] {
+            piranha_throw(std::invalid_argument, "invalid extra denominator in the finalisation of a series");
+        }
+        finalise_impl(s, d);
     }
 
 protected:
@@ -1154,12 +1874,161 @@ protected:
      * via thread_pool::use_threads().
      */
     unsigned m_n_threads;
+    /// Squaring flag.
+    /**
+     * This value is set to \p true by the constructor if the two operands are the same object. In this case,
+     * base_series_multiplier::m_v1 and base_series_multiplier::m_v2 refer to equal terms stored in the same order,
+     * and the multiplication can be performed via plain_squaring(). Derived classes which reorder
+     * base_series_multiplier::m_v1 and base_series_multiplier::m_v2 independently must reset this flag to \p false.
+     */
+    mutable bool m_square;
+    /// Prepared operands.
+    /**
+     * If the multiplier was constructed from a piranha::prepared_operand, these members will point to it:
+     * base_series_multiplier::m_prep1 if the prepared series corresponds to base_series_multiplier::m_v1,
+     * base_series_multiplier::m_prep2 if it corresponds to base_series_multiplier::m_v2. Otherwise, they are null.
+     */
+    prepared_operand<Series> const *m_prep1 = nullptr;
+    /// Prepared operands.
+    prepared_operand<Series> const *m_prep2 = nullptr;
 
 private:
     // See the constructor for an explanation.
     container_type m_zero_f1;
     container_type m_zero_f2;
 };
+
+namespace detail
+{
+
+// Enabler for batch_multiply().
+template <typename Series, typename It>
+using batch_multiply_enabler = typename std::enable_if<
+    conjunction<is_forward_iterator<It>,
+                std::is_same<typename std::iterator_traits<It>::value_type, Series>,
+                std::is_same<decltype(std::declval<const Series &>() * std::declval<const Series &>()),
+                             Series>>::value,
+    int>::type;
+
+// Specialisation of the estimate used by piranha::product() for the series whose multiplier derives from
+// base_series_multiplier. Below the estimation threshold, the number of term-by-term products is used.
+template <typename Series>
+struct series_product_estimate<
+    Series, enable_if_t<conjunction<std::is_base_of<base_series_multiplier<Series>, series_multiplier<Series>>,
+                                    std::is_constructible<series_multiplier<Series>, const Series &,
+                                                          const Series &>>::value>> {
+    // NOTE: derive from the multiplier in order to access the protected estimation method.
+    struct estimator : series_multiplier<Series> {
+        using series_multiplier<Series>::series_multiplier;
+        integer estimate() const
+        {
+            using base = base_series_multiplier<Series>;
+            return integer(this->template estimate_final_series_size<Series::term_type::key_type::multiply_arity,
+                                                                     typename base::template plain_multiplier<false>>());
+        }
+    };
+    static integer run(const Series &a, const Series &b)
+    {
+        const integer n_products = integer(a.size()) * b.size();
+        const integer e_thr(tuning::get_estimate_threshold());
+        if (n_products < e_thr * e_thr) {
+            return n_products;
+        }
+        return estimator(a, b).estimate();
+    }
+};
+
+// Multiply a prepared operand by a series. The series multiplier is used directly if it can be constructed
+// from a prepared operand, otherwise we fall back to the plain series multiplication.
+template <typename Series>
+inline Series batch_multiply_single(const prepared_operand<Series> &p, const Series &s)
+{
+    if constexpr (std::is_constructible<series_multiplier<Series>, const prepared_operand<Series> &,
+                                        const Series &>::value) {
+        // NOTE: the multiplier requires equal symbol sets, the series multiplication operator takes care of the
+        // merging in the other cases.
+        if (p.get_series().get_symbol_set() == s.get_symbol_set()) {
+            return series_multiplier<Series>(p, s)();
+        }
+    }
+    return p.get_series() * s;
+}
+}
+
+/// One-to-many multiplication.
+/**
+ * \note
+ * This function is enabled only if \p It is a forward iterator whose value type is \p Series, and the
+ * multiplication of two instances of \p Series results in \p Series.
+ *
+ * This function will compute the products of the series prepared in \p p by each series in the range
+ * <tt>[begin,end)</tt>. The products are computed via the constructor of piranha::series_multiplier accepting a
+ * piranha::prepared_operand, if available, so that the preprocessing of the prepared series is performed only
+ * once. Otherwise, the products are computed via the multiplication operator of \p Series.
+ *
+ * If the number of products is at least equal to the number of threads set in piranha::settings, the products
+ * will be computed concurrently, each product being computed single-threaded in a thread of the
+ * piranha::thread_pool. Otherwise, the products are computed one after the other, each product possibly using
+ * multiple threads.
+ *
+ * The series prepared in \p p and the series in the range must not be modified while this function is running.
+ *
+ * @param p the prepared first operand.
+ * @param begin the beginning of the range of second operands.
+ * @param end the end of the range of second operands.
+ *
+ * @return a vector containing the products, in the same order of the input range.
+ *
+ * @throws unspecified any exception thrown by:
+ * - the constructor and the call operator of piranha::series_multiplier,
+ * - the multiplication operator of \p Series,
+ * - memory errors in standard containers,
+ * - task_group::run(),
+ * - piranha::safe_cast().
+ */
+template <typename Series, typename It, detail::batch_multiply_enabler<Series, It> = 0>
+inline std::vector<Series> batch_multiply(const prepared_operand<Series> &p, It begin, It end)
+{
+    // NOTE: store the iterators in a vector, so that each thread can jump directly to its operands.
+    std::vector<It> its;
+    for (; begin != end; ++begin) {
+        its.push_back(begin);
+    }
+    using size_type = typename std::vector<Series>::size_type;
+    std::vector<Series> retval(safe_cast<size_type>(its.size()));
+    if (its.empty()) {
+        return retval;
+    }
+    const unsigned n_threads = (its.size() >= settings::get_n_threads())
+                                   ? thread_pool::use_threads(integer(its.size()), integer(1u))
+                                   : 1u;
+    if (n_threads == 1u) {
+        for (size_type i = 0u; i < retval.size(); ++i) {
+            retval[i] = detail::batch_multiply_single(p, *its[i]);
+        }
+        return retval;
+    }
+    // Thread t computes the products t, t + n_threads, t + 2 * n_threads, etc.
+    auto thread_func = [&p, &its, &retval, n_threads](unsigned t_idx) {
+        for (auto i = static_cast<size_type>(t_idx); i < retval.size(); i += n_threads) {
+            retval[i] = detail::batch_multiply_single(p, *its[i]);
+        }
+    };
+    task_group t_group;
+    try {
+        for (unsigned i = 0u; i < n_threads; ++i) {
+            t_group.run(i, thread_func, i);
+        }
+        // First let's wait for everything to finish.
+        t_group.wait_all();
+        // Then, let's handle the exceptions.
+        t_group.get_all();
+    } catch (...) {
+        t_group.wait_all();
+        throw;
+    }
+    return retval;
+}
 }
 
 #endif
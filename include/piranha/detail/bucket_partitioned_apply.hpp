@@ -0,0 +1,125 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_DETAIL_BUCKET_PARTITIONED_APPLY_HPP
+#define PIRANHA_DETAIL_BUCKET_PARTITIONED_APPLY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <piranha/config.hpp>
+#include <piranha/exceptions.hpp>
+#include <piranha/parallel.hpp>
+
+namespace piranha
+{
+namespace detail
+{
+
+// Apply the functor f to the elements of the random-access range [begin, end), which are destined to be inserted
+// into the hash set s, using n_threads threads. f is called as f(st, it, h), where it is an iterator
+// into the range, h the hash value of *it according to s, and st a per-thread state of type State.
+// The elements are first partitioned in parallel according to their destination bucket in s, and then each
+// thread takes care of a contiguous range of buckets, so that no two threads will ever touch the same bucket.
+// Within a bucket, the elements are processed in the order in which they appear in the input range.
+// The per-thread states are returned at the end of the operation.
+// NOTE: s must have a nonzero number of buckets if the range is not empty, and its bucket count must not change
+// during the operation.
+template <typename State, typename Set, typename Iterator, typename F>
+inline std::vector<State> bucket_partitioned_apply(const Set &s, Iterator begin, Iterator end, unsigned n_threads,
+                                                   const F &f)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<Iterator>::iterator_category>::value,
+                  "A random-access iterator is needed.");
+    using size_type = typename Set::size_type;
+    if (n_threads == 0u) [[unlikely]]
+    {
+        piranha_throw(std::invalid_argument, "invalid number of threads");
+    }
+    const auto n = static_cast<std::size_t>(std::distance(begin, end));
+    const size_type b_count = s.bucket_count();
+    piranha_assert(!n || b_count);
+    // Never use more threads than buckets or elements.
+    if (b_count < n_threads) {
+        n_threads = static_cast<unsigned>(b_count);
+    }
+    if (n < n_threads) {
+        n_threads = static_cast<unsigned>(n);
+    }
+    if (n_threads <= 1u) {
+        std::vector<State> retval(1u);
+        for (auto it = begin; it != end; ++it) {
+            f(retval[0], it, s._hash(*it));
+        }
+        return retval;
+    }
+    // Buckets per thread.
+    const auto bpt = static_cast<size_type>(b_count / n_threads);
+    // The (index, hash) pairs of the elements, partitioned first by source thread and then by destination thread.
+    using part_type = std::vector<std::pair<std::size_t, std::size_t>>;
+    std::vector<std::vector<part_type>> parts(n_threads, std::vector<part_type>(n_threads));
+    // Elements per thread.
+    const auto ept = n / n_threads;
+    // NOTE: both phases are indexed by the source/destination thread index t rather than by the thread of the pool
+    // running them, hence the mapping of the indices to the threads of the pool does not matter.
+    auto partitioner = [&s, &parts, begin, bpt, ept, n, n_threads](unsigned t, const unsigned &t_end) {
+        for (; t != t_end; ++t) {
+            auto &p = parts[t];
+            const auto start = ept * t, end = (t == n_threads - 1u) ? n : ept * (t + 1u);
+            for (auto i = start; i != end; ++i) {
+                const auto h = s._hash(*(begin + static_cast<std::ptrdiff_t>(i)));
+                const auto d
+                    = std::min(static_cast<size_type>(s._bucket_from_hash(h) / bpt), size_type(n_threads - 1u));
+                p[static_cast<std::size_t>(d)].emplace_back(i, h);
+            }
+        }
+    };
+    parallel_for(n_threads, 0u, n_threads, partitioner);
+    std::vector<State> retval(n_threads);
+    auto applier = [&parts, &retval, &f, begin, n_threads](unsigned d, const unsigned &d_end) {
+        for (; d != d_end; ++d) {
+            for (unsigned t = 0u; t < n_threads; ++t) {
+                for (const auto &p : parts[t][d]) {
+                    f(retval[d], begin + static_cast<std::ptrdiff_t>(p.first), p.second);
+                }
+            }
+        }
+    };
+    parallel_for(n_threads, 0u, n_threads, applier);
+    return retval;
+}
+}
+}
+
+#endif
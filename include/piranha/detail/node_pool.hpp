@@ -0,0 +1,249 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_DETAIL_NODE_POOL_HPP
+#define PIRANHA_DETAIL_NODE_POOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <piranha/config.hpp>
+
+namespace piranha
+{
+
+namespace detail
+{
+
+// Pool of linked list nodes, used for the overflow chains of hash_set.
+// NOTE: the nodes are carved out of slabs of geometrically increasing size, and the nodes given back to the pool
+// are recycled via a free list. Memory is returned to the system only when the pool is released or destroyed, all
+// at once. Node must be trivially destructible and default constructible, and it must have an m_next member of type
+// Node *, which is used to link the free list.
+// In order to support concurrent use from different threads (e.g., the multi-threaded series multiplication
+// inserting into different buckets of the same table), each thread allocates from its own sub-pool. The sub-pools
+// are kept in a state object which is allocated only upon the first allocation (possibly by several threads at
+// once, hence the atomic pointer), so that an unused pool is as small as a pointer. The sub-pool of the calling
+// thread is located via a small thread-local cache keyed on the address of the state and on a generation number
+// which is unique to each state, so that a new state allocated at the address of a destroyed one is never
+// confused with it.
+template <typename Node>
+class node_pool
+{
+    static_assert(std::is_trivially_destructible<Node>::value, "The node type must be trivially destructible.");
+    static_assert(std::is_same<decltype(std::declval<Node &>().m_next), Node *>::value,
+                  "The node type must have an m_next member of type pointer to node.");
+    // Number of nodes in the first slab of a sub-pool, and maximum number of nodes in a slab.
+    static constexpr std::size_t min_slab_size = 64u;
+    static constexpr std::size_t max_slab_size = 65536u;
+    using allocator_type = std::allocator<Node>;
+    using allocator_access = std::allocator_traits<allocator_type>;
+    struct sub_pool {
+        explicit sub_pool(const std::thread::id &tid) : m_tid(tid) {}
+        sub_pool(const sub_pool &) = delete;
+        sub_pool &operator=(const sub_pool &) = delete;
+        ~sub_pool()
+        {
+            allocator_type a;
+            for (const auto &p : m_slabs) {
+                allocator_access::deallocate(a, p.first, p.second);
+            }
+        }
+        // Add a new slab and make it current.
+        void add_slab()
+        {
+            // Make sure the vector of slabs can record the new one before allocating it.
+            m_slabs.reserve(m_slabs.size() + 1u);
+            allocator_type a;
+            const auto new_slab = allocator_access::allocate(a, m_slab_size);
+            m_slabs.emplace_back(new_slab, m_slab_size);
+            m_cur = new_slab;
+            m_end = new_slab + m_slab_size;
+            m_slab_size = std::min(m_slab_size * 2u, max_slab_size);
+        }
+        const std::thread::id m_tid;
+        // Head of the free list.
+        Node *m_free = nullptr;
+        // Unused range in the current slab.
+        Node *m_cur = nullptr;
+        Node *m_end = nullptr;
+        std::size_t m_slab_size = min_slab_size;
+        std::vector<std::pair<Node *, std::size_t>> m_slabs;
+    };
+    struct state {
+        state() : m_gen(new_gen()) {}
+        // Generate a new generation number. Zero is never used, so that it can mark the unused slots of the cache.
+        static unsigned long long new_gen()
+        {
+            static std::atomic<unsigned long long> counter(1u);
+            return counter.fetch_add(1u, std::memory_order_relaxed);
+        }
+        const unsigned long long m_gen;
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<sub_pool>> m_sub_pools;
+    };
+    // Get the state, creating it if necessary.
+    state &get_state()
+    {
+        auto st = m_state.load(std::memory_order_acquire);
+        if (st) [[likely]] {
+            return *st;
+        }
+        std::unique_ptr<state> new_st(new state);
+        if (m_state.compare_exchange_strong(st, new_st.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            st = new_st.release();
+        }
+        // NOTE: if another thread won the race, st now points to its state and ours is destroyed.
+        return *st;
+    }
+    // Locate (or create) the sub-pool of the calling thread.
+    sub_pool &local()
+    {
+        struct cache_entry {
+            const state *m_state;
+            unsigned long long m_gen;
+            sub_pool *m_sp;
+        };
+        // NOTE: a few slots in the cache, so that a thread alternating between a handful of pools
+        // (e.g., the source and destination tables of a rehash) does not need to hit the mutex. The slots
+        // are kept in most-recently-used order, hence the pool in use is normally found in the first one.
+        thread_local std::array<cache_entry, 8u> cache{};
+        auto &st = get_state();
+        if (cache[0].m_state == &st && cache[0].m_gen == st.m_gen) [[likely]] {
+            return *cache[0].m_sp;
+        }
+        auto c_it = std::find_if(cache.begin() + 1, cache.end(),
+                                 [&st](const cache_entry &e) { return e.m_state == &st && e.m_gen == st.m_gen; });
+        if (c_it == cache.end()) {
+            const auto tid = std::this_thread::get_id();
+            std::lock_guard<std::mutex> lock(st.m_mutex);
+            auto &sps = st.m_sub_pools;
+            auto it = std::find_if(sps.begin(), sps.end(),
+                                   [&tid](const std::unique_ptr<sub_pool> &p) { return p->m_tid == tid; });
+            if (it == sps.end()) {
+                sps.reserve(sps.size() + 1u);
+                sps.emplace_back(new sub_pool(tid));
+                it = sps.end() - 1;
+            }
+            // Evict the least recently used slot.
+            c_it = cache.end() - 1;
+            *c_it = cache_entry{&st, st.m_gen, it->get()};
+        }
+        // Move the slot to the front.
+        std::rotate(cache.begin(), c_it, c_it + 1);
+        return *cache[0].m_sp;
+    }
+
+public:
+    node_pool() : m_state(nullptr) {}
+    node_pool(const node_pool &) = delete;
+    // NOTE: the state moves along with the sub-pools, hence the cached sub-pools remain valid.
+    node_pool(node_pool &&other) noexcept : m_state(other.m_state.exchange(nullptr, std::memory_order_relaxed)) {}
+    node_pool &operator=(const node_pool &) = delete;
+    node_pool &operator=(node_pool &&other) noexcept
+    {
+        if (this != &other) [[likely]] {
+            release();
+            m_state.store(other.m_state.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        return *this;
+    }
+    ~node_pool()
+    {
+        release();
+    }
+    void swap(node_pool &other) noexcept
+    {
+        const auto tmp = m_state.load(std::memory_order_relaxed);
+        m_state.store(other.m_state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.m_state.store(tmp, std::memory_order_relaxed);
+    }
+    // Get a default-constructed node.
+    Node *allocate()
+    {
+        auto &sp = local();
+        Node *retval;
+        if (sp.m_free) {
+            retval = sp.m_free;
+            sp.m_free = retval->m_next;
+        } else {
+            if (sp.m_cur == sp.m_end) {
+                sp.add_slab();
+            }
+            retval = sp.m_cur++;
+        }
+        return ::new (static_cast<void *>(retval)) Node();
+    }
+    // Give back a node obtained from allocate(). If the sub-pool of the calling thread cannot be
+    // created, the node will be reclaimed only when the pool is released.
+    void deallocate(Node *n) noexcept
+    {
+        piranha_assert(m_state.load(std::memory_order_relaxed));
+        try {
+            auto &sp = local();
+            n->m_next = sp.m_free;
+            sp.m_free = n;
+        } catch (...) {
+        }
+    }
+    // Free all the memory of the pool. All the nodes must have been given back or be unused.
+    // NOTE: the cache entries referring to the destroyed state are never matched again, thanks to the
+    // generation number.
+    void release() noexcept
+    {
+        delete m_state.exchange(nullptr, std::memory_order_relaxed);
+    }
+    // Total number of nodes in the slabs of the pool.
+    std::size_t capacity() const
+    {
+        std::size_t retval = 0u;
+        if (const auto st = m_state.load(std::memory_order_relaxed)) {
+            for (const auto &sp : st->m_sub_pools) {
+                for (const auto &p : sp->m_slabs) {
+                    retval += p.second;
+                }
+            }
+        }
+        return retval;
+    }
+
+private:
+    std::atomic<state *> m_state;
+};
+}
+}
+
+#endif
@@ -0,0 +1,197 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_DETAIL_SMALL_TASK_HPP
+#define PIRANHA_DETAIL_SMALL_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <piranha/config.hpp>
+
+namespace piranha
+{
+
+namespace detail
+{
+
+// Type-erased, move-only nullary callable with small buffer optimisation.
+// NOTE: this is used in place of std::function<void()> for the tasks of the thread pool. The callables which are
+// small enough and nothrow move constructible (e.g., lambdas capturing a few pointers, std::packaged_task) are
+// stored in the internal buffer, so that wrapping them does not allocate. The others are allocated on the heap.
+// Move construction and move assignment never throw.
+class small_task
+{
+public:
+    // Size of the internal buffer.
+    static constexpr std::size_t buffer_size = 6u * sizeof(void *);
+
+private:
+    struct storage_type {
+        alignas(std::max_align_t) unsigned char m_data[buffer_size];
+    };
+    struct vtable {
+        void (*m_call)(storage_type &);
+        // Move-construct into the first storage from the second one, and destroy the second one.
+        void (*m_relocate)(storage_type &, storage_type &) noexcept;
+        void (*m_destroy)(storage_type &) noexcept;
+    };
+    template <typename F>
+    using is_local = std::integral_constant<bool, sizeof(F) <= buffer_size && alignof(F) <= alignof(storage_type)
+                                                      && std::is_nothrow_move_constructible<F>::value>;
+    // Operations for a callable stored in the buffer.
+    template <typename F>
+    struct local_ops {
+        static F &get(storage_type &s)
+        {
+            return *std::launder(reinterpret_cast<F *>(&s));
+        }
+        static void call(storage_type &s)
+        {
+            get(s)();
+        }
+        static void relocate(storage_type &dst, storage_type &src) noexcept
+        {
+            ::new (static_cast<void *>(&dst)) F(std::move(get(src)));
+            get(src).~F();
+        }
+        static void destroy(storage_type &s) noexcept
+        {
+            get(s).~F();
+        }
+        static constexpr vtable vt = {call, relocate, destroy};
+    };
+    // Operations for a callable allocated on the heap (the buffer stores the pointer).
+    template <typename F>
+    struct remote_ops {
+        static F *&get(storage_type &s)
+        {
+            return *std::launder(reinterpret_cast<F **>(&s));
+        }
+        static void call(storage_type &s)
+        {
+            (*get(s))();
+        }
+        static void relocate(storage_type &dst, storage_type &src) noexcept
+        {
+            ::new (static_cast<void *>(&dst)) F *(get(src));
+        }
+        static void destroy(storage_type &s) noexcept
+        {
+            delete get(s);
+        }
+        static constexpr vtable vt = {call, relocate, destroy};
+    };
+    template <typename F>
+    using ops = std::conditional_t<is_local<F>::value, local_ops<F>, remote_ops<F>>;
+    template <typename F>
+    using ctor_enabler
+        = std::enable_if_t<!std::is_same<std::decay_t<F>, small_task>::value
+                               && std::is_constructible<std::decay_t<F>, F &&>::value
+                               && std::is_invocable<std::decay_t<F> &>::value,
+                           int>;
+    template <typename F>
+    void construct(F &&f, std::true_type)
+    {
+        ::new (static_cast<void *>(&m_storage)) std::decay_t<F>(std::forward<F>(f));
+    }
+    template <typename F>
+    void construct(F &&f, std::false_type)
+    {
+        ::new (static_cast<void *>(&m_storage)) std::decay_t<F> *(new std::decay_t<F>(std::forward<F>(f)));
+    }
+
+public:
+    small_task() noexcept : m_vt(nullptr) {}
+    template <typename F, ctor_enabler<F> = 0>
+    small_task(F &&f) : m_vt(nullptr)
+    {
+        using f_type = std::decay_t<F>;
+        construct(std::forward<F>(f), is_local<f_type>{});
+        m_vt = &ops<f_type>::vt;
+    }
+    small_task(small_task &&other) noexcept : m_vt(other.m_vt)
+    {
+        if (m_vt) {
+            m_vt->m_relocate(m_storage, other.m_storage);
+            other.m_vt = nullptr;
+        }
+    }
+    small_task(const small_task &) = delete;
+    small_task &operator=(small_task &&other) noexcept
+    {
+        if (this != &other) [[likely]] {
+            reset();
+            if (other.m_vt) {
+                other.m_vt->m_relocate(m_storage, other.m_storage);
+                m_vt = other.m_vt;
+                other.m_vt = nullptr;
+            }
+        }
+        return *this;
+    }
+    small_task &operator=(const small_task &) = delete;
+    ~small_task()
+    {
+        reset();
+    }
+    explicit operator bool() const noexcept
+    {
+        return m_vt != nullptr;
+    }
+    // Invoke the stored callable. The task must not be empty.
+    void operator()()
+    {
+        piranha_assert(m_vt);
+        m_vt->m_call(m_storage);
+    }
+    // Destroy the stored callable, leaving the task empty.
+    void reset() noexcept
+    {
+        if (m_vt) {
+            m_vt->m_destroy(m_storage);
+            m_vt = nullptr;
+        }
+    }
+    // Check if a callable of type F would be stored without allocating.
+    template <typename F>
+    static constexpr bool is_small()
+    {
+        return is_local<std::decay_t<F>>::value;
+    }
+
+private:
+    const vtable *m_vt;
+    storage_type m_storage;
+};
+}
+}
+
+#endif
@@ -0,0 +1,183 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_DETAIL_WORK_STEALING_DEQUE_HPP
+#define PIRANHA_DETAIL_WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <piranha/config.hpp>
+
+namespace piranha
+{
+
+namespace detail
+{
+
+// A Chase-Lev work-stealing deque of pointers. The owner thread pushes and pops at the bottom of the deque (LIFO),
+// while other threads steal from the top (FIFO). The implementation follows:
+// D. Chase, Y. Lev, "Dynamic circular work-stealing deque", SPAA 2005,
+// N. M. Le et al., "Correct and efficient work-stealing for weak memory models", PPoPP 2013.
+// The circular buffer grows as needed. The old buffers might still be read by concurrent thieves, hence they are
+// kept alive until the deque is destroyed (the total memory overhead is bounded by the size of the largest buffer).
+// The deque does not own the pointed-to objects.
+template <typename T>
+class work_stealing_deque
+{
+    static_assert(std::is_pointer<T>::value, "The work-stealing deque can store only pointers.");
+    using index_t = std::int64_t;
+    struct buffer {
+        explicit buffer(index_t size) : m_mask(size - 1), m_data(new std::atomic<T>[static_cast<std::size_t>(size)])
+        {
+            piranha_assert(size > 0 && !(size & (size - 1)));
+        }
+        index_t size() const
+        {
+            return m_mask + 1;
+        }
+        T get(index_t i) const
+        {
+            return m_data[static_cast<std::size_t>(i & m_mask)].load(std::memory_order_relaxed);
+        }
+        void put(index_t i, T x)
+        {
+            m_data[static_cast<std::size_t>(i & m_mask)].store(x, std::memory_order_relaxed);
+        }
+        const index_t m_mask;
+        std::unique_ptr<std::atomic<T>[]> m_data;
+    };
+    static constexpr index_t initial_size = 32;
+
+public:
+    work_stealing_deque() : m_top(0), m_bottom(0)
+    {
+        m_buffers.emplace_back(new buffer(initial_size));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+    work_stealing_deque(const work_stealing_deque &) = delete;
+    work_stealing_deque(work_stealing_deque &&) = delete;
+    work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+    work_stealing_deque &operator=(work_stealing_deque &&) = delete;
+    ~work_stealing_deque() = default;
+    // Push at the bottom. Can be called only by the owner thread.
+    void push(T x)
+    {
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        const auto t = m_top.load(std::memory_order_acquire);
+        auto buf = m_buffer.load(std::memory_order_relaxed);
+        if (b - t > buf->size() - 1) {
+            buf = grow(buf, t, b);
+        }
+        buf->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    // Pop from the bottom. Can be called only by the owner thread. Returns nullptr if the deque is empty.
+    T pop()
+    {
+        const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        const auto buf = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // Empty deque.
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto x = buf->get(b);
+        if (t == b) {
+            // Last element: race against the thieves.
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                x = nullptr;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+    // Steal from the top. Can be called by any thread. Returns nullptr if the deque is empty or if
+    // the steal lost a race against the owner or another thief.
+    T steal()
+    {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        // NOTE: the original algorithm uses a consume load here.
+        const auto buf = m_buffer.load(std::memory_order_acquire);
+        const auto x = buf->get(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return x;
+    }
+    // Check if the deque is empty. The result is exact only if called by the owner thread
+    // while no thieves are active, otherwise it is just a hint.
+    bool empty() const
+    {
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        const auto t = m_top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+private:
+    // Double the size of the buffer, copying the live elements in [t, b).
+    buffer *grow(buffer *old, index_t t, index_t b)
+    {
+        std::unique_ptr<buffer> new_buf(new buffer(old->size() * 2));
+        for (auto i = t; i != b; ++i) {
+            new_buf->put(i, old->get(i));
+        }
+        m_buffers.push_back(std::move(new_buf));
+        auto retval = m_buffers.back().get();
+        m_buffer.store(retval, std::memory_order_release);
+        return retval;
+    }
+
+private:
+    alignas(64) std::atomic<index_t> m_top;
+    alignas(64) std::atomic<index_t> m_bottom;
+    std::atomic<buffer *> m_buffer;
+    // All the buffers allocated so far (accessed only by the owner thread).
+    std::vector<std::unique_ptr<buffer>> m_buffers;
+};
+
+template <typename T>
+constexpr typename work_stealing_deque<T>::index_t work_stealing_deque<T>::initial_size;
+}
+}
+
+#endif
@@ -342,8 +342,10 @@ private:
             m_container._increase_size();
         }
         // Try to locate the term.
-        auto bucket_idx = m_container._bucket(term);
-        const auto it = m_container._find(term, bucket_idx);
+        // NOTE: the hash value is computed only once, and reused for the insertion.
+        const auto h = m_container._hash(term);
+        auto bucket_idx = m_container._bucket_from_hash(h);
+        const auto it = m_container._find(term, bucket_idx, h);
         if (it == m_container.end()) {
             // New term.
             if (m_container.size() == std::numeric_limits<size_type>::max()) [[unlikely]]
@@ -358,10 +360,10 @@ private:
             {
                 m_container._increase_size();
                 // We need a new bucket index in case of a rehash.
-                bucket_idx = m_container._bucket(term);
+                bucket_idx = m_container._bucket_from_hash(h);
             }
             // Actually perform the insertion and finish by updating the size.
-            m_container._unique_insert(std::forward<Term>(term), bucket_idx);
+            m_container._unique_insert(std::forward<Term>(term), bucket_idx, h);
             m_container._update_size(m_container.size() + size_type(1u));
         } else {
             // Existing term - update the exponent.
@@ -1176,6 +1178,15 @@ public:
         return d._container().empty();
     }
 };
+
+/// Specialisation of piranha::hash_set_cache_hash for terms with divisor keys.
+/**
+ * The hash value of a piranha::divisor is computed from all the terms of the divisor, thus it is cached
+ * in piranha::hash_set.
+ */
+template <typename Cf, typename T, typename Hash>
+struct hash_set_cache_hash<term<Cf, divisor<T>>, Hash> : std::true_type {
+};
 }
 
 #if defined(PIRANHA_WITH_BOOST_S11N)
@@ -0,0 +1,1800 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#pragma once
+
+#ifndef PIRANHA_FLAT_HASH_SET_HPP
+#define PIRANHA_FLAT_HASH_SET_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// SSE2 is used for the parallel comparison of the control bytes, when available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIRANHA_FLAT_HASH_SET_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <piranha/config.hpp>
+#include <piranha/detail/atomic_flag_array.hpp>
+#include <piranha/detail/atomic_lock_guard.hpp>
+#include <piranha/detail/bucket_partitioned_apply.hpp>
+#include <piranha/detail/debug_access.hpp>
+#include <piranha/detail/init.hpp>
+#include <piranha/exceptions.hpp>
+#include <piranha/hash_quality.hpp>
+#include <piranha/parallel.hpp>
+#include <piranha/s11n.hpp>
+#include <piranha/safe_cast.hpp>
+#include <piranha/settings.hpp>
+#include <piranha/thread_pool.hpp>
+#include <piranha/type_traits.hpp>
+
+namespace piranha
+{
+
+/// Flat hash set.
+/**
+ * Hash set with the same public and low-level interface as piranha::hash_set, and thus usable as a drop-in
+ * replacement for it (e.g., as the term container of a series, see piranha::series_container). It is a
+ * grouped-bucket variant of the flat hash tables with control bytes, rather than a fully open-addressing table.
+ *
+ * The elements are stored inline in an array of groups of 16 slots. Each slot is associated to a control byte
+ * holding 7 bits of a mixing of the hash value of the element (or a marker value if the slot is empty), so that
+ * the control bytes are well distributed even when the hash values are not (e.g., small integers). The search
+ * within a group is performed by comparing all the control bytes at once (using SSE2 instructions, where available)
+ * and by invoking the equality predicate only on the slots whose control byte matches. In order to preserve the
+ * semantics of piranha::hash_set (and, in particular, the fact that an element belongs to the bucket identified
+ * by its hash value reduced modulo the bucket count, on which the parallel series multiplication algorithms rely),
+ * the probing does not extend past the destination group: a group plays the role of a bucket of piranha::hash_set,
+ * and in the unlikely event of a full group the additional elements are appended to a contiguous overflow array
+ * associated to the group.
+ *
+ * The maximum load factor is accordingly expressed in elements per group, and it is hard-coded to 8.
+ *
+ * As the control bytes already allow to skip most of the calls to the equality predicate, the full hash
+ * values are never cached (see piranha::hash_set_cache_hash).
+ *
+ * The iterator invalidation rules, the type requirements, the exception safety guarantee and the move semantics
+ * are the same as in piranha::hash_set. Note that, differently from piranha::hash_set, erasing an element moves
+ * the last element of the destination group into the erased position.
+ */
+template <typename T, typename Hash = std::hash<T>, typename Pred = std::equal_to<T>>
+class flat_hash_set
+{
+    PIRANHA_TT_CHECK(is_container_element, T);
+    PIRANHA_TT_CHECK(is_hash_function_object, Hash, T);
+    PIRANHA_TT_CHECK(is_equality_function_object, Pred, T);
+    // Make friend with debug access class.
+    template <typename U>
+    friend class debug_access;
+
+public:
+    /// Functor type for the calculation of hash values.
+    using hasher = Hash;
+    /// Functor type for comparing the items in the set.
+    using key_equal = Pred;
+    /// Key type.
+    using key_type = T;
+    /// Size type.
+    /**
+     * Alias for \p std::size_t.
+     */
+    using size_type = std::size_t;
+
+private:
+    // Number of slots in a group.
+    static constexpr size_type group_size = 16u;
+    // Control byte of an empty slot. All the other control bytes have the highest bit unset.
+    static constexpr std::uint8_t empty_ctrl = 0x80u;
+    // Group of slots constituting a bucket.
+    // NOTE: the occupied slots are always the first m_n ones, and the overflow array is used only
+    // if all the slots are occupied. The elements of the group are thus indexed contiguously by a position
+    // in the [0, size()[ range, with the positions starting from group_size referring to the overflow array.
+    struct group {
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_type;
+        template <typename U>
+        class iterator_impl : public boost::iterator_facade<iterator_impl<U>, U, boost::forward_traversal_tag>
+        {
+            typedef typename std::conditional<std::is_const<U>::value, group const *, group *>::type ptr_type;
+            template <typename V>
+            friend class iterator_impl;
+
+        public:
+            iterator_impl() : m_ptr(nullptr), m_pos(0u) {}
+            explicit iterator_impl(ptr_type ptr, const size_type &pos) : m_ptr(ptr), m_pos(pos) {}
+            // Constructor from other iterator type.
+            template <typename V,
+                      enable_if_t<std::is_convertible<typename iterator_impl<V>::ptr_type, ptr_type>::value, int> = 0>
+            iterator_impl(const iterator_impl<V> &other) : m_ptr(other.m_ptr), m_pos(other.m_pos)
+            {
+            }
+
+        private:
+            friend class boost::iterator_core_access;
+            void increment()
+            {
+                piranha_assert(m_ptr && m_pos < m_ptr->size());
+                ++m_pos;
+            }
+            template <typename V>
+            bool equal(const iterator_impl<V> &other) const
+            {
+                return m_ptr == other.m_ptr && m_pos == other.m_pos;
+            }
+            U &dereference() const
+            {
+                piranha_assert(m_ptr && m_pos < m_ptr->size());
+                return m_ptr->at(m_pos);
+            }
+
+        public:
+            ptr_type m_ptr;
+            size_type m_pos;
+        };
+        typedef iterator_impl<T> iterator;
+        typedef iterator_impl<T const> const_iterator;
+        // Static checks on the iterator types.
+        PIRANHA_TT_CHECK(is_forward_iterator, iterator);
+        PIRANHA_TT_CHECK(is_forward_iterator, const_iterator);
+        group() : m_n(0u)
+        {
+            for (auto &c : m_ctrl) {
+                c = empty_ctrl;
+            }
+        }
+        group(const group &other) : m_overflow(other.m_overflow), m_n(0u)
+        {
+            for (auto &c : m_ctrl) {
+                c = empty_ctrl;
+            }
+            try {
+                for (; m_n < other.m_n; ++m_n) {
+                    ::new (static_cast<void *>(&m_slots[m_n])) T(*other.slot(m_n));
+                    m_ctrl[m_n] = other.m_ctrl[m_n];
+                }
+            } catch (...) {
+                destroy();
+                throw;
+            }
+        }
+        group(group &&) = delete;
+        group &operator=(const group &) = delete;
+        group &operator=(group &&) = delete;
+        ~group()
+        {
+            destroy();
+        }
+        const T *slot(const size_type &i) const
+        {
+            piranha_assert(i < m_n);
+            return static_cast<const T *>(static_cast<const void *>(&m_slots[i]));
+        }
+        T *slot(const size_type &i)
+        {
+            piranha_assert(i < m_n);
+            return static_cast<T *>(static_cast<void *>(&m_slots[i]));
+        }
+        const T &at(const size_type &pos) const
+        {
+            return (pos < group_size) ? *slot(pos) : m_overflow[pos - group_size];
+        }
+        T &at(const size_type &pos)
+        {
+            return (pos < group_size) ? *slot(pos) : m_overflow[pos - group_size];
+        }
+        size_type size() const
+        {
+            return static_cast<size_type>(m_n + m_overflow.size());
+        }
+        bool empty() const
+        {
+            return !m_n;
+        }
+        // Bit mask of the slots whose control byte is equal to h2. As h2 never has the highest
+        // bit set, the empty slots never match.
+        unsigned match(const std::uint8_t &h2) const
+        {
+#if defined(PIRANHA_FLAT_HASH_SET_SSE2)
+            const auto ctrl = _mm_loadu_si128(static_cast<const __m128i *>(static_cast<const void *>(m_ctrl)));
+            return static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(h2)))));
+#else
+            unsigned retval = 0u;
+            for (unsigned i = 0u; i < m_n; ++i) {
+                retval |= static_cast<unsigned>(m_ctrl[i] == h2) << i;
+            }
+            return retval;
+#endif
+        }
+        // Position of the element equal to k, or size() if k is not in the group.
+        size_type find(const T &k, const std::uint8_t &h2, const key_equal &k_equal) const
+        {
+            for (auto mask = match(h2); mask; mask &= mask - 1u) {
+                const auto i = static_cast<size_type>(std::countr_zero(mask));
+                if (k_equal(*slot(i), k)) {
+                    return i;
+                }
+            }
+            // The overflow array is not filtered by the control bytes.
+            const auto ov_size = m_overflow.size();
+            for (decltype(m_overflow.size()) i = 0u; i < ov_size; ++i) {
+                if (k_equal(m_overflow[i], k)) [[unlikely]]
+                {
+                    return static_cast<size_type>(group_size + i);
+                }
+            }
+            return size();
+        }
+        // Insert item and return its position.
+        template <typename U, enable_if_t<std::is_same<T, uncvref_t<U>>::value, int> = 0>
+        size_type insert(U &&item, const std::uint8_t &h2)
+        {
+            if (m_n < group_size) [[likely]]
+            {
+                ::new (static_cast<void *>(&m_slots[m_n])) T(std::forward<U>(item));
+                m_ctrl[m_n] = h2;
+                return m_n++;
+            }
+            m_overflow.push_back(std::forward<U>(item));
+            return static_cast<size_type>(group_size + m_overflow.size() - 1u);
+        }
+        iterator begin()
+        {
+            return iterator(this, 0u);
+        }
+        iterator end()
+        {
+            return iterator(this, size());
+        }
+        const_iterator begin() const
+        {
+            return const_iterator(this, 0u);
+        }
+        const_iterator end() const
+        {
+            return const_iterator(this, size());
+        }
+        void destroy()
+        {
+            m_overflow.clear();
+            for (; m_n; --m_n) {
+                slot(m_n - 1u)->~T();
+                m_ctrl[m_n - 1u] = empty_ctrl;
+            }
+            // After destruction, the group should be equivalent to a default-constructed one.
+            piranha_assert(empty());
+        }
+        std::uint8_t m_ctrl[group_size];
+        storage_type m_slots[group_size];
+        std::vector<T> m_overflow;
+        size_type m_n;
+    };
+    // Allocator type.
+    using allocator_type = std::allocator<group>;
+    using allocator_access = std::allocator_traits<allocator_type>;
+    // The container is a pointer to an array of groups.
+    using ptr_type = group *;
+    // Internal pack type, containing the pointer to the objects, the hash/equal functor
+    // and the allocator.
+    using pack_type = std::tuple<ptr_type, hasher, key_equal, allocator_type>;
+    // A few handy accessors.
+    ptr_type &ptr()
+    {
+        return std::get<0u>(m_pack);
+    }
+    const ptr_type &ptr() const
+    {
+        return std::get<0u>(m_pack);
+    }
+    const hasher &hash() const
+    {
+        return std::get<1u>(m_pack);
+    }
+    const key_equal &k_equal() const
+    {
+        return std::get<2u>(m_pack);
+    }
+    allocator_type &allocator()
+    {
+        return std::get<3u>(m_pack);
+    }
+    const allocator_type &allocator() const
+    {
+        return std::get<3u>(m_pack);
+    }
+    // The control byte of an element is given by the 7 highest bits of the hash value after a multiplicative
+    // mixing step (Fibonacci hashing). The mixing is needed as the hash values of some key types (e.g., Kronecker
+    // monomials) are small integers whose bits above the ones determining the destination group are all zero.
+    static std::uint8_t h2_from_hash(const std::size_t &hash)
+    {
+        constexpr auto mult = static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+        return static_cast<std::uint8_t>((hash * mult) >> (std::numeric_limits<std::size_t>::digits - 7));
+    }
+    // Definition of the iterator type for the set.
+    template <typename Key>
+    class iterator_impl : public boost::iterator_facade<iterator_impl<Key>, Key, boost::forward_traversal_tag>
+    {
+        friend class flat_hash_set;
+        typedef typename std::conditional<std::is_const<Key>::value, flat_hash_set const, flat_hash_set>::type set_type;
+        typedef typename std::conditional<std::is_const<Key>::value, typename group::const_iterator,
+                                          typename group::iterator>::type it_type;
+
+    public:
+        iterator_impl() : m_set(nullptr), m_idx(0u), m_it() {}
+        explicit iterator_impl(set_type *set, const size_type &idx, it_type it) : m_set(set), m_idx(idx), m_it(it) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        void increment()
+        {
+            piranha_assert(m_set);
+            auto &container = m_set->ptr();
+            // Assert that the current iterator is valid.
+            piranha_assert(m_idx < m_set->bucket_count());
+            piranha_assert(!container[m_idx].empty());
+            piranha_assert(m_it != container[m_idx].end());
+            ++m_it;
+            if (m_it == container[m_idx].end()) {
+                const size_type container_size = m_set->bucket_count();
+                while (true) {
+                    ++m_idx;
+                    if (m_idx == container_size) {
+                        m_it = it_type{};
+                        return;
+                    } else if (!container[m_idx].empty()) {
+                        m_it = container[m_idx].begin();
+                        return;
+                    }
+                }
+            }
+        }
+        bool equal(const iterator_impl &other) const
+        {
+            piranha_assert(m_set && other.m_set);
+            return (m_idx == other.m_idx && m_it == other.m_it);
+        }
+        Key &dereference() const
+        {
+            piranha_assert(m_set && m_idx < m_set->bucket_count() && m_it != m_set->ptr()[m_idx].end());
+            return *m_it;
+        }
+
+    private:
+        set_type *m_set;
+        size_type m_idx;
+        it_type m_it;
+    };
+    // Number of threads to be used for an operation on n elements. The thread pool is queried (which involves
+    // a global lock) only if the work is large enough to be split among at least two threads.
+    static unsigned work_n_threads(const size_type &n)
+    {
+        const auto min_work = settings::get_min_work_per_thread();
+        return (static_cast<unsigned long long>(n) / 2u >= min_work)
+                   ? thread_pool::use_threads(static_cast<unsigned long long>(n), min_work)
+                   : 1u;
+    }
+    void init_from_n_buckets(const size_type &n_buckets, unsigned n_threads)
+    {
+        piranha_assert(!ptr() && !m_log2_size && !m_n_elements);
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        // Proceed to actual construction only if the requested number of buckets is nonzero.
+        if (!n_buckets) {
+            return;
+        }
+        const size_type log2_size = get_log2_from_hint(n_buckets);
+        const size_type size = size_type(1u) << log2_size;
+        auto new_ptr = allocator_access::allocate(allocator(), size);
+        if (!new_ptr) {
+            piranha_throw(std::bad_alloc, );
+        }
+        if (n_threads == 1u) {
+            // Default-construct the groups.
+            // NOTE: this is a noexcept operation, no need to account for rolling back.
+            for (size_type i = 0u; i < size; ++i) {
+                allocator_access::construct(allocator(), &new_ptr[i]);
+            }
+        } else {
+            // The ranges constructed so far, for rolling back.
+            std::mutex mutex;
+            std::vector<std::pair<size_type, size_type>> constructed_ranges;
+            auto constructor = [this, new_ptr, &mutex, &constructed_ranges](const size_type &start,
+                                                                            const size_type &end) {
+                // NOTE: the construction is noexcept, only the recording of the range can throw.
+                for (size_type i = start; i != end; ++i) {
+                    allocator_access::construct(this->allocator(), &new_ptr[i]);
+                }
+                try {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    constructed_ranges.emplace_back(start, end);
+                } catch (...) {
+                    for (size_type i = start; i != end; ++i) {
+                        allocator_access::destroy(this->allocator(), &new_ptr[i]);
+                    }
+                    throw;
+                }
+            };
+            try {
+                constructed_ranges.reserve(n_threads);
+                // NOTE: contiguous partitioning, so that each thread touches first its own part of the array.
+                parallel_for(n_threads, size_type(0u), size, constructor, size_type(1u), partitioning::contiguous);
+            } catch (...) {
+                for (const auto &r : constructed_ranges) {
+                    for (size_type i = r.first; i != r.second; ++i) {
+                        allocator_access::destroy(allocator(), &new_ptr[i]);
+                    }
+                }
+                allocator_access::deallocate(allocator(), new_ptr, size);
+                throw;
+            }
+        }
+        // Assign the members.
+        ptr() = new_ptr;
+        m_log2_size = log2_size;
+    }
+    // Destroy all elements and deallocate ptr().
+    void destroy_and_deallocate()
+    {
+        if (ptr()) {
+            const size_type size = size_type(1u) << m_log2_size;
+            for (size_type i = 0u; i < size; ++i) {
+                allocator_access::destroy(allocator(), &ptr()[i]);
+            }
+            allocator_access::deallocate(allocator(), ptr(), size);
+        } else {
+            piranha_assert(!m_log2_size && !m_n_elements);
+        }
+    }
+#if defined(PIRANHA_WITH_BOOST_S11N)
+    // Serialization support.
+    friend class boost::serialization::access;
+    template <class Archive>
+    void save(Archive &ar, unsigned) const
+    {
+        boost_save(ar, size());
+        boost_save_range(ar, begin(), end());
+    }
+    template <class Archive>
+    void load(Archive &ar, unsigned)
+    {
+        *this = flat_hash_set{};
+        size_type size;
+        boost_load(ar, size);
+        rehash(boost::numeric_cast<size_type>(std::ceil(static_cast<double>(size) / max_load_factor())));
+        for (size_type i = 0; i < size; ++i) {
+            T tmp;
+            boost_load(ar, tmp);
+            const auto p = insert(std::move(tmp));
+            if (unlikely(!p.second)) {
+                piranha_throw(std::invalid_argument, "while deserializing a flat_hash_set from a Boost archive "
+                                                     "a duplicate value was encountered");
+            }
+        }
+    }
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+#endif
+    // Enabler for insert().
+    template <typename U>
+    using insert_enabler = enable_if_t<std::is_same<key_type, uncvref_t<U>>::value, int>;
+    // Enabler for bulk_insert().
+    template <typename Iterator>
+    using bulk_insert_enabler = enable_if_t<
+        conjunction<std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Iterator>::iterator_category>,
+                    std::is_same<key_type, uncvref_t<typename std::iterator_traits<Iterator>::reference>>>::value,
+        int>;
+    // Run a consistency check on the set, will return false if something is wrong.
+    bool sanity_check() const
+    {
+        size_type count = 0u;
+        for (size_type i = 0u; i < bucket_count(); ++i) {
+            const auto &g = ptr()[i];
+            // The overflow array can be used only if the group is full.
+            if (!g.m_overflow.empty() && g.m_n != group_size) {
+                return false;
+            }
+            for (size_type j = 0u; j < group_size; ++j) {
+                if (j < g.m_n ? g.m_ctrl[j] != h2_from_hash(hash()(*g.slot(j))) : g.m_ctrl[j] != empty_ctrl) {
+                    return false;
+                }
+            }
+            for (auto it = g.begin(); it != g.end(); ++it) {
+                if (_bucket(*it) != i) {
+                    return false;
+                }
+                ++count;
+            }
+        }
+        if (count != m_n_elements) {
+            return false;
+        }
+        if (m_log2_size >= unsigned(std::numeric_limits<size_type>::digits)) {
+            return false;
+        }
+        if (!ptr() && (m_log2_size || m_n_elements)) {
+            return false;
+        }
+        count = 0u;
+        for (auto it = begin(); it != end(); ++it, ++count) {
+        }
+        if (count != m_n_elements) {
+            return false;
+        }
+        return true;
+    }
+    static const size_type m_n_nonzero_sizes = static_cast<size_type>(std::numeric_limits<size_type>::digits);
+    // Get log2 of set size at least equal to hint. To be used only when hint is not zero.
+    static size_type get_log2_from_hint(const size_type &hint)
+    {
+        piranha_assert(hint);
+        for (size_type i = 0u; i < m_n_nonzero_sizes; ++i) {
+            if ((size_type(1u) << i) >= hint) {
+                return i;
+            }
+        }
+        piranha_throw(std::bad_alloc, );
+    }
+
+    // Maximum number of locks used during concurrent insertions.
+    static constexpr size_type m_max_n_locks = size_type(1u) << 20u;
+    // State of a concurrent insertion session, as in piranha::hash_set.
+    struct concurrent_state {
+        explicit concurrent_state(const size_type &n_locks)
+            : m_locks(static_cast<std::size_t>(n_locks)), m_mask(static_cast<size_type>(n_locks - 1u)), m_count(0u)
+        {
+        }
+        detail::atomic_flag_array m_locks;
+        const size_type m_mask;
+        std::atomic<size_type> m_count;
+    };
+    // Move the elements of this into new_set using n_threads threads. See the implementation
+    // in piranha::hash_set for an explanation of the partitioning.
+    void parallel_migrate(flat_hash_set &new_set, unsigned n_threads)
+    {
+        const size_type old_count = bucket_count(), n_res = std::min(old_count, new_set.bucket_count());
+        piranha_assert(n_threads > 1u && n_res);
+        auto thread_function = [this, &new_set, old_count, n_res](const size_type &start, const size_type &end) {
+            for (size_type r = start; r != end; ++r) {
+                for (size_type i = r; i < old_count; i += n_res) {
+                    auto &g = ptr()[i];
+                    const auto it_f = g.end();
+                    for (auto it = g.begin(); it != it_f; ++it) {
+                        const auto h = this->_hash(*it);
+                        new_set._unique_insert(std::move(*it), new_set._bucket_from_hash(h), h);
+                    }
+                }
+            }
+        };
+        parallel_for(n_threads, size_type(0u), n_res, thread_function);
+    }
+
+public:
+    /// Iterator type.
+    /**
+     * A read-only forward iterator.
+     */
+    using iterator = iterator_impl<key_type const>;
+
+private:
+    // Static checks on the iterator type.
+    PIRANHA_TT_CHECK(is_forward_iterator, iterator);
+
+public:
+    /// Const iterator type.
+    /**
+     * Equivalent to the iterator type.
+     */
+    using const_iterator = iterator;
+    /// Local iterator.
+    /**
+     * Const iterator that can be used to iterate through a single bucket.
+     */
+    using local_iterator = typename group::const_iterator;
+    /// Default constructor.
+    /**
+     * @param h hasher functor.
+     * @param k equality predicate.
+     *
+     * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>.
+     */
+    flat_hash_set(const hasher &h = hasher{}, const key_equal &k = key_equal{})
+        : m_pack(nullptr, h, k, allocator_type{}), m_log2_size(0u), m_n_elements(0u)
+    {
+    }
+    /// Constructor from number of buckets.
+    /**
+     * Equivalent to the corresponding constructor of piranha::hash_set.
+     *
+     * @param n_buckets desired number of buckets.
+     * @param h hasher functor.
+     * @param k equality predicate.
+     * @param n_threads number of threads to use during initialisation.
+     *
+     * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum, or in
+     * case of memory errors.
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by:
+     * - the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>,
+     * - piranha::parallel_for(), if \p n_threads is not 1.
+     */
+    explicit flat_hash_set(const size_type &n_buckets, const hasher &h = hasher{}, const key_equal &k = key_equal{},
+                           unsigned n_threads = 1u)
+        : m_pack(nullptr, h, k, allocator_type{}), m_log2_size(0u), m_n_elements(0u)
+    {
+        init_from_n_buckets(n_buckets, n_threads);
+    }
+    /// Copy constructor.
+    /**
+     * As in piranha::hash_set, the buckets of large sets are copied in parallel.
+     *
+     * @param other piranha::flat_hash_set that will be copied into \p this.
+     *
+     * @throws unspecified any exception thrown by memory allocation errors,
+     * the copy constructor of the stored type, <tt>Hash</tt> or <tt>Pred</tt>, piranha::thread_pool::use_threads()
+     * or piranha::parallel_for().
+     */
+    flat_hash_set(const flat_hash_set &other)
+        : m_pack(nullptr, other.hash(), other.k_equal(), other.allocator()), m_log2_size(0u), m_n_elements(0u)
+    {
+        if (other.ptr()) {
+            const size_type size = size_type(1u) << other.m_log2_size;
+            const unsigned n_threads = work_n_threads(other.size());
+            std::mutex mutex;
+            std::vector<std::pair<size_type, size_type>> ranges;
+            auto new_ptr = allocator_access::allocate(allocator(), size);
+            if (!new_ptr) [[unlikely]]
+            {
+                piranha_throw(std::bad_alloc, );
+            }
+            auto copier = [this, new_ptr, &other, &mutex, &ranges](const size_type &start, const size_type &end) {
+                size_type i = start;
+                try {
+                    for (; i != end; ++i) {
+                        allocator_access::construct(this->allocator(), &new_ptr[i], other.ptr()[i]);
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ranges.emplace_back(start, end);
+                } catch (...) {
+                    for (size_type j = start; j != i; ++j) {
+                        allocator_access::destroy(this->allocator(), &new_ptr[j]);
+                    }
+                    throw;
+                }
+            };
+            try {
+                parallel_for(n_threads, size_type(0u), size, copier);
+            } catch (...) {
+                for (const auto &r : ranges) {
+                    for (size_type j = r.first; j != r.second; ++j) {
+                        allocator_access::destroy(allocator(), &new_ptr[j]);
+                    }
+                }
+                allocator_access::deallocate(allocator(), new_ptr, size);
+                throw;
+            }
+            ptr() = new_ptr;
+            m_log2_size = other.m_log2_size;
+            m_n_elements = other.m_n_elements;
+        } else {
+            piranha_assert(!other.m_log2_size && !other.m_n_elements);
+        }
+    }
+    /// Move constructor.
+    /**
+     * @param other set to be moved.
+     */
+    flat_hash_set(flat_hash_set &&other) noexcept
+        : m_pack(std::move(other.m_pack)), m_log2_size(other.m_log2_size), m_n_elements(other.m_n_elements),
+          m_concurrent(std::move(other.m_concurrent))
+    {
+        other.ptr() = nullptr;
+        other.m_log2_size = 0u;
+        other.m_n_elements = 0u;
+    }
+    /// Constructor from range.
+    /**
+     * @param begin begin of range.
+     * @param end end of range.
+     * @param n_buckets number of initial buckets.
+     * @param h hash functor.
+     * @param k key equality predicate.
+     *
+     * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum.
+     * @throws unspecified any exception thrown by the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>, or arising
+     * from calling insert() on the elements of the range.
+     */
+    template <typename InputIterator>
+    explicit flat_hash_set(const InputIterator &begin, const InputIterator &end, const size_type &n_buckets = 0u,
+                           const hasher &h = hasher{}, const key_equal &k = key_equal{})
+        : m_pack(nullptr, h, k, allocator_type{}), m_log2_size(0u), m_n_elements(0u)
+    {
+        init_from_n_buckets(n_buckets, 1u);
+        for (auto it = begin; it != end; ++it) {
+            insert(*it);
+        }
+    }
+    /// Constructor from initializer list.
+    /**
+     * @param list initializer list of elements to be inserted.
+     *
+     * @throws std::bad_alloc if the desired number of buckets is greater than an implementation-defined maximum.
+     * @throws unspecified any exception thrown by either insert() or of the default constructor of <tt>Hash</tt> or
+     * <tt>Pred</tt>.
+     */
+    template <typename U>
+    explicit flat_hash_set(std::initializer_list<U> list)
+        : m_pack(nullptr, hasher{}, key_equal{}, allocator_type{}), m_log2_size(0u), m_n_elements(0u)
+    {
+        init_from_n_buckets(
+            static_cast<size_type>(std::ceil(static_cast<double>(list.size()) / max_load_factor())), 1u);
+        for (const auto &x : list) {
+            insert(x);
+        }
+    }
+    /// Destructor.
+    /**
+     * No side effects.
+     */
+    ~flat_hash_set()
+    {
+        piranha_assert(sanity_check());
+        destroy_and_deallocate();
+    }
+    /// Copy assignment operator.
+    /**
+     * @param other assignment argument.
+     *
+     * @return reference to \p this.
+     *
+     * @throws unspecified any exception thrown by the copy constructor.
+     */
+    flat_hash_set &operator=(const flat_hash_set &other)
+    {
+        if (this != &other) [[likely]]
+        {
+            flat_hash_set tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+    /// Move assignment operator.
+    /**
+     * @param other set to be moved into \p this.
+     *
+     * @return reference to \p this.
+     */
+    flat_hash_set &operator=(flat_hash_set &&other) noexcept
+    {
+        if (this != &other) [[likely]]
+        {
+            destroy_and_deallocate();
+            m_pack = std::move(other.m_pack);
+            m_log2_size = other.m_log2_size;
+            m_n_elements = other.m_n_elements;
+            m_concurrent = std::move(other.m_concurrent);
+            other.ptr() = nullptr;
+            other.m_log2_size = 0u;
+            other.m_n_elements = 0u;
+        }
+        return *this;
+    }
+    /// Const begin iterator.
+    /**
+     * @return flat_hash_set::const_iterator to the first element of the set, or end() if the set is empty.
+     */
+    const_iterator begin() const
+    {
+        const_iterator retval;
+        retval.m_set = this;
+        size_type idx = 0u;
+        const auto b_count = bucket_count();
+        for (; idx < b_count; ++idx) {
+            if (!ptr()[idx].empty()) {
+                break;
+            }
+        }
+        retval.m_idx = idx;
+        if (idx != b_count) {
+            retval.m_it = ptr()[idx].begin();
+        }
+        return retval;
+    }
+    /// Const end iterator.
+    /**
+     * @return flat_hash_set::const_iterator to the position past the last element of the set.
+     */
+    const_iterator end() const
+    {
+        return const_iterator(this, bucket_count(), local_iterator{});
+    }
+    /// Begin iterator.
+    /**
+     * @return flat_hash_set::iterator to the first element of the set, or end() if the set is empty.
+     */
+    iterator begin()
+    {
+        return static_cast<flat_hash_set const *>(this)->begin();
+    }
+    /// End iterator.
+    /**
+     * @return flat_hash_set::iterator to the position past the last element of the set.
+     */
+    iterator end()
+    {
+        return static_cast<flat_hash_set const *>(this)->end();
+    }
+    /// Number of elements contained in the set.
+    /**
+     * @return number of elements in the set.
+     */
+    size_type size() const
+    {
+        return m_n_elements;
+    }
+    /// Test for empty set.
+    /**
+     * @return \p true if size() returns 0, \p false otherwise.
+     */
+    bool empty() const
+    {
+        return !size();
+    }
+    /// Number of buckets.
+    /**
+     * @return number of buckets (i.e., of groups of slots) in the set.
+     */
+    size_type bucket_count() const
+    {
+        return (ptr()) ? (size_type(1u) << m_log2_size) : size_type(0u);
+    }
+    /// Load factor.
+    /**
+     * @return <tt>(double)size() / bucket_count()</tt>, or 0 if the set is empty.
+     */
+    double load_factor() const
+    {
+        const auto b_count = bucket_count();
+        return (b_count) ? static_cast<double>(size()) / static_cast<double>(b_count) : 0.;
+    }
+    /// Index of destination bucket.
+    /**
+     * @param k input argument.
+     *
+     * @return index of the destination bucket for \p k.
+     *
+     * @throws std::invalid_argument if bucket_count() returns zero.
+     * @throws unspecified any exception thrown by _bucket().
+     */
+    size_type bucket(const key_type &k) const
+    {
+        if (!bucket_count()) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "cannot calculate bucket index in an empty set");
+        }
+        return _bucket(k);
+    }
+    /// Find element.
+    /**
+     * @param k element to be located.
+     *
+     * @return flat_hash_set::const_iterator to <tt>k</tt>'s position in the set, or end() if \p k is not in the set.
+     *
+     * @throws unspecified any exception thrown by _find() or by _bucket().
+     */
+    const_iterator find(const key_type &k) const
+    {
+        if (!bucket_count()) [[unlikely]]
+        {
+            return end();
+        }
+        return _find(k, _bucket(k));
+    }
+    /// Find element.
+    /**
+     * @param k element to be located.
+     *
+     * @return flat_hash_set::iterator to <tt>k</tt>'s position in the set, or end() if \p k is not in the set.
+     *
+     * @throws unspecified any exception thrown by _find().
+     */
+    iterator find(const key_type &k)
+    {
+        return static_cast<const flat_hash_set *>(this)->find(k);
+    }
+    /// Maximum load factor.
+    /**
+     * @return the maximum load factor allowed before a resize.
+     */
+    double max_load_factor() const
+    {
+        // Half of the slots of a group: the probability of having to use the overflow array
+        // is then below 1% for a well-behaved hash function.
+        return 8.;
+    }
+    /// Insert element.
+    /**
+     * \note
+     * This template method is activated only if \p T and \p U are the same type, aside from cv qualifications and
+     * references.
+     *
+     * Equivalent to piranha::hash_set::insert().
+     *
+     * @param k object that will be inserted into the set.
+     *
+     * @return <tt>(flat_hash_set::iterator,bool)</tt> pair containing an iterator to the newly-inserted object (or its
+     * existing equivalent) and the result of the operation.
+     *
+     * @throws unspecified any exception thrown by:
+     * - flat_hash_set::key_type's copy constructor,
+     * - _find(),
+     * - _bucket().
+     * @throws std::overflow_error if a successful insertion would result in size() exceeding the maximum
+     * value representable by type piranha::flat_hash_set::size_type.
+     * @throws std::bad_alloc if the operation results in a resize of the set past an implementation-defined
+     * maximum number of buckets.
+     */
+    template <typename U, insert_enabler<U> = 0>
+    std::pair<iterator, bool> insert(U &&k)
+    {
+        auto b_count = bucket_count();
+        if (!b_count) [[unlikely]]
+        {
+            _increase_size();
+            b_count = 1u;
+        }
+        const auto h = _hash(k);
+        auto bucket_idx = _bucket_from_hash(h);
+        const auto it = _find(k, bucket_idx, h);
+        if (it != end()) {
+            return std::make_pair(it, false);
+        }
+        if (m_n_elements == std::numeric_limits<size_type>::max()) [[unlikely]]
+        {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        if (static_cast<double>(m_n_elements + size_type(1u)) / static_cast<double>(b_count)
+            > max_load_factor()) [[unlikely]]
+        {
+            _increase_size();
+            bucket_idx = _bucket_from_hash(h);
+        }
+        const auto it_retval = _unique_insert(std::forward<U>(k), bucket_idx, h);
+        ++m_n_elements;
+        return std::make_pair(it_retval, true);
+    }
+    /// Insert a range of elements.
+    /**
+     * \note
+     * This method is enabled only if \p Iterator is a random-access iterator whose reference type is
+     * flat_hash_set::key_type, aside from cv qualifications and references.
+     *
+     * Equivalent to piranha::hash_set::bulk_insert().
+     *
+     * @param begin start of the range.
+     * @param end end of the range.
+     * @param unique flag signalling that the elements of the range are not in the set and are all distinct.
+     * @param n_threads number of threads to use.
+     *
+     * @return the number of elements inserted into the set.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws std::overflow_error if the insertion could result in size() exceeding the maximum
+     * value representable by type piranha::flat_hash_set::size_type.
+     * @throws unspecified any exception thrown by:
+     * - rehash(),
+     * - flat_hash_set::key_type's copy or move constructor,
+     * - _find(),
+     * - _hash(),
+     * - piranha::task_group::run(),
+     * - memory errors in standard containers,
+     * - <tt>boost::numeric_cast()</tt>.
+     */
+    template <typename Iterator, bulk_insert_enabler<Iterator> = 0>
+    size_type bulk_insert(Iterator begin, Iterator end, bool unique = false, unsigned n_threads = 1u)
+    {
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        piranha_assert(!m_concurrent);
+        if (begin == end) {
+            return 0u;
+        }
+        const auto dist = std::distance(begin, end);
+        piranha_assert(dist > 0);
+        if (static_cast<std::make_unsigned_t<decltype(dist)>>(dist)
+            > std::numeric_limits<size_type>::max() - m_n_elements) [[unlikely]]
+        {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        const auto n_final = static_cast<size_type>(m_n_elements + static_cast<size_type>(dist));
+        // Size the set for the final number of elements in one go.
+        if (static_cast<double>(n_final) / static_cast<double>(bucket_count()) > max_load_factor()) {
+            rehash(boost::numeric_cast<size_type>(std::ceil(static_cast<double>(n_final) / max_load_factor())),
+                   n_threads);
+        }
+        auto inserter = [this, unique](size_type &count, const Iterator &it, const std::size_t &h) {
+            const auto idx = this->_bucket_from_hash(h);
+            if (unique) {
+                piranha_assert(this->_find(*it, idx, h) == this->end());
+            } else if (this->_find(*it, idx, h) != this->end()) {
+                return;
+            }
+            this->_unique_insert(*it, idx, h);
+            ++count;
+        };
+        size_type count = 0u;
+        try {
+            for (const auto &c : detail::bucket_partitioned_apply<size_type>(*this, begin, end, n_threads, inserter)) {
+                count = static_cast<size_type>(count + c);
+            }
+        } catch (...) {
+            // The element count is unknown at this point, clear up the set.
+            clear();
+            throw;
+        }
+        m_n_elements = static_cast<size_type>(m_n_elements + count);
+        return count;
+    }
+    /// Erase element.
+    /**
+     * Erase the element to which \p it points. \p it must be a valid iterator
+     * pointing to an element of the set.
+     *
+     * Erasing an element invalidates all iterators pointing to elements in the same bucket
+     * as the erased element.
+     *
+     * After the operation has taken place, the size() of the set will be decreased by one.
+     *
+     * @param it iterator to the element of the set to be removed.
+     *
+     * @return iterator pointing to the element following \p it prior to the element being erased, or end() if
+     * no such element exists.
+     *
+     * @throws unspecified any exception thrown by _erase().
+     */
+    iterator erase(const_iterator it)
+    {
+        piranha_assert(!empty());
+        const auto b_it = _erase(it);
+        iterator retval;
+        retval.m_set = this;
+        const auto b_count = bucket_count();
+        if (b_it == ptr()[it.m_idx].end()) {
+            auto idx = static_cast<size_type>(it.m_idx + 1u);
+            for (; idx < b_count; ++idx) {
+                if (!ptr()[idx].empty()) {
+                    break;
+                }
+            }
+            retval.m_idx = idx;
+            if (idx != b_count) {
+                retval.m_it = ptr()[idx].begin();
+            }
+        } else {
+            retval.m_idx = it.m_idx;
+            retval.m_it = b_it;
+        }
+        piranha_assert(m_n_elements);
+        m_n_elements = static_cast<size_type>(m_n_elements - 1u);
+        return retval;
+    }
+    /// Remove all elements.
+    /**
+     * After this call, size() and bucket_count() will both return zero.
+     */
+    void clear()
+    {
+        destroy_and_deallocate();
+        ptr() = nullptr;
+        m_log2_size = 0u;
+        m_n_elements = 0u;
+        // Terminate any concurrent insertion session.
+        m_concurrent.reset();
+    }
+    /// Swap content.
+    /**
+     * @param other swap argument.
+     *
+     * @throws unspecified any exception thrown by swapping hasher or equality predicate via \p std::swap.
+     */
+    void swap(flat_hash_set &other)
+    {
+        std::swap(m_pack, other.m_pack);
+        std::swap(m_log2_size, other.m_log2_size);
+        std::swap(m_n_elements, other.m_n_elements);
+        m_concurrent.swap(other.m_concurrent);
+    }
+    /// Rehash set.
+    /**
+     * Equivalent to piranha::hash_set::rehash().
+     *
+     * @param new_size new desired number of buckets.
+     * @param n_threads number of threads to use.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by the constructor from number of buckets,
+     * _unique_insert(), _bucket() or piranha::parallel_for().
+     */
+    void rehash(const size_type &new_size, unsigned n_threads = 1u)
+    {
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        if (!new_size) {
+            if (!size()) {
+                clear();
+            }
+            return;
+        }
+        if (static_cast<double>(size()) / static_cast<double>(new_size) > max_load_factor()) {
+            return;
+        }
+        piranha_assert(!m_concurrent);
+        flat_hash_set new_set(new_size, hash(), k_equal(), n_threads);
+        try {
+            if (n_threads == 1u || !size()) {
+                const auto it_f = _m_end();
+                for (auto it = _m_begin(); it != it_f; ++it) {
+                    const auto h = _hash(*it);
+                    new_set._unique_insert(std::move(*it), new_set._bucket_from_hash(h), h);
+                }
+            } else {
+                parallel_migrate(new_set, n_threads);
+            }
+        } catch (...) {
+            clear();
+            new_set.clear();
+            throw;
+        }
+        new_set.m_n_elements = m_n_elements;
+        clear();
+        *this = std::move(new_set);
+    }
+    /// Shrink the bucket array.
+    /**
+     * Equivalent to piranha::hash_set::shrink_to_fit(). The overflow arrays of the groups are rebuilt
+     * during the rehash, so their excess capacity is released as well.
+     *
+     * @param n_threads number of threads to use.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by rehash().
+     */
+    void shrink_to_fit(unsigned n_threads = 1u)
+    {
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        piranha_assert(!m_concurrent);
+        if (!size()) {
+            clear();
+            return;
+        }
+        // Minimum number of groups needed to stay within the maximum load factor.
+        const auto min_size
+            = boost::numeric_cast<size_type>(std::ceil(static_cast<double>(size()) / max_load_factor()));
+        if ((size_type(1u) << get_log2_from_hint(min_size)) < bucket_count()) {
+            rehash(min_size, n_threads);
+        }
+    }
+    /// Test for a pending incremental rehash.
+    /**
+     * The flat hash set does not support the incremental rehash mode of piranha::hash_set, hence this
+     * method is provided only for interface compatibility.
+     *
+     * @return \p false.
+     */
+    bool rehash_in_progress() const
+    {
+        return false;
+    }
+    /// Complete a pending incremental rehash.
+    /**
+     * This method does nothing, and it is provided only for interface compatibility with piranha::hash_set.
+     */
+    void complete_rehash() {}
+    /// Get information on the sparsity of the set.
+    /**
+     * @return an <tt>std::map<size_type,size_type></tt> in which the key is the number of elements
+     * stored in a bucket and the mapped type the number of buckets containing those many elements.
+     *
+     * @throws unspecified any exception thrown by memory errors in standard containers.
+     */
+    std::map<size_type, size_type> evaluate_sparsity() const
+    {
+        const auto it_f = ptr() + bucket_count();
+        std::map<size_type, size_type> retval;
+        for (auto it = ptr(); it != it_f; ++it) {
+            ++retval[it->size()];
+        }
+        return retval;
+    }
+    /// Evaluate the quality of the distribution of the elements.
+    /**
+     * Equivalent to piranha::hash_set::evaluate_hash_quality(). The elements stored out of the inline storage
+     * of the buckets are those in the overflow arrays of the groups.
+     *
+     * @param n_threads number of threads to use.
+     *
+     * @return a report on the distribution of the elements in the set.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by the hash function, piranha::parallel_reduce() or by memory
+     * errors in standard containers.
+     */
+    hash_quality evaluate_hash_quality(unsigned n_threads = 1u) const
+    {
+        return detail::compute_hash_quality(
+            size(), bucket_count(), n_threads, [this](const size_type &i, std::vector<std::size_t> &v) {
+                const auto &g = ptr()[i];
+                const auto it_f = g.end();
+                for (auto it = g.begin(); it != it_f; ++it) {
+                    v.push_back(this->_hash(*it));
+                }
+                return static_cast<size_type>(g.m_overflow.size());
+            });
+    }
+    /** @name Low-level interface
+     * Low-level methods and types, with the same semantics as in piranha::hash_set.
+     */
+    //@{
+    /// Mutable iterator.
+    /**
+     * See piranha::hash_set::_m_iterator.
+     */
+    using _m_iterator = iterator_impl<key_type>;
+    /// Mutable begin iterator.
+    /**
+     * @return flat_hash_set::_m_iterator to the beginning of the set.
+     */
+    _m_iterator _m_begin()
+    {
+        const auto b_count = bucket_count();
+        _m_iterator retval;
+        retval.m_set = this;
+        size_type idx = 0u;
+        for (; idx < b_count; ++idx) {
+            if (!ptr()[idx].empty()) {
+                break;
+            }
+        }
+        retval.m_idx = idx;
+        if (idx != b_count) {
+            retval.m_it = ptr()[idx].begin();
+        }
+        return retval;
+    }
+    /// Mutable end iterator.
+    /**
+     * @return flat_hash_set::_m_iterator to the end of the set.
+     */
+    _m_iterator _m_end()
+    {
+        return _m_iterator(this, bucket_count(), typename group::iterator{});
+    }
+    /// Insert unique element (low-level).
+    /**
+     * \note
+     * This template method is activated only if \p T and \p U are the same type, aside from cv qualifications and
+     * references.
+     *
+     * See piranha::hash_set::_unique_insert().
+     *
+     * @param k object that will be inserted into the set.
+     * @param bucket_idx destination bucket for \p k.
+     *
+     * @return iterator pointing to the newly-inserted element.
+     *
+     * @throws unspecified any exception thrown by the copy constructor of flat_hash_set::key_type, by the call
+     * operator of the hasher or by memory allocation errors.
+     */
+    template <typename U, insert_enabler<U> = 0>
+    iterator _unique_insert(U &&k, const size_type &bucket_idx)
+    {
+        const auto h = _hash(k);
+        return _unique_insert(std::forward<U>(k), bucket_idx, h);
+    }
+    /// Insert unique element with known hash value (low-level).
+    /**
+     * \note
+     * This template method is activated only if \p T and \p U are the same type, aside from cv qualifications and
+     * references.
+     *
+     * See piranha::hash_set::_unique_insert(). The hash value \p h of \p k is used to compute the control byte
+     * of the element.
+     *
+     * @param k object that will be inserted into the set.
+     * @param bucket_idx destination bucket for \p k.
+     * @param h hash value of \p k.
+     *
+     * @return iterator pointing to the newly-inserted element.
+     *
+     * @throws unspecified any exception thrown by the copy constructor of flat_hash_set::key_type or by memory
+     * allocation errors.
+     */
+    template <typename U, insert_enabler<U> = 0>
+    iterator _unique_insert(U &&k, const size_type &bucket_idx, const std::size_t &h)
+    {
+        piranha_assert(find(k) == end());
+        piranha_assert(bucket_idx == _bucket(k) && h == _hash(k));
+        auto &g = ptr()[bucket_idx];
+        const auto pos = g.insert(std::forward<U>(k), h2_from_hash(h));
+        return iterator(this, bucket_idx, local_iterator(&g, pos));
+    }
+    /// Find element (low-level).
+    /**
+     * See piranha::hash_set::_find().
+     *
+     * @param k element to be located.
+     * @param bucket_idx index of the destination bucket for \p k.
+     *
+     * @return flat_hash_set::iterator to <tt>k</tt>'s position in the set, or end() if \p k is not in the set.
+     *
+     * @throws unspecified any exception thrown by calling the hasher or the equality predicate.
+     */
+    const_iterator _find(const key_type &k, const size_type &bucket_idx) const
+    {
+        return _find(k, bucket_idx, _hash(k));
+    }
+    /// Find element with known hash value (low-level).
+    /**
+     * See piranha::hash_set::_find().
+     *
+     * @param k element to be located.
+     * @param bucket_idx index of the destination bucket for \p k.
+     * @param h hash value of \p k.
+     *
+     * @return flat_hash_set::iterator to <tt>k</tt>'s position in the set, or end() if \p k is not in the set.
+     *
+     * @throws unspecified any exception thrown by calling the equality predicate.
+     */
+    const_iterator _find(const key_type &k, const size_type &bucket_idx, const std::size_t &h) const
+    {
+        piranha_assert(bucket_idx == _bucket(k) && bucket_idx < bucket_count() && h == _hash(k));
+        const auto &g = ptr()[bucket_idx];
+        const auto pos = g.find(k, h2_from_hash(h), k_equal());
+        if (pos == g.size()) {
+            return end();
+        }
+        return const_iterator(this, bucket_idx, local_iterator(&g, pos));
+    }
+    /// Hash value (low-level).
+    /**
+     * @param k input argument.
+     *
+     * @return the hash value of \p k, as computed by the hasher of the set.
+     *
+     * @throws unspecified any exception thrown by the call operator of the hasher.
+     */
+    std::size_t _hash(const key_type &k) const
+    {
+        return hash()(k);
+    }
+    /// Index of destination bucket from hash value.
+    /**
+     * Note that this method will not check if the number of buckets is zero.
+     *
+     * @param hash input hash value.
+     *
+     * @return index of the destination bucket for an object with hash value \p hash.
+     */
+    size_type _bucket_from_hash(const std::size_t &hash) const
+    {
+        piranha_assert(bucket_count());
+        return hash % (size_type(1u) << m_log2_size);
+    }
+    /// Index of destination bucket (low-level).
+    /**
+     * @param k input argument.
+     *
+     * @return index of the destination bucket for \p k.
+     *
+     * @throws unspecified any exception thrown by the call operator of the hasher.
+     */
+    size_type _bucket(const key_type &k) const
+    {
+        return _bucket_from_hash(hash()(k));
+    }
+    /// Force update of the number of elements.
+    /**
+     * @param new_size new set size.
+     */
+    void _update_size(const size_type &new_size)
+    {
+        m_n_elements = new_size;
+    }
+    /// Increase bucket count.
+    /**
+     * Equivalent to piranha::hash_set::_increase_size().
+     *
+     * @throws std::bad_alloc if the operation results in a resize of the set past an implementation-defined
+     * maximum number of buckets.
+     * @throws unspecified any exception thrown by rehash() or piranha::thread_pool::use_threads().
+     */
+    void _increase_size()
+    {
+        if (m_log2_size >= m_n_nonzero_sizes - 1u) [[unlikely]]
+        {
+            piranha_throw(std::bad_alloc, );
+        }
+        piranha_assert(ptr() || (!ptr() && !m_log2_size));
+        const auto new_log2_size = (ptr()) ? (m_log2_size + 1u) : 0u;
+        rehash(size_type(1u) << new_log2_size, work_n_threads(size()));
+    }
+    /// Const reference to the group in bucket.
+    /**
+     * The returned object can be iterated over via flat_hash_set::local_iterator, as the list returned by
+     * piranha::hash_set::_get_bucket_list().
+     *
+     * @param idx index of the bucket whose group will be returned.
+     *
+     * @return a const reference to the group of items contained in the bucket positioned
+     * at index \p idx.
+     */
+    const group &_get_bucket_list(const size_type &idx) const
+    {
+        piranha_assert(idx < bucket_count());
+        return ptr()[idx];
+    }
+    /// Erase element.
+    /**
+     * See piranha::hash_set::_erase(). The last element of the bucket is moved into the position
+     * of the erased element.
+     *
+     * @param it iterator to the element of the set to be removed.
+     *
+     * @return local iterator pointing to the element following \p it prior to the element being erased, or local end()
+     * if no such element exists.
+     *
+     * @throws unspecified any exception thrown by the call operator of the hasher.
+     */
+    local_iterator _erase(const_iterator it)
+    {
+        piranha_assert(it.m_set == this);
+        piranha_assert(it.m_idx < bucket_count());
+        piranha_assert(!ptr()[it.m_idx].empty());
+        piranha_assert(it.m_it != ptr()[it.m_idx].end());
+        auto &g = ptr()[it.m_idx];
+        const auto pos = it.m_it.m_pos;
+        if (g.m_overflow.empty()) [[likely]]
+        {
+            // Fill the hole with the last slot.
+            const auto last = static_cast<size_type>(g.m_n - 1u);
+            if (pos != last) {
+                g.slot(pos)->~T();
+                ::new (static_cast<void *>(&g.m_slots[pos])) T(std::move(*g.slot(last)));
+                g.m_ctrl[pos] = g.m_ctrl[last];
+            }
+            g.slot(last)->~T();
+            g.m_ctrl[last] = empty_ctrl;
+            g.m_n = last;
+        } else {
+            // Fill the hole with the last element of the overflow array.
+            auto &last = g.m_overflow.back();
+            if (pos < group_size) {
+                // NOTE: compute the new control byte before touching anything, as the hasher might throw.
+                const auto h2 = h2_from_hash(hash()(last));
+                g.slot(pos)->~T();
+                ::new (static_cast<void *>(&g.m_slots[pos])) T(std::move(last));
+                g.m_ctrl[pos] = h2;
+            } else if (&g.m_overflow[pos - group_size] != &last) {
+                g.m_overflow[pos - group_size] = std::move(last);
+            }
+            g.m_overflow.pop_back();
+        }
+        return local_iterator(&g, pos);
+    }
+
+    /// Concurrent inserter (low-level).
+    /**
+     * Equivalent to piranha::hash_set::_concurrent_inserter.
+     */
+    class _concurrent_inserter
+    {
+    public:
+        /// Constructor.
+        /**
+         * @param s the set into which the elements will be inserted.
+         *
+         * @throws std::invalid_argument if no concurrent insertion session is active in \p s.
+         */
+        explicit _concurrent_inserter(flat_hash_set &s) : m_set(s), m_count(0u)
+        {
+            if (!s.m_concurrent) [[unlikely]]
+            {
+                piranha_throw(std::invalid_argument, "no concurrent insertion session is active");
+            }
+        }
+        /// Deleted copy constructor.
+        _concurrent_inserter(const _concurrent_inserter &) = delete;
+        /// Deleted move constructor.
+        _concurrent_inserter(_concurrent_inserter &&) = delete;
+        /// Deleted copy assignment.
+        _concurrent_inserter &operator=(const _concurrent_inserter &) = delete;
+        /// Deleted move assignment.
+        _concurrent_inserter &operator=(_concurrent_inserter &&) = delete;
+        /// Destructor.
+        /**
+         * Adds the number of elements inserted by \p this to the shared counter of the session.
+         */
+        ~_concurrent_inserter()
+        {
+            if (m_set.m_concurrent) {
+                m_set.m_concurrent->m_count.fetch_add(m_count, std::memory_order_relaxed);
+            }
+        }
+        /// Insert or accumulate.
+        /**
+         * Equivalent to piranha::hash_set::_concurrent_inserter::insert().
+         *
+         * @param k the element to be inserted.
+         * @param c the combiner.
+         *
+         * @return \p true if \p k was inserted, \p false if it was combined with an existing element.
+         *
+         * @throws unspecified any exception thrown by _unique_insert(), _find(), _hash() or by the combiner.
+         */
+        template <typename U, typename Combiner, insert_enabler<U> = 0>
+        bool insert(U &&k, const Combiner &c)
+        {
+            auto &st = *m_set.m_concurrent;
+            const auto h = m_set._hash(k);
+            const auto bucket_idx = m_set._bucket_from_hash(h);
+            detail::atomic_lock_guard lock(st.m_locks[static_cast<std::size_t>(bucket_idx & st.m_mask)]);
+            const auto it = m_set._find(k, bucket_idx, h);
+            if (it == m_set.end()) {
+                m_set._unique_insert(std::forward<U>(k), bucket_idx, h);
+                ++m_count;
+                return true;
+            }
+            c(*it, std::forward<U>(k));
+            return false;
+        }
+
+    private:
+        flat_hash_set &m_set;
+        size_type m_count;
+    };
+    /// Begin a concurrent insertion session.
+    /**
+     * Equivalent to piranha::hash_set::_concurrent_begin().
+     *
+     * @throws std::invalid_argument if the set has no buckets or if a concurrent insertion session is already active.
+     * @throws unspecified any exception thrown by memory allocation errors.
+     */
+    void _concurrent_begin()
+    {
+        if (!bucket_count()) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument,
+                          "cannot begin a concurrent insertion session in a set with no buckets");
+        }
+        if (m_concurrent) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "a concurrent insertion session is already active");
+        }
+        m_concurrent.reset(new concurrent_state(std::min(bucket_count(), m_max_n_locks)));
+    }
+    /// End a concurrent insertion session.
+    /**
+     * Equivalent to piranha::hash_set::_concurrent_end().
+     *
+     * @throws std::invalid_argument if no concurrent insertion session is active.
+     * @throws std::overflow_error if the new size overflows the maximum value representable by size_type.
+     */
+    void _concurrent_end()
+    {
+        if (!m_concurrent) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "no concurrent insertion session is active");
+        }
+        const auto count = m_concurrent->m_count.load();
+        m_concurrent.reset();
+        if (count > std::numeric_limits<size_type>::max() - m_n_elements) [[unlikely]]
+        {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        m_n_elements = static_cast<size_type>(m_n_elements + count);
+    }
+    //@}
+private:
+    pack_type m_pack;
+    size_type m_log2_size;
+    size_type m_n_elements;
+    std::unique_ptr<concurrent_state> m_concurrent;
+};
+
+template <typename T, typename Hash, typename Pred>
+const typename flat_hash_set<T, Hash, Pred>::size_type flat_hash_set<T, Hash, Pred>::m_n_nonzero_sizes;
+
+#if defined(PIRANHA_WITH_BOOST_S11N)
+
+inline namespace impl
+{
+
+// Enablers for boost s11n.
+template <typename Archive, typename T, typename Hash, typename Pred>
+using flat_hash_set_boost_save_enabler
+    = enable_if_t<conjunction<has_boost_save<Archive, T>,
+                              has_boost_save<Archive, typename flat_hash_set<T, Hash, Pred>::size_type>>::value>;
+
+template <typename Archive, typename T, typename Hash, typename Pred>
+using flat_hash_set_boost_load_enabler
+    = enable_if_t<conjunction<has_boost_load<Archive, T>,
+                              has_boost_load<Archive, typename flat_hash_set<T, Hash, Pred>::size_type>>::value>;
+}
+
+/// Specialisation of piranha::boost_save() for piranha::flat_hash_set.
+/**
+ * \note
+ * This specialisation is enabled only if \p T and the size type of piranha::flat_hash_set satisfy
+ * piranha::has_boost_save.
+ *
+ * The format is the same as for piranha::hash_set.
+ *
+ * @throws unspecified any exception thrown by piranha::boost_save().
+ */
+template <typename Archive, typename T, typename Hash, typename Pred>
+struct boost_save_impl<Archive, flat_hash_set<T, Hash, Pred>, flat_hash_set_boost_save_enabler<Archive, T, Hash, Pred>>
+    : boost_save_via_boost_api<Archive, flat_hash_set<T, Hash, Pred>> {
+};
+
+/// Specialisation of piranha::boost_load() for piranha::flat_hash_set.
+/**
+ * \note
+ * This specialisation is enabled only if \p T and the size type of piranha::flat_hash_set satisfy
+ * piranha::has_boost_load.
+ *
+ * The behaviour is the same as for piranha::hash_set.
+ *
+ * @throws std::invalid_argument if a duplicate element is encountered during deserialization.
+ * @throws unspecified any exception thrown by:
+ * - the public interface of piranha::flat_hash_set,
+ * - piranha::boost_load(),
+ * - <tt>boost::numeric_cast()</tt>.
+ */
+template <typename Archive, typename T, typename Hash, typename Pred>
+struct boost_load_impl<Archive, flat_hash_set<T, Hash, Pred>, flat_hash_set_boost_load_enabler<Archive, T, Hash, Pred>>
+    : boost_load_via_boost_api<Archive, flat_hash_set<T, Hash, Pred>> {
+};
+
+#endif
+
+#if defined(PIRANHA_WITH_MSGPACK)
+
+inline namespace impl
+{
+
+// Enablers for msgpack s11n.
+template <typename Stream, typename T>
+using flat_hash_set_msgpack_pack_enabler
+    = enable_if_t<conjunction<is_msgpack_stream<Stream>, has_msgpack_pack<Stream, T>>::value>;
+
+template <typename T>
+using flat_hash_set_msgpack_convert_enabler = enable_if_t<has_msgpack_convert<T>::value>;
+}
+
+/// Specialisation of piranha::msgpack_pack() for piranha::flat_hash_set.
+/**
+ * \note
+ * This specialisation is enabled only if
+ * - \p Stream satisfies piranha::is_msgpack_stream,
+ * - \p T satisfies piranha::has_msgpack_pack,
+ * - the size type of piranha::flat_hash_set is safely convertible to \p std::uint32_t.
+ */
+template <typename Stream, typename T, typename Hash, typename Pred>
+struct msgpack_pack_impl<Stream, flat_hash_set<T, Hash, Pred>, flat_hash_set_msgpack_pack_enabler<Stream, T>> {
+    /// Call operator.
+    /**
+     * The msgpack representation of a piranha::flat_hash_set is the same as for piranha::hash_set.
+     *
+     * @param p the target packer.
+     * @param h the piranha::flat_hash_set that will be serialized.
+     * @param f the desired piranha::msgpack_format.
+     *
+     * @throws unspecified any exception thrown by:
+     * - the public interface of <tt>msgpack::packer</tt>,
+     * - piranha::safe_cast(),
+     * - piranha::msgpack_pack().
+     */
+    void operator()(msgpack::packer<Stream> &p, const flat_hash_set<T, Hash, Pred> &h, msgpack_format f) const
+    {
+        msgpack_pack_range(p, h.begin(), h.end(), h.size(), f);
+    }
+};
+
+/// Specialisation of piranha::msgpack_convert() for piranha::flat_hash_set.
+/**
+ * \note
+ * This specialisation is enabled only if \p T satisfies piranha::has_msgpack_convert.
+ */
+template <typename T, typename Hash, typename Pred>
+struct msgpack_convert_impl<flat_hash_set<T, Hash, Pred>, flat_hash_set_msgpack_convert_enabler<T>> {
+    /// Call operator.
+    /**
+     * The behaviour is the same as for piranha::hash_set.
+     *
+     * @param h the target piranha::flat_hash_set.
+     * @param o the source <tt>msgpack::object</tt>.
+     * @param f the desired piranha::msgpack_format.
+     *
+     * @throws std::invalid_argument if a duplicate element is encountered during deserialization.
+     * @throws unspecified any exception thrown by:
+     * - the public interface of piranha::flat_hash_set and <tt>msgpack::object</tt>,
+     * - <tt>boost::numeric_cast()</tt>,
+     * - piranha::msgpack_convert().
+     */
+    void operator()(flat_hash_set<T, Hash, Pred> &h, const msgpack::object &o, msgpack_format f) const
+    {
+        h = flat_hash_set<T, Hash, Pred>{};
+        std::vector<msgpack::object> items;
+        o.convert(items);
+        h.rehash(boost::numeric_cast<typename flat_hash_set<T, Hash, Pred>::size_type>(
+            std::ceil(static_cast<double>(items.size()) / h.max_load_factor())));
+        for (const auto &obj : items) {
+            T tmp;
+            msgpack_convert(tmp, obj, f);
+            const auto p = h.insert(std::move(tmp));
+            if (unlikely(!p.second)) {
+                piranha_throw(std::invalid_argument, "while deserializing a flat_hash_set from a msgpack object "
+                                                     "a duplicate value was encountered");
+            }
+        }
+    }
+};
+
+#endif
+}
+
+#endif
@@ -0,0 +1,242 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_HASH_QUALITY_HPP
+#define PIRANHA_HASH_QUALITY_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <piranha/config.hpp>
+#include <piranha/exceptions.hpp>
+#include <piranha/parallel.hpp>
+
+namespace piranha
+{
+
+/// Hash quality report.
+/**
+ * This structure describes how the elements of a hash table (e.g., piranha::hash_set or piranha::flat_hash_set) are
+ * distributed among its buckets, and it is returned by methods such as piranha::hash_set::evaluate_hash_quality()
+ * and piranha::series::table_hash_quality().
+ *
+ * The bucket of an element is determined by reducing its hash value modulo the number of buckets, which is always
+ * a power of two. Two elements can then end up in the same bucket either because their hash values are identical,
+ * or because their hash values differ only in the bits discarded by the reduction. The two kinds of collisions are
+ * reported separately: a hash function which is injective on the stored elements (e.g., the hash of
+ * piranha::kronecker_monomial, which is the Kronecker code itself) will have no hash collisions, but
+ * it can still produce many reduction collisions if the codes are clustered (e.g., if they differ only
+ * in their high bits).
+ *
+ * The report also contains the number of occupied buckets that a uniformly-distributed hash function would produce
+ * on average, which is used by is_degenerate() to flag pathological distributions.
+ */
+struct hash_quality {
+    /// Number of elements in the table.
+    std::size_t m_n_elements = 0u;
+    /// Number of buckets in the table.
+    std::size_t m_n_buckets = 0u;
+    /// Number of nonempty buckets.
+    std::size_t m_n_occupied = 0u;
+    /// Expected number of nonempty buckets for a uniformly-distributed hash function.
+    double m_expected_occupied = 0.;
+    /// Maximum number of elements in a bucket.
+    std::size_t m_max_chain = 0u;
+    /// Average number of elements in the nonempty buckets.
+    double m_mean_chain = 0.;
+    /// Number of elements stored out of the inline storage of the buckets.
+    /**
+     * These are the elements stored in the overflow nodes of piranha::hash_set, or in the overflow arrays
+     * of piranha::flat_hash_set. Accessing them requires at least one additional indirection.
+     */
+    std::size_t m_n_overflow = 0u;
+    /// Number of distinct hash values.
+    std::size_t m_n_distinct_hashes = 0u;
+    /// Mask of the bits which are not constant across the hash values of the elements.
+    std::size_t m_varying_bits = 0u;
+    /// Number of collisions due to identical hash values.
+    /**
+     * @return the number of elements minus the number of distinct hash values.
+     */
+    std::size_t hash_collisions() const
+    {
+        return m_n_elements - m_n_distinct_hashes;
+    }
+    /// Number of collisions due to the reduction of the hash values modulo the number of buckets.
+    /**
+     * @return the number of distinct hash values minus the number of nonempty buckets.
+     */
+    std::size_t reduction_collisions() const
+    {
+        return m_n_distinct_hashes - m_n_occupied;
+    }
+    /// Share of the elements stored out of the inline storage of the buckets.
+    /**
+     * @return <tt>m_n_overflow / m_n_elements</tt>, or zero if the table is empty.
+     */
+    double overflow_share() const
+    {
+        return m_n_elements ? static_cast<double>(m_n_overflow) / static_cast<double>(m_n_elements) : 0.;
+    }
+    /// Number of constant index bits.
+    /**
+     * @return the number of bits used in the computation of the bucket index (i.e., the lowest
+     * <tt>log2(m_n_buckets)</tt> bits) which have the same value in the hash values of all the elements.
+     */
+    unsigned constant_index_bits() const
+    {
+        if (!m_n_buckets) {
+            return 0u;
+        }
+        return static_cast<unsigned>(std::popcount(~m_varying_bits & (m_n_buckets - 1u)));
+    }
+    /// Detect degenerate hash distributions.
+    /**
+     * The distribution of the elements is flagged as degenerate if either:
+     * - the number of nonempty buckets is less than half the expected value for a uniformly-distributed hash
+     *   function, or
+     * - the table contains at least \p m_n_buckets elements (so that, for a uniformly-distributed hash function,
+     *   all the index bits are expected to vary) and constant_index_bits() is not zero.
+     *
+     * @return \p true if the distribution of the elements in the table is degenerate, \p false otherwise.
+     */
+    bool is_degenerate() const
+    {
+        return static_cast<double>(m_n_occupied) < m_expected_occupied / 2.
+               || (m_n_elements > 1u && m_n_elements >= m_n_buckets && constant_index_bits());
+    }
+};
+
+/// Stream operator for piranha::hash_quality.
+/**
+ * Will print a human-readable summary of \p hq to \p os.
+ *
+ * @param os target stream.
+ * @param hq the report to be printed.
+ *
+ * @return a reference to \p os.
+ *
+ * @throws unspecified any exception thrown by the streaming operators of \p os.
+ */
+inline std::ostream &operator<<(std::ostream &os, const hash_quality &hq)
+{
+    os << "Elements             : " << hq.m_n_elements << '\n';
+    os << "Buckets              : " << hq.m_n_buckets << '\n';
+    os << "Occupied buckets     : " << hq.m_n_occupied << " (expected: " << hq.m_expected_occupied << ")\n";
+    os << "Max chain length     : " << hq.m_max_chain << '\n';
+    os << "Mean chain length    : " << hq.m_mean_chain << '\n';
+    os << "Overflow share       : " << hq.overflow_share() << '\n';
+    os << "Hash collisions      : " << hq.hash_collisions() << '\n';
+    os << "Reduction collisions : " << hq.reduction_collisions() << '\n';
+    os << "Constant index bits  : " << hq.constant_index_bits() << '\n';
+    os << "Degenerate           : " << (hq.is_degenerate() ? "yes" : "no") << '\n';
+    return os;
+}
+
+namespace detail
+{
+
+// Compute the hash quality report of a table with n_elements elements and b_count buckets, using n_threads threads,
+// each examining ranges of buckets. bucket_f(i, v) must append to v the hash values of the elements in
+// the bucket at index i, and return how many of them are stored out of the inline storage of the bucket.
+// NOTE: the hash values in different buckets are necessarily distinct, so the distinct hash values can be counted
+// separately for each range.
+template <typename F>
+inline hash_quality compute_hash_quality(std::size_t n_elements, std::size_t b_count, unsigned n_threads,
+                                         const F &bucket_f)
+{
+    if (n_threads == 0u) [[unlikely]]
+    {
+        piranha_throw(std::invalid_argument, "invalid number of threads");
+    }
+    hash_quality retval;
+    retval.m_n_elements = n_elements;
+    retval.m_n_buckets = b_count;
+    if (!b_count) {
+        return retval;
+    }
+    // The probability that a bucket stays empty is (1 - 1 / b_count)**n_elements.
+    const auto b = static_cast<double>(b_count), n = static_cast<double>(n_elements);
+    retval.m_expected_occupied = n_elements ? -b * std::expm1(n * std::log1p(-1. / b)) : 0.;
+    struct partial {
+        std::size_t m_occupied = 0u;
+        std::size_t m_max_chain = 0u;
+        std::size_t m_overflow = 0u;
+        std::size_t m_distinct = 0u;
+        std::size_t m_or = 0u;
+        std::size_t m_and = std::numeric_limits<std::size_t>::max();
+    };
+    auto range_function = [&bucket_f](std::size_t start, std::size_t end) {
+        partial p;
+        std::vector<std::size_t> hashes, tmp;
+        for (auto i = start; i != end; ++i) {
+            tmp.clear();
+            p.m_overflow += bucket_f(i, tmp);
+            if (tmp.empty()) {
+                continue;
+            }
+            ++p.m_occupied;
+            p.m_max_chain = std::max(p.m_max_chain, tmp.size());
+            for (const auto &h : tmp) {
+                p.m_or |= h;
+                p.m_and &= h;
+            }
+            hashes.insert(hashes.end(), tmp.begin(), tmp.end());
+        }
+        std::sort(hashes.begin(), hashes.end());
+        p.m_distinct = static_cast<std::size_t>(std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+        return p;
+    };
+    auto merge = [](partial p1, const partial &p2) {
+        p1.m_occupied += p2.m_occupied;
+        p1.m_max_chain = std::max(p1.m_max_chain, p2.m_max_chain);
+        p1.m_overflow += p2.m_overflow;
+        p1.m_distinct += p2.m_distinct;
+        p1.m_or |= p2.m_or;
+        p1.m_and &= p2.m_and;
+        return p1;
+    };
+    const auto p = parallel_reduce(n_threads, std::size_t(0u), b_count, partial{}, range_function, merge);
+    retval.m_n_occupied = p.m_occupied;
+    retval.m_max_chain = p.m_max_chain;
+    retval.m_n_overflow = p.m_overflow;
+    retval.m_n_distinct_hashes = p.m_distinct;
+    retval.m_varying_bits = n_elements ? (p.m_or & ~p.m_and) : 0u;
+    retval.m_mean_chain = retval.m_n_occupied ? n / static_cast<double>(retval.m_n_occupied) : 0.;
+    return retval;
+}
+}
+}
+
+#endif
@@ -31,6 +31,8 @@ see https://www.gnu.org/licenses/. */
 #ifndef PIRANHA_HASH_SET_HPP
 #define PIRANHA_HASH_SET_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <cmath>
@@ -38,9 +40,11 @@ see https://www.gnu.org/licenses/. */
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <stdexcept>
 #include <string>
@@ -50,17 +54,58 @@ see https://www.gnu.org/licenses/. */
 #include <vector>
 
 #include <piranha/config.hpp>
+#include <piranha/detail/atomic_flag_array.hpp>
+#include <piranha/detail/atomic_lock_guard.hpp>
+#include <piranha/detail/bucket_partitioned_apply.hpp>
 #include <piranha/detail/debug_access.hpp>
 #include <piranha/detail/init.hpp>
+#include <piranha/detail/node_pool.hpp>
 #include <piranha/exceptions.hpp>
+#include <piranha/hash_quality.hpp>
+#include <piranha/parallel.hpp>
 #include <piranha/s11n.hpp>
 #include <piranha/safe_cast.hpp>
+#include <piranha/settings.hpp>
 #include <piranha/thread_pool.hpp>
 #include <piranha/type_traits.hpp>
 
 namespace piranha
 {
 
+/// Hash caching selector for piranha::hash_set.
+/**
+ * If the value of this type trait is \p true, piranha::hash_set will store the hash value of each element
+ * of type \p T (as computed by \p Hash) alongside the element itself. The stored hash values are then used
+ * when rehashing (so that the elements are never hashed again) and when looking up elements (so that the
+ * equality predicate is invoked only on elements with a matching hash value), at the price of an additional
+ * \p std::size_t per element.
+ *
+ * The default implementation has a value of \p false. It can be specialised for types whose hash value
+ * is expensive to compute.
+ */
+template <typename T, typename Hash, typename = void>
+struct hash_set_cache_hash : std::false_type {
+};
+
+inline namespace impl
+{
+
+// Storage for the hash value in the nodes of a hash_set.
+template <bool>
+struct hash_set_node_hash {
+    void set_hash(const std::size_t &) {}
+};
+
+template <>
+struct hash_set_node_hash<true> {
+    void set_hash(const std::size_t &h)
+    {
+        m_hash = h;
+    }
+    std::size_t m_hash;
+};
+}
+
 /// Hash set.
 /**
  * Hash set class with interface similar to \p std::unordered_set. The main points of difference with respect to
@@ -69,12 +114,15 @@ namespace piranha
  * - the exception safety guarantee is weaker (see below),
  * - iterators and iterator invalidation: after a rehash operation, all iterators will be invalidated and existing
  *   references/pointers to the elements will also be invalid; after an insertion/erase operation, all existing
- *   iterators, pointers and references to the elements in the destination bucket will be invalid,
+ *   iterators, pointers and references to the elements in the destination bucket will be invalid (in incremental
+ *   rehash mode, an insertion can migrate elements between buckets, and it hence invalidates all iterators),
  * - the complexity of iterator traversal depends on the load factor of the table.
  *
  * The implementation employs a separate chaining strategy consisting of an array of buckets, each one a singly linked
  * list with the first node stored directly within the array (so that the first insertion in a bucket does not require
- * any heap allocation).
+ * any heap allocation). The other nodes are drawn from a pool owned by the set, which allocates memory in large slabs,
+ * recycles the nodes of erased elements and frees all its memory at once when the set is cleared or destroyed. Each
+ * thread inserting into the set via the low-level interface draws nodes from its own sub-pool.
  *
  * An additional set of low-level methods is provided: such methods are suitable for use in high-performance and
  * multi-threaded contexts, and, if misused, could lead to data corruption and other unpredictable errors.
@@ -82,6 +130,15 @@ namespace piranha
  * Note that for performance reasons the implementation employs sizes that are powers of two. Hence, particular care
  * should be taken that the hash function does not exhibit commensurabilities with powers of 2.
  *
+ * If piranha::hash_set_cache_hash is specialised to \p true for \p T and \p Hash, the hash value of each element is
+ * stored alongside it.
+ *
+ * The set can optionally operate in incremental rehash mode (see set_incremental_rehash()). In this mode, when the
+ * maximum load factor is exceeded the elements are not migrated all at once into a larger bucket array: the old
+ * array is kept alive alongside the new one, and each insertion migrates a small, fixed number of old buckets. Lookups
+ * and iteration take into account both arrays, so that the cost of a resize is spread over many insertions rather
+ * than paid in a single pause.
+ *
  * ## Type requirements ##
  *
  * - \p T must satisfy piranha::is_container_element,
@@ -126,8 +183,10 @@ class hash_set
     // Make friend with debug access class.
     template <typename U>
     friend class debug_access;
+    // Hash caching flag.
+    static constexpr bool cache_hash = hash_set_cache_hash<T, Hash>::value;
     // Node class for bucket element.
-    struct node {
+    struct node : hash_set_node_hash<cache_hash> {
         typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_type;
         node() : m_next(nullptr) {}
         // Erase all other ctors/assignments, we do not want to
@@ -169,6 +228,8 @@ class hash_set
         storage_type m_storage;
         node *m_next;
     };
+    // Pool for the nodes of the lists past the first one.
+    using pool_type = detail::node_pool<node>;
     // List constituting the bucket.
     // NOTE: in this list implementation the m_next pointer is used as a flag to signal if the current node
     // stores an item: the pointer is not null if it does contain something. The value of m_next pointer in a node is
@@ -223,12 +284,20 @@ class hash_set
         PIRANHA_TT_CHECK(is_forward_iterator, iterator);
         PIRANHA_TT_CHECK(is_forward_iterator, const_iterator);
         list() : m_node() {}
-        list(list &&other) noexcept : m_node()
+        // NOTE: the nodes past the first one belong to the pool of the set, so lists can be neither
+        // copied nor moved around on their own.
+        list(const list &) = delete;
+        list(list &&) = delete;
+        list &operator=(const list &) = delete;
+        list &operator=(list &&) = delete;
+        ~list()
         {
-            steal_from_rvalue(std::move(other));
+            destroy();
         }
-        list(const list &other) : m_node()
+        // Copy the content of other into this, which must be empty, drawing the new nodes from pool.
+        void copy_from(const list &other, pool_type &pool)
         {
+            piranha_assert(empty());
             try {
                 auto cur = &m_node;
                 auto other_cur = &other.m_node;
@@ -239,15 +308,22 @@ class hash_set
                         piranha_assert(cur->m_next == &terminator);
                         // Create a new node with content equal to other_cur
                         // and linking forward to the terminator.
-                        std::unique_ptr<node> new_node(::new node());
-                        ::new (static_cast<void *>(&new_node->m_storage)) T(*other_cur->ptr());
+                        auto new_node = pool.allocate();
+                        try {
+                            ::new (static_cast<void *>(&new_node->m_storage)) T(*other_cur->ptr());
+                        } catch (...) {
+                            pool.deallocate(new_node);
+                            throw;
+                        }
+                        copy_hash(*new_node, *other_cur);
                         new_node->m_next = &terminator;
                         // Link the new node.
-                        cur->m_next = new_node.release();
+                        cur->m_next = new_node;
                         cur = cur->m_next;
                     } else {
                         // This means this is the first node.
                         ::new (static_cast<void *>(&cur->m_storage)) T(*other_cur->ptr());
+                        copy_hash(*cur, *other_cur);
                         cur->m_next = &terminator;
                     }
                     other_cur = other_cur->m_next;
@@ -257,56 +333,36 @@ class hash_set
                 throw;
             }
         }
-        list &operator=(list &&other)
+        // Copy the cached hash value, if any.
+        static void copy_hash(node &to, const node &from)
         {
-            if (this != &other) [[likely]]{
-                // Destroy the content of this.
-                destroy();
-                steal_from_rvalue(std::move(other));
-            }
-            return *this;
-        }
-        list &operator=(const list &other)
-        {
-            if (this != &other) [[likely]]{
-                auto tmp = other;
-                *this = std::move(tmp);
-            }
-            return *this;
-        }
-        ~list()
-        {
-            destroy();
-        }
-        void steal_from_rvalue(list &&other)
-        {
-            piranha_assert(empty());
-            // Do something only if there is content in the other.
-            if (other.m_node.m_next) {
-                // Move construct current first node with first node of other.
-                ::new (static_cast<void *>(&m_node.m_storage)) T(std::move(*other.m_node.ptr()));
-                // Link remaining content of other into this.
-                m_node.m_next = other.m_node.m_next;
-                // Destroy first node of other.
-                other.m_node.ptr()->~T();
-                other.m_node.m_next = nullptr;
+            if constexpr (cache_hash) {
+                to.m_hash = from.m_hash;
             }
-            piranha_assert(other.empty());
+            (void)to;
+            (void)from;
         }
         template <typename U, enable_if_t<std::is_same<T, uncvref_t<U>>::value, int> = 0>
-        node *insert(U &&item)
+        node *insert(U &&item, const std::size_t &h, pool_type &pool)
         {
             // NOTE: optimize with likely/unlikely?
             if (m_node.m_next) {
                 // Create the new node and forward-link it to the second node.
-                std::unique_ptr<node> new_node(::new node());
-                ::new (static_cast<void *>(&new_node->m_storage)) T(std::forward<U>(item));
+                auto new_node = pool.allocate();
+                try {
+                    ::new (static_cast<void *>(&new_node->m_storage)) T(std::forward<U>(item));
+                } catch (...) {
+                    pool.deallocate(new_node);
+                    throw;
+                }
+                new_node->set_hash(h);
                 new_node->m_next = m_node.m_next;
                 // Link first node to the new node.
-                m_node.m_next = new_node.release();
+                m_node.m_next = new_node;
                 return m_node.m_next;
             } else {
                 ::new (static_cast<void *>(&m_node.m_storage)) T(std::forward<U>(item));
+                m_node.set_hash(h);
                 m_node.m_next = &terminator;
                 return &m_node;
             }
@@ -331,6 +387,8 @@ class hash_set
         {
             return !m_node.m_next;
         }
+        // NOTE: this destroys the payloads but it does not give the nodes back to the pool, whose
+        // memory is released all at once when the set is cleared or destroyed.
         void destroy()
         {
             node *cur = &m_node;
@@ -342,10 +400,6 @@ class hash_set
                 // Destroy the old payload and erase connections.
                 old->ptr()->~T();
                 old->m_next = nullptr;
-                // If the old node was not the initial one, delete it.
-                if (old != &m_node) {
-                    ::delete old;
-                }
             }
             // After destruction, the list should be equivalent to a default-constructed one.
             piranha_assert(empty());
@@ -403,6 +457,15 @@ private:
     {
         return std::get<2u>(m_pack);
     }
+    // Hash value of the element stored in a node: the cached one, if available.
+    std::size_t node_hash(const node &n) const
+    {
+        if constexpr (cache_hash) {
+            return n.m_hash;
+        } else {
+            return hash()(*n.ptr());
+        }
+    }
     allocator_type &allocator()
     {
         return std::get<3u>(m_pack);
@@ -429,21 +492,20 @@ private:
         void increment()
         {
             piranha_assert(m_set);
-            auto &container = m_set->ptr();
             // Assert that the current iterator is valid.
-            piranha_assert(m_idx < m_set->bucket_count());
-            piranha_assert(!container[m_idx].empty());
-            piranha_assert(m_it != container[m_idx].end());
+            piranha_assert(m_idx < m_set->v_bucket_count());
+            piranha_assert(!m_set->v_bucket(m_idx).empty());
+            piranha_assert(m_it != m_set->v_bucket(m_idx).end());
             ++m_it;
-            if (m_it == container[m_idx].end()) {
-                const size_type container_size = m_set->bucket_count();
+            if (m_it == m_set->v_bucket(m_idx).end()) {
+                const size_type container_size = m_set->v_bucket_count();
                 while (true) {
                     ++m_idx;
                     if (m_idx == container_size) {
                         m_it = it_type{};
                         return;
-                    } else if (!container[m_idx].empty()) {
-                        m_it = container[m_idx].begin();
+                    } else if (!m_set->v_bucket(m_idx).empty()) {
+                        m_it = m_set->v_bucket(m_idx).begin();
                         return;
                     }
                 }
@@ -458,7 +520,7 @@ private:
         }
         Key &dereference() const
         {
-            piranha_assert(m_set && m_idx < m_set->bucket_count() && m_it != m_set->ptr()[m_idx].end());
+            piranha_assert(m_set && m_idx < m_set->v_bucket_count() && m_it != m_set->v_bucket(m_idx).end());
             return *m_it;
         }
 
@@ -467,6 +529,15 @@ private:
         size_type m_idx;
         it_type m_it;
     };
+    // Number of threads to be used for an operation on n elements. The thread pool is queried (which involves
+    // a global lock) only if the work is large enough to be split among at least two threads.
+    static unsigned work_n_threads(const size_type &n)
+    {
+        const auto min_work = settings::get_min_work_per_thread();
+        return (static_cast<unsigned long long>(n) / 2u >= min_work)
+                   ? thread_pool::use_threads(static_cast<unsigned long long>(n), min_work)
+                   : 1u;
+    }
     void init_from_n_buckets(const size_type &n_buckets, unsigned n_threads)
     {
         piranha_assert(!ptr() && !m_log2_size && !m_n_elements);
@@ -495,39 +566,31 @@ private:
                 allocator_access::construct(allocator(), &new_ptr[i]);
             }
         } else {
-            // Sync variables.
-            using crs_type = std::vector<std::pair<size_type, size_type>>;
-            crs_type constructed_ranges(static_cast<typename crs_type::size_type>(n_threads),
-                                        std::make_pair(size_type(0u), size_type(0u)));
-            if (constructed_ranges.size() != n_threads) [[unlikely]]
-            {
-                piranha_throw(std::bad_alloc, );
-            }
-
-            // Thread function.
-            auto thread_function = [this, new_ptr, &constructed_ranges](const size_type &start, const size_type &end,
-                                                                        const unsigned &thread_idx) {
+            // The ranges constructed so far, for rolling back.
+            std::mutex mutex;
+            std::vector<std::pair<size_type, size_type>> constructed_ranges;
+            auto constructor = [this, new_ptr, &mutex, &constructed_ranges](const size_type &start,
+                                                                            const size_type &end) {
+                // NOTE: the construction is noexcept, only the recording of the range can throw.
                 for (size_type i = start; i != end; ++i) {
                     allocator_access::construct(this->allocator(), &new_ptr[i]);
                 }
-                constructed_ranges[thread_idx] = std::make_pair(start, end);
+                try {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    constructed_ranges.emplace_back(start, end);
+                } catch (...) {
+                    for (size_type i = start; i != end; ++i) {
+                        allocator_access::destroy(this->allocator(), &new_ptr[i]);
+                    }
+                    throw;
+                }
             };
-            // Work per thread.
-            const auto wpt = size / n_threads;
-            future_list<decltype(thread_function(0u, 0u, 0u))> f_list;
             try {
-                for (unsigned i = 0u; i < n_threads; ++i) {
-                    const auto start = static_cast<size_type>(wpt * i),
-                               end = static_cast<size_type>((i == n_threads - 1u) ? size : wpt * (i + 1u));
-                    f_list.push_back(thread_pool::enqueue(i, thread_function, start, end, i));
-                }
-                f_list.wait_all();
-                // NOTE: no need to get_all() here, as we know no exceptions will be generated inside thread_func.
+                constructed_ranges.reserve(n_threads);
+                // NOTE: contiguous partitioning, so that each thread touches first its own part of the array.
+                parallel_for(n_threads, size_type(0u), size, constructor, size_type(1u), partitioning::contiguous);
             } catch (...) {
-                // NOTE: everything in thread_func is noexcept, if we are here the exception was thrown by enqueue or
-                // push_back.
-                // Wait for everything to wind down.
-                f_list.wait_all();
+                // NOTE: if we are here, all the participants have finished.
                 // Destroy what was constructed.
                 for (const auto &r : constructed_ranges) {
                     for (size_type i = r.first; i != r.second; ++i) {
@@ -558,6 +621,19 @@ private:
         } else {
             piranha_assert(!m_log2_size && !m_n_elements);
         }
+        // Same for the old bucket array of a pending incremental rehash.
+        if (m_old_ptr) {
+            const size_type old_size = size_type(1u) << m_old_log2_size;
+            for (size_type i = 0u; i < old_size; ++i) {
+                allocator_access::destroy(allocator(), &m_old_ptr[i]);
+            }
+            allocator_access::deallocate(allocator(), m_old_ptr, old_size);
+            m_old_ptr = nullptr;
+            m_old_log2_size = 0u;
+            m_n_migrated = 0u;
+        }
+        // Free in one go the memory of all the nodes of the lists.
+        m_pool.release();
     }
 #if defined(PIRANHA_WITH_BOOST_S11N)
     // Serialization support.
@@ -595,13 +671,34 @@ private:
     // Enabler for insert().
     template <typename U>
     using insert_enabler = enable_if_t<std::is_same<key_type, uncvref_t<U>>::value, int>;
+    // Enabler for bulk_insert().
+    template <typename Iterator>
+    using bulk_insert_enabler = enable_if_t<
+        conjunction<std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Iterator>::iterator_category>,
+                    std::is_same<key_type, uncvref_t<typename std::iterator_traits<Iterator>::reference>>>::value,
+        int>;
     // Run a consistency check on the set, will return false if something is wrong.
     bool sanity_check() const
     {
         size_type count = 0u;
-        for (size_type i = 0u; i < bucket_count(); ++i) {
-            for (auto it = ptr()[i].begin(); it != ptr()[i].end(); ++it) {
-                if (_bucket(*it) != i) {
+        const size_type b_count = bucket_count();
+        for (size_type i = 0u; i < v_bucket_count(); ++i) {
+            for (auto it = v_bucket(i).begin(); it != v_bucket(i).end(); ++it) {
+                if (i < b_count) {
+                    if (_bucket(*it) != i) {
+                        return false;
+                    }
+                } else {
+                    // The elements in the old bucket array must be in a bucket that has not been migrated yet,
+                    // and in the correct one.
+                    const auto old_idx = static_cast<size_type>(i - b_count);
+                    if (old_idx < m_n_migrated || hash()(*it) % (size_type(1u) << m_old_log2_size) != old_idx) {
+                        return false;
+                    }
+                }
+                // The cached hash value must be up to date.
+                if (node_hash(*it.m_ptr) != hash()(*it)) {
                     return false;
                 }
                 ++count;
@@ -618,6 +715,11 @@ private:
         if (!ptr() && (m_log2_size || m_n_elements)) {
             return false;
         }
+        // An incremental rehash can be in progress only towards a larger bucket array.
+        if (m_old_ptr
+            && (!ptr() || m_old_log2_size >= m_log2_size || m_n_migrated >= (size_type(1u) << m_old_log2_size))) {
+            return false;
+        }
         // Check size is consistent with number of iterator traversals.
         count = 0u;
         for (auto it = begin(); it != end(); ++it, ++count) {
@@ -643,6 +745,163 @@ private:
         piranha_throw(std::bad_alloc, );
     }
 
+    // Number of old buckets migrated by each insertion during an incremental rehash.
+    // NOTE: the new array has twice as many buckets as the old one, hence at the beginning of an incremental
+    // rehash there is room for about as many insertions as there are old buckets before the next resize. With a
+    // few buckets per insertion, the migration will be over well before that.
+    static constexpr size_type m_incremental_rehash_step = 4u;
+    // Maximum number of locks used during concurrent insertions.
+    static constexpr size_type m_max_n_locks = size_type(1u) << 20u;
+    // State of a concurrent insertion session: the striped locks protecting the buckets and the number
+    // of elements inserted so far by the inserters which have been destroyed.
+    struct concurrent_state {
+        explicit concurrent_state(const size_type &n_locks)
+            : m_locks(static_cast<std::size_t>(n_locks)), m_mask(static_cast<size_type>(n_locks - 1u)), m_count(0u)
+        {
+        }
+        detail::atomic_flag_array m_locks;
+        const size_type m_mask;
+        std::atomic<size_type> m_count;
+    };
+    // Move the elements of this into new_set using n_threads threads.
+    // NOTE: the bucket counts are powers of two and the destination bucket is the hash value reduced modulo
+    // the bucket count, hence the elements of a source bucket with index i can end up only in destination buckets
+    // whose index is congruent to i modulo the smaller of the two bucket counts (and vice versa). By assigning to
+    // each thread a range of residues, no two threads will ever touch the same source or destination bucket.
+    void parallel_migrate(hash_set &new_set, unsigned n_threads)
+    {
+        const size_type old_count = bucket_count(), n_res = std::min(old_count, new_set.bucket_count());
+        piranha_assert(n_threads > 1u && n_res);
+        // The threads access the bucket arrays directly, hence no incremental rehash can be pending.
+        piranha_assert(!m_old_ptr && !new_set.m_old_ptr);
+        auto thread_function = [this, &new_set, old_count, n_res](const size_type &start, const size_type &end) {
+            for (size_type r = start; r != end; ++r) {
+                for (size_type i = r; i < old_count; i += n_res) {
+                    auto &l = ptr()[i];
+                    const auto it_f = l.end();
+                    for (auto it = l.begin(); it != it_f; ++it) {
+                        const auto h = this->node_hash(*it.m_ptr);
+                        new_set._unique_insert(std::move(*it), new_set._bucket_from_hash(h), h);
+                    }
+                }
+            }
+        };
+        // NOTE: the cost of a residue depends on the occupation of its buckets, hence adaptive partitioning.
+        parallel_for(n_threads, size_type(0u), n_res, thread_function);
+    }
+
+    // Number of buckets addressable by the iterators: the virtual indices past bucket_count() refer
+    // to the old bucket array of a pending incremental rehash.
+    size_type v_bucket_count() const
+    {
+        return m_old_ptr ? static_cast<size_type>(bucket_count() + (size_type(1u) << m_old_log2_size))
+                         : bucket_count();
+    }
+    // Bucket with virtual index idx.
+    list &v_bucket(const size_type &idx) const
+    {
+        const auto b_count = bucket_count();
+        piranha_assert(idx < v_bucket_count());
+        return (idx < b_count) ? ptr()[idx] : m_old_ptr[idx - b_count];
+    }
+    // Start an incremental rehash towards a new bucket array of size 2**new_log2_size.
+    void begin_incremental_rehash(const size_type &new_log2_size)
+    {
+        piranha_assert(ptr() && new_log2_size > m_log2_size);
+        complete_migration();
+        const size_type size = size_type(1u) << new_log2_size;
+        auto new_ptr = allocator_access::allocate(allocator(), size);
+        if (!new_ptr) [[unlikely]]
+        {
+            piranha_throw(std::bad_alloc, );
+        }
+        for (size_type i = 0u; i < size; ++i) {
+            allocator_access::construct(allocator(), &new_ptr[i]);
+        }
+        m_old_ptr = ptr();
+        m_old_log2_size = m_log2_size;
+        m_n_migrated = 0u;
+        ptr() = new_ptr;
+        m_log2_size = new_log2_size;
+    }
+    // Move the elements of the old bucket with index i into the new bucket array.
+    // NOTE: the nodes are unlinked from the old list as soon as their content has been moved, so that each element
+    // is always in exactly one of the two arrays, even if an exception is thrown.
+    void migrate_bucket(const size_type &i)
+    {
+        auto &l = m_old_ptr[i];
+        // First the elements past the first one, whose nodes are given back to the pool.
+        while (l.m_node.m_next && l.m_node.m_next != &list::terminator) {
+            const auto n = l.m_node.m_next;
+            const auto h = node_hash(*n);
+            ptr()[_bucket_from_hash(h)].insert(std::move(*n->ptr()), h, m_pool);
+            l.m_node.m_next = n->m_next;
+            n->ptr()->~T();
+            m_pool.deallocate(n);
+        }
+        // Then the element stored in the array.
+        if (!l.empty()) {
+            const auto h = node_hash(l.m_node);
+            ptr()[_bucket_from_hash(h)].insert(std::move(*l.m_node.ptr()), h, m_pool);
+            l.m_node.ptr()->~T();
+            l.m_node.m_next = nullptr;
+        }
+    }
+    // Migrate up to n buckets of a pending incremental rehash, deallocating the old bucket array at the end
+    // of the migration.
+    void migrate_buckets(const size_type &n)
+    {
+        piranha_assert(m_old_ptr);
+        const size_type old_size = size_type(1u) << m_old_log2_size;
+        const size_type end = (old_size - m_n_migrated > n) ? static_cast<size_type>(m_n_migrated + n) : old_size;
+        for (; m_n_migrated != end; ++m_n_migrated) {
+            migrate_bucket(m_n_migrated);
+        }
+        if (m_n_migrated == old_size) {
+            allocator_type a(allocator());
+            for (size_type i = 0u; i < old_size; ++i) {
+                allocator_access::destroy(a, &m_old_ptr[i]);
+            }
+            allocator_access::deallocate(a, m_old_ptr, old_size);
+            m_old_ptr = nullptr;
+            m_old_log2_size = 0u;
+            m_n_migrated = 0u;
+        }
+    }
+    // Complete a pending incremental rehash, if any.
+    void complete_migration()
+    {
+        if (m_old_ptr) [[unlikely]]
+        {
+            migrate_buckets(static_cast<size_type>((size_type(1u) << m_old_log2_size) - m_n_migrated));
+        }
+    }
+    // Apply f to the nodes of the bucket with index i as if a pending incremental rehash had been completed, that is,
+    // including the nodes of the old bucket array which would be migrated into the bucket i.
+    // NOTE: the set is not modified, hence this can be used by concurrent readers.
+    template <typename F>
+    void bucket_apply(const size_type &i, const F &f) const
+    {
+        const auto &l = ptr()[i];
+        for (auto it = l.begin(); it != l.end(); ++it) {
+            f(*it.m_ptr);
+        }
+        if (m_old_ptr) [[unlikely]]
+        {
+            // The elements of the new bucket i can come only from the old bucket whose index is i reduced modulo
+            // the old bucket count.
+            const auto j = static_cast<size_type>(i % (size_type(1u) << m_old_log2_size));
+            if (j >= m_n_migrated) {
+                const auto &ol = m_old_ptr[j];
+                for (auto it = ol.begin(); it != ol.end(); ++it) {
+                    if (_bucket_from_hash(node_hash(*it.m_ptr)) == i) {
+                        f(*it.m_ptr);
+                    }
+                }
+            }
+        }
+    }
+
 public:
     /// Iterator type.
     /**
@@ -696,7 +955,7 @@ public:
      * @throws std::invalid_argument if \p n_threads is zero.
      * @throws unspecified any exception thrown by:
      * - the copy constructors of <tt>Hash</tt> or <tt>Pred</tt>,
-     * - piranha::thread_pool::enqueue() or piranha::future_list::push_back(), if \p n_threads is not 1.
+     * - piranha::parallel_for(), if \p n_threads is not 1.
      */
     explicit hash_set(const size_type &n_buckets, const hasher &h = hasher{}, const key_equal &k = key_equal{},
                       unsigned n_threads = 1u)
@@ -706,35 +965,77 @@ public:
     }
     /// Copy constructor.
     /**
-     * The hasher, the equality comparator and the allocator will also be copied.
+     * The hasher, the equality comparator and the allocator will also be copied. If \p other contains at least
+     * twice the minimum work per thread given by piranha::settings::get_min_work_per_thread(), the buckets
+     * will be copied in parallel, using the number of threads suggested by piranha::thread_pool::use_threads()
+     * for a work size equal to the number of elements. Otherwise, the copy is performed in the calling thread
+     * without querying the thread pool. If an incremental rehash is in progress in \p other, the copy
+     * will store all the elements in its bucket array. The incremental rehash mode is copied as well.
      *
      * @param other piranha::hash_set that will be copied into \p this.
      *
      * @throws unspecified any exception thrown by memory allocation errors,
-     * the copy constructor of the stored type, <tt>Hash</tt> or <tt>Pred</tt>.
+     * the copy constructor of the stored type, <tt>Hash</tt> or <tt>Pred</tt>, piranha::thread_pool::use_threads()
+     * or piranha::parallel_for().
      */
     hash_set(const hash_set &other)
-        : m_pack(nullptr, other.hash(), other.k_equal(), other.allocator()), m_log2_size(0u), m_n_elements(0u)
+        : m_pack(nullptr, other.hash(), other.k_equal(), other.allocator()), m_log2_size(0u), m_n_elements(0u),
+          m_incremental(other.m_incremental)
     {
         // Proceed to actual copy only if other has some content.
         if (other.ptr())
         {
             const size_type size = size_type(1u) << other.m_log2_size;
+            const unsigned n_threads = work_n_threads(other.size());
+            // The ranges of buckets constructed so far, for rolling back.
+            std::mutex mutex;
+            std::vector<std::pair<size_type, size_type>> ranges;
             auto new_ptr = allocator_access::allocate(allocator(), size);
             if (!new_ptr) [[unlikely]]
             {
                 piranha_throw(std::bad_alloc, );
             }
-            size_type i = 0u;
+            // Copy-construct the buckets in the [start, end) range. On failure, the range is rolled back locally,
+            // otherwise it is recorded in ranges.
+            auto copier = [this, new_ptr, &other, &mutex, &ranges](const size_type &start, const size_type &end) {
+                size_type i = start;
+                try {
+                    for (; i != end; ++i) {
+                        allocator_access::construct(this->allocator(), &new_ptr[i]);
+                        new_ptr[i].copy_from(other.ptr()[i], this->m_pool);
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ranges.emplace_back(start, end);
+                } catch (...) {
+                    // NOTE: if copy_from() failed, the i-th bucket was constructed and it is left empty.
+                    const auto last = (i == end) ? end : static_cast<size_type>(i + 1u);
+                    for (size_type j = start; j != last; ++j) {
+                        allocator_access::destroy(this->allocator(), &new_ptr[j]);
+                    }
+                    throw;
+                }
+            };
             try {
-                // Copy-construct the elements of the array.
-                for (; i < size; ++i) {
-                    allocator_access::construct(allocator(), &new_ptr[i], other.ptr()[i]);
+                parallel_for(n_threads, size_type(0u), size, copier);
+                // Fold the elements still in the old bucket array of an incremental rehash into the new buckets.
+                if (other.m_old_ptr) {
+                    const size_type old_size = size_type(1u) << other.m_old_log2_size;
+                    for (size_type i = other.m_n_migrated; i < old_size; ++i) {
+                        const auto &l = other.m_old_ptr[i];
+                        const auto it_f = l.end();
+                        for (auto it = l.begin(); it != it_f; ++it) {
+                            const auto h = other.node_hash(*it.m_ptr);
+                            new_ptr[h % size].insert(*it, h, m_pool);
+                        }
+                    }
                 }
             } catch (...) {
+                // NOTE: if we are here, all the participants have finished.
                 // Unwind the construction and deallocate, before re-throwing.
-                for (size_type j = 0u; j < i; ++j) {
-                    allocator_access::destroy(allocator(), &new_ptr[j]);
+                for (const auto &r : ranges) {
+                    for (size_type j = r.first; j != r.second; ++j) {
+                        allocator_access::destroy(allocator(), &new_ptr[j]);
+                    }
                 }
                 allocator_access::deallocate(allocator(), new_ptr, size);
                 throw;
@@ -754,17 +1055,23 @@ public:
     /// Move constructor.
     /**
      * After the move, \p other will have zero buckets and zero elements, and its hasher and equality predicate
-     * will have been used to move-construct their counterparts in \p this.
+     * will have been used to move-construct their counterparts in \p this. A pending incremental rehash is
+     * transferred to \p this, together with the incremental rehash mode.
      *
      * @param other set to be moved.
      */
     hash_set(hash_set &&other) noexcept
-        : m_pack(std::move(other.m_pack)), m_log2_size(other.m_log2_size), m_n_elements(other.m_n_elements)
+        : m_pack(std::move(other.m_pack)), m_log2_size(other.m_log2_size), m_n_elements(other.m_n_elements),
+          m_pool(std::move(other.m_pool)), m_concurrent(std::move(other.m_concurrent)), m_old_ptr(other.m_old_ptr),
+          m_old_log2_size(other.m_old_log2_size), m_n_migrated(other.m_n_migrated), m_incremental(other.m_incremental)
     {
         // Clear out the other one.
         other.ptr() = nullptr;
         other.m_log2_size = 0u;
         other.m_n_elements = 0u;
+        other.m_old_ptr = nullptr;
+        other.m_old_log2_size = 0u;
+        other.m_n_migrated = 0u;
     }
     /// Constructor from range.
     /**
@@ -850,10 +1157,19 @@ public:
             m_pack = std::move(other.m_pack);
             m_log2_size = other.m_log2_size;
             m_n_elements = other.m_n_elements;
+            m_concurrent = std::move(other.m_concurrent);
+            m_pool = std::move(other.m_pool);
+            m_old_ptr = other.m_old_ptr;
+            m_old_log2_size = other.m_old_log2_size;
+            m_n_migrated = other.m_n_migrated;
+            m_incremental = other.m_incremental;
             // Zero out other.
             other.ptr() = nullptr;
             other.m_log2_size = 0u;
             other.m_n_elements = 0u;
+            other.m_old_ptr = nullptr;
+            other.m_old_log2_size = 0u;
+            other.m_n_migrated = 0u;
         }
         return *this;
     }
@@ -870,16 +1186,16 @@ public:
         const_iterator retval;
         retval.m_set = this;
         size_type idx = 0u;
-        const auto b_count = bucket_count();
+        const auto b_count = v_bucket_count();
         for (; idx < b_count; ++idx) {
-            if (!ptr()[idx].empty()) {
+            if (!v_bucket(idx).empty()) {
                 break;
             }
         }
         retval.m_idx = idx;
         // If we are not at the end, assign proper iterator.
         if (idx != b_count) {
-            retval.m_it = ptr()[idx].begin();
+            retval.m_it = v_bucket(idx).begin();
         }
         return retval;
     }
@@ -891,7 +1207,7 @@ public:
      */
     const_iterator end() const
     {
-        return const_iterator(this, bucket_count(), local_iterator{});
+        return const_iterator(this, v_bucket_count(), local_iterator{});
     }
 
 
@@ -1061,8 +1377,9 @@ public:
             b_count = 1u;
         }
         // Try to locate the element.
-        auto bucket_idx = _bucket(k);
-        const auto it = _find(k, bucket_idx);
+        const auto h = _hash(k);
+        auto bucket_idx = _bucket_from_hash(h);
+        const auto it = _find(k, bucket_idx, h);
         if (it != end()) {
             // Item already present, exit.
             return std::make_pair(it, false);
@@ -1078,15 +1395,108 @@ public:
         {
             _increase_size();
             // We need a new bucket index in case of a rehash.
-            bucket_idx = _bucket(k);
+            bucket_idx = _bucket_from_hash(h);
         }
 
-        const auto it_retval = _unique_insert(std::forward<U>(k), bucket_idx);
+        _rehash_step();
+        const auto it_retval = _unique_insert(std::forward<U>(k), bucket_idx, h);
         ++m_n_elements;
         return std::make_pair(it_retval, true);
     }
 
 
+    /// Insert a range of elements.
+    /**
+     * \note
+     * This method is enabled only if \p Iterator is a random-access iterator whose reference type is
+     * hash_set::key_type, aside from cv qualifications and references.
+     *
+     * The elements in the range [\p begin, \p end) are inserted into the set with the same result as calling
+     * insert() on each of them in order, but the set is resized at most once, so that it can accommodate size()
+     * plus the size of the range without exceeding the maximum load factor. If \p n_threads is not 1, the elements
+     * are first partitioned in parallel according to their destination bucket, and then the first \p n_threads
+     * threads from piranha::thread_pool insert them, each taking care of a separate range of buckets.
+     * The elements of the range are copied or moved depending on the reference type of \p Iterator (e.g.,
+     * <tt>std::move_iterator</tt> can be used to move them into the set).
+     *
+     * If \p unique is \p true, the elements of the range are assumed to be distinct from each other and from the
+     * elements already in the set, and they are inserted without any lookup. The behaviour is undefined if this
+     * assumption does not hold.
+     *
+     * A pending incremental rehash is completed before the insertion.
+     *
+     * If any exception is thrown, the set will be left empty.
+     *
+     * @param begin start of the range.
+     * @param end end of the range.
+     * @param unique flag signalling that the elements of the range are not in the set and are all distinct.
+     * @param n_threads number of threads to use.
+     *
+     * @return the number of elements inserted into the set.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws std::overflow_error if the insertion could result in size() exceeding the maximum
+     * value representable by type piranha::hash_set::size_type.
+     * @throws unspecified any exception thrown by:
+     * - rehash(),
+     * - hash_set::key_type's copy or move constructor,
+     * - _find(),
+     * - _hash(),
+     * - piranha::task_group::run(),
+     * - memory errors in standard containers,
+     * - <tt>boost::numeric_cast()</tt>.
+     */
+    template <typename Iterator, bulk_insert_enabler<Iterator> = 0>
+    size_type bulk_insert(Iterator begin, Iterator end, bool unique = false, unsigned n_threads = 1u)
+    {
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        piranha_assert(!m_concurrent);
+        if (begin == end) {
+            return 0u;
+        }
+        // The elements are partitioned according to the buckets of a single array.
+        complete_migration();
+        const auto dist = std::distance(begin, end);
+        piranha_assert(dist > 0);
+        if (static_cast<std::make_unsigned_t<decltype(dist)>>(dist)
+            > std::numeric_limits<size_type>::max() - m_n_elements) [[unlikely]]
+        {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        const auto n_final = static_cast<size_type>(m_n_elements + static_cast<size_type>(dist));
+        // Size the set for the final number of elements in one go.
+        if (static_cast<double>(n_final) / static_cast<double>(bucket_count()) > max_load_factor()) {
+            rehash(boost::numeric_cast<size_type>(std::ceil(static_cast<double>(n_final) / max_load_factor())),
+                   n_threads);
+        }
+        auto inserter = [this, unique](size_type &count, const Iterator &it, const std::size_t &h) {
+            const auto idx = this->_bucket_from_hash(h);
+            if (unique) {
+                piranha_assert(this->_find(*it, idx, h) == this->end());
+            } else if (this->_find(*it, idx, h) != this->end()) {
+                return;
+            }
+            this->_unique_insert(*it, idx, h);
+            ++count;
+        };
+        size_type count = 0u;
+        try {
+            for (const auto &c : detail::bucket_partitioned_apply<size_type>(*this, begin, end, n_threads, inserter)) {
+                count = static_cast<size_type>(count + c);
+            }
+        } catch (...) {
+            // The element count is unknown at this point, clear up the set.
+            clear();
+            throw;
+        }
+        m_n_elements = static_cast<size_type>(m_n_elements + count);
+        return count;
+    }
+
+
     /// Erase element.
     /**
      * Erase the element to which \p it points. \p it must be a valid iterator
@@ -1108,25 +1518,25 @@ public:
         const auto b_it = _erase(it);
         iterator retval;
         retval.m_set = this;
-        const auto b_count = bucket_count();
-        if (b_it == ptr()[it.m_idx].end()) {
+        const auto b_count = v_bucket_count();
+        if (b_it == v_bucket(it.m_idx).end()) {
             // Travel to the next iterator if the deleted element was
             // the last one in the bucket.
             auto idx = static_cast<size_type>(it.m_idx + 1u);
             // Advance to the first non-empty bucket if necessary,
             // without going past the end of the set.
             for (; idx < b_count; ++idx) {
-                if (!ptr()[idx].empty()) {
+                if (!v_bucket(idx).empty()) {
                     break;
                 }
             }
             retval.m_idx = idx;
             // If we are not at the end, assign proper iterator.
             if (idx != b_count) {
-                retval.m_it = ptr()[idx].begin();
+                retval.m_it = v_bucket(idx).begin();
             }
             // NOTE: in case we reached the end of the container, the end() iterator should be:
-            // {this,bucket_count,local_iterator{}}
+            // {this,v_bucket_count,local_iterator{}}
             // this has been set above already, bucket_count is set by retval.m_idx = idx
             // and the default local_iterator ctor is called by the def ctor of iterator.
         } else {
@@ -1143,7 +1553,7 @@ public:
 
     /// Remove all elements.
     /**
-     * After this call, size() and bucket_count() will both return zero.
+     * After this call, size() and bucket_count() will both return zero. The incremental rehash mode is not altered.
      */
     void clear()
     {
@@ -1152,6 +1562,8 @@ public:
         ptr() = nullptr;
         m_log2_size = 0u;
         m_n_elements = 0u;
+        // Terminate any concurrent insertion session.
+        m_concurrent.reset();
     }
 
 
@@ -1168,6 +1580,12 @@ public:
         std::swap(m_pack, other.m_pack);
         std::swap(m_log2_size, other.m_log2_size);
         std::swap(m_n_elements, other.m_n_elements);
+        m_pool.swap(other.m_pool);
+        m_concurrent.swap(other.m_concurrent);
+        std::swap(m_old_ptr, other.m_old_ptr);
+        std::swap(m_old_log2_size, other.m_old_log2_size);
+        std::swap(m_n_migrated, other.m_n_migrated);
+        std::swap(m_incremental, other.m_incremental);
     }
 
 
@@ -1176,14 +1594,15 @@ public:
      * Change the number of buckets in the set to at least \p new_size. No rehash is performed
      * if rehashing would lead to exceeding the maximum load factor. If \p n_threads is not 1,
      * then the first \p n_threads threads from piranha::thread_pool will be used concurrently during
-     * the rehash operation.
+     * the rehash operation, both for the initialisation of the new buckets and for the migration of
+     * the elements into them. A pending incremental rehash is completed before anything else.
      *
      * @param new_size new desired number of buckets.
      * @param n_threads number of threads to use.
      *
      * @throws std::invalid_argument if \p n_threads is zero.
      * @throws unspecified any exception thrown by the constructor from number of buckets,
-     * _unique_insert() or _bucket().
+     * _unique_insert(), _bucket() or piranha::parallel_for().
      */
     void rehash(const size_type &new_size, unsigned n_threads = 1u)
     {
@@ -1191,6 +1610,7 @@ public:
         {
             piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
         }
+        complete_migration();
         // If rehash is requested to zero, do something only if there are no items stored in the set.
         if (!new_size) {
             if (!size()) {
@@ -1204,13 +1624,19 @@ public:
             return;
         }
 
+        // Rehashing is not allowed during concurrent insertions.
+        piranha_assert(!m_concurrent);
         // Create a new set with needed amount of buckets.
         hash_set new_set(new_size, hash(), k_equal(), n_threads);
         try {
-            const auto it_f = _m_end();
-            for (auto it = _m_begin(); it != it_f; ++it) {
-                const auto new_idx = new_set._bucket(*it);
-                new_set._unique_insert(std::move(*it), new_idx);
+            if (n_threads == 1u || !size()) {
+                const auto it_f = _m_end();
+                for (auto it = _m_begin(); it != it_f; ++it) {
+                    const auto h = node_hash(*it.m_it.m_ptr);
+                    new_set._unique_insert(std::move(*it), new_set._bucket_from_hash(h), h);
+                }
+            } else {
+                parallel_migrate(new_set, n_threads);
             }
         } catch (...) {
             // Clear up both this and the new set upon any kind of error.
@@ -1218,8 +1644,9 @@ public:
             new_set.clear();
             throw;
         }
-        // Retain the number of elements.
+        // Retain the number of elements and the rehash mode.
         new_set.m_n_elements = m_n_elements;
+        new_set.m_incremental = m_incremental;
         // Clear the old set.
         clear();
         // Assign the new set.
@@ -1227,29 +1654,150 @@ public:
     }
 
 
+    /// Shrink the bucket array.
+    /**
+     * Reduce the number of buckets to the minimum implementation-defined value which does not lead to exceeding
+     * the maximum load factor. If the set is empty, this method is equivalent to clear(). Otherwise, if the
+     * bucket count can be reduced, the elements are migrated to a smaller bucket array via rehash(), using
+     * \p n_threads threads. The memory held by the overflow nodes of the old buckets is returned to the allocator.
+     * If the bucket count cannot be reduced, this method has no effect.
+     *
+     * This method is useful to reclaim memory after most of the elements of a large set have been erased.
+     *
+     * @param n_threads number of threads to use.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by rehash().
+     */
+    void shrink_to_fit(unsigned n_threads = 1u)
+    {
+        if (!n_threads) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "the number of threads must be strictly positive");
+        }
+        piranha_assert(!m_concurrent);
+        if (!size()) {
+            clear();
+            return;
+        }
+        // Minimum number of buckets needed to stay within the maximum load factor.
+        const auto min_size
+            = boost::numeric_cast<size_type>(std::ceil(static_cast<double>(size()) / max_load_factor()));
+        if ((size_type(1u) << get_log2_from_hint(min_size)) < bucket_count()) {
+            rehash(min_size, n_threads);
+        }
+    }
+
+
+    /// Set the incremental rehash mode.
+    /**
+     * In incremental rehash mode, the growth of the set triggered by an insertion does not migrate all the elements
+     * at once into the new bucket array. The old bucket array is instead kept alive alongside the new one, and each
+     * subsequent call to insert() (or to _rehash_step()) migrates a small, fixed number of old buckets, until the old
+     * array is empty and can be deallocated. This bounds the cost of any single insertion, at the price of slightly
+     * slower lookups while a rehash is in progress. Explicit calls to rehash() are never incremental. The low-level
+     * methods never migrate buckets: before any concurrent use of the low-level interface, a pending incremental
+     * rehash must be completed via complete_rehash().
+     *
+     * If \p flag is \p false, a pending incremental rehash is completed.
+     *
+     * @param flag \p true to enable the incremental rehash mode, \p false to disable it.
+     *
+     * @throws unspecified any exception thrown by complete_rehash().
+     */
+    void set_incremental_rehash(bool flag)
+    {
+        if (!flag) {
+            complete_rehash();
+        }
+        m_incremental = flag;
+    }
+
+
+    /// Get the incremental rehash mode.
+    /**
+     * @return \p true if the incremental rehash mode is enabled, \p false otherwise.
+     */
+    bool get_incremental_rehash() const
+    {
+        return m_incremental;
+    }
+
+
+    /// Test for a pending incremental rehash.
+    /**
+     * @return \p true if an incremental rehash is in progress, \p false otherwise.
+     */
+    bool rehash_in_progress() const
+    {
+        return m_old_ptr != nullptr;
+    }
+
+
+    /// Complete a pending incremental rehash.
+    /**
+     * Migrate all the remaining buckets of a pending incremental rehash, if any, and deallocate the old bucket array.
+     * This can be used to pay the remaining cost of the migration at a convenient time, and it must be called
+     * before accessing the set concurrently via the low-level interface.
+     *
+     * @throws unspecified any exception thrown by the move constructor of hash_set::key_type or by memory allocation
+     * errors. In such case, the elements which have not been migrated yet are left in the old bucket array.
+     */
+    void complete_rehash()
+    {
+        complete_migration();
+    }
+
+
     /// Get information on the sparsity of the set.
     /**
      * @return an <tt>std::map<size_type,size_type></tt> in which the key is the number of elements
      * stored in a bucket and the mapped type the number of buckets containing those many elements.
+     * A pending incremental rehash is accounted for as if it had been completed.
      *
-     * @throws unspecified any exception thrown by memory errors in standard containers.
+     * @throws unspecified any exception thrown by memory errors in standard containers or, during an incremental
+     * rehash, by the hash function.
      */
     std::map<size_type, size_type> evaluate_sparsity() const
     {
-        const auto it_f = ptr() + bucket_count();
+        const auto b_count = bucket_count();
         std::map<size_type, size_type> retval;
         size_type counter;
-        for (auto it = ptr(); it != it_f; ++it) {
+        for (size_type i = 0u; i < b_count; ++i) {
             counter = 0u;
-            for (auto l_it = it->begin(); l_it != it->end(); ++l_it) {
-                ++counter;
-            }
+            bucket_apply(i, [&counter](const auto &) { ++counter; });
             ++retval[counter];
         }
         return retval;
     }
 
 
+    /// Evaluate the quality of the distribution of the elements.
+    /**
+     * This method will examine the buckets of the set and return a piranha::hash_quality report about the
+     * distribution of the elements. The elements stored in the overflow nodes are those which are not the
+     * first element of their bucket. If \p n_threads is not 1, then the first \p n_threads threads from
+     * piranha::thread_pool will be used concurrently, each examining a range of buckets. A pending incremental
+     * rehash is accounted for as if it had been completed.
+     *
+     * @param n_threads number of threads to use.
+     *
+     * @return a report on the distribution of the elements in the set.
+     *
+     * @throws std::invalid_argument if \p n_threads is zero.
+     * @throws unspecified any exception thrown by the hash function, piranha::parallel_reduce() or by memory errors
+     * in standard containers.
+     */
+    hash_quality evaluate_hash_quality(unsigned n_threads = 1u) const
+    {
+        return detail::compute_hash_quality(
+            size(), bucket_count(), n_threads, [this](const size_type &i, std::vector<std::size_t> &v) {
+                this->bucket_apply(i, [this, &v](const auto &n) { v.push_back(this->node_hash(n)); });
+                return v.empty() ? size_type(0u) : static_cast<size_type>(v.size() - 1u);
+            });
+    }
+
+
     /** @name Low-level interface
      * Low-level methods and types.
      */
@@ -1272,19 +1820,19 @@ public:
     {
         // NOTE: this could take a while in case of an empty set with lots of buckets. Take a shortcut
         // taking into account the number of elements in the set - if zero, go directly to end()?
-        const auto b_count = bucket_count();
+        const auto b_count = v_bucket_count();
         _m_iterator retval;
         retval.m_set = this;
         size_type idx = 0u;
         for (; idx < b_count; ++idx) {
-            if (!ptr()[idx].empty()) {
+            if (!v_bucket(idx).empty()) {
                 break;
             }
         }
         retval.m_idx = idx;
         // If we are not at the end, assign proper iterator.
         if (idx != b_count) {
-            retval.m_it = ptr()[idx].begin();
+            retval.m_it = v_bucket(idx).begin();
         }
         return retval;
     }
@@ -1296,7 +1844,7 @@ public:
      */
     _m_iterator _m_end()
     {
-        return _m_iterator(this, bucket_count(), typename list::iterator{});
+        return _m_iterator(this, v_bucket_count(), typename list::iterator{});
     }
 
 
@@ -1313,7 +1861,9 @@ public:
      * This method will not check if a key equivalent to \p k already exists in the set, it will not
      * update the number of elements present in the set after the insertion, it will not resize
      * the set in case the maximum load factor is exceeded, nor it will check
-     * if the value of \p bucket_idx is correct.
+     * if the value of \p bucket_idx is correct. If an incremental rehash is in progress, \p k is inserted into the
+     * new bucket array and no bucket of the old array is migrated (see _rehash_step()), hence concurrent insertions
+     * into distinct buckets are safe.
      *
      * @param k object that will be inserted into the set.
      * @param bucket_idx destination bucket for \p k.
@@ -1325,12 +1875,44 @@ public:
      */
     template <typename U, insert_enabler<U> = 0>
     iterator _unique_insert(U &&k, const size_type &bucket_idx)
+    {
+        if constexpr (cache_hash) {
+            const auto h = _hash(k);
+            return _unique_insert(std::forward<U>(k), bucket_idx, h);
+        } else {
+            return _unique_insert(std::forward<U>(k), bucket_idx, std::size_t(0));
+        }
+    }
+
+
+    /// Insert unique element with known hash value (low-level).
+    /**
+     * \note
+     * This template method is activated only if \p T and \p U are the same type, aside from cv qualifications and
+     * references.
+     *
+     * Equivalent to the other overload of this method, with the hash value \p h of \p k supplied by the caller
+     * (so that it does not need to be recomputed if the set is caching the hash values). \p h must be equal to
+     * the output of _hash() for \p k, and it is ignored if the hash values are not cached.
+     *
+     * @param k object that will be inserted into the set.
+     * @param bucket_idx destination bucket for \p k.
+     * @param h hash value of \p k.
+     *
+     * @return iterator pointing to the newly-inserted element.
+     *
+     * @throws unspecified any exception thrown by the copy constructor of hash_set::key_type or by memory allocation
+     * errors.
+     */
+    template <typename U, insert_enabler<U> = 0>
+    iterator _unique_insert(U &&k, const size_type &bucket_idx, const std::size_t &h)
     {
         // Assert that key is not present already in the set.
-        piranha_assert(find(std::forward<U>(k)) == end());
-        // Assert bucket index is correct.
+        piranha_assert(find(k) == end());
+        // Assert bucket index and hash are correct.
         piranha_assert(bucket_idx == _bucket(k));
-        auto p = ptr()[bucket_idx].insert(std::forward<U>(k));
+        piranha_assert(!cache_hash || h == _hash(k));
+        auto p = ptr()[bucket_idx].insert(std::forward<U>(k), h, m_pool);
         return iterator(this, bucket_idx, local_iterator(p));
     }
 
@@ -1350,22 +1932,86 @@ public:
      */
     const_iterator _find(const key_type &k, const size_type &bucket_idx) const
     {
-        // Assert bucket index is correct.
+        if constexpr (cache_hash) {
+            return _find(k, bucket_idx, _hash(k));
+        } else {
+            return _find(k, bucket_idx, std::size_t(0));
+        }
+    }
+
+
+    /// Find element with known hash value (low-level).
+    /**
+     * Equivalent to the other overload of this method, with the hash value \p h of \p k supplied by the caller.
+     * \p h must be equal to the output of _hash() for \p k. If the set is caching the hash values, the equality
+     * predicate will be called only on the elements whose hash value is equal to \p h, otherwise \p h is ignored.
+     *
+     * If an incremental rehash is in progress and \p k is not in the bucket \p bucket_idx, \p k will be looked up
+     * in the old bucket array as well.
+     *
+     * @param k element to be located.
+     * @param bucket_idx index of the destination bucket for \p k.
+     * @param h hash value of \p k.
+     *
+     * @return hash_set::iterator to <tt>k</tt>'s position in the set, or end() if \p k is not in the set.
+     *
+     * @throws unspecified any exception thrown by calling the equality predicate or, during an incremental
+     * rehash, by the hasher.
+     */
+    const_iterator _find(const key_type &k, const size_type &bucket_idx, const std::size_t &h) const
+    {
+        // Assert bucket index and hash are correct.
         piranha_assert(bucket_idx == _bucket(k) && bucket_idx < bucket_count());
-        const auto &b = ptr()[bucket_idx];
-        const auto it_f = b.end();
+        piranha_assert(!cache_hash || h == _hash(k));
         const_iterator retval(end());
-        for (auto it = b.begin(); it != it_f; ++it) {
-            if (k_equal()(*it, k)) {
-                retval.m_idx = bucket_idx;
-                retval.m_it = it;
-                break;
+        // Look for k in the bucket b with virtual index idx, using hash value hv.
+        auto search = [this, &k, &retval](const list &b, const size_type &idx, const std::size_t &hv) {
+            (void)hv;
+            const auto it_f = b.end();
+            for (auto it = b.begin(); it != it_f; ++it) {
+                if constexpr (cache_hash) {
+                    if (it.m_ptr->m_hash != hv) {
+                        continue;
+                    }
+                }
+                if (this->k_equal()(*it, k)) {
+                    retval.m_idx = idx;
+                    retval.m_it = it;
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (search(ptr()[bucket_idx], bucket_idx, h)) {
+            return retval;
+        }
+        // During an incremental rehash, k could still be in a bucket of the old array which has not been
+        // migrated yet.
+        if (m_old_ptr) [[unlikely]]
+        {
+            const std::size_t old_h = cache_hash ? h : _hash(k);
+            const auto old_idx = static_cast<size_type>(old_h % (size_type(1u) << m_old_log2_size));
+            if (old_idx >= m_n_migrated) {
+                search(m_old_ptr[old_idx], static_cast<size_type>(bucket_count() + old_idx), old_h);
             }
         }
         return retval;
     }
 
 
+    /// Hash value (low-level).
+    /**
+     * @param k input argument.
+     *
+     * @return the hash value of \p k, as computed by the hasher of the set.
+     *
+     * @throws unspecified any exception thrown by the call operator of the hasher.
+     */
+    std::size_t _hash(const key_type &k) const
+    {
+        return hash()(k);
+    }
+
     /// Index of destination bucket from hash value.
     /**
      * Note that this method will not check if the number of buckets is zero.
@@ -1412,11 +2058,19 @@ public:
 
     /// Increase bucket count.
     /**
-     * Increase the number of buckets to the next implementation-defined value.
+     * Increase the number of buckets to the next implementation-defined value. If the set contains at least twice
+     * the minimum work per thread returned by piranha::settings::get_min_work_per_thread(), the rehash operation
+     * will use the number of threads suggested by piranha::thread_pool::use_threads(), with the number of elements
+     * as work size. Otherwise, it will run in the calling thread without querying the thread pool.
+     *
+     * In incremental rehash mode, the elements are not migrated immediately: the current bucket array is kept
+     * alongside the new one, and its buckets are migrated a few at a time by the subsequent insertions. A pending
+     * incremental rehash is completed before starting a new one.
      *
      * @throws std::bad_alloc if the operation results in a resize of the set past an implementation-defined
      * maximum number of buckets.
-     * @throws unspecified any exception thrown by rehash().
+     * @throws unspecified any exception thrown by rehash(), piranha::thread_pool::use_threads() or by memory
+     * allocation errors.
      */
     void _increase_size()
     {
@@ -1428,13 +2082,39 @@ public:
         // the next log2_size is 0u. Otherwise increase current log2_size.
         piranha_assert(ptr() || (!ptr() && !m_log2_size));
         const auto new_log2_size = (ptr()) ? (m_log2_size + 1u) : 0u;
-        // Rehash to the new size.
-        rehash(size_type(1u) << new_log2_size);
+        if (m_incremental && ptr()) {
+            begin_incremental_rehash(new_log2_size);
+            return;
+        }
+        // Rehash to the new size, migrating the elements in parallel if there are enough of them.
+        rehash(size_type(1u) << new_log2_size, work_n_threads(size()));
+    }
+
+
+    /// Incremental rehash step (low-level).
+    /**
+     * If an incremental rehash is in progress, migrate a few buckets of the old bucket array into the new one.
+     * This is the step performed by insert() before each insertion, and it should be called in the same way by
+     * single-threaded users of _unique_insert() which grow the set via _increase_size(). The bucket indices of
+     * the new array are not affected.
+     *
+     * @throws unspecified any exception thrown by the move constructor of hash_set::key_type or by memory allocation
+     * errors.
+     */
+    void _rehash_step()
+    {
+        if (m_old_ptr) [[unlikely]]
+        {
+            migrate_buckets(m_incremental_rehash_step);
+        }
     }
 
 
     /// Const reference to list in bucket.
     /**
+     * No incremental rehash must be in progress, otherwise part of the elements of the set would not be
+     * reachable from the bucket array. Callers must use complete_rehash() beforehand.
+     *
      * @param idx index of the bucket whose list will be returned.
      *
      * @return a const reference to the list of items contained in the bucket positioned
@@ -1443,6 +2123,7 @@ public:
     const list &_get_bucket_list(const size_type &idx) const
     {
         piranha_assert(idx < bucket_count());
+        piranha_assert(!m_old_ptr);
         return ptr()[idx];
     }
 
@@ -1468,10 +2149,10 @@ public:
     {
         // Verify the iterator is valid.
         piranha_assert(it.m_set == this);
-        piranha_assert(it.m_idx < bucket_count());
-        piranha_assert(!ptr()[it.m_idx].empty());
-        piranha_assert(it.m_it != ptr()[it.m_idx].end());
-        auto &bucket = ptr()[it.m_idx];
+        piranha_assert(it.m_idx < v_bucket_count());
+        piranha_assert(!v_bucket(it.m_idx).empty());
+        piranha_assert(it.m_it != v_bucket(it.m_idx).end());
+        auto &bucket = v_bucket(it.m_idx);
         // If the pointed-to element is the first one in the bucket, we need special care.
         if (&*it == &*bucket.m_node.ptr()) {
             // Destroy the payload.
@@ -1485,8 +2166,9 @@ public:
                 auto tmp = bucket.m_node.m_next->m_next;
                 // Move-construct from the second element, and then destroy it.
                 ::new (static_cast<void *>(&bucket.m_node.m_storage)) T(std::move(*bucket.m_node.m_next->ptr()));
+                list::copy_hash(bucket.m_node, *bucket.m_node.m_next);
                 bucket.m_node.m_next->ptr()->~T();
-                ::delete bucket.m_node.m_next;
+                m_pool.deallocate(bucket.m_node.m_next);
                 // Establish the new link.
                 bucket.m_node.m_next = tmp;
                 return bucket.begin();
@@ -1502,7 +2184,7 @@ public:
                     prev_b_it.m_ptr->m_next = b_it.m_ptr->m_next;
                     // Delete the current one.
                     b_it.m_ptr->ptr()->~T();
-                    ::delete b_it.m_ptr;
+                    m_pool.deallocate(b_it.m_ptr);
                     break;
                 };
             }
@@ -1515,11 +2197,153 @@ public:
             return ++prev_b_it;
         }
     }
+
+    /// Concurrent inserter (low-level).
+    /**
+     * Objects of this class insert elements into a piranha::hash_set concurrently from multiple threads, after a
+     * call to _concurrent_begin() and before the matching call to _concurrent_end(). Each thread must use its own
+     * inserter.
+     *
+     * The buckets are protected by a set of striped spinlocks owned by the set. Each inserter counts privately the
+     * elements it has inserted, and it adds its count to a counter shared by all the inserters upon destruction.
+     * The shared counter is reconciled with size() by _concurrent_end().
+     */
+    class _concurrent_inserter
+    {
+    public:
+        /// Constructor.
+        /**
+         * @param s the set into which the elements will be inserted.
+         *
+         * @throws std::invalid_argument if no concurrent insertion session is active in \p s.
+         */
+        explicit _concurrent_inserter(hash_set &s) : m_set(s), m_count(0u)
+        {
+            if (!s.m_concurrent) [[unlikely]]
+            {
+                piranha_throw(std::invalid_argument, "no concurrent insertion session is active");
+            }
+        }
+        /// Deleted copy constructor.
+        _concurrent_inserter(const _concurrent_inserter &) = delete;
+        /// Deleted move constructor.
+        _concurrent_inserter(_concurrent_inserter &&) = delete;
+        /// Deleted copy assignment.
+        _concurrent_inserter &operator=(const _concurrent_inserter &) = delete;
+        /// Deleted move assignment.
+        _concurrent_inserter &operator=(_concurrent_inserter &&) = delete;
+        /// Destructor.
+        /**
+         * Adds the number of elements inserted by \p this to the shared counter of the session.
+         */
+        ~_concurrent_inserter()
+        {
+            if (m_set.m_concurrent) {
+                m_set.m_concurrent->m_count.fetch_add(m_count, std::memory_order_relaxed);
+            }
+        }
+        /// Insert or accumulate.
+        /**
+         * \note
+         * This template method is activated only if \p T and \p U are the same type, aside from cv qualifications
+         * and references.
+         *
+         * If no element equivalent to \p k exists in the set, \p k will be inserted. Otherwise,
+         * <tt>c(x, std::forward<U>(k))</tt> is called, where \p x is a const reference to the existing element. The
+         * combiner must not alter the hash value of \p x or its equivalence class, and it is called while the bucket
+         * is locked. Elements whose value becomes irrelevant after a combination (e.g., terms with a zero
+         * coefficient) are not removed.
+         *
+         * The set is never rehashed during concurrent insertions, hence the caller must make sure the set has
+         * enough buckets.
+         *
+         * @param k the element to be inserted.
+         * @param c the combiner.
+         *
+         * @return \p true if \p k was inserted, \p false if it was combined with an existing element.
+         *
+         * @throws unspecified any exception thrown by _unique_insert(), _find(), _hash() or by the combiner.
+         */
+        template <typename U, typename Combiner, insert_enabler<U> = 0>
+        bool insert(U &&k, const Combiner &c)
+        {
+            auto &st = *m_set.m_concurrent;
+            const auto h = m_set._hash(k);
+            const auto bucket_idx = m_set._bucket_from_hash(h);
+            detail::atomic_lock_guard lock(st.m_locks[static_cast<std::size_t>(bucket_idx & st.m_mask)]);
+            const auto it = m_set._find(k, bucket_idx, h);
+            if (it == m_set.end()) {
+                m_set._unique_insert(std::forward<U>(k), bucket_idx, h);
+                ++m_count;
+                return true;
+            }
+            c(*it, std::forward<U>(k));
+            return false;
+        }
+
+    private:
+        hash_set &m_set;
+        size_type m_count;
+    };
+    /// Begin a concurrent insertion session.
+    /**
+     * After this call, elements can be inserted concurrently via hash_set::_concurrent_inserter. No other method
+     * modifying the set should be called until _concurrent_end() is invoked. A pending incremental rehash is completed
+     * before the session begins.
+     *
+     * @throws std::invalid_argument if the set has no buckets or if a concurrent insertion session is already active.
+     * @throws unspecified any exception thrown by memory allocation errors.
+     */
+    void _concurrent_begin()
+    {
+        if (!bucket_count()) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument,
+                          "cannot begin a concurrent insertion session in a set with no buckets");
+        }
+        if (m_concurrent) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "a concurrent insertion session is already active");
+        }
+        // The inserters must not migrate buckets concurrently.
+        complete_migration();
+        m_concurrent.reset(new concurrent_state(std::min(bucket_count(), m_max_n_locks)));
+    }
+    /// End a concurrent insertion session.
+    /**
+     * The number of elements inserted by the (already destroyed) inserters of the session will be added to size().
+     *
+     * @throws std::invalid_argument if no concurrent insertion session is active.
+     * @throws std::overflow_error if the new size overflows the maximum value representable by size_type.
+     */
+    void _concurrent_end()
+    {
+        if (!m_concurrent) [[unlikely]]
+        {
+            piranha_throw(std::invalid_argument, "no concurrent insertion session is active");
+        }
+        const auto count = m_concurrent->m_count.load();
+        m_concurrent.reset();
+        if (count > std::numeric_limits<size_type>::max() - m_n_elements) [[unlikely]]
+        {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        m_n_elements = static_cast<size_type>(m_n_elements + count);
+    }
     //@}
 private:
     pack_type m_pack;
     size_type m_log2_size;
     size_type m_n_elements;
+    pool_type m_pool;
+    std::unique_ptr<concurrent_state> m_concurrent;
+    // Old bucket array of a pending incremental rehash (null if no rehash is in progress), its log2 size
+    // and the number of its buckets that have already been migrated to the new array.
+    ptr_type m_old_ptr = nullptr;
+    size_type m_old_log2_size = 0u;
+    size_type m_n_migrated = 0u;
+    // Incremental rehash mode flag.
+    bool m_incremental = false;
 };
 
 
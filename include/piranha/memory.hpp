@@ -36,6 +36,7 @@ see https://www.gnu.org/licenses/. */
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <stdexcept>
 #include <type_traits>
@@ -45,7 +46,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/config.hpp>
 #include <piranha/detail/init.hpp>
 #include <piranha/exceptions.hpp>
-#include <piranha/thread_pool.hpp>
+#include <piranha/parallel.hpp>
 #include <piranha/type_traits.hpp>
 
 #if defined(PIRANHA_HAVE_POSIX_MEMALIGN) // POSIX memalign.
@@ -275,6 +276,11 @@ inline bool alignment_check(const std::size_t &alignment)
  * the operation concurrently. If \p n_threads is 1 or 0, the operation will be performed in the
  * calling thread. If \p ptr is null, this function will be a no-op.
  *
+ * The array is split into \p n_threads contiguous ranges, the <tt>i</tt>-th range being initialised by the
+ * <tt>i</tt>-th thread in the pool (see piranha::partitioning::contiguous). If thread binding is active (see
+ * piranha::thread_pool::set_binding()), the first touch of each range thus happens on the processor (and NUMA node)
+ * to which the corresponding thread is bound.
+ *
  * This function provides the strong exception safety guarantee: in case of errors, any constructed
  * instance of \p T will be destroyed before the error is re-thrown.
  *
@@ -285,21 +291,19 @@ inline bool alignment_check(const std::size_t &alignment)
  * @throws std::bad_alloc in case of memory allocation errors in multithreaded mode.
  * @throws unspecified any exception thrown by:
  * - the value initialisation of instances of type \p T,
- * - piranha::thread_pool::enqueue() and piranha::future_list::push_back(), only in multithreaded mode.
+ * - piranha::parallel_for(), only in multithreaded mode.
  */
 template <typename T, typename = typename std::enable_if<is_container_element<T>::value>::type>
 inline void parallel_value_init(T *ptr, const std::size_t &size, const unsigned &n_threads)
 {
-    using ranges_vector = std::vector<std::pair<T *, T *>>;
-    using rv_size_type = typename ranges_vector::size_type;
-    if (ptr == nullptr) [[unlikely]] 
+    if (ptr == nullptr) [[unlikely]]
     {
         piranha_assert(!size);
         return;
     }
 
     // Initing functor.
-    auto init_function = [](T *start, T *end, const unsigned &thread_idx, ranges_vector *rv) {
+    auto init_function = [](T *start, T *end) {
         auto orig_start = start;
         try {
             for (; start != end; ++start) {
@@ -313,34 +317,32 @@ inline void parallel_value_init(T *ptr, const std::size_t &size, const unsigned
             // Re-throw.
             throw;
         }
-        // If the init was successful and we are in multithreaded mode, record
-        // the range that was inited.
-        if (rv != nullptr) {
-            (*rv)[static_cast<rv_size_type>(thread_idx)].first = orig_start;
-            (*rv)[static_cast<rv_size_type>(thread_idx)].second = end;
-        }
     };
-    if (n_threads <= 1) {
-        init_function(ptr, ptr + size, 0u, nullptr);
+    if (n_threads <= 1u) {
+        init_function(ptr, ptr + size);
     } else {
-        // Init the ranges vector with (ptr,ptr) pairs, so they are empty ranges.
-        ranges_vector inited_ranges(static_cast<rv_size_type>(n_threads), std::make_pair(ptr, ptr));
-        if (inited_ranges.size() != n_threads) [[unlikely]]
-        {
-            piranha_throw(std::bad_alloc, );
-        }
-        // Work per thread.
-        const auto wpt = static_cast<std::size_t>(size / n_threads);
-        future_list<decltype(init_function(ptr, ptr, 0u, &inited_ranges))> f_list;
+        // The ranges that were inited, for rolling back.
+        std::mutex mutex;
+        std::vector<std::pair<T *, T *>> inited_ranges;
         try {
-            for (auto i = 0u; i < n_threads; ++i) {
-                auto start = ptr + i * wpt, end = (i == n_threads - 1u) ? ptr + size : ptr + (i + 1u) * wpt;
-                f_list.push_back(thread_pool::enqueue(i, init_function, start, end, i, &inited_ranges));
-            }
-            f_list.wait_all();
-            f_list.get_all();
+            inited_ranges.reserve(n_threads);
+            // NOTE: contiguous partitioning, so that the i-th block is touched first by the i-th thread.
+            parallel_for(n_threads, std::size_t(0u), size,
+                         [ptr, &init_function, &mutex, &inited_ranges](std::size_t b, std::size_t e) {
+                             init_function(ptr + b, ptr + e);
+                             try {
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 inited_ranges.emplace_back(ptr + b, ptr + e);
+                             } catch (...) {
+                                 for (auto start = ptr + b; start != ptr + e; ++start) {
+                                     start->~T();
+                                 }
+                                 throw;
+                             }
+                         },
+                         std::size_t(1u), partitioning::contiguous);
         } catch (...) {
-            f_list.wait_all();
+            // NOTE: if we are here, all the participants have finished.
             // Rollback the ranges that were inited.
             for (const auto &p : inited_ranges) {
                 for (auto start = p.first; start != p.second; ++start) {
@@ -358,9 +360,8 @@ inline void parallel_value_init(T *ptr, const std::size_t &size, const unsigned
  * This function is enabled only if \p T satisfies the piranha::is_container_element type trait.
  *
  * This function will destroy in parallel the element of an array \p ptr of size \p size. If \p n_threads
- * is 0 or 1, the operation will be performed in the calling thread, otherwise the first \p n_threads in
- * piranha::thread_pool
- * will be used to perform the operation concurrently.
+ * is 0 or 1, the operation will be performed in the calling thread, otherwise up to \p n_threads threads
+ * will be used to perform the operation concurrently via piranha::parallel_for().
  *
  * The function is a no-op if \p ptr is null or if \p T has a trivial destructor.
  *
@@ -371,8 +372,6 @@ inline void parallel_value_init(T *ptr, const std::size_t &size, const unsigned
 template <typename T, typename = typename std::enable_if<is_container_element<T>::value>::type>
 inline void parallel_destroy(T *ptr, const std::size_t &size, const unsigned &n_threads)
 {
-    using ranges_vector = std::vector<std::pair<T *, T *>>;
-    using rv_size_type = typename ranges_vector::size_type;
     // Nothing to be done for null pointers.
     if (ptr == nullptr) [[unlikely]]
     {
@@ -400,48 +399,14 @@ inline void parallel_destroy(T *ptr, const std::size_t &size, const unsigned &n_
     if (n_threads <= 1u) {
         destroy_function(ptr, ptr + size);
     } else {
-        // A vector of ranges representing elements yet to be destroyed in case something goes wrong
-        // in the multithreaded part.
-        ranges_vector d_ranges;
-        future_list<decltype(destroy_function(ptr, ptr))> f_list;
         try {
-            d_ranges.resize(static_cast<rv_size_type>(n_threads), std::make_pair(ptr, ptr));
-            if (d_ranges.size() != n_threads) [[unlikely]]
-            {
-                piranha_throw(std::bad_alloc, );
-            }
+            parallel_for(n_threads, std::size_t(0u), size, [ptr, &destroy_function](std::size_t b, std::size_t e) {
+                destroy_function(ptr + b, ptr + e);
+            });
         } catch (...) {
-            // Just perform the single-threaded version, and GTFO.
+            // NOTE: the loop body cannot throw and, in adaptive mode, parallel_for() can fail only before
+            // starting the loop. Just perform the single-threaded version.
             destroy_function(ptr, ptr + size);
-            return;
-        }
-        try {
-            // Work per thread.
-            const auto wpt = static_cast<std::size_t>(size / n_threads);
-            // The ranges to destroy in the cleanup phase are, initially, all the ranges.
-            for (auto i = 0u; i < n_threads; ++i) {
-                auto start = ptr + i * wpt, end = (i == n_threads - 1u) ? ptr + size : ptr + (i + 1u) * wpt;
-                d_ranges[static_cast<rv_size_type>(i)] = std::make_pair(start, end);
-            }
-            // Perform the actual destruction and update the d_ranges vector.
-            for (auto i = 0u; i < n_threads; ++i) {
-                auto start = d_ranges[static_cast<rv_size_type>(i)].first,
-                     end = d_ranges[static_cast<rv_size_type>(i)].second;
-                f_list.push_back(thread_pool::enqueue(i, destroy_function, start, end));
-                // The range needs not to be destroyed anymore, as the enqueue/push_back was successful. Replace
-                // with an empty range.
-                d_ranges[static_cast<rv_size_type>(i)].first = ptr;
-                d_ranges[static_cast<rv_size_type>(i)].second = ptr;
-            }
-            f_list.wait_all();
-            // NOTE: T is a container_element, no need to get exceptions here.
-        } catch (...) {
-            f_list.wait_all();
-            // If anything failed in the multithreaded part, just destroy in single-thread the ranges
-            // that were not destroyed.
-            for (const auto &p : d_ranges) {
-                destroy_function(p.first, p.second);
-            }
         }
     }
 }
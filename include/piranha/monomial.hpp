@@ -57,6 +57,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/detail/safe_integral_arith.hpp>
 #include <piranha/exceptions.hpp>
 #include <piranha/forwarding.hpp>
+#include <piranha/hash_set.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/is_cf.hpp>
 #include <piranha/is_key.hpp>
@@ -1296,6 +1297,15 @@ template <typename T, typename S>
 class key_ldegree_impl<monomial<T, S>> : public key_degree_impl<monomial<T, S>>
 {
 };
+
+/// Specialisation of piranha::hash_set_cache_hash for terms with monomial keys.
+/**
+ * The hash value of a piranha::monomial is computed from all its exponents, thus it is cached
+ * in piranha::hash_set.
+ */
+template <typename Cf, typename T, typename S, typename Hash>
+struct hash_set_cache_hash<term<Cf, monomial<T, S>>, Hash> : std::true_type {
+};
 } // namespace piranha
 
 #if defined(PIRANHA_WITH_BOOST_S11N)
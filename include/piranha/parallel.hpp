@@ -0,0 +1,417 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_PARALLEL_HPP
+#define PIRANHA_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <piranha/config.hpp>
+#include <piranha/exceptions.hpp>
+#include <piranha/thread_pool.hpp>
+#include <piranha/type_traits.hpp>
+
+namespace piranha
+{
+
+/// Partitioning strategies for piranha::parallel_for() and piranha::parallel_reduce().
+enum class partitioning {
+    /// Adaptive partitioning.
+    /**
+     * The range is consumed in chunks claimed dynamically by the participating threads. The size of the chunks
+     * decreases as the range is consumed (guided self-scheduling): large chunks keep the scheduling overhead low
+     * at the beginning, small chunks balance the load at the end. The chunks are never smaller than the grain size
+     * (except for the last one). The calling thread takes part in the computation, together with tasks submitted
+     * via piranha::thread_pool::enqueue_any().
+     */
+    adaptive,
+    /// Contiguous partitioning.
+    /**
+     * The range is split into as many contiguous blocks of (almost) equal size as the number of threads, and the
+     * <tt>i</tt>-th block is processed by the <tt>i</tt>-th thread in piranha::thread_pool (the number of threads
+     * is capped to the size of the pool). This is useful when the placement of the work matters, e.g., for the
+     * first touch of memory that will later be accessed by the same threads (see
+     * piranha::thread_pool::set_binding()).
+     */
+    contiguous
+};
+
+inline namespace impl
+{
+
+// Enabler for parallel_for() and parallel_reduce().
+template <typename Int>
+using parallel_range_enabler
+    = enable_if_t<conjunction<std::is_integral<Int>, negation<std::is_same<Int, bool>>>::value, int>;
+
+// Check the arguments of parallel_for() and parallel_reduce(), and return the number of threads that will
+// actually be used (never more than the number of whole grains in the range, and at least 1).
+template <typename Int>
+inline unsigned parallel_n_threads(unsigned n_threads, const Int &begin, const Int &end, const Int &grain)
+{
+    using uint_t = std::make_unsigned_t<Int>;
+    if (unlikely(n_threads == 0u)) {
+        piranha_throw(std::invalid_argument, "invalid number of threads");
+    }
+    if (unlikely(grain <= Int(0))) {
+        piranha_throw(std::invalid_argument, "invalid grain size (it must be strictly positive)");
+    }
+    if (unlikely(end < begin)) {
+        piranha_throw(std::invalid_argument, "invalid range (the end is before the beginning)");
+    }
+    const auto size = static_cast<uint_t>(static_cast<uint_t>(end) - static_cast<uint_t>(begin));
+    const auto g = static_cast<uint_t>(grain);
+    const auto n_grains = static_cast<uint_t>(size / g);
+    if (n_grains < n_threads) {
+        return n_grains ? static_cast<unsigned>(n_grains) : 1u;
+    }
+    return n_threads;
+}
+
+// The range of an adaptive loop, from which the participating threads claim chunks.
+template <typename Int>
+class adaptive_range
+{
+    using uint_t = std::make_unsigned_t<Int>;
+
+public:
+    adaptive_range(const Int &begin, const Int &end, const Int &grain, unsigned n_threads)
+        : m_begin(begin), m_size(static_cast<uint_t>(static_cast<uint_t>(end) - static_cast<uint_t>(begin))),
+          m_grain(static_cast<uint_t>(grain)), m_n_threads(n_threads), m_next(0u), m_cancelled(false)
+    {
+        piranha_assert(n_threads > 0u && grain > Int(0) && begin <= end);
+    }
+    // Claim the next chunk [b, e). Returns false if the range is exhausted or if the loop was cancelled.
+    bool claim(Int &b, Int &e)
+    {
+        if (m_cancelled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        // NOTE: relaxed ordering is fine here, the results of the computation are synchronised
+        // at the end of the loop.
+        auto cur = m_next.load(std::memory_order_relaxed);
+        uint_t size;
+        do {
+            if (cur >= m_size) {
+                return false;
+            }
+            const auto rem = static_cast<uint_t>(m_size - cur);
+            // Guided self-scheduling: claim a fraction of what is left, at least one grain.
+            size = std::min(rem, std::max(m_grain, static_cast<uint_t>(rem / m_n_threads / 2u)));
+        } while (!m_next.compare_exchange_weak(cur, static_cast<uint_t>(cur + size), std::memory_order_relaxed,
+                                               std::memory_order_relaxed));
+        b = static_cast<Int>(static_cast<uint_t>(static_cast<uint_t>(m_begin) + cur));
+        e = static_cast<Int>(static_cast<uint_t>(static_cast<uint_t>(b) + size));
+        return true;
+    }
+    // Stop handing out chunks.
+    void cancel()
+    {
+        m_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+private:
+    const Int m_begin;
+    const uint_t m_size;
+    const uint_t m_grain;
+    const unsigned m_n_threads;
+    std::atomic<uint_t> m_next;
+    std::atomic<bool> m_cancelled;
+};
+
+// Shared control block of the helpers of an adaptive loop. The helpers are submitted via
+// thread_pool::enqueue_any() and they might start running after the loop has been completed by the other
+// participants: in such case they must not touch the (possibly destroyed) state of the loop. The caller
+// closes the loop when it is done, and then waits only for the helpers which registered before the closure.
+struct parallel_control {
+    // Record the first exception thrown by a participant.
+    void set_exception(std::exception_ptr eptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_eptr) {
+            m_eptr = std::move(eptr);
+        }
+    }
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    unsigned m_active = 0u;
+    bool m_closed = false;
+    std::exception_ptr m_eptr;
+};
+
+// Run the nullary function w in the calling thread and in up to n_threads - 1 helper tasks. w is expected to consume
+// chunks from range until it is exhausted. The first exception thrown by any participant cancels the loop, and
+// it is re-thrown after all the participants are done. Apart from the allocation of the control block, the loop
+// machinery does not throw: if not all the helpers can be submitted, the range is consumed by fewer threads.
+template <typename Int, typename Worker>
+inline void parallel_adaptive(unsigned n_threads, adaptive_range<Int> &range, const Worker &w)
+{
+    auto ctl = std::make_shared<parallel_control>();
+    auto helper = [ctl, &range, &w]() {
+        {
+            std::lock_guard<std::mutex> lock(ctl->m_mutex);
+            if (ctl->m_closed) {
+                return;
+            }
+            ++ctl->m_active;
+        }
+        try {
+            w();
+        } catch (...) {
+            range.cancel();
+            ctl->set_exception(std::current_exception());
+        }
+        std::lock_guard<std::mutex> lock(ctl->m_mutex);
+        piranha_assert(ctl->m_active > 0u);
+        if (--ctl->m_active == 0u) {
+            ctl->m_cond.notify_all();
+        }
+    };
+    try {
+        for (unsigned i = 1u; i < n_threads; ++i) {
+            // NOTE: the futures are not needed, the helpers never throw and they signal their completion
+            // via the control block.
+            thread_pool::enqueue_any(helper);
+        }
+    } catch (...) {
+        // NOTE: failing to submit a helper is not fatal, the loop will just be run by fewer threads.
+    }
+    try {
+        w();
+    } catch (...) {
+        range.cancel();
+        ctl->set_exception(std::current_exception());
+    }
+    std::unique_lock<std::mutex> lock(ctl->m_mutex);
+    ctl->m_closed = true;
+    // NOTE: wait() will be noexcept in C++14.
+    while (ctl->m_active) {
+        ctl->m_cond.wait(lock);
+    }
+    if (ctl->m_eptr) {
+        std::rethrow_exception(ctl->m_eptr);
+    }
+}
+
+// Run f(i, b, e) for the i-th of n_threads contiguous blocks [b, e) of [begin, end), in the i-th thread of the pool.
+// The blocks which have not started yet are skipped after the first exception.
+// NOTE: when called from a thread of the pool with nested parallelism enabled, task_group::run() does not
+// pin the blocks, and task_group::wait_all() lets the calling thread run them while waiting.
+template <typename Int, typename F>
+inline void parallel_contiguous(unsigned n_threads, const Int &begin, const Int &end, const F &f)
+{
+    using uint_t = std::make_unsigned_t<Int>;
+    // NOTE: the blocks are mapped to the threads of the pool, hence we cannot use more threads than that.
+    n_threads = std::min(n_threads, thread_pool::size());
+    const auto size = static_cast<uint_t>(static_cast<uint_t>(end) - static_cast<uint_t>(begin));
+    // Elements per block.
+    const auto epb = static_cast<uint_t>(size / n_threads);
+    std::atomic<bool> cancelled(false);
+    auto block = [&f, &cancelled, begin, end, epb, n_threads](unsigned i) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const auto b = static_cast<Int>(static_cast<uint_t>(static_cast<uint_t>(begin) + epb * i));
+        const auto e = (i == n_threads - 1u)
+                           ? end
+                           : static_cast<Int>(static_cast<uint_t>(static_cast<uint_t>(begin) + epb * (i + 1u)));
+        try {
+            f(i, b, e);
+        } catch (...) {
+            cancelled.store(true, std::memory_order_relaxed);
+            throw;
+        }
+    };
+    task_group t_group;
+    try {
+        for (unsigned i = 0u; i < n_threads; ++i) {
+            t_group.run(i, block, i);
+        }
+        // First let's wait for everything to finish.
+        t_group.wait_all();
+        // Then, let's handle the exceptions.
+        t_group.get_all();
+    } catch (...) {
+        cancelled.store(true, std::memory_order_relaxed);
+        t_group.wait_all();
+        throw;
+    }
+}
+}
+
+/// Parallel for loop.
+/**
+ * \note
+ * This function is enabled only if \p Int is an integral type other than \p bool.
+ *
+ * This function will call <tt>f(b, e)</tt> for a set of disjoint subranges <tt>[b, e)</tt> covering the range
+ * <tt>[begin, end)</tt>, using up to \p n_threads threads. The subranges are built according to the partitioning
+ * strategy \p p (see piranha::partitioning), and they contain at least \p grain elements (except possibly for the
+ * last one). \p f may be called concurrently from multiple threads, and the subranges are processed in an
+ * unspecified order. No more threads than the number of whole grains in the range will be used. If only one thread is
+ * used, \p f will be called once with the whole range in the calling thread. If the range is empty, \p f
+ * will not be called.
+ *
+ * If an invocation of \p f throws, the loop is cancelled (i.e., no new subranges will be processed), and the
+ * exception is re-thrown after the pending invocations of \p f have completed. If multiple invocations throw, only
+ * one of the exceptions is re-thrown.
+ *
+ * Note that in adaptive mode the calling thread participates in the computation, and in contiguous mode it
+ * consumes the pending blocks while waiting, so that the function can also be safely called from the threads
+ * of piranha::thread_pool (see piranha::thread_pool_::set_nested_parallelism()). Failures in the submission of the
+ * helper tasks are not errors in adaptive mode: the range will be processed by fewer threads.
+ *
+ * @param n_threads the maximum number of threads to use.
+ * @param begin the beginning of the range.
+ * @param end the end of the range.
+ * @param f the loop body.
+ * @param grain the minimum number of elements in a subrange.
+ * @param p the partitioning strategy.
+ *
+ * @throws std::invalid_argument if \p n_threads or \p grain are not strictly positive, or if \p end is less than
+ * \p begin.
+ * @throws unspecified any exception thrown by:
+ * - \p f,
+ * - piranha::task_group::run(), in contiguous mode,
+ * - threading primitives,
+ * - memory allocation errors.
+ */
+template <typename Int, typename F, parallel_range_enabler<Int> = 0>
+inline void parallel_for(unsigned n_threads, Int begin, Int end, const F &f, Int grain = Int(1),
+                         partitioning p = partitioning::adaptive)
+{
+    n_threads = parallel_n_threads(n_threads, begin, end, grain);
+    if (begin == end) {
+        return;
+    }
+    if (n_threads == 1u) {
+        f(begin, end);
+        return;
+    }
+    if (p == partitioning::contiguous) {
+        parallel_contiguous(n_threads, begin, end, [&f](unsigned, const Int &b, const Int &e) { f(b, e); });
+        return;
+    }
+    adaptive_range<Int> range(begin, end, grain, n_threads);
+    parallel_adaptive(n_threads, range, [&range, &f]() {
+        Int b, e;
+        while (range.claim(b, e)) {
+            f(b, e);
+        }
+    });
+}
+
+/// Parallel reduction.
+/**
+ * \note
+ * This function is enabled only if \p Int is an integral type other than \p bool.
+ *
+ * This function will compute <tt>f(b, e)</tt> for a set of disjoint subranges <tt>[b, e)</tt> covering the range
+ * <tt>[begin, end)</tt>, using up to \p n_threads threads, and it will combine the partial results via the binary
+ * operation \p op, starting from \p init. The subranges are built as explained in piranha::parallel_for(), which
+ * also documents the handling of exceptions.
+ *
+ * \p op must be associative. In adaptive mode, the order in which the partial results are combined is unspecified,
+ * hence \p op must also be commutative in order to obtain deterministic results. In contiguous mode, the
+ * partial results are combined in the order of the subranges.
+ *
+ * @param n_threads the maximum number of threads to use.
+ * @param begin the beginning of the range.
+ * @param end the end of the range.
+ * @param init the initial value of the reduction.
+ * @param f the function computing the partial result of a subrange.
+ * @param op the binary operation used to combine the partial results.
+ * @param grain the minimum number of elements in a subrange.
+ * @param p the partitioning strategy.
+ *
+ * @return the reduction of the partial results, or \p init if the range is empty.
+ *
+ * @throws unspecified any exception thrown by piranha::parallel_for(), by \p op, or by the copy/move
+ * operations of \p T.
+ */
+template <typename Int, typename T, typename F, typename Op, parallel_range_enabler<Int> = 0>
+inline T parallel_reduce(unsigned n_threads, Int begin, Int end, T init, const F &f, const Op &op,
+                         Int grain = Int(1), partitioning p = partitioning::adaptive)
+{
+    n_threads = parallel_n_threads(n_threads, begin, end, grain);
+    if (begin == end) {
+        return init;
+    }
+    if (n_threads == 1u) {
+        return op(std::move(init), f(begin, end));
+    }
+    if (p == partitioning::contiguous) {
+        std::vector<std::optional<T>> partials(n_threads);
+        parallel_contiguous(n_threads, begin, end,
+                            [&f, &partials](unsigned i, const Int &b, const Int &e) { partials[i].emplace(f(b, e)); });
+        // NOTE: some of the partials might be empty if the number of threads was capped to the size of the pool.
+        for (auto &r : partials) {
+            if (r) {
+                init = op(std::move(init), std::move(*r));
+            }
+        }
+        return init;
+    }
+    adaptive_range<Int> range(begin, end, grain, n_threads);
+    std::mutex mutex;
+    std::optional<T> retval;
+    parallel_adaptive(n_threads, range, [&range, &f, &op, &mutex, &retval]() {
+        std::optional<T> local;
+        Int b, e;
+        while (range.claim(b, e)) {
+            if (local) {
+                local.emplace(op(std::move(*local), f(b, e)));
+            } else {
+                local.emplace(f(b, e));
+            }
+        }
+        if (local) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (retval) {
+                retval.emplace(op(std::move(*retval), std::move(*local)));
+            } else {
+                retval.emplace(std::move(*local));
+            }
+        }
+    });
+    piranha_assert(retval);
+    return op(std::move(init), std::move(*retval));
+}
+}
+
+#endif
@@ -153,6 +153,8 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/divisor_series.hpp>
 #include <piranha/dynamic_aligning_allocator.hpp>
 #include <piranha/exceptions.hpp>
+#include <piranha/flat_hash_set.hpp>
+#include <piranha/hash_quality.hpp>
 #include <piranha/hash_set.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/invert.hpp>
@@ -181,6 +183,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/math/sin.hpp>
 #include <piranha/memory.hpp>
 #include <piranha/monomial.hpp>
+#include <piranha/parallel.hpp>
 #include <piranha/poisson_series.hpp>
 #include <piranha/polynomial.hpp>
 #include <piranha/power_series.hpp>
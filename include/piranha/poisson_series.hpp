@@ -30,10 +30,14 @@ see https://www.gnu.org/licenses/. */
 #define PIRANHA_POISSON_SERIES_HPP
 
 #include <algorithm>
-#include <atomic>
+#include <array>
 #include <boost/container/container_fwd.hpp>
 #include <boost/iterator/transform_iterator.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+#include <cmath>
+#include <cstddef>
 #include <iterator>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -70,6 +74,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/term.hpp>
 #include <piranha/thread_pool.hpp>
 #include <piranha/trigonometric_series.hpp>
+#include <piranha/tuning.hpp>
 #include <piranha/type_traits.hpp>
 
 namespace piranha
@@ -766,6 +771,12 @@ using ps_series_multiplier_enabler = typename std::enable_if<std::is_base_of<poi
 }
 
 /// Specialisation of piranha::series_multiplier for piranha::poisson_series.
+/**
+ * The multiplication of two Poisson series is performed via a dedicated algorithm which, in multithreaded mode,
+ * subdivides the output series in zones of contiguous buckets, each one written by a single thread, so that no
+ * locking is needed during the accumulation of the term-by-term products. The division by two implied by
+ * Werner's formulae is folded into the final pass over the output series.
+ */
 template <typename Series>
 class series_multiplier<Series, detail::ps_series_multiplier_enabler<Series>> : public base_series_multiplier<Series>
 {
@@ -773,71 +784,226 @@ class series_multiplier<Series, detail::ps_series_multiplier_enabler<Series>> :
     template <typename T>
     using call_enabler = typename std::enable_if<
         key_is_multipliable<typename T::term_type::cf_type, typename T::term_type::key_type>::value, int>::type;
-    void divide_by_two(Series &s) const
+    // Zoned multiplication.
+    // The term-by-term products are computed via the multiply() method of the trigonometric key. In single-threaded
+    // mode, the products are accumulated directly into the output series. In multi-threaded mode, the output
+    // series is subdivided in m_n_threads zones of contiguous buckets, and the multiplication proceeds in rounds:
+    // - first, each thread computes the products of a subset of the rows of the current round, and it appends
+    //   the resulting terms to private buffers, one per zone;
+    // - then, each thread accumulates into the output series the buffered terms of the zone it owns.
+    // Since the zones are disjoint, no locking is needed. At the end, each thread halves the coefficients
+    // and erases the zero terms in its own zone.
+    // If the two operands are the same object, the j-th term of the second series is multiplied by the i-th term of
+    // the first series only if j >= i, using doubled coefficients for the cross products.
+    Series zoned_multiplication() const
     {
-        // NOTE: if we ever implement multi-threaded series division we most likely need
-        // to revisit this.
-        piranha_assert(this->m_n_threads > 0u);
-        if (this->m_n_threads == 1u) {
-            // This is possible, as the requirements of series divisibility and trig key
-            // multipliability overlap.
-            s /= 2;
-        } else {
-            using bucket_size_type = typename base::bucket_size_type;
-            using term_type = typename Series::term_type;
-            auto &container = s._container();
-            std::atomic<bucket_size_type> total_erase_count(0u);
-            auto divider
-                = [&container, &total_erase_count, this](bucket_size_type start_idx, bucket_size_type end_idx) {
-                      // A vector of terms to be erased at each bucket iteration.
-                      std::vector<term_type> term_list;
-                      // Total number of terms erased by this thread.
-                      bucket_size_type erase_count = 0u;
-                      for (; start_idx != end_idx; ++start_idx) {
-                          // Reset the list of terms to be erased.
-                          term_list.clear();
-                          const auto &list = container._get_bucket_list(start_idx);
-                          for (const auto &t : list) {
-                              t.m_cf /= 2;
-                              if (unlikely(t.is_zero(this->m_ss))) {
-                                  term_list.push_back(t);
-                              }
-                          }
-                          for (const auto &t : term_list) {
-                              container._erase(container._find(t, start_idx));
-                              erase_count = static_cast<bucket_size_type>(erase_count + 1u);
-                          }
-                      }
-                      // Update the global counter of erased terms.
-                      total_erase_count += erase_count;
-                  };
-            // Buckets per thread.
-            const auto bpt = static_cast<bucket_size_type>(container.bucket_count() / this->m_n_threads);
-            // Go with the threads.
-            future_list<decltype(divider(0u, 0u))> ff_list;
+        using term_type = typename Series::term_type;
+        using cf_type = typename term_type::cf_type;
+        using key_type = typename term_type::key_type;
+        using size_type = typename base::size_type;
+        using bucket_size_type = typename base::bucket_size_type;
+        constexpr std::size_t arity = key_type::multiply_arity;
+        // For rational coefficients, the halving is folded into finalise_series().
+        constexpr bool rat_cf = mppp::detail::is_rational<cf_type>::value;
+        Series retval;
+        retval.set_symbol_set(this->m_ss);
+        const auto &v1 = this->m_v1;
+        const auto &v2 = this->m_v2;
+        const size_type size1 = v1.size(), size2 = v2.size();
+        if (unlikely(!size1 || !size2)) {
+            return retval;
+        }
+        const bool square = this->m_square;
+        piranha_assert(!square || size1 == size2);
+        const unsigned n_threads = this->m_n_threads;
+        piranha_assert(n_threads > 0u);
+        auto &container = retval._container();
+        // The doubled terms of the first series, used for the cross products in the squaring case.
+        std::vector<term_type> dbl;
+        if (square) {
+            dbl.reserve(static_cast<typename std::vector<term_type>::size_type>(size1));
+            for (const auto ptr : v1) {
+                dbl.emplace_back(cf_type(ptr->m_cf + ptr->m_cf), ptr->m_key);
+            }
+        }
+        // First index in the second series of the terms multiplied by the i-th term of the first series.
+        auto rs = [square](const size_type &i) { return square ? i : size_type(0u); };
+        // Compute the product of the i-th term of the first series by the j-th term of the second series.
+        auto mult = [&v1, &v2, &dbl, square, this](std::array<term_type, arity> &tmp_t, const size_type &i,
+                                                    const size_type &j) {
+            key_type::multiply(tmp_t, (square && i != j) ? dbl[static_cast<decltype(dbl.size())>(i)] : *v1[i],
+                               *v2[j], this->m_ss);
+        };
+        // Estimate the size of the result if needed. As in plain_multiplication(), we always estimate in
+        // multithreaded mode, where the bucket count of the output series cannot change during the multiplication.
+        bool estimate = true;
+        const auto e_thr = tuning::get_estimate_threshold();
+        if (integer(size1) * size2 < integer(e_thr) * e_thr && n_threads == 1u) {
+            estimate = false;
+        }
+        if (estimate) {
+            const auto est
+                = this->template estimate_final_series_size<arity, typename base::template plain_multiplier<false>>();
+            const auto n_buckets = boost::numeric_cast<bucket_size_type>(
+                std::ceil(static_cast<double>(est) / container.max_load_factor()));
+            piranha_assert(n_buckets > 0u);
+            container.rehash(n_buckets, tuning::get_parallel_memory_set() ? n_threads : 1u);
+        }
+        const auto c_end = container.end();
+        // Accumulate the term t into the bucket of index b_idx of the output series. If steal is true,
+        // t will not be used anymore.
+        auto accumulate = [&container, c_end](term_type &t, const bucket_size_type &b_idx, bool steal) {
+            const auto it = container._find(t, b_idx);
+            if (it == c_end) {
+                // NOTE: move in coefficient series, as in base_series_multiplier. Other coefficients are
+                // copied, unless stolen, so that t can re-use its resources in the next multiplication.
+                if (steal || is_series<cf_type>::value) {
+                    container._unique_insert(std::move(t), b_idx);
+                } else {
+                    container._unique_insert(t, b_idx);
+                }
+            } else {
+                it->m_cf += t.m_cf;
+            }
+        };
+        // Halve the coefficients of the terms in the [a,b[ bucket range of the output series, erase the terms
+        // which become zero and return the number of terms left in the range.
+        // NOTE: there is no need to check for compatibility, as the trigonometric key always produces
+        // terms in canonical form.
+        auto sweep = [&container, this](bucket_size_type a, const bucket_size_type &b) {
+            bucket_size_type count = 0u;
+            std::vector<term_type> term_list;
+            for (; a != b; ++a) {
+                term_list.clear();
+                for (const auto &t : container._get_bucket_list(a)) {
+                    if constexpr (!rat_cf) {
+                        t.m_cf /= 2;
+                    }
+                    if (unlikely(t.is_zero(this->m_ss))) {
+                        term_list.push_back(t);
+                    } else {
+                        if (unlikely(count == std::numeric_limits<bucket_size_type>::max())) {
+                            piranha_throw(std::overflow_error, "overflow error in the number of terms of a series");
+                        }
+                        count = static_cast<bucket_size_type>(count + 1u);
+                    }
+                }
+                for (const auto &t : term_list) {
+                    container._erase(container._find(t, a));
+                }
+            }
+            return count;
+        };
+        if (n_threads == 1u) {
+            try {
+                std::array<term_type, arity> tmp_t;
+                auto f = [&tmp_t, &mult, &rs, &accumulate, &container, &retval, estimate](const size_type &i,
+                                                                                         const size_type &j) {
+                    if (j < rs(i)) {
+                        return;
+                    }
+                    mult(tmp_t, i, j);
+                    for (auto &t : tmp_t) {
+                        if (estimate) {
+                            accumulate(t, container._bucket(t), false);
+                        } else {
+                            retval.insert(t);
+                        }
+                    }
+                };
+                this->blocked_multiplication(f, 0u, size1);
+                container._update_size(sweep(0u, container.bucket_count()));
+                this->finalise_series(retval, 2u);
+            } catch (...) {
+                retval._container().clear();
+                throw;
+            }
+            return retval;
+        }
+        // Multi-threaded case.
+        const bucket_size_type b_count = container.bucket_count();
+        // Buckets per zone. The last zone also includes the remainder.
+        const auto bpz = static_cast<bucket_size_type>(b_count / n_threads);
+        auto zone_idx = [bpz, n_threads](const bucket_size_type &b_idx) {
+            return bpz ? std::min(static_cast<unsigned>(b_idx / bpz), n_threads - 1u) : n_threads - 1u;
+        };
+        auto zone_begin = [bpz](unsigned z) { return static_cast<bucket_size_type>(bpz * z); };
+        auto zone_end = [bpz, b_count, n_threads](unsigned z) {
+            return (z == n_threads - 1u) ? b_count : static_cast<bucket_size_type>(bpz * (z + 1u));
+        };
+        // The buffers: buffers[t][z] contains the terms computed by thread t which need to be accumulated
+        // in the zone z, together with their bucket indices.
+        using buffer_type = std::vector<std::pair<bucket_size_type, term_type>>;
+        std::vector<std::vector<buffer_type>> buffers(n_threads, std::vector<buffer_type>(n_threads));
+        // Number of rows processed in each round, chosen so that each thread computes roughly block_size**2
+        // term-by-term products per round.
+        const integer bs(tuning::get_multiplication_block_size());
+        const auto rows_per_round
+            = static_cast<size_type>(std::max(integer(1), std::min(integer(size1), bs * bs * n_threads / size2)));
+        // The number of terms left in each zone after the final sweep.
+        std::vector<bucket_size_type> counts(n_threads, bucket_size_type(0u));
+        // Run func(t) for each thread index t in the thread pool.
+        auto run_threads = [n_threads](const auto &func) {
+            task_group t_group;
             try {
-                for (unsigned i = 0u; i < this->m_n_threads; ++i) {
-                    const auto start_idx = static_cast<bucket_size_type>(bpt * i);
-                    // Special casing for the last thread.
-                    const auto end_idx = (i == this->m_n_threads - 1u) ? container.bucket_count()
-                                                                       : static_cast<bucket_size_type>(bpt * (i + 1u));
-                    ff_list.push_back(thread_pool::enqueue(i, divider, start_idx, end_idx));
+                for (unsigned i = 0u; i < n_threads; ++i) {
+                    t_group.run(i, func, i);
                 }
                 // First let's wait for everything to finish.
-                ff_list.wait_all();
+                t_group.wait_all();
                 // Then, let's handle the exceptions.
-                ff_list.get_all();
+                t_group.get_all();
             } catch (...) {
-                ff_list.wait_all();
-                // Clear out the container as it might be in an inconsistent state.
-                container.clear();
+                t_group.wait_all();
                 throw;
             }
-            // Final size update - all of this is noexcept.
-            const auto tot = total_erase_count.load();
-            piranha_assert(tot <= s.size());
-            container._update_size(static_cast<bucket_size_type>(s.size() - tot));
+        };
+        try {
+            for (size_type r_begin = 0u; r_begin < size1;) {
+                const auto r_end = static_cast<size_type>(
+                    r_begin + std::min(rows_per_round, static_cast<size_type>(size1 - r_begin)));
+                // Compute the products. Thread t takes the rows r_begin + t, r_begin + t + n_threads, etc.
+                run_threads([&, r_begin, r_end](unsigned t_idx) {
+                    std::array<term_type, arity> tmp_t;
+                    auto &bufs = buffers[t_idx];
+                    for (auto i = static_cast<size_type>(r_begin + t_idx); i < r_end;
+                         i = static_cast<size_type>(i + n_threads)) {
+                        for (auto j = rs(i); j < size2; ++j) {
+                            mult(tmp_t, i, j);
+                            for (auto &t : tmp_t) {
+                                const auto b_idx = container._bucket(t);
+                                bufs[zone_idx(b_idx)].emplace_back(b_idx, std::move(t));
+                            }
+                        }
+                    }
+                });
+                const bool last = (r_end == size1);
+                // Accumulate the buffered terms. Thread z owns the zone z.
+                run_threads([&, last](unsigned z) {
+                    for (auto &bufs : buffers) {
+                        auto &buf = bufs[z];
+                        for (auto &p : buf) {
+                            accumulate(p.second, p.first, true);
+                        }
+                        buf.clear();
+                    }
+                    if (last) {
+                        counts[z] = sweep(zone_begin(z), zone_end(z));
+                    }
+                });
+                r_begin = r_end;
+            }
+            integer tot(0);
+            for (const auto &c : counts) {
+                tot += c;
+            }
+            container._update_size(static_cast<bucket_size_type>(tot));
+            this->finalise_series(retval, 2u);
+        } catch (...) {
+            retval._container().clear();
+            throw;
         }
+        return retval;
     }
 
 public:
@@ -849,19 +1015,30 @@ public:
      * This operator is enabled only if the coefficient and key types of \p Series satisfy
      * piranha::key_is_multipliable.
      *
-     * The call operator will use base_series_multiplier::plain_multiplication().
+     * The call operator will compute the term-by-term products via the <tt>multiply()</tt> method of the
+     * trigonometric key. In multithreaded mode, the output series is subdivided in zones which are written
+     * by a single thread each, without locking. If the two operands are the same object, only half of the
+     * term-by-term products will be computed. The coefficients are halved in the final pass over the output
+     * series or, for mp++ rational coefficients, in base_series_multiplier::finalise_series().
      *
      * @return the result of the multiplication.
      *
-     * @throws unspecified any exception thrown by base_series_multiplier::plain_multiplication(),
-     * or by piranha::term::is_zero().
+     * @throws std::overflow_error if the number of terms in the result overflows its size type.
+     * @throws unspecified any exception thrown by:
+     * - base_series_multiplier::estimate_final_series_size(),
+     * - base_series_multiplier::blocked_multiplication(),
+     * - base_series_multiplier::finalise_series(),
+     * - the <tt>multiply()</tt> method of the key type,
+     * - the public and low-level interfaces of piranha::hash_set,
+     * - the arithmetic operators of the coefficient type,
+     * - piranha::term::is_zero(),
+     * - memory errors in standard containers,
+     * - task_group::run().
      */
     template <typename T = Series, call_enabler<T> = 0>
     Series operator()() const
     {
-        auto retval(this->plain_multiplication());
-        divide_by_two(retval);
-        return retval;
+        return zoned_multiplication();
     }
 };
 }
@@ -77,7 +77,9 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/math/degree.hpp>
 #include <piranha/math/is_zero.hpp>
 #include <piranha/math/pow.hpp>
+#include <piranha/memory.hpp>
 #include <piranha/monomial.hpp>
+#include <piranha/parallel.hpp>
 #include <piranha/power_series.hpp>
 #include <piranha/safe_cast.hpp>
 #include <piranha/series.hpp>
@@ -915,6 +917,28 @@ symbol_fset polynomial<Cf, Key>::s_at_degree_names;
 namespace detail
 {
 
+// Counter of the multiply-accumulate operations on polynomial coefficients in progress within the polynomial
+// multiplier on the current thread (see the polynomial specialisation of math::multiply_accumulate_impl).
+inline unsigned &poly_nested_fma_count()
+{
+    thread_local unsigned count = 0u;
+    return count;
+}
+
+// RAII helper to mark a multiply-accumulate operation on polynomial coefficients.
+struct poly_nested_fma {
+    poly_nested_fma()
+    {
+        ++poly_nested_fma_count();
+    }
+    ~poly_nested_fma()
+    {
+        --poly_nested_fma_count();
+    }
+    poly_nested_fma(const poly_nested_fma &) = delete;
+    poly_nested_fma &operator=(const poly_nested_fma &) = delete;
+};
+
 // Identification of key types for dispatching in the multiplier.
 template <typename T>
 struct is_kronecker_monomial {
@@ -1027,31 +1051,21 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
     {
         using expo_type = typename key_t<T>::value_type;
         using mm_vec = std::vector<std::pair<expo_type, expo_type>>;
-        using v_ptr = typename base::v_ptr;
+        using term_ptr_iter = typename base::v_ptr::const_pointer;
         // NOTE: we know that the input series are not null.
         piranha_assert(this->m_v1.size() != 0u && this->m_v2.size() != 0u);
         // Sync mutex, actually used only in mt mode.
         std::mutex mut;
         // The function used to determine minmaxs for the two series. This is used both in
         // single-thread and multi-thread mode.
-        auto thread_func = [&mut, this](unsigned t_idx, const v_ptr *vp, mm_vec *mmv) {
+        auto thread_func = [&mut, this](term_ptr_iter start, term_ptr_iter end, mm_vec *mmv) {
         // Checker for monomial sizes in debug mode.
 #if !defined(NDEBUG)
             auto monomial_checker
                 = [this](const typename Series::term_type &t) { return t.m_key.size() == this->m_ss.size(); };
 #endif
-            piranha_assert(t_idx < this->m_n_threads);
-            // Establish the block size.
-            const auto block_size = vp->size() / this->m_n_threads;
-            auto start = vp->data() + t_idx * block_size;
-            const auto end
-                = vp->data() + ((t_idx == this->m_n_threads - 1u) ? vp->size() : ((t_idx + 1u) * block_size));
-            // We need to make sure we have at least 1 element to process. This is guaranteed
-            // in the single-threaded implementation but not in multithreading.
-            if (start == end) {
-                piranha_assert(this->m_n_threads > 1u);
-                return;
-            }
+            // NOTE: the ranges passed in by check_bounds_impl() are never empty.
+            piranha_assert(start != end);
             piranha_assert(monomial_checker(**start));
             // Local vector that will hold the minmax values for this thread.
             mm_vec minmax_values;
@@ -1121,7 +1135,7 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
     {
         using value_type = typename key_t<Series>::value_type;
         using ka = kronecker_array<value_type>;
-        using v_ptr = typename base::v_ptr;
+        using term_ptr_iter = typename base::v_ptr::const_pointer;
         using mm_vec = std::vector<std::pair<value_type, value_type>>;
         piranha_assert(this->m_v1.size() != 0u && this->m_v2.size() != 0u);
         // NOTE: here we are sure about this since the symbol set in a series should never
@@ -1129,16 +1143,8 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
         // would kick in.
         piranha_assert(this->m_ss.size() < ka::get_limits().size());
         std::mutex mut;
-        auto thread_func = [&mut, this](unsigned t_idx, const v_ptr *vp, mm_vec *mmv) {
-            piranha_assert(t_idx < this->m_n_threads);
-            const auto block_size = vp->size() / this->m_n_threads;
-            auto start = vp->data() + t_idx * block_size;
-            const auto end
-                = vp->data() + ((t_idx == this->m_n_threads - 1u) ? vp->size() : ((t_idx + 1u) * block_size));
-            if (start == end) {
-                piranha_assert(this->m_n_threads > 1u);
-                return;
-            }
+        auto thread_func = [&mut, this](term_ptr_iter start, term_ptr_iter end, mm_vec *mmv) {
+            piranha_assert(start != end);
             mm_vec minmax_values;
             // Tmp vector for unpacking, inited with the first element in the range.
             // NOTE: we need to check that the exponents of the monomials in the result do not
@@ -1193,53 +1199,44 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
         }
     }
     // Implementation detail of the bound checking logic. This is common enough to be shared.
+    // If an operand was prepared, its minmax values are loaded from the cache rather than being recomputed.
     template <typename MmVec, typename Func>
     void check_bounds_impl(MmVec &minmax_values1, MmVec &minmax_values2, Func &thread_func) const
     {
-        if (this->m_n_threads == 1u) {
-            thread_func(0u, &(this->m_v1), &minmax_values1);
-            thread_func(0u, &(this->m_v2), &minmax_values2);
-        } else {
-            // Series 1.
-            {
-                future_list<void> ff_list;
-                try {
-                    for (unsigned i = 0u; i < this->m_n_threads; ++i) {
-                        ff_list.push_back(thread_pool::enqueue(i, thread_func, i, &(this->m_v1), &minmax_values1));
-                    }
-                    // First let's wait for everything to finish.
-                    ff_list.wait_all();
-                    // Then, let's handle the exceptions.
-                    ff_list.get_all();
-                } catch (...) {
-                    ff_list.wait_all();
-                    throw;
-                }
-            }
-            // Series 2.
-            {
-                future_list<void> ff_list;
-                try {
-                    for (unsigned i = 0u; i < this->m_n_threads; ++i) {
-                        ff_list.push_back(thread_pool::enqueue(i, thread_func, i, &(this->m_v2), &minmax_values2));
-                    }
-                    // First let's wait for everything to finish.
-                    ff_list.wait_all();
-                    // Then, let's handle the exceptions.
-                    ff_list.get_all();
-                } catch (...) {
-                    ff_list.wait_all();
-                    throw;
-                }
+        using mm_type = typename MmVec::value_type::first_type;
+        auto load_prepared = [](const prepared_operand<Series> *prep, MmVec &mmv) {
+            if (prep == nullptr || prep->_bounds().empty()) {
+                return false;
             }
+            std::transform(prep->_bounds().begin(), prep->_bounds().end(), std::back_inserter(mmv),
+                           [](const std::pair<integer, integer> &p) {
+                               return std::make_pair(static_cast<mm_type>(p.first), static_cast<mm_type>(p.second));
+                           });
+            return true;
+        };
+        const bool cached1 = load_prepared(this->m_prep1, minmax_values1),
+                   cached2 = load_prepared(this->m_prep2, minmax_values2);
+        // NOTE: in multi-threaded mode, the ranges of terms are claimed dynamically by the threads, and thread_func
+        // merges the minmax values of each range into the output vector.
+        auto run = [this, &thread_func](const typename base::v_ptr &v, MmVec &mmv) {
+            parallel_for(this->m_n_threads, decltype(v.size())(0u), v.size(),
+                         [&thread_func, &v, &mmv](const auto &b, const auto &e) {
+                             thread_func(v.data() + b, v.data() + e, &mmv);
+                         });
+        };
+        if (!cached1) {
+            run(this->m_v1, minmax_values1);
+        }
+        if (!cached2) {
+            run(this->m_v2, minmax_values2);
         }
     }
     // Enabler for the call operator.
     template <typename T>
     using call_enabler = typename std::enable_if<
         key_is_multipliable<cf_t<T>, key_t<T>>::value && has_multiply_accumulate<cf_t<T>>::value, int>::type;
-    // Utility helpers for the subtraction of degree types in the truncation routines. The specialisation
-    // for integral types will check the operation for overflow.
+    // Utility helpers for the subtraction and addition of degree types in the truncation and heap-based
+    // multiplication routines. The specialisations for integral types will check the operations for overflow.
     template <typename T, typename std::enable_if<!std::is_integral<T>::value, int>::type = 0>
     static T degree_sub(const T &a, const T &b)
     {
@@ -1250,6 +1247,16 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
     {
         return safe_int_sub(a, b);
     }
+    template <typename T, typename std::enable_if<!std::is_integral<T>::value, int>::type = 0>
+    static T degree_add(const T &a, const T &b)
+    {
+        return a + b;
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    static T degree_add(const T &a, const T &b)
+    {
+        return safe_int_add(a, b);
+    }
     // Dispatch of untruncated multiplication.
     template <typename T = Series,
               typename std::enable_if<detail::is_kronecker_monomial<typename T::term_type::key_type>::value, int>::type
@@ -1263,7 +1270,26 @@ class series_multiplier<Series, detail::poly_multiplier_enabler<Series>> : publi
               = 0>
     Series um_impl() const
     {
-        return this->plain_multiplication();
+        return this->m_square ? this->plain_squaring() : this->plain_multiplication();
+    }
+    // Dispatch of untruncated multiply-accumulate.
+    template <typename T = Series,
+              typename std::enable_if<detail::is_kronecker_monomial<typename T::term_type::key_type>::value, int>::type
+              = 0>
+    void uma_impl(Series &h) const
+    {
+        untruncated_kronecker_mult(h);
+    }
+    template <typename T = Series,
+              typename std::enable_if<!detail::is_kronecker_monomial<typename T::term_type::key_type>::value, int>::type
+              = 0>
+    void uma_impl(Series &h) const
+    {
+        if (this->m_square) {
+            this->plain_square_accumulate(h);
+        } else {
+            this->plain_multiply_accumulate(h);
+        }
     }
 
 public:
@@ -1285,8 +1311,7 @@ public:
      * - the base constructor,
      * - standard threading primitives,
      * - memory errors in standard containers,
-     * - thread_pool::enqueue(),
-     * - future_list::push_back().
+     * - piranha::parallel_for().
      */
     explicit series_multiplier(const Series &s1, const Series &s2) : base(s1, s2)
     {
@@ -1296,6 +1321,71 @@ public:
         }
         check_bounds();
     }
+    /// Constructor from a prepared operand.
+    /**
+     * This constructor is equivalent to the other constructor, but the first operand is taken from the
+     * piranha::prepared_operand \p p. The term pointers and the exponent bounds cached in \p p will be reused
+     * rather than being recomputed.
+     *
+     * @param p the prepared first operand.
+     * @param s2 second series operand.
+     *
+     * @throws std::overflow_error if a bounds check fails.
+     * @throws unspecified any exception thrown by the other constructor.
+     */
+    explicit series_multiplier(const prepared_operand<Series> &p, const Series &s2) : base(p, s2)
+    {
+        if (unlikely(this->m_v1.empty() || this->m_v2.empty() || this->m_ss.size() == 0u)) {
+            return;
+        }
+        check_bounds();
+    }
+    /// Prepare an operand.
+    /**
+     * This method is called by the constructor of piranha::prepared_operand. If the exponents of the key type of
+     * \p Series are of a C++ integral type, the minimum and maximum exponent of each symbol in the prepared
+     * series will be computed and stored in \p p, so that the bounds checks of subsequent multiplications will
+     * not need to examine the terms of the prepared series again. Otherwise, this method is a no-op.
+     *
+     * @param p the piranha::prepared_operand being constructed.
+     *
+     * @throws unspecified any exception thrown by memory errors in standard containers or by the unpacking of
+     * piranha::kronecker_monomial.
+     */
+    static void _prepare(prepared_operand<Series> &p)
+    {
+        using value_type = typename key_t<Series>::value_type;
+        if constexpr (std::is_integral<value_type>::value) {
+            const auto &v = p._term_pointers();
+            const auto &ss = p.get_series().get_symbol_set();
+            if (v.empty() || ss.size() == 0u) {
+                return;
+            }
+            std::vector<std::pair<value_type, value_type>> mm(
+                static_cast<decltype(ss.size())>(ss.size()),
+                std::make_pair(std::numeric_limits<value_type>::max(), std::numeric_limits<value_type>::min()));
+            auto update = [&mm](auto it) {
+                for (auto &p_mm : mm) {
+                    p_mm = update_minmax{}(p_mm, *it);
+                    ++it;
+                }
+            };
+            for (const auto ptr : v) {
+                if constexpr (detail::is_kronecker_monomial<key_t<Series>>::value) {
+                    const auto tmp = ptr->m_key.unpack(ss);
+                    update(tmp.begin());
+                } else {
+                    piranha_assert(ptr->m_key.size() == ss.size());
+                    update(ptr->m_key.begin());
+                }
+            }
+            auto &b = p._bounds();
+            b.clear();
+            std::transform(mm.begin(), mm.end(), std::back_inserter(b), [](const std::pair<value_type, value_type> &x) {
+                return std::make_pair(integer(x.first), integer(x.second));
+            });
+        }
+    }
     /// Perform multiplication.
     /**
      * \note
@@ -1316,7 +1406,7 @@ public:
      * @throws unspecified any exception thrown by:
      * - piranha::base_series_multiplier::plain_multiplication(),
      * - piranha::base_series_multiplier::estimate_final_series_size(),
-     * - piranha::base_series_multiplier::sanitise_series(),
+     * - piranha::base_series_multiplier::sanitise_accumulation(),
      * - piranha::base_series_multiplier::finalise_series(),
      * - <tt>boost::numeric_cast()</tt>,
      * - the public interface of piranha::hash_set,
@@ -1324,8 +1414,7 @@ public:
      * - memory errors in standard containers,
      * - piranha::math::mul3(),
      * - piranha::math::multiply_accumulate(),
-     * - thread_pool::enqueue(),
-     * - future_list::push_back(),
+     * - task_group::run(),
      * - _truncated_multiplication(),
      * - polynomial::get_auto_truncate_degree().
      */
@@ -1352,7 +1441,7 @@ public:
      * @throws unspecified any exception thrown by:
      * - piranha::base_series_multiplier::plain_multiplication(),
      * - piranha::base_series_multiplier::estimate_final_series_size(),
-     * - piranha::base_series_multiplier::sanitise_series(),
+     * - piranha::base_series_multiplier::sanitise_accumulation(),
      * - piranha::base_series_multiplier::finalise_series(),
      * - <tt>boost::numeric_cast()</tt>,
      * - the public interface of piranha::hash_set,
@@ -1360,13 +1449,47 @@ public:
      * - memory errors in standard containers,
      * - piranha::math::mul3(),
      * - piranha::math::multiply_accumulate(),
-     * - thread_pool::enqueue(),
-     * - future_list::push_back().
+     * - task_group::run().
      */
     Series _untruncated_multiplication() const
     {
         return um_impl();
     }
+    /// Multiply-accumulate.
+    /**
+     * \note
+     * This method can be used only if operator()() can be called.
+     *
+     * This method is equivalent to
+     * @code
+     * h += (*this)();
+     * @endcode
+     * but, unless a truncation is active, the terms of the product are accumulated directly into the container of
+     * \p h, which is rehashed at most once according to the estimated size of the result. No temporary series is
+     * created for the product, with the exception of polynomials with rational coefficients, whose products are
+     * accumulated directly only if \p h is empty.
+     *
+     * \p h must not be one of the operands used in the construction of \p this. Only the part of \p h touched
+     * by the accumulation is sanitised, and in case of exceptions \p h is left in the state described in
+     * piranha::base_series_multiplier::plain_multiply_accumulate().
+     *
+     * @param h the polynomial into which the product will be accumulated.
+     *
+     * @throws std::invalid_argument if the symbol set of \p h differs from the symbol set of the operands.
+     * @throws unspecified any exception thrown by operator()() or by the in-place addition of polynomials.
+     */
+    template <typename T = Series, call_enabler<T> = 0>
+    void _multiply_accumulate(Series &h) const
+    {
+        if (unlikely(h.get_symbol_set() != this->m_ss)) {
+            piranha_throw(std::invalid_argument, "incompatible symbol sets in polynomial multiply-accumulate");
+        }
+        if (check_truncation()) {
+            h += execute();
+            return;
+        }
+        uma_impl(h);
+    }
     /// Truncated multiplication.
     /**
      * \note
@@ -1445,7 +1568,7 @@ public:
         auto lf = [&sl](const size_type &idx1) {
             return sl[static_cast<typename std::vector<size_type>::size_type>(idx1)];
         };
-        return this->plain_multiplication(lf);
+        return tm_impl(v_d1, v_d2, max_degree, lf);
     }
     /// Establish skip limits for truncated multiplication.
     /**
@@ -1529,14 +1652,160 @@ public:
         piranha_assert(retval_checker());
         return retval;
     }
+    /// Heap-based multiplication.
+    /**
+     * \note
+     * This method can be used only if operator()() can be called and the key type of \p Series
+     * is a piranha::kronecker_monomial.
+     *
+     * This method will multiply the two polynomials used as input arguments in the class' constructor
+     * using the algorithm of Monagan and Pearce. The terms of the operands are sorted according to the
+     * total degree of their monomials and, for equal degree, according to their Kronecker codes. A binary heap
+     * containing at most one cursor per term of the first operand is then used to generate the term-by-term
+     * products in ascending order, so that the terms of the result are produced one at a time, with all their
+     * contributions already accumulated.
+     *
+     * The extra memory required by this algorithm is proportional to the size of the first operand (plus the
+     * size of the result), and no estimation of the size of the result is needed. The product is computed
+     * in a single thread, and the truncation settings are ignored.
+     *
+     * The generation of the result stops after \p max_terms non-null terms have been produced. The returned series
+     * will thus contain the \p max_terms terms of lowest degree of the product (with ties in the degree broken
+     * by the Kronecker codes).
+     *
+     * @param max_terms the maximum number of terms in the result.
+     *
+     * @return the result of the multiplication of the two operands used in the construction of \p this.
+     *
+     * @throws std::overflow_error if the computation of the degrees of the terms overflows.
+     * @throws unspecified any exception thrown by:
+     * - piranha::base_series_multiplier::sanitise_series(),
+     * - piranha::base_series_multiplier::finalise_series(),
+     * - <tt>boost::numeric_cast()</tt>,
+     * - the public interface of piranha::hash_set,
+     * - piranha::safe_cast(),
+     * - memory errors in standard containers,
+     * - piranha::math::mul3(),
+     * - piranha::math::multiply_accumulate(),
+     * - piranha::key_degree().
+     */
+    template <typename T = Series, call_enabler<T> = 0,
+              typename std::enable_if<detail::is_kronecker_monomial<key_t<T>>::value, int>::type = 0>
+    Series _heap_multiplication(
+        const typename Series::size_type &max_terms = std::numeric_limits<typename Series::size_type>::max()) const
+    {
+        using size_type = typename base::size_type;
+        using term_type = typename Series::term_type;
+        using key_type = key_t<Series>;
+        using int_type = decltype(key_type{}.get_int());
+        using degree_type = decltype(piranha::key_degree(key_type{}, this->m_ss));
+        // Sorting criterion: total degree of the monomial, then Kronecker code. This order is preserved
+        // by the multiplication of monomials.
+        using prio_type = std::pair<degree_type, int_type>;
+        auto &v1 = this->m_v1;
+        auto &v2 = this->m_v2;
+        const auto size1 = v1.size(), size2 = v2.size();
+        Series retval;
+        retval.set_symbol_set(this->m_ss);
+        if (unlikely(!size1 || !size2 || !max_terms)) {
+            return retval;
+        }
+        // Sort the operands and compute their priorities.
+        auto prio_sort = [this](typename base::v_ptr &v) {
+            std::vector<std::pair<prio_type, term_type const *>> tmp;
+            for (auto ptr : v) {
+                tmp.emplace_back(prio_type(piranha::key_degree(ptr->m_key, this->m_ss), ptr->m_key.get_int()), ptr);
+            }
+            std::stable_sort(tmp.begin(), tmp.end(),
+                             [](const std::pair<prio_type, term_type const *> &p1,
+                                const std::pair<prio_type, term_type const *> &p2) { return p1.first < p2.first; });
+            std::vector<prio_type> retval;
+            for (decltype(tmp.size()) i = 0u; i < tmp.size(); ++i) {
+                v[static_cast<decltype(v.size())>(i)] = tmp[i].second;
+                retval.push_back(tmp[i].first);
+            }
+            return retval;
+        };
+        const auto p1 = prio_sort(v1), p2 = prio_sort(v2);
+        // Priority of the product of the i-th term of the first series by the j-th term of the second one.
+        auto prio = [&p1, &p2](const std::pair<size_type, size_type> &c) {
+            const auto &a = p1[static_cast<decltype(p1.size())>(c.first)],
+                       &b = p2[static_cast<decltype(p2.size())>(c.second)];
+            return prio_type(degree_add(a.first, b.first), static_cast<int_type>(a.second + b.second));
+        };
+        // The heap of cursors, ordered so that the cursor with the lowest priority is at the top.
+        std::vector<std::pair<size_type, size_type>> heap;
+        heap.reserve(static_cast<decltype(heap.size())>(size1));
+        auto heap_cmp = [&prio](const std::pair<size_type, size_type> &c1, const std::pair<size_type, size_type> &c2) {
+            return prio(c2) < prio(c1);
+        };
+        // Pop the top of the heap, pushing the successors of the popped cursor. The successors
+        // are chosen so that each pair of indices is generated exactly once, and the heap never
+        // contains more than one cursor per term of the first series.
+        auto heap_pop = [&heap, &heap_cmp, size1, size2]() {
+            std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+            const auto c = heap.back();
+            heap.pop_back();
+            if (c.second == 0u && c.first + 1u < size1) {
+                heap.emplace_back(static_cast<size_type>(c.first + 1u), size_type(0u));
+                std::push_heap(heap.begin(), heap.end(), heap_cmp);
+            }
+            if (c.second + 1u < size2) {
+                heap.emplace_back(c.first, static_cast<size_type>(c.second + 1u));
+                std::push_heap(heap.begin(), heap.end(), heap_cmp);
+            }
+            return c;
+        };
+        // The terms of the result, in ascending order.
+        std::vector<term_type> terms;
+        heap.emplace_back(size_type(0u), size_type(0u));
+        while (!heap.empty() && terms.size() < max_terms) {
+            const auto cur_prio = prio(heap.front());
+            auto c = heap_pop();
+            term_type tmp_term;
+            tmp_term.m_key.set_int(cur_prio.second);
+            cf_mult_impl(tmp_term.m_cf, v1[c.first]->m_cf, v2[c.second]->m_cf);
+            // Accumulate all the products with the same monomial.
+            while (!heap.empty() && prio(heap.front()) == cur_prio) {
+                c = heap_pop();
+                this->fma_wrap(tmp_term.m_cf, v1[c.first]->m_cf, v2[c.second]->m_cf);
+            }
+            if (!math::is_zero(tmp_term.m_cf)) {
+                terms.push_back(std::move(tmp_term));
+            }
+        }
+        // Move the terms into retval.
+        try {
+            auto &container = retval._container();
+            container.rehash(boost::numeric_cast<typename Series::size_type>(
+                std::ceil(static_cast<double>(terms.size()) / container.max_load_factor())));
+            for (auto &t : terms) {
+                const auto b_idx = container._bucket(t);
+                container._unique_insert(std::move(t), b_idx);
+            }
+            this->sanitise_series(retval, 1u);
+            this->finalise_series(retval);
+        } catch (...) {
+            retval._container().clear();
+            throw;
+        }
+        return retval;
+    }
     //@}
 private:
     // NOTE: wrapper to multadd that treats specially rational coefficients. We need to decide in the future
     // if this stays here or if it is better to generalise it.
+    // NOTE: the multiply-accumulate of polynomial coefficients is marked as nested, so that it does not go
+    // through the polynomial specialisation of math::multiply_accumulate_impl (see below).
     template <typename T, typename std::enable_if<!mppp::detail::is_rational<T>::value, int>::type = 0>
     static void fma_wrap(T &a, const T &b, const T &c)
     {
-        math::multiply_accumulate(a, b, c);
+        if constexpr (std::is_base_of<detail::polynomial_tag, T>::value) {
+            const detail::poly_nested_fma nested;
+            math::multiply_accumulate(a, b, c);
+        } else {
+            math::multiply_accumulate(a, b, c);
+        }
     }
     template <typename T, typename std::enable_if<mppp::detail::is_rational<T>::value, int>::type = 0>
     static void fma_wrap(T &a, const T &b, const T &c)
@@ -1571,6 +1840,99 @@ private:
         const auto idx = ss_intersect_idx(this->m_ss, std::get<2u>(t));
         return _truncated_multiplication(std::get<1u>(t), std::get<2u>(t), idx);
     }
+    // Dispatch of truncated multiplication. v_d1 and v_d2 are the degrees of the terms in the two series, with
+    // the second series sorted by degree, and lf is the limits functor computed from them.
+    template <typename T, typename LimitFunctor, typename U = Series,
+              typename std::enable_if<!detail::is_kronecker_monomial<typename U::term_type::key_type>::value, int>::type
+              = 0>
+    Series tm_impl(std::vector<T> &, std::vector<T> &, const T &, const LimitFunctor &lf) const
+    {
+        return this->plain_multiplication(lf);
+    }
+    template <typename T, typename LimitFunctor, typename U = Series,
+              typename std::enable_if<detail::is_kronecker_monomial<typename U::term_type::key_type>::value, int>::type
+              = 0>
+    Series tm_impl(std::vector<T> &v_d1, std::vector<T> &v_d2, const T &max_degree, const LimitFunctor &lf) const
+    {
+        return truncated_kronecker_mult(v_d1, v_d2, max_degree, lf);
+    }
+    // Truncated Kronecker multiplication. This uses the same zoned scheduling as the untruncated
+    // multiplication: the second series is subdivided in segments of terms with the same degree,
+    // and the skip limits, which are always segment boundaries, determine which segments need to be
+    // multiplied by each term of the first series.
+    template <typename T, typename LimitFunctor>
+    Series truncated_kronecker_mult(std::vector<T> &v_d1, std::vector<T> &v_d2, const T &max_degree,
+                                    const LimitFunctor &lf) const
+    {
+        using size_type = typename base::size_type;
+        using d_size_type = typename std::vector<T>::size_type;
+        const auto size1 = this->m_v1.size(), size2 = this->m_v2.size();
+        Series retval;
+        retval.set_symbol_set(this->m_ss);
+        if (unlikely(!size1 || !size2)) {
+            return retval;
+        }
+        const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? this->m_n_threads : 1u;
+        // Same estimation logic as in the untruncated case.
+        const auto e_thr = tuning::get_estimate_threshold();
+        const bool estimate = integer(size1) * size2 >= integer(e_thr) * e_thr;
+        if (estimate) {
+            const auto est
+                = this->template estimate_final_series_size<1u, typename base::template plain_multiplier<false>>(lf);
+            retval._container().rehash(boost::numeric_cast<typename Series::size_type>(std::ceil(
+                                           static_cast<double>(est) / retval._container().max_load_factor())),
+                                       n_threads_rehash);
+        } else {
+            retval._container().rehash(heuristic_size(), n_threads_rehash);
+        }
+        piranha_assert(retval._container().bucket_count());
+        // Sort the first series by bucket and the second series by degree and bucket, applying the
+        // same permutations to the degree vectors.
+        const auto &container = retval._container();
+        auto r_bucket = [&container](typename Series::term_type const *p) {
+            return container._bucket_from_hash(p->hash());
+        };
+        auto apply_perm = [](const std::vector<size_type> &perm, auto &v, auto &v_d) {
+            std::remove_reference_t<decltype(v)> v_copy(v.size());
+            std::remove_reference_t<decltype(v_d)> v_d_copy(v_d.size());
+            for (decltype(perm.size()) i = 0u; i < perm.size(); ++i) {
+                v_copy[i] = v[perm[i]];
+                v_d_copy[static_cast<d_size_type>(i)] = v_d[static_cast<d_size_type>(perm[i])];
+            }
+            v = std::move(v_copy);
+            v_d = std::move(v_d_copy);
+        };
+        std::vector<size_type> perm(piranha::safe_cast<typename std::vector<size_type>::size_type>(size1));
+        std::iota(perm.begin(), perm.end(), size_type(0u));
+        std::stable_sort(perm.begin(), perm.end(), [&r_bucket, this](const size_type &i1, const size_type &i2) {
+            return r_bucket(this->m_v1[i1]) < r_bucket(this->m_v1[i2]);
+        });
+        apply_perm(perm, this->m_v1, v_d1);
+        perm.resize(piranha::safe_cast<typename std::vector<size_type>::size_type>(size2));
+        std::iota(perm.begin(), perm.end(), size_type(0u));
+        std::stable_sort(perm.begin(), perm.end(), [&r_bucket, &v_d2, this](const size_type &i1, const size_type &i2) {
+            const auto &d1 = v_d2[static_cast<d_size_type>(i1)], &d2 = v_d2[static_cast<d_size_type>(i2)];
+            return d1 < d2 || (!(d2 < d1) && r_bucket(this->m_v2[i1]) < r_bucket(this->m_v2[i2]));
+        });
+        apply_perm(perm, this->m_v2, v_d2);
+        // The operands are no longer stored in the same order.
+        this->m_square = false;
+        // Build the segments.
+        std::vector<size_type> segs{size_type(0u)};
+        for (size_type i = 1u; i < size2; ++i) {
+            if (v_d2[static_cast<d_size_type>(i - 1u)] < v_d2[static_cast<d_size_type>(i)]) {
+                segs.push_back(i);
+            }
+        }
+        segs.push_back(size2);
+        // The new skip limits.
+        const auto sl = _get_skip_limits(v_d1, v_d2, max_degree);
+        sparse_kronecker_multiplication(
+            retval, segs,
+            [&sl](const size_type &idx1) { return sl[static_cast<typename std::vector<size_type>::size_type>(idx1)]; },
+            !estimate, false);
+        return retval;
+    }
     // NOTE: the existence of these functors is because GCC 4.8 has troubles capturing variadic arguments in lambdas
     // in _truncated_multiplication, and we need to use std::bind instead. Once we switch to 4.9, we can revert
     // to lambdas and drop the <functional> header.
@@ -1614,8 +1976,8 @@ private:
     {
         return false;
     }
-    // Case 2: Kronecker mult, do the special multiplication unless a truncation is active. In that case, run the
-    // plain mult.
+    // Case 2: Kronecker mult, do the special multiplication unless a truncation is active. In that case, go
+    // through the truncated multiplication.
     template <typename T = Series,
               typename std::enable_if<detail::is_kronecker_monomial<typename T::term_type::key_type>::value, int>::type
               = 0>
@@ -1631,50 +1993,351 @@ private:
               = 0>
     Series untruncated_kronecker_mult() const
     {
-        // Cache the sizes.
-        const auto size1 = this->m_v1.size(), size2 = this->m_v2.size();
-        // Determine whether we want to estimate or not. We check the threshold, and
-        // we force the estimation in multithreaded mode.
-        bool estimate = true;
-        const auto e_thr = tuning::get_estimate_threshold();
-        if (integer(size1) * size2 < integer(e_thr) * e_thr && this->m_n_threads == 1u) {
-            estimate = false;
-        }
-        // If estimation is not worth it, we go with the plain multiplication.
-        // NOTE: this is probably not optimal, but we have to do like this as the sparse
-        // Kronecker multiplication below requires estimation. Maybe in the future we can
-        // have a version without estimation.
-        if (!estimate) {
-            return this->plain_multiplication();
-        }
         // Setup the return value.
         Series retval;
         retval.set_symbol_set(this->m_ss);
-        // Do not do anything if one of the two series is empty, just return an empty series.
+        untruncated_kronecker_mult(retval);
+        return retval;
+    }
+    // Untruncated Kronecker multiplication, accumulating the result into retval (which must have the
+    // merged symbol set).
+    template <typename T = Series,
+              typename std::enable_if<detail::is_kronecker_monomial<typename T::term_type::key_type>::value, int>::type
+              = 0>
+    void untruncated_kronecker_mult(Series &retval) const
+    {
+        // Cache the sizes.
+        const auto size1 = this->m_v1.size(), size2 = this->m_v2.size();
+        piranha_assert(retval.get_symbol_set() == this->m_ss);
+        // Do not do anything if one of the two series is empty.
         if (unlikely(!size1 || !size2)) {
-            return retval;
+            return;
+        }
+        // NOTE: the products of rational coefficients are accumulated as products of integral numerators,
+        // which is not compatible with the terms already present in retval.
+        if constexpr (mppp::detail::is_rational<cf_t<Series>>::value) {
+            if (!retval.empty()) {
+                retval += untruncated_kronecker_mult();
+                return;
+            }
         }
+        // The accumulation into retval goes through the low-level interface of its container, possibly from
+        // multiple threads, hence any pending incremental rehash must be completed first.
+        retval._container().complete_rehash();
         // Rehash the retun value's container accordingly. Check the tuning flag to see if we want to use
         // multiple threads for initing the return value.
         // NOTE: it is important here that we use the same n_threads for multiplication and memset as
         // we tie together pinned threads with potentially different NUMA regions.
         const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? this->m_n_threads : 1u;
+        // Determine whether we want to estimate or not. If the estimation is not worth it, we start
+        // from a heuristic size and let the sparse multiplication deal with the terms that do not fit.
+        // NOTE: the limits on the number of terms per zone in the multiplication without estimation
+        // do not account for the terms already present in retval, hence we always estimate when accumulating.
+        const auto e_thr = tuning::get_estimate_threshold();
+        if (integer(size1) * size2 < integer(e_thr) * e_thr && retval.empty()) {
+            retval._container().rehash(heuristic_size(), n_threads_rehash);
+            sparse_kronecker_multiplication(retval, true);
+            return;
+        }
         // Use the plain functor in normal mode for the estimation.
         const auto est
             = this->template estimate_final_series_size<1u, typename base::template plain_multiplier<false>>();
-        // NOTE: if something goes wrong here, no big deal as retval is still empty.
-        retval._container().rehash(boost::numeric_cast<typename Series::size_type>(
-                                       std::ceil(static_cast<double>(est) / retval._container().max_load_factor())),
-                                   n_threads_rehash);
+        // If the result is expected to fill a large enough portion of its exponent range, accumulate
+        // it into a flat array rather than into a hash table.
+        if (dense_kronecker_multiplication(retval, est)) {
+            return;
+        }
+        // NOTE: if something goes wrong here, no big deal as retval is still in a valid state.
+        const auto n_buckets = boost::numeric_cast<typename Series::size_type>(
+            std::ceil(static_cast<double>(est + retval.size()) / retval._container().max_load_factor()));
+        if (n_buckets > retval._container().bucket_count()) {
+            retval._container().rehash(n_buckets, n_threads_rehash);
+        }
         piranha_assert(retval._container().bucket_count());
-        sparse_kronecker_multiplication(retval);
-        return retval;
+        sparse_kronecker_multiplication(retval, false);
+    }
+    // Initial size of the result for the multiplication without estimation. In absence of cancellations,
+    // the size of the result is at least the size of the larger operand and at most the product of the sizes.
+    typename Series::size_type heuristic_size() const
+    {
+        const auto size1 = this->m_v1.size(), size2 = this->m_v2.size();
+        const integer prod = integer(size1) * size2, guess = integer(size1 > size2 ? size1 : size2) * 4;
+        return static_cast<typename Series::size_type>(prod < guess ? prod : guess);
     }
-    void sparse_kronecker_multiplication(Series &retval) const
+    // Dense Kronecker multiplication.
+    // The exponents of the result are re-encoded locally, using as strides the widths of the exponent ranges
+    // of the product (rather than the global limits of the Kronecker codification). The local code is then an
+    // index into a flat array of coefficients, and the local code of a product is the sum of the local codes
+    // of the factors, provided that the factors are encoded with respect to their own minimum exponents.
+    // If the estimated fill ratio of the array is below the tuning threshold, nothing is done and false is returned.
+    // Otherwise, the result is computed into retval and true is returned.
+    bool dense_kronecker_multiplication(Series &retval, const typename base::bucket_size_type &est) const
+    {
+        using term_type = typename Series::term_type;
+        using key_type = key_t<Series>;
+        using value_type = typename key_type::value_type;
+        using uvalue_type = typename std::make_unsigned<value_type>::type;
+        using v_type = typename key_type::v_type;
+        using ka = kronecker_array<value_type>;
+        using int_type = decltype(key_type{}.get_int());
+        using cf_type = cf_t<Series>;
+        // Pairs of local code and pointer to term.
+        using lc_vector = std::vector<std::pair<std::size_t, term_type const *>>;
+        const auto &v1 = this->m_v1;
+        const auto &v2 = this->m_v2;
+        const auto n_vars = this->m_ss.size();
+        piranha_assert(v1.size() && v2.size());
+        if (!n_vars) {
+            return false;
+        }
+        // Establish the minimum and maximum exponents of the operands.
+        auto minmax = [this, n_vars](const typename base::v_ptr &v) {
+            std::vector<std::pair<value_type, value_type>> retval;
+            auto tmp = v[0u]->m_key.unpack(this->m_ss);
+            for (const auto &e : tmp) {
+                retval.emplace_back(e, e);
+            }
+            for (decltype(v.size()) i = 1u; i < v.size(); ++i) {
+                tmp = v[i]->m_key.unpack(this->m_ss);
+                for (decltype(tmp.size()) j = 0u; j < n_vars; ++j) {
+                    retval[j] = update_minmax{}(retval[j], tmp[j]);
+                }
+            }
+            return retval;
+        };
+        const auto mm1 = minmax(v1), mm2 = minmax(v2);
+        // Compute the widths of the exponent ranges of the result, the strides of the local codification
+        // and the total size of the flat array.
+        std::vector<std::size_t> strides;
+        integer r_size(1);
+        for (decltype(mm1.size()) i = 0u; i < n_vars; ++i) {
+            strides.push_back(static_cast<std::size_t>(r_size));
+            r_size *= integer(mm1[i].second) + mm2[i].second - mm1[i].first - mm2[i].first + 1;
+            if (r_size > std::numeric_limits<std::size_t>::max()) {
+                return false;
+            }
+        }
+        // Check the estimated fill ratio.
+        if (integer(est) * 100 < r_size * tuning::get_dense_multiplication_threshold()) {
+            return false;
+        }
+        const auto a_size = static_cast<std::size_t>(r_size);
+        // Local codes of the operands, sorted in ascending order.
+        auto l_codes = [this, &strides, n_vars](const typename base::v_ptr &v,
+                                                const std::vector<std::pair<value_type, value_type>> &mm) {
+            lc_vector retval;
+            retval.reserve(static_cast<typename lc_vector::size_type>(v.size()));
+            for (auto ptr : v) {
+                const auto tmp = ptr->m_key.unpack(this->m_ss);
+                std::size_t lc = 0u;
+                for (decltype(tmp.size()) j = 0u; j < n_vars; ++j) {
+                    // NOTE: the difference is non-negative and it fits in the range of value_type's unsigned
+                    // counterpart, so it can be computed with modular arithmetic.
+                    lc += static_cast<std::size_t>(static_cast<uvalue_type>(static_cast<uvalue_type>(tmp[j])
+                                                                            - static_cast<uvalue_type>(mm[j].first)))
+                          * strides[j];
+                }
+                retval.emplace_back(lc, ptr);
+            }
+            std::stable_sort(retval.begin(), retval.end(),
+                             [](const typename lc_vector::value_type &p1, const typename lc_vector::value_type &p2) {
+                                 return p1.first < p2.first;
+                             });
+            return retval;
+        };
+        const auto lc1 = l_codes(v1, mm1), lc2 = l_codes(v2, mm2);
+        // When squaring, lc1 and lc2 contain the same terms in the same order, and only the products
+        // of the i-th term of lc1 by the terms of lc2 with index not less than i are computed. The cross
+        // products use the doubled coefficients.
+        const bool square = this->m_square;
+        std::vector<cf_type> dbl;
+        if (square) {
+            for (const auto &p : lc1) {
+                dbl.emplace_back(p.second->m_cf + p.second->m_cf);
+            }
+        }
+        // The accumulator.
+        const unsigned n_threads_memset = tuning::get_parallel_memory_set() ? this->m_n_threads : 1u;
+        auto acc = make_parallel_array<cf_type>(a_size, n_threads_memset);
+        auto acc_ptr = acc.get();
+        // Perform all the term-by-term multiplications whose result is written in the [a,b[ range
+        // of the accumulator.
+        auto zone_consume = [&lc1, &lc2, &dbl, square, acc_ptr, this](std::size_t a, std::size_t b) {
+            auto cmp = [](const typename lc_vector::value_type &p, const std::size_t &n) { return p.first < n; };
+            for (decltype(lc1.size()) i = 0u; i < lc1.size(); ++i) {
+                const auto &p1 = lc1[i];
+                if (p1.first >= b) {
+                    // The local codes in lc1 are sorted, no more products can end up in [a,b[.
+                    break;
+                }
+                auto start2 = a > p1.first ? std::lower_bound(lc2.begin(), lc2.end(), a - p1.first, cmp) : lc2.begin();
+                const auto end2 = std::lower_bound(start2, lc2.end(), b - p1.first, cmp);
+                if (square) {
+                    const auto diag = lc2.begin() + static_cast<typename lc_vector::difference_type>(i);
+                    if (start2 <= diag) {
+                        start2 = diag;
+                        if (start2 < end2) {
+                            this->fma_wrap(acc_ptr[p1.first + start2->first], p1.second->m_cf, start2->second->m_cf);
+                            ++start2;
+                        }
+                    }
+                }
+                const auto &cf1 = square ? dbl[i] : p1.second->m_cf;
+                for (; start2 < end2; ++start2) {
+                    this->fma_wrap(acc_ptr[p1.first + start2->first], cf1, start2->second->m_cf);
+                }
+            }
+        };
+        if (this->m_n_threads == 1u) {
+            zone_consume(0u, a_size);
+        } else {
+            // Subdivide the accumulator in zones, and let the threads pick them in the same fashion
+            // as in sparse_kronecker_multiplication().
+            const unsigned zm = 10u;
+            const std::size_t n_zones = static_cast<std::size_t>(integer(this->m_n_threads) * zm);
+            const std::size_t zs = a_size / n_zones;
+            detail::atomic_flag_array af(n_zones);
+            auto thread_functor = [&af, &zone_consume, zm, n_zones, zs, a_size](const unsigned &thread_idx) {
+                auto z_idx = static_cast<std::size_t>(std::size_t(thread_idx) * zm);
+                const auto start_z_idx = z_idx;
+                while (true) {
+                    if (!af[z_idx].test_and_set()) {
+                        zone_consume(z_idx * zs, z_idx == n_zones - 1u ? a_size : (z_idx + 1u) * zs);
+                    }
+                    z_idx = static_cast<std::size_t>(z_idx + 1u);
+                    if (z_idx == n_zones) {
+                        z_idx = 0u;
+                    }
+                    if (z_idx == start_z_idx) {
+                        break;
+                    }
+                }
+            };
+            task_group t_group;
+            try {
+                for (unsigned i = 0u; i < this->m_n_threads; ++i) {
+                    t_group.run(i, thread_functor, i);
+                }
+                t_group.wait_all();
+                t_group.get_all();
+            } catch (...) {
+                t_group.wait_all();
+                throw;
+            }
+        }
+        // Global codes of the minimum exponents of the result and of the local strides.
+        v_type tmp_v;
+        for (decltype(mm1.size()) i = 0u; i < n_vars; ++i) {
+            tmp_v.push_back(static_cast<value_type>(mm1[i].first + mm2[i].first));
+        }
+        const int_type min_code = ka::encode(tmp_v);
+        std::vector<int_type> g_strides;
+        for (decltype(mm1.size()) i = 0u; i < n_vars; ++i) {
+            std::fill(tmp_v.begin(), tmp_v.end(), value_type(0));
+            tmp_v[static_cast<decltype(tmp_v.size())>(i)] = value_type(1);
+            g_strides.push_back(ka::encode(tmp_v));
+        }
+        // Transfer the non-zero coefficients into retval. The number of inserted terms and the buckets
+        // in which zero terms might be present are recorded (see sanitise_accumulation()).
+        typename base::bucket_size_type n_new = 0u;
+        std::vector<typename base::bucket_size_type> zeros;
+        try {
+            const auto nnz = std::count_if(acc_ptr, acc_ptr + a_size, [](const cf_type &c) { return !math::is_zero(c); });
+            if (!nnz) {
+                return true;
+            }
+            const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? this->m_n_threads : 1u;
+            auto &container = retval._container();
+            // If retval already contains terms, the coefficients need to be added to the existing ones.
+            const bool accumulate = !container.empty();
+            const auto n_buckets = boost::numeric_cast<typename Series::size_type>(
+                std::ceil((static_cast<double>(nnz) + static_cast<double>(container.size()))
+                          / container.max_load_factor()));
+            if (n_buckets > container.bucket_count()) {
+                container.rehash(n_buckets, n_threads_rehash);
+            }
+            const auto it_end = container.end();
+            for (std::size_t i = 0u; i < a_size; ++i) {
+                if (math::is_zero(acc_ptr[i])) {
+                    continue;
+                }
+                // Decode the local code and turn it into a global one.
+                int_type code = min_code;
+                for (decltype(strides.size()) j = 0u; j < n_vars; ++j) {
+                    const auto width = j == n_vars - 1u ? a_size / strides[j] : strides[j + 1u] / strides[j];
+                    code = static_cast<int_type>(code + static_cast<int_type>((i / strides[j]) % width) * g_strides[j]);
+                }
+                term_type tmp_term(std::move(acc_ptr[i]), key_type(code));
+                const auto b_idx = container._bucket(tmp_term);
+                if (accumulate) {
+                    const auto it = container._find(tmp_term, b_idx);
+                    if (it != it_end) {
+                        it->m_cf += tmp_term.m_cf;
+                        if (unlikely(math::is_zero(it->m_cf))) {
+                            zeros.push_back(b_idx);
+                        }
+                        continue;
+                    }
+                }
+                container._unique_insert(std::move(tmp_term), b_idx);
+                ++n_new;
+            }
+            this->sanitise_accumulation(retval, n_new, zeros);
+            this->finalise_series(retval);
+        } catch (...) {
+            this->recover_accumulation(
+                retval, [&retval, &n_new, &zeros]() { base::sanitise_accumulation(retval, n_new, zeros); });
+            throw;
+        }
+        return true;
+    }
+    // Sort the operands according to the destination bucket in retval.
+    void sort_by_bucket(const Series &retval) const
+    {
+        using term_type = typename Series::term_type;
+        const auto &container = retval._container();
+        auto term_cmp = [&container](term_type const *p1, term_type const *p2) {
+            return container._bucket_from_hash(p1->hash()) < container._bucket_from_hash(p2->hash());
+        };
+        std::stable_sort(this->m_v1.begin(), this->m_v1.end(), term_cmp);
+        std::stable_sort(this->m_v2.begin(), this->m_v2.end(), term_cmp);
+    }
+    void sparse_kronecker_multiplication(Series &retval, bool overflow) const
+    {
+        using size_type = typename base::size_type;
+        sort_by_bucket(retval);
+        const auto size2 = this->m_v2.size();
+        sparse_kronecker_multiplication(retval, std::vector<size_type>{size_type(0u), size2},
+                                        [size2](const size_type &) { return size2; }, overflow, this->m_square);
+    }
+    // Sparse Kronecker multiplication, general form.
+    // The second series is subdivided in the segments [segs[k],segs[k + 1][, and the terms within each segment
+    // are sorted according to their destination bucket in retval, as are the terms of the first series.
+    // The term of index i in the first series is multiplied only by the terms of the second series with
+    // index less than lf(i), which must be one of the segment boundaries.
+    // If overflow is true, the size of retval was not estimated: in this case the number of terms written in
+    // each zone of retval is limited by the number of buckets in the zone, and the terms in excess are
+    // accumulated in per-zone overflow containers, which are merged into retval at the end.
+    // If square is true, the two series contain the same terms in the same order: the term of index i in the
+    // first series is then multiplied only by the terms of the second series with index not less than i, using
+    // the doubled coefficient for the cross products.
+    template <typename LimitFunctor>
+    void sparse_kronecker_multiplication(Series &retval, const std::vector<typename base::size_type> &segs,
+                                         const LimitFunctor &lf, bool overflow, bool square) const
     {
         using bucket_size_type = typename base::bucket_size_type;
         using size_type = typename base::size_type;
         using term_type = typename Series::term_type;
+        using cf_type = cf_t<Series>;
+        using container_type = std::remove_reference_t<decltype(retval._container())>;
+        // State of a zone of retval: number of terms written in the zone, max number of terms,
+        // overflow container and buckets of the zone which might contain zero terms (see sanitise_accumulation()).
+        struct zone_state {
+            bucket_size_type m_count;
+            bucket_size_type m_max;
+            container_type m_overflow;
+            std::vector<bucket_size_type> m_zeros;
+        };
         // Type representing multiplication tasks:
         // - the current term index from s1,
         // - the first term index in s2,
@@ -1686,13 +2349,20 @@ private:
         const auto size1 = v1.size();
         const auto size2 = v2.size();
         auto &container = retval._container();
+        piranha_assert(segs.size() >= 2u && segs.front() == 0u && segs.back() == size2);
+        piranha_assert(!square || size1 == size2);
+        // First index in the second series of the terms multiplied by the i-th term of the first series.
+        auto rs = [square](const size_type &i) { return square ? i : size_type(0u); };
+        // The doubled coefficients for the cross products in the squaring case.
+        std::vector<cf_type> dbl;
+        if (square) {
+            for (const auto ptr : v1) {
+                dbl.emplace_back(ptr->m_cf + ptr->m_cf);
+            }
+        }
         // A convenience functor to compute the destination bucket
         // of a term into retval.
         auto r_bucket = [&container](term_type const *p) { return container._bucket_from_hash(p->hash()); };
-        // Sort input terms according to bucket positions in retval.
-        auto term_cmp = [&r_bucket](term_type const *p1, term_type const *p2) { return r_bucket(p1) < r_bucket(p2); };
-        std::stable_sort(v1.begin(), v1.end(), term_cmp);
-        std::stable_sort(v2.begin(), v2.end(), term_cmp);
         // Task comparator. It will compare the bucket index of the terms resulting from
         // the multiplication of the term in the first series by the first term in the block
         // of the second series. This is essentially the first bucket index of retval in which the task
@@ -1719,10 +2389,13 @@ private:
         // End of the container, always the same value.
         const auto it_end = container.end();
         // Function to perform all the term-by-term multiplications in a task, using tmp_term
-        // as a temporary value for the computation of the result.
-        auto task_consume = [&v1, &v2, &container, it_end, this](const task_type &task, term_type &tmp_term) {
+        // as a temporary value for the computation of the result. z is the state of the zone
+        // of retval in which the task writes.
+        auto task_consume = [&v1, &v2, &dbl, &container, it_end, square, this](const task_type &task,
+                                                                                term_type &tmp_term, zone_state &z) {
             // Get the term in the first series.
-            auto t1 = v1[std::get<0u>(task)];
+            const auto idx1 = std::get<0u>(task);
+            auto t1 = v1[idx1];
             // Get pointers to the second series.
             // NOTE: don't use the subscript operator[] here, as these could point
             // one past the end of the vector.
@@ -1730,13 +2403,10 @@ private:
             auto end2 = v2.data() + std::get<2u>(task);
             // NOTE: these will have to be adapted for kd_monomial.
             using int_type = decltype(t1->m_key.get_int());
-            // Get shortcuts to cf and key in t1.
-            const auto &cf1 = t1->m_cf;
             const int_type key1 = t1->m_key.get_int();
-            // Iterate over the task.
-            for (; start2 != end2; ++start2) {
-                // Const ref to the current term in the second series.
-                const auto &cur = **start2;
+            // Multiply the term of key key1 and coefficient cf1 by cur, and accumulate the result.
+            auto term_consume = [&tmp_term, &z, &container, it_end, key1, this](const cf_type &cf1,
+                                                                                 const term_type &cur) {
                 // Add the keys.
                 // NOTE: this will have to be adapted for kd_monomial.
                 tmp_term.m_key.set_int(static_cast<int_type>(key1 + cur.m_key.get_int()));
@@ -1744,38 +2414,109 @@ private:
                 auto bucket_idx = container._bucket(tmp_term);
                 const auto it = container._find(tmp_term, bucket_idx);
                 if (it == it_end) {
-                    // NOTE: for coefficient series, we might want to insert with move() below,
-                    // as we are not going to re-use the allocated resources in tmp.m_cf.
-                    // Take care of multiplying the coefficient.
-                    cf_mult_impl(tmp_term.m_cf, cf1, cur.m_cf);
-                    container._unique_insert(tmp_term, bucket_idx);
+                    if (z.m_count < z.m_max) [[likely]] {
+                        // NOTE: for coefficient series, we might want to insert with move() below,
+                        // as we are not going to re-use the allocated resources in tmp.m_cf.
+                        // Take care of multiplying the coefficient.
+                        cf_mult_impl(tmp_term.m_cf, cf1, cur.m_cf);
+                        container._unique_insert(tmp_term, bucket_idx);
+                        z.m_count = static_cast<bucket_size_type>(z.m_count + 1u);
+                        if (unlikely(math::is_zero(tmp_term.m_cf))) {
+                            z.m_zeros.push_back(bucket_idx);
+                        }
+                    } else {
+                        // The zone is full, go through the overflow container.
+                        const auto o_it = z.m_overflow.find(tmp_term);
+                        if (o_it == z.m_overflow.end()) {
+                            cf_mult_impl(tmp_term.m_cf, cf1, cur.m_cf);
+                            z.m_overflow.insert(tmp_term);
+                        } else {
+                            this->fma_wrap(o_it->m_cf, cf1, cur.m_cf);
+                        }
+                    }
                 } else {
                     // NOTE: here we need to decide if we want to give the same treatment to fmp as we did with
                     // cf_mult_impl.
                     // For the moment it is an implementation detail of this class.
                     this->fma_wrap(it->m_cf, cf1, cur.m_cf);
+                    if (unlikely(math::is_zero(it->m_cf))) {
+                        z.m_zeros.push_back(bucket_idx);
+                    }
+                }
+            };
+            // When squaring, the product by the diagonal term (which can only be the first term of the task)
+            // uses the original coefficient, all the others the doubled one.
+            if (square && start2 != end2 && std::get<1u>(task) == idx1) {
+                term_consume(t1->m_cf, **start2);
+                ++start2;
+            }
+            const auto &cf1 = square ? dbl[static_cast<decltype(dbl.size())>(idx1)] : t1->m_cf;
+            // Iterate over the task.
+            for (; start2 != end2; ++start2) {
+                term_consume(cf1, **start2);
+            }
+        };
+        // Max number of terms in a zone of n_buckets buckets.
+        auto zone_max = [&container, overflow](const bucket_size_type &n_buckets) {
+            return overflow ? static_cast<bucket_size_type>(n_buckets * container.max_load_factor())
+                            : std::numeric_limits<bucket_size_type>::max();
+        };
+        // Account for the terms written in the zones and remove the zero terms from retval.
+        auto sanitise = [&retval](std::vector<zone_state> &zones) {
+            for (auto &z : zones) {
+                base::sanitise_accumulation(retval, z.m_count, z.m_zeros);
+            }
+        };
+        // Merge the overflow containers into retval. This needs to be called after sanitise().
+        auto merge_overflow = [&container, this](std::vector<zone_state> &zones) {
+            integer n_overflow(0);
+            for (const auto &z : zones) {
+                n_overflow += z.m_overflow.size();
+            }
+            if (n_overflow.is_zero()) {
+                return;
+            }
+            const unsigned n_threads_rehash = tuning::get_parallel_memory_set() ? this->m_n_threads : 1u;
+            container.rehash(boost::numeric_cast<bucket_size_type>(std::ceil(
+                                 static_cast<double>(n_overflow + container.size()) / container.max_load_factor())),
+                             n_threads_rehash);
+            for (auto &z : zones) {
+                for (const auto &t : z.m_overflow) {
+                    if (!math::is_zero(t.m_cf)) {
+                        container.insert(t);
+                    }
                 }
+                z.m_overflow.clear();
             }
         };
+        // The states of the zones of retval.
+        std::vector<zone_state> zones;
         if (this->m_n_threads == 1u) {
             try {
                 // Single threaded case.
                 // Create the vector of tasks.
                 std::vector<task_type> tasks;
                 for (decltype(v1.size()) i = 0u; i < size1; ++i) {
-                    task_split(std::make_tuple(i, size_type(0u), size2), tasks);
+                    const size_type limit = lf(i);
+                    for (decltype(segs.size()) k = 0u; k + 1u < segs.size() && segs[k + 1u] <= limit; ++k) {
+                        task_split(std::make_tuple(i, std::min(std::max(segs[k], rs(i)), segs[k + 1u]), segs[k + 1u]),
+                                   tasks);
+                    }
                 }
                 // Sort the tasks.
                 std::stable_sort(tasks.begin(), tasks.end(), task_cmp);
                 // Iterate over the tasks and run the multiplication.
                 term_type tmp_term;
+                zones.push_back(zone_state{0u, zone_max(container.bucket_count()), container_type{}, {}});
                 for (const auto &t : tasks) {
-                    task_consume(t, tmp_term);
+                    task_consume(t, tmp_term, zones[0u]);
                 }
-                this->sanitise_series(retval, this->m_n_threads);
+                sanitise(zones);
+                merge_overflow(zones);
                 this->finalise_series(retval);
             } catch (...) {
-                retval._container().clear();
+                // NOTE: the terms in the overflow containers are discarded.
+                this->recover_accumulation(retval, [&sanitise, &zones]() { sanitise(zones); });
                 throw;
             }
             return;
@@ -1798,12 +2539,12 @@ private:
         // term in v1 multiplied by the idx-th term in v2 will be written into retval at a bucket index not less than
         // zb.
         auto l_bound
-            = [&v1, &v2, &r_bucket, zm](size_type first, size_type last, bucket_size_type zb, size_type i) -> size_type {
+            = [&v1, &v2, &r_bucket](size_type first, size_type last, bucket_size_type zb, size_type i) -> size_type {
             piranha_assert(first <= last);
             bucket_size_type ib = r_bucket(v1[i]);
             // Avoid zb - ib below wrapping around.
             if (zb < ib) {
-                return 0u;
+                return first;
             }
             const auto cmp = static_cast<bucket_size_type>(zb - ib);
             size_type idx, step, count = static_cast<size_type>(last - first);
@@ -1825,14 +2566,36 @@ private:
             return first;
         };
         // Fill the task table.
-        auto table_filler = [&task_table, bpz, this, bucket_count, size1, size2, &l_bound, &task_split,
-                             &task_cmp,zm](const unsigned &thread_idx) {
-            for (unsigned n = 0u; n < zm; ++n) {
+        // Append to out the tasks of the i-th term of the first series writing into the [a,b[ bucket range.
+        // Returns true if all the products of the i-th term (and, hence, of the following terms) end up
+        // past the end of the range.
+        // NOTE: when squaring, the range of the i-th term is clipped from below at the index i. The
+        // following terms in the first series have both a larger bucket index and a larger clipping index, hence
+        // the past-the-end logic still holds.
+        auto zone_tasks = [&segs, &lf, &l_bound, &task_split, &rs, size2](size_type i, bucket_size_type a,
+                                                                            bucket_size_type b,
+                                                                            std::vector<task_type> &out) {
+            const size_type limit = lf(i);
+            bool past_end = true;
+            for (decltype(segs.size()) k = 0u; k + 1u < segs.size() && segs[k + 1u] <= limit; ++k) {
+                const size_type first = std::min(std::max(segs[k], rs(i)), segs[k + 1u]);
+                const auto t
+                    = std::make_tuple(i, l_bound(first, segs[k + 1u], a, i), l_bound(first, segs[k + 1u], b, i));
+                past_end = past_end && std::get<2u>(t) == first;
+                task_split(t, out);
+            }
+            // NOTE: if some of the segments are excluded by the limits, we cannot infer anything about the
+            // following terms.
+            return past_end && limit == size2;
+        };
+        auto table_filler = [&task_table, bpz, bucket_count, size1, &zone_tasks, &task_cmp,
+                             n_zones](bucket_size_type z, const bucket_size_type &z_end) {
+            for (; z != z_end; ++z) {
                 std::vector<task_type> cur_tasks;
                 // [a,b[ is the container zone.
-                bucket_size_type a = static_cast<bucket_size_type>(thread_idx * bpz * zm + n * bpz);
+                bucket_size_type a = static_cast<bucket_size_type>(z * bpz);
                 bucket_size_type b;
-                if (n == zm - 1u && thread_idx == this->m_n_threads - 1u) {
+                if (z == n_zones - 1u) {
                     // Special casing if this is the last zone in the container.
                     b = bucket_count;
                 } else {
@@ -1840,49 +2603,34 @@ private:
                 }
                 // First batch of tasks.
                 for (size_type i = 0u; i < size1; ++i) {
-                    auto t = std::make_tuple(i, l_bound(0u, size2, a, i), l_bound(0u, size2, b, i));
-                    if (std::get<1u>(t) == 0u && std::get<2u>(t) == 0u) {
+                    if (zone_tasks(i, a, b, cur_tasks)) {
                         // This means that all the next tasks we will compute will be empty,
                         // no sense in calculating them.
                         break;
                     }
-                    task_split(t, cur_tasks);
                 }
                 // Second batch of tasks.
                 // Note: we can always compute a,b + bucket_count because of the limits on the maximum value of
                 // bucket_count.
                 for (size_type i = 0u; i < size1; ++i) {
-                    auto t = std::make_tuple(i, l_bound(0u, size2, static_cast<bucket_size_type>(a + bucket_count), i),
-                                             l_bound(0u, size2, static_cast<bucket_size_type>(b + bucket_count), i));
-                    if (std::get<1u>(t) == 0u && std::get<2u>(t) == 0u) {
+                    if (zone_tasks(i, static_cast<bucket_size_type>(a + bucket_count),
+                                   static_cast<bucket_size_type>(b + bucket_count), cur_tasks)) {
                         break;
                     }
-                    task_split(t, cur_tasks);
                 }
                 // Sort the task vector.
                 std::stable_sort(cur_tasks.begin(), cur_tasks.end(), task_cmp);
                 // Move the vector of tasks in the table.
-                task_table[static_cast<decltype(task_table.size())>(thread_idx * zm + n)] = std::move(cur_tasks);
+                task_table[static_cast<decltype(task_table.size())>(z)] = std::move(cur_tasks);
             }
         };
-        // Go with the threads to fill the task table.
-        future_list<decltype(table_filler(0u))> ff_list;
-        try {
-            for (unsigned i = 0u; i < this->m_n_threads; ++i) {
-                ff_list.push_back(thread_pool::enqueue(i, table_filler, i));
-            }
-            // First let's wait for everything to finish.
-            ff_list.wait_all();
-            // Then, let's handle the exceptions.
-            ff_list.get_all();
-        } catch (...) {
-            ff_list.wait_all();
-            throw;
-        }
+        // Go with the threads to fill the task table. The cost of the zones varies wildly (e.g., when
+        // truncating or squaring), hence they are claimed dynamically by the threads.
+        parallel_for(this->m_n_threads, bucket_size_type(0u), n_zones, table_filler);
         // Check the consistency of the table for debug purposes.
-        auto table_checker = [&task_table, size1, size2, &r_bucket, bpz, bucket_count, &v1, &v2]() -> bool {
+        auto table_checker = [&task_table, size1, &lf, &rs, &r_bucket, bpz, bucket_count, &v1, &v2]() -> bool {
             // Total number of term-by-term multiplications. Needs to be equal
-            // to size1 * size2 at the end.
+            // to the sum of the limits at the end.
             integer tot_n(0);
             // Tmp term for multiplications.
             term_type tmp_term;
@@ -1911,14 +2659,24 @@ private:
                     }
                 }
             }
-            return tot_n == integer(size1) * size2;
+            integer tot_limits(0);
+            for (size_type i = 0u; i < size1; ++i) {
+                tot_limits += lf(i) - rs(i);
+            }
+            return tot_n == tot_limits;
         };
         (void)table_checker;
         piranha_assert(table_checker());
         // Init the vector of atomic flags.
         detail::atomic_flag_array af(piranha::safe_cast<std::size_t>(task_table.size()));
+        // Init the states of the zones.
+        for (decltype(task_table.size()) i = 0u; i < task_table.size(); ++i) {
+            zones.push_back(zone_state{
+                0u, zone_max(i == task_table.size() - 1u ? static_cast<bucket_size_type>(bucket_count - bpz * i) : bpz),
+                container_type{}, {}});
+        }
         // Thread functor.
-        auto thread_functor = [&task_table, &af, &task_consume, zm](const unsigned &thread_idx) {
+        auto thread_functor = [&task_table, &af, &task_consume, &zones, zm](const unsigned &thread_idx) {
             using t_size_type = decltype(task_table.size());
             // Temporary term_type for caching.
             term_type tmp_term;
@@ -1931,7 +2689,7 @@ private:
                     // Current vector of tasks.
                     const auto &cur_tasks = task_table[t_idx];
                     for (const auto &t : cur_tasks) {
-                        task_consume(t, tmp_term);
+                        task_consume(t, tmp_term, zones[t_idx]);
                     }
                 }
                 // Update the index, wrapping around if necessary.
@@ -1946,26 +2704,85 @@ private:
             }
         };
         // Go with the multiplication threads.
-        future_list<decltype(thread_functor(0u))> ft_list;
+        task_group t_group;
         try {
             for (unsigned i = 0u; i < this->m_n_threads; ++i) {
-                ft_list.push_back(thread_pool::enqueue(i, thread_functor, i));
+                t_group.run(i, thread_functor, i);
             }
             // First let's wait for everything to finish.
-            ft_list.wait_all();
+            t_group.wait_all();
             // Then, let's handle the exceptions.
-            ft_list.get_all();
+            t_group.get_all();
             // Finally, fix and finalise the series.
-            this->sanitise_series(retval, this->m_n_threads);
+            sanitise(zones);
+            merge_overflow(zones);
             this->finalise_series(retval);
         } catch (...) {
-            ft_list.wait_all();
-            // Clean up and re-throw.
-            retval._container().clear();
+            t_group.wait_all();
+            // Restore the invariants of retval and re-throw.
+            this->recover_accumulation(retval, [&sanitise, &zones]() { sanitise(zones); });
             throw;
         }
     }
 };
+
+namespace detail
+{
+
+// Enabler for the multiply-accumulate specialisation for polynomials.
+template <typename T>
+using poly_multiply_accumulate_t
+    = decltype(std::declval<const series_multiplier<T> &>()._multiply_accumulate(std::declval<T &>()));
+
+template <typename T>
+using poly_multiply_accumulate_enabler = enable_if_t<
+    conjunction<std::is_base_of<polynomial_tag, T>, is_detected<poly_multiply_accumulate_t, T>>::value>;
+}
+
+namespace math
+{
+
+/// Specialisation of the implementation of piranha::math::multiply_accumulate() for piranha::polynomial.
+/**
+ * This specialisation is enabled if \p T is an instance of piranha::polynomial supporting
+ * piranha::series_multiplier::_multiply_accumulate().
+ */
+template <typename T>
+struct multiply_accumulate_impl<T, detail::poly_multiply_accumulate_enabler<T>> {
+    /// Call operator.
+    /**
+     * If \p x is distinct from \p y and \p z and the three arguments have the same symbol set (or \p x is
+     * empty and \p y and \p z have the same symbol set), the product of \p y and \p z will be accumulated
+     * directly into \p x via piranha::series_multiplier::_multiply_accumulate(). The direct accumulation is
+     * reserved to top-level calls: when \p x, \p y and \p z are coefficients of an outer polynomial being
+     * multiplied by piranha::series_multiplier, or in all the other cases, the body of this operator is
+     * equivalent to:
+     * @code
+     * x += y * z;
+     * @endcode
+     *
+     * @param x target value for accumulation.
+     * @param y first argument.
+     * @param z second argument.
+     *
+     * @throws unspecified any exception thrown by piranha::series_multiplier::_multiply_accumulate(),
+     * or by the multiplication and in-place addition of polynomials.
+     */
+    void operator()(T &x, const T &y, const T &z) const
+    {
+        if (!detail::poly_nested_fma_count() && &x != &y && &x != &z && y.get_symbol_set() == z.get_symbol_set()) {
+            if (x.empty() && x.get_symbol_set() != y.get_symbol_set()) {
+                x.set_symbol_set(y.get_symbol_set());
+            }
+            if (x.get_symbol_set() == y.get_symbol_set()) {
+                series_multiplier<T>(y, z)._multiply_accumulate(x);
+                return;
+            }
+        }
+        x += y * z;
+    }
+};
+}
 }
 
 #endif
@@ -69,8 +69,12 @@ extern "C" {
 
 #endif
 
+#include <cstddef>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <piranha/config.hpp>
 #include <piranha/detail/init.hpp>
@@ -81,6 +85,83 @@ extern "C" {
 namespace piranha
 {
 
+namespace detail
+{
+
+// Parse a list of CPU indices in the format used by the Linux kernel (e.g., "0-3,8,10-11"), returning
+// the indices in the order in which they appear. Whitespace around the entries is ignored, an empty
+// (or whitespace-only) list results in an empty vector.
+inline std::vector<unsigned> parse_cpu_list(const std::string &str)
+{
+    std::vector<unsigned> retval;
+    const auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    const auto throw_invalid = [&str]() {
+        piranha_throw(std::invalid_argument, "invalid CPU list '" + str + "'");
+    };
+    // Parse an unsigned index from the range [begin, end).
+    const auto parse_index = [&str, &throw_invalid](std::size_t begin, std::size_t end) {
+        if (unlikely(begin == end)) {
+            throw_invalid();
+        }
+        unsigned long long n = 0u;
+        for (auto i = begin; i != end; ++i) {
+            if (unlikely(str[i] < '0' || str[i] > '9')) {
+                throw_invalid();
+            }
+            n = n * 10u + static_cast<unsigned>(str[i] - '0');
+            if (unlikely(n > 1000000ull)) {
+                // Guard against overflow and absurd indices.
+                throw_invalid();
+            }
+        }
+        return static_cast<unsigned>(n);
+    };
+    std::size_t begin = 0u;
+    const auto size = str.size();
+    while (begin < size && is_space(str[begin])) {
+        ++begin;
+    }
+    auto end = size;
+    while (end > begin && is_space(str[end - 1u])) {
+        --end;
+    }
+    if (begin == end) {
+        return retval;
+    }
+    while (true) {
+        auto comma = str.find(',', begin);
+        if (comma == std::string::npos || comma > end) {
+            comma = end;
+        }
+        // Trim the entry.
+        auto e_begin = begin, e_end = comma;
+        while (e_begin < e_end && is_space(str[e_begin])) {
+            ++e_begin;
+        }
+        while (e_end > e_begin && is_space(str[e_end - 1u])) {
+            --e_end;
+        }
+        const auto dash = str.find('-', e_begin);
+        if (dash != std::string::npos && dash < e_end) {
+            const auto first = parse_index(e_begin, dash), last = parse_index(dash + 1u, e_end);
+            if (unlikely(first > last)) {
+                throw_invalid();
+            }
+            for (auto i = first; i <= last; ++i) {
+                retval.push_back(i);
+            }
+        } else {
+            retval.push_back(parse_index(e_begin, e_end));
+        }
+        if (comma == end) {
+            break;
+        }
+        begin = comma + 1u;
+    }
+    return retval;
+}
+}
+
 /// Runtime information.
 /**
  * This class allows to query information about the runtime environment.
@@ -215,6 +296,51 @@ public:
         return 0u;
 #endif
     }
+    /// NUMA topology.
+    /**
+     * This function returns the NUMA topology of the machine as a vector of NUMA nodes, each node being
+     * represented by the list of the indices of the logical CPUs belonging to it. The nodes are listed in
+     * increasing order of node index.
+     *
+     * The detection is currently implemented only on Linux, via the \p sysfs interface. On other platforms, or if
+     * the detection fails, an empty vector will be returned.
+     *
+     * @return the list of NUMA nodes, or an empty vector if the topology cannot be determined.
+     */
+    static std::vector<std::vector<unsigned>> get_numa_nodes()
+    {
+        std::vector<std::vector<unsigned>> retval;
+#if defined(__linux__)
+        // Read the first line of a sysfs file.
+        const auto read_line = [](const std::string &name, std::string &line) {
+            std::ifstream sys_file(name);
+            if (!sys_file.is_open() || !sys_file.good()) {
+                return false;
+            }
+            return static_cast<bool>(std::getline(sys_file, line));
+        };
+        try {
+            const std::string node_dir = "/sys/devices/system/node/";
+            std::string line;
+            if (!read_line(node_dir + "online", line)) {
+                return retval;
+            }
+            for (auto node : detail::parse_cpu_list(line)) {
+                if (!read_line(node_dir + "node" + std::to_string(node) + "/cpulist", line)) {
+                    return {};
+                }
+                auto cpus = detail::parse_cpu_list(line);
+                // NOTE: memory-only nodes have no CPUs, skip them.
+                if (!cpus.empty()) {
+                    retval.push_back(std::move(cpus));
+                }
+            }
+        } catch (...) {
+            return {};
+        }
+#endif
+        return retval;
+    }
 };
 }
 
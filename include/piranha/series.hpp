@@ -46,6 +46,7 @@ see https://www.gnu.org/licenses/. */
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -59,11 +60,14 @@ see https://www.gnu.org/licenses/. */
 
 #include <piranha/config.hpp>
 #include <piranha/convert_to.hpp>
+#include <piranha/detail/bucket_partitioned_apply.hpp>
 #include <piranha/detail/debug_access.hpp>
 #include <piranha/detail/init.hpp>
 #include <piranha/detail/series_fwd.hpp>
 #include <piranha/detail/sfinae_types.hpp>
 #include <piranha/exceptions.hpp>
+#include <piranha/flat_hash_set.hpp>
+#include <piranha/hash_quality.hpp>
 #include <piranha/hash_set.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/invert.hpp>
@@ -83,6 +87,8 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/settings.hpp>
 #include <piranha/symbol_utils.hpp>
 #include <piranha/term.hpp>
+#include <piranha/thread_pool.hpp>
+#include <piranha/tuning.hpp>
 #include <piranha/type_traits.hpp>
 
 namespace piranha
@@ -565,6 +571,7 @@ class series_operators
         // std::move(a) + std::move(a).
         if (unlikely(&x == &y)) {
             retval.template merge_terms<Sign>(retval);
+            retval.auto_compact();
             return retval;
         }
         // NOTE: we do not use x any more, as it might have been moved.
@@ -585,6 +592,8 @@ class series_operators
                 retval.template merge_terms<Sign>(std::forward<U>(y));
             }
         }
+        // The terms of the operands might have cancelled out.
+        retval.auto_compact();
         return retval;
     }
     // NOTE: this case has no special algorithmic requirements, the base requirements for cf and series types
@@ -740,7 +749,11 @@ class series_operators
         template <typename T, typename U>
         series_common_type<T, U, 2> operator()(T &&x, U &&y) const
         {
-            return series_multiplier<series_common_type<T, U, 2>>(std::forward<T>(x), std::forward<U>(y))();
+            auto retval = series_multiplier<series_common_type<T, U, 2>>(std::forward<T>(x), std::forward<U>(y))();
+            // The table of the product was sized from an estimate of the number of terms, which can be
+            // grossly exceeding the actual size in case of cancellations or truncation.
+            retval.auto_compact();
+            return retval;
         }
     };
     template <typename T, typename U, typename std::enable_if<bso_type<T, U, 2>::value == 0u, int>::type = 0>
@@ -1245,6 +1258,20 @@ public:
     }
 };
 
+/// Series container selector.
+/**
+ * This class is used by piranha::series to select the type of the container in which the terms are stored.
+ * \p Derived is the final series type and \p Term its term type. The default implementation selects
+ * piranha::hash_set; it can be specialised (e.g., to piranha::flat_hash_set) in order to change the container
+ * used by a specific series type. The selected container must provide the same interface as piranha::hash_set,
+ * including the low-level methods.
+ */
+template <typename Derived, typename Term, typename Enable = void>
+struct series_container {
+    /// Container type.
+    using type = hash_set<Term>;
+};
+
 /// Series class.
 /**
  * This class contains the arithmetic and comparison operator overloads for piranha::series instances
@@ -1301,7 +1328,10 @@ private:
 
 protected:
     /// Container type for terms.
-    using container_type = hash_set<term_type>;
+    /**
+     * The container type is selected via piranha::series_container.
+     */
+    using container_type = typename series_container<Derived, term_type>::type;
 
 private:
     typedef decltype(std::declval<container_type>().evaluate_sparsity()) sparsity_info_type;
@@ -1354,6 +1384,18 @@ private:
 #pragma GCC diagnostic pop
 #endif
     }
+    // Detect support for the incremental rehash mode in the terms container.
+    template <typename C>
+    using incremental_rehash_t = decltype(std::declval<C &>().set_incremental_rehash(true));
+    // Increase the bucket count of the table of terms, incrementally if requested in piranha::tuning
+    // and supported by the terms container.
+    void increase_table_size()
+    {
+        if constexpr (is_detected<incremental_rehash_t, container_type>::value) {
+            m_container.set_incremental_rehash(tuning::get_incremental_rehash());
+        }
+        m_container._increase_size();
+    }
     // Insert compatible, non-ignorable term.
     template <bool Sign, typename T>
     void insertion_impl(T &&term)
@@ -1365,8 +1407,10 @@ private:
             m_container._increase_size();
         }
         // Try to locate the element.
-        auto bucket_idx = m_container._bucket(term);
-        const auto it = m_container._find(term, bucket_idx);
+        // NOTE: the hash value is computed only once, and reused for the insertion.
+        const auto h = m_container._hash(term);
+        auto bucket_idx = m_container._bucket_from_hash(h);
+        const auto it = m_container._find(term, bucket_idx, h);
         if (it == m_container.end()) {
             if (unlikely(m_container.size() == std::numeric_limits<size_type>::max())) {
                 piranha_throw(std::overflow_error, "maximum number of elements reached");
@@ -1375,11 +1419,15 @@ private:
             if (unlikely(static_cast<double>(m_container.size() + size_type(1u))
                              / static_cast<double>(m_container.bucket_count())
                          > m_container.max_load_factor())) {
-                m_container._increase_size();
+                increase_table_size();
                 // We need a new bucket index in case of a rehash.
-                bucket_idx = m_container._bucket(term);
+                bucket_idx = m_container._bucket_from_hash(h);
+            }
+            if constexpr (is_detected<incremental_rehash_t, container_type>::value) {
+                // Migrate a few buckets of a pending incremental rehash, as hash_set::insert() would do.
+                m_container._rehash_step();
             }
-            const auto new_it = m_container._unique_insert(std::forward<T>(term), bucket_idx);
+            const auto new_it = m_container._unique_insert(std::forward<T>(term), bucket_idx, h);
             m_container._update_size(m_container.size() + size_type(1u));
             // Insertion was successful, change sign if requested.
             if (!Sign) {
@@ -1416,6 +1464,17 @@ private:
     }
     template <typename T>
     using insert_enabler = enable_if_t<std::is_same<term_type, uncvref_t<T>>::value, int>;
+    template <typename Iterator>
+    using bulk_insert_enabler = enable_if_t<
+        conjunction<std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Iterator>::iterator_category>,
+                    std::is_same<term_type, uncvref_t<typename std::iterator_traits<Iterator>::reference>>>::value,
+        int>;
+    // Number of terms inserted and erased by a thread during bulk insertion.
+    struct bulk_insert_counts {
+        size_type m_inserted = 0u;
+        size_type m_erased = 0u;
+    };
     // Terms merging
     // =============
     // NOTE: ideas to improve the algorithm:
@@ -1440,6 +1499,28 @@ private:
     template <bool Sign, typename T>
     void merge_terms_impl1(T &&s, typename std::enable_if<!is_nonconst_rvalue_ref<T &&>::value>::type * = nullptr)
     {
+        if (m_container.empty()) {
+            // Merging into an empty series amounts to a copy of the container (which is parallelised
+            // for large series), followed by a negation of the coefficients for a subtraction.
+            m_container = s.m_container;
+            if (!Sign) {
+                try {
+                    const auto it_f = m_container.end();
+                    for (auto it = m_container.begin(); it != it_f;) {
+                        math::negate(it->m_cf);
+                        if (unlikely(it->is_zero(m_symbol_set))) {
+                            it = m_container.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
+                } catch (...) {
+                    m_container.clear();
+                    throw;
+                }
+            }
+            return;
+        }
         const auto it_f = s.m_container.end();
         try {
             for (auto it = s.m_container.begin(); it != it_f; ++it) {
@@ -1528,6 +1609,16 @@ private:
         static_assert(std::is_base_of<series<Cf, Key, Derived>, typename std::decay<T>::type>::value, "Type error.");
         merge_terms_impl0<Sign>(std::forward<T>(s));
     }
+    // Shrink the table of terms if its load factor dropped below the threshold set in piranha::tuning.
+    // This is used at the end of operations whose result could have been sized for many more terms.
+    void auto_compact()
+    {
+        const auto thr = tuning::get_compaction_threshold();
+        if (thr && m_container.bucket_count()
+            && m_container.load_factor() * 100. < m_container.max_load_factor() * static_cast<double>(thr)) {
+            shrink_to_fit();
+        }
+    }
     // Generic construction
     // ====================
     template <typename T, typename U = series,
@@ -1907,10 +1998,9 @@ private:
         // Size first.
         s_size_t s_size;
         boost_load(ar, s_size);
-        // Preallocate buckets.
-        _container().rehash(
-            boost::numeric_cast<s_size_t>(std::ceil(static_cast<double>(s_size) / _container().max_load_factor())));
-        // Insert all the terms.
+        // Load all the terms.
+        std::vector<term_type> terms;
+        terms.reserve(piranha::safe_cast<typename std::vector<term_type>::size_type>(s_size));
         for (s_size_t i = 0u; i < s_size; ++i) {
             // NOTE: the rationale for creating a new term each time is that if we move it, we have
             // no guarantees on the moved-from state (in particular, we cannot be certain that a moved-from
@@ -1919,8 +2009,10 @@ private:
             boost_load(ar, t.m_cf);
             boost_s11n_key_wrapper<typename term_type::key_type> w{t.m_key, ss};
             boost_load(ar, w);
-            insert(std::move(t));
+            terms.push_back(std::move(t));
         }
+        // Insert them in one go. The archive is not trusted, so duplicate keys are still accounted for.
+        bulk_insert(std::make_move_iterator(terms.begin()), std::make_move_iterator(terms.end()));
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 #endif
@@ -2024,6 +2116,8 @@ public:
     series() = default;
     /// Defaulted copy constructor.
     /**
+     * The terms of large series are copied in parallel (see the copy constructor of piranha::hash_set).
+     *
      * @throws unspecified any exception thrown by the copy constructor of piranha::hash_set.
      */
     series(const series &) = default;
@@ -2212,6 +2306,138 @@ public:
     {
         insert<true>(std::forward<T>(term));
     }
+    /// Insert a range of terms.
+    /**
+     * \note
+     * This method is enabled only if \p Iterator is a random-access iterator whose reference type is
+     * piranha::series::term_type, aside from cv qualifications and references.
+     *
+     * This method will insert the terms in the range [\p begin, \p end) into the series. The result is the same as
+     * calling insert() on each term of the range, in order, but the table of terms is resized at most once
+     * to fit the final number of terms, and, for large ranges, the terms are inserted in parallel (using the
+     * number of threads suggested by piranha::thread_pool::use_threads() and
+     * piranha::settings::get_min_work_per_thread()) after having been partitioned according to their destination
+     * bucket. The terms of the range are copied or moved depending on the reference type of \p Iterator (e.g.,
+     * <tt>std::move_iterator</tt> can be used to move them into the series).
+     *
+     * If \p unique is \p true, the terms of the range are assumed to have keys distinct from each other and from
+     * the keys of the terms already in the series, and they are inserted without any lookup. The behaviour is
+     * undefined if this assumption does not hold.
+     *
+     * If any exception is thrown, the series will be left empty.
+     *
+     * @param begin start of the range.
+     * @param end end of the range.
+     * @param unique flag signalling that the keys of the terms in the range are not in the series and are all
+     * distinct.
+     *
+     * @throws std::invalid_argument if a term of the range is incompatible.
+     * @throws std::overflow_error if the insertion could result in a number of terms exceeding the maximum
+     * value representable by piranha::series::size_type.
+     * @throws unspecified any exception thrown by:
+     * - the low-level interface of the terms container,
+     * - piranha::math::negate(), in-place addition/subtraction on coefficient types,
+     * - piranha::term::is_zero(),
+     * - piranha::term::is_compatible(),
+     * - the copy or move constructor of the term type,
+     * - piranha::thread_pool::use_threads(), piranha::task_group::run(),
+     * - memory errors in standard containers,
+     * - <tt>boost::numeric_cast()</tt>.
+     */
+    template <bool Sign, typename Iterator, bulk_insert_enabler<Iterator> = 0>
+    void bulk_insert(Iterator begin, Iterator end, bool unique = false)
+    {
+        if (begin == end) {
+            return;
+        }
+        const auto dist = std::distance(begin, end);
+        piranha_assert(dist > 0);
+        if (unlikely(static_cast<std::make_unsigned_t<decltype(dist)>>(dist)
+                     > std::numeric_limits<size_type>::max() - m_container.size())) {
+            piranha_throw(std::overflow_error, "maximum number of elements reached");
+        }
+        const auto n_final = static_cast<size_type>(m_container.size() + static_cast<size_type>(dist));
+        const auto n_threads
+            = thread_pool::use_threads(static_cast<unsigned long long>(dist), settings::get_min_work_per_thread());
+        auto inserter = [this, unique](bulk_insert_counts &c, const Iterator &it, const std::size_t &h) {
+            const term_type &t = *it;
+            if (unlikely(!t.is_compatible(this->m_symbol_set))) {
+                piranha_throw(std::invalid_argument, "cannot insert incompatible term");
+            }
+            if (unlikely(t.is_zero(this->m_symbol_set))) {
+                return;
+            }
+            const auto idx = this->m_container._bucket_from_hash(h);
+            if (unique) {
+                piranha_assert(this->m_container._find(t, idx, h) == this->m_container.end());
+            } else {
+                auto e_it = this->m_container._find(t, idx, h);
+                if (e_it != this->m_container.end()) {
+                    insertion_cf_arithmetics<Sign>(e_it, *it);
+                    if (unlikely(e_it->is_zero(this->m_symbol_set))) {
+                        this->m_container._erase(e_it);
+                        ++c.m_erased;
+                    }
+                    return;
+                }
+            }
+            const auto new_it = this->m_container._unique_insert(*it, idx, h);
+            ++c.m_inserted;
+            if (!Sign) {
+                math::negate(new_it->m_cf);
+                if (unlikely(new_it->is_zero(this->m_symbol_set))) {
+                    this->m_container._erase(new_it);
+                    ++c.m_erased;
+                }
+            }
+        };
+        try {
+            if constexpr (is_detected<incremental_rehash_t, container_type>::value) {
+                // The threads access the buckets via the low-level interface, which requires a completed rehash.
+                m_container.complete_rehash();
+            }
+            // Size the table for the final number of terms in one go.
+            if (static_cast<double>(n_final) / static_cast<double>(m_container.bucket_count())
+                > m_container.max_load_factor()) {
+                m_container.rehash(boost::numeric_cast<size_type>(
+                                       std::ceil(static_cast<double>(n_final) / m_container.max_load_factor())),
+                                   n_threads);
+            }
+            // NOTE: the number of terms is updated only at the end, as the low-level interface is used
+            // for the insertion.
+            size_type inserted = 0u, erased = 0u;
+            for (const auto &c : detail::bucket_partitioned_apply<bulk_insert_counts>(m_container, begin, end,
+                                                                                      n_threads, inserter)) {
+                inserted = static_cast<size_type>(inserted + c.m_inserted);
+                erased = static_cast<size_type>(erased + c.m_erased);
+            }
+            piranha_assert(erased <= m_container.size() + inserted);
+            m_container._update_size(static_cast<size_type>(m_container.size() + inserted - erased));
+        } catch (...) {
+            m_container.clear();
+            throw;
+        }
+    }
+    /// Insert a range of terms with <tt>Sign = true</tt>.
+    /**
+     * \note
+     * This method is enabled only if \p Iterator is a random-access iterator whose reference type is
+     * piranha::series::term_type, aside from cv qualifications and references.
+     *
+     * Convenience wrapper for the generic bulk_insert() method, with \p Sign set to \p true.
+     *
+     * @param begin start of the range.
+     * @param end end of the range.
+     * @param unique flag signalling that the keys of the terms in the range are not in the series and are all
+     * distinct.
+     *
+     * @throws unspecified any exception thrown by generic bulk_insert().
+     */
+    template <typename Iterator, bulk_insert_enabler<Iterator> = 0>
+    void bulk_insert(Iterator begin, Iterator end, bool unique = false)
+    {
+        bulk_insert<true>(begin, end, unique);
+    }
     /// Identity operator.
     /**
      * @return copy of \p this, cast to \p Derived.
@@ -2298,7 +2524,51 @@ public:
     {
         return m_container.bucket_count();
     }
+    /// Table hash quality.
+    /**
+     * Will call the \p evaluate_hash_quality() method of the internal terms container (e.g.,
+     * piranha::hash_set::evaluate_hash_quality()) and return the result. For large tables, the buckets are
+     * examined in parallel, using the number of threads suggested by piranha::thread_pool::use_threads() and
+     * piranha::settings::get_min_work_per_thread().
+     *
+     * The report can be used to detect key types whose hash values are poorly distributed among the buckets
+     * (see piranha::hash_quality::is_degenerate()).
+     *
+     * @return a report on the distribution of the terms in the internal container.
+     *
+     * @throws unspecified any exception thrown by the \p evaluate_hash_quality() method of the terms container
+     * or by piranha::thread_pool::use_threads().
+     */
+    hash_quality table_hash_quality() const
+    {
+        const auto b_count = m_container.bucket_count();
+        return m_container.evaluate_hash_quality(
+            b_count ? thread_pool::use_threads(static_cast<unsigned long long>(b_count),
+                                               settings::get_min_work_per_thread())
+                    : 1u);
+    }
     //@}
+    /// Shrink the table of terms.
+    /**
+     * Will call the \p shrink_to_fit() method of the internal terms container (e.g.,
+     * piranha::hash_set::shrink_to_fit()), so that the number of buckets is reduced to the minimum compatible
+     * with the number of terms in the series. For large series, the terms are migrated in parallel, using the
+     * number of threads suggested by piranha::thread_pool::use_threads() and
+     * piranha::settings::get_min_work_per_thread().
+     *
+     * This method is called automatically after some operations which can leave the table of terms mostly empty
+     * (see piranha::tuning::get_compaction_threshold()). If this method throws, \p this will be left empty.
+     *
+     * @throws unspecified any exception thrown by the \p shrink_to_fit() method of the terms container
+     * or by piranha::thread_pool::use_threads().
+     */
+    void shrink_to_fit()
+    {
+        const auto size = m_container.size();
+        m_container.shrink_to_fit(
+            size ? thread_pool::use_threads(static_cast<unsigned long long>(size), settings::get_min_work_per_thread())
+                 : 1u);
+    }
     /// Exponentiation.
     /**
      * \note
@@ -2315,6 +2585,11 @@ public:
      * - if \p x represents a non-negative integral value, the return value is constructed via repeated multiplications;
      * - otherwise, an exception will be raised.
      *
+     * If the tuning::get_pow_squaring() flag is set, the even powers \f$ 2k \f$ are computed by squaring the power
+     * \f$ k \f$, rather than by multiplying the power \f$ 2k-1 \f$ by \p this, whenever the estimated number of
+     * term-by-term multiplications of the squaring (which is about half the square of the number of terms of the
+     * power \f$ k \f$) is smaller.
+     *
      * An internal thread-safe cache of natural powers of series is maintained in order to improve performance during,
      * e.g., substitution operations. This cache can be cleared with clear_pow_cache().
      *
@@ -2390,7 +2665,23 @@ public:
         // Fill in the missing powers.
         while (v.size() <= n) {
             // NOTE: for series it seems like it is better to run the dumb algorithm instead of, e.g.,
-            // exponentiation by squaring - the growth in number of terms seems to be slower.
+            // exponentiation by squaring - the growth in number of terms seems to be slower. In the
+            // squaring mode, we square only when the squaring is expected to be cheaper than the
+            // multiplication by this.
+            if constexpr (std::is_same<decltype(std::declval<const m_type &>() * std::declval<const m_type &>()),
+                                       m_type>::value) {
+                const auto k = v.size();
+                if (tuning::get_pow_squaring() && k % 2u == 0u) {
+                    const auto &h = v[static_cast<s_type>(k / 2u)];
+                    if (integer(h.size()) * h.size() < integer(v.back().size()) * size() * 2) {
+                        // NOTE: h is multiplied by itself, so that the series multiplier can
+                        // use the squaring algorithm.
+                        auto tmp = h * h;
+                        v.push_back(std::move(tmp));
+                        continue;
+                    }
+                }
+            }
             v.push_back(v.back() * (*static_cast<Derived const *>(this)));
         }
         return ret_type(v[static_cast<s_type>(n)]);
@@ -2574,7 +2865,8 @@ public:
      *
      * @throw unspecified any exception thrown by:
      * - the call operator of \p func,
-     * - insert(),
+     * - bulk_insert(),
+     * - memory errors in standard containers,
      * - the assignment operator of piranha::symbol_fset,
      * - term, coefficient, key construction.
      */
@@ -2582,12 +2874,15 @@ public:
     {
         Derived retval;
         retval.m_symbol_set = m_symbol_set;
+        std::vector<term_type> terms;
         const auto it_f = this->m_container.end();
         for (auto it = this->m_container.begin(); it != it_f; ++it) {
             if (func(detail::pair_from_term<term_type, Derived>(m_symbol_set, *it))) {
-                retval.insert(*it);
+                terms.push_back(*it);
             }
         }
+        // The selected terms come from this, hence they are all distinct and compatible.
+        retval.bulk_insert(std::make_move_iterator(terms.begin()), std::make_move_iterator(terms.end()), true);
         return retval;
     }
     /// Term transformation.
@@ -2647,7 +2942,8 @@ public:
      * - piranha::safe_cast(),
      * - operations on piranha::symbol_fset,
      * - the trimming methods of coefficient and/or key,
-     * - insert(),
+     * - bulk_insert(),
+     * - memory errors in standard containers,
      * - term, coefficient and key type construction.
      */
     Derived trim() const
@@ -2662,9 +2958,12 @@ public:
         // Build the retval.
         Derived retval;
         retval.m_symbol_set = ss_trim(m_symbol_set, trim_mask);
+        std::vector<term_type> terms;
+        terms.reserve(static_cast<typename std::vector<term_type>::size_type>(size()));
         for (auto it = this->m_container.begin(); it != it_f; ++it) {
-            retval.insert(term_type{trim_cf_impl(it->m_cf), it->m_key.trim(trim_mask, m_symbol_set)});
+            terms.push_back(term_type{trim_cf_impl(it->m_cf), it->m_key.trim(trim_mask, m_symbol_set)});
         }
+        retval.bulk_insert(std::make_move_iterator(terms.begin()), std::make_move_iterator(terms.end()));
         return retval;
     }
     /// Print in TeX mode.
@@ -2898,6 +3197,179 @@ inline auto series_merge_f(S1 &&s1, S2 &&s2, const F &f) -> decltype(f(std::forw
 }
 } // namespace impl
 
+namespace detail
+{
+
+// Enabler for piranha::product().
+template <typename T, typename... Args>
+using series_product_enabler = typename std::enable_if<
+    conjunction<is_series<T>, std::is_same<T, Args>...,
+                std::is_same<decltype(std::declval<const T &>() * std::declval<const T &>()), T>,
+                std::is_constructible<T, int>>::value,
+    int>::type;
+
+// Estimate of the number of terms in the product of two series with the same symbol set, used by piranha::product()
+// to choose the order of the multiplications. The default implementation returns the number of term-by-term
+// products, which is an upper bound for the size of the product. It is specialised in base_series_multiplier.hpp
+// for the series whose multiplier derives from piranha::base_series_multiplier.
+template <typename T, typename = void>
+struct series_product_estimate {
+    static integer run(const T &a, const T &b)
+    {
+        return integer(a.size()) * b.size();
+    }
+};
+
+// Implementation of piranha::product().
+template <typename T>
+inline T series_product_impl(const std::vector<T const *> &ops)
+{
+    if (ops.empty()) {
+        return T(1);
+    }
+    // Establish the symbol set of the result, merging only the symbol sets of the operands.
+    symbol_fset ss = ops[0]->get_symbol_set();
+    for (const auto p : ops) {
+        if (p->get_symbol_set() != ss) {
+            ss = std::get<0>(ss_merge(ss, p->get_symbol_set()));
+        }
+    }
+    // The pool of the factors still to be multiplied. Each factor is represented by a pointer and by
+    // an owning pointer which is null for the original operands.
+    using pool_value = std::pair<T const *, std::shared_ptr<T>>;
+    std::vector<pool_value> pool;
+    // The operands whose symbol set differs from ss are replaced by copies with the extended symbol set.
+    // An operand appearing more than once is copied only once, so that the multiplier can still
+    // recognise the squaring of an operand.
+    std::vector<pool_value> copies;
+    for (const auto p : ops) {
+        if (p->get_symbol_set() == ss) {
+            pool.emplace_back(p, nullptr);
+            continue;
+        }
+        const auto it = std::find_if(copies.begin(), copies.end(), [p](const pool_value &c) { return c.first == p; });
+        if (it != copies.end()) {
+            pool.emplace_back(it->second.get(), it->second);
+            continue;
+        }
+        auto tmp = std::make_shared<T>(p->merge_arguments(ss, std::get<2>(ss_merge(ss, p->get_symbol_set()))));
+        copies.emplace_back(p, tmp);
+        pool.emplace_back(tmp.get(), std::move(tmp));
+    }
+    copies.clear();
+    // Each factor in the pool gets a unique id, used to cache the estimates of the pairwise products.
+    std::vector<unsigned long> ids;
+    for (decltype(pool.size()) i = 0u; i < pool.size(); ++i) {
+        ids.push_back(static_cast<unsigned long>(i));
+    }
+    auto next_id = static_cast<unsigned long>(pool.size());
+    std::map<std::pair<unsigned long, unsigned long>, integer> estimates;
+    // Multiply repeatedly the two factors whose product has the smallest estimated size, breaking ties with
+    // the number of term-by-term products. Keeping the intermediate results small keeps small the cost of
+    // the following multiplications.
+    while (pool.size() > 1u) {
+        using size_type = decltype(pool.size());
+        size_type best_i = 0u, best_j = 1u;
+        integer best_est, best_work;
+        for (size_type i = 0u; i < pool.size(); ++i) {
+            for (size_type j = i + 1u; j < pool.size(); ++j) {
+                const auto key = std::make_pair(ids[i], ids[j]);
+                auto it = estimates.find(key);
+                if (it == estimates.end()) {
+                    it = estimates.emplace(key, series_product_estimate<T>::run(*pool[i].first, *pool[j].first))
+                             .first;
+                }
+                const integer work = integer(pool[i].first->size()) * pool[j].first->size();
+                if ((i == 0u && j == 1u) || it->second < best_est || (it->second == best_est && work < best_work)) {
+                    best_i = i;
+                    best_j = j;
+                    best_est = it->second;
+                    best_work = work;
+                }
+            }
+        }
+        auto res = std::make_shared<T>(*pool[best_i].first * *pool[best_j].first);
+        // NOTE: this releases the intermediate results which are not needed any more. Erase
+        // the element with the largest index first.
+        pool.erase(pool.begin() + static_cast<std::ptrdiff_t>(best_j));
+        pool.erase(pool.begin() + static_cast<std::ptrdiff_t>(best_i));
+        ids.erase(ids.begin() + static_cast<std::ptrdiff_t>(best_j));
+        ids.erase(ids.begin() + static_cast<std::ptrdiff_t>(best_i));
+        pool.emplace_back(res.get(), std::move(res));
+        ids.push_back(next_id++);
+    }
+    if (pool[0].second && pool[0].second.use_count() == 1) {
+        return std::move(*pool[0].second);
+    }
+    return *pool[0].first;
+}
+} // namespace detail
+
+/// Product of series.
+/**
+ * \note
+ * This function is enabled only if \p T is an instance of piranha::series, all the types in \p Args are \p T,
+ * the product of two instances of \p T returns \p T and \p T is constructible from \p int.
+ *
+ * This function computes the product of the input series. The symbol set of the result is computed once
+ * from the symbol sets of all the operands, and each operand with a different symbol set is extended
+ * only once. The order of the binary multiplications is not necessarily left to right: at each step,
+ * the two factors (including the intermediate results) whose product has the smallest estimated number of terms
+ * are multiplied together, ties being broken by the number of term-by-term products. This keeps the intermediate
+ * results small, so that long chains of multiplications do not accumulate the cost of repeatedly multiplying
+ * a large intermediate result. For the series types whose multiplier derives from piranha::base_series_multiplier,
+ * the size of a product is estimated via piranha::base_series_multiplier::estimate_final_series_size() (if the
+ * number of term-by-term products is above the threshold returned by piranha::tuning::get_estimate_threshold()),
+ * otherwise it is estimated by the number of term-by-term products. If the same series appears more than once
+ * among the operands, its copies may be multiplied together via the squaring algorithm of the series multiplier.
+ *
+ * @param s the first operand.
+ * @param args the other operands.
+ *
+ * @return the product of the operands.
+ *
+ * @throws unspecified any exception thrown by:
+ * - series multiplication,
+ * - the construction of the series multiplier and the size estimation,
+ * - piranha::ss_merge(), piranha::series::merge_arguments(),
+ * - memory errors in standard containers.
+ */
+template <typename T, typename... Args, detail::series_product_enabler<T, Args...> = 0>
+inline T product(const T &s, const Args &... args)
+{
+    return detail::series_product_impl(std::vector<T const *>{&s, &args...});
+}
+
+/// Product of a range of series.
+/**
+ * \note
+ * This function is enabled only if \p It is a forward iterator whose value type satisfies the requirements
+ * of the variadic overload of piranha::product().
+ *
+ * This function computes the product of the series in the range <tt>[begin,end)</tt>, using the same
+ * algorithm of the variadic overload of piranha::product(). An empty range results in the series constructed
+ * from 1.
+ *
+ * @param begin the beginning of the range.
+ * @param end the end of the range.
+ *
+ * @return the product of the series in the range.
+ *
+ * @throws unspecified any exception thrown by the variadic overload of piranha::product().
+ */
+template <typename It,
+          typename std::enable_if<is_forward_iterator<It>::value, int>::type = 0,
+          detail::series_product_enabler<typename std::iterator_traits<It>::value_type> = 0>
+inline typename std::iterator_traits<It>::value_type product(It begin, It end)
+{
+    using value_type = typename std::iterator_traits<It>::value_type;
+    std::vector<value_type const *> ops;
+    for (; begin != end; ++begin) {
+        ops.push_back(&*begin);
+    }
+    return detail::series_product_impl(ops);
+}
+
 /// Specialisation of piranha::print_coefficient_impl for series.
 /**
  * This specialisation is enabled if \p Series is an instance of piranha::series.
@@ -3718,7 +4190,6 @@ struct msgpack_convert_impl<Series, series_msgpack_convert_enabler<Series>> {
         using term_type = typename Series::term_type;
         using cf_type = typename term_type::cf_type;
         using key_type = typename term_type::key_type;
-        using s_size_t = decltype(s.size());
         // Erase s.
         s = Series{};
         // Convert the object.
@@ -3733,10 +4204,9 @@ struct msgpack_convert_impl<Series, series_msgpack_convert_enabler<Series>> {
                            return tmp_str;
                        });
         s.set_symbol_set(symbol_fset(v_str.begin(), v_str.end()));
-        // Preallocate buckets.
-        s._container().rehash(boost::numeric_cast<s_size_t>(
-            std::ceil(static_cast<double>(tmp_v[1].size()) / s._container().max_load_factor())));
-        // Insert all the terms.
+        // Convert all the terms.
+        std::vector<term_type> terms;
+        terms.reserve(tmp_v[1].size());
         for (const auto &t : tmp_v[1]) {
             std::array<msgpack::object, 2> tmp_term;
             t.convert(tmp_term);
@@ -3744,8 +4214,10 @@ struct msgpack_convert_impl<Series, series_msgpack_convert_enabler<Series>> {
             key_type tmp_key;
             msgpack_convert(tmp_cf, tmp_term[0], f);
             tmp_key.msgpack_convert(tmp_term[1], f, s.get_symbol_set());
-            s.insert(term_type{std::move(tmp_cf), std::move(tmp_key)});
+            terms.emplace_back(std::move(tmp_cf), std::move(tmp_key));
         }
+        // Insert them in one go.
+        s.bulk_insert(std::make_move_iterator(terms.begin()), std::make_move_iterator(terms.end()));
     }
 };
 
@@ -126,6 +126,74 @@ public:
         const auto candidate = runtime_info::get_hardware_concurrency();
         set_n_threads((candidate > 0u) ? candidate : 1u);
     }
+    /// Set the thread binding policy.
+    /**
+     * This function is equivalent to piranha::thread_pool::set_binding().
+     *
+     * @param flag the desired thread binding policy.
+     *
+     * @throws unspecified any exception thrown by piranha::thread_pool::set_binding().
+     */
+    static void set_thread_binding(bool flag)
+    {
+        thread_pool::set_binding(flag);
+    }
+    /// Get the thread binding policy.
+    /**
+     * This function is equivalent to piranha::thread_pool::get_binding().
+     *
+     * @return the active thread binding policy.
+     *
+     * @throws unspecified any exception thrown by piranha::thread_pool::get_binding().
+     */
+    static bool get_thread_binding()
+    {
+        return thread_pool::get_binding();
+    }
+    /// Reset the thread binding policy.
+    /**
+     * Will disable thread binding.
+     *
+     * @throws unspecified any exception thrown by set_thread_binding().
+     */
+    static void reset_thread_binding()
+    {
+        set_thread_binding(false);
+    }
+    /// Set the nested parallelism policy.
+    /**
+     * This function is equivalent to piranha::thread_pool::set_nested_parallelism().
+     *
+     * @param flag the desired nested parallelism policy.
+     *
+     * @throws unspecified any exception thrown by piranha::thread_pool::set_nested_parallelism().
+     */
+    static void set_nested_parallelism(bool flag)
+    {
+        thread_pool::set_nested_parallelism(flag);
+    }
+    /// Get the nested parallelism policy.
+    /**
+     * This function is equivalent to piranha::thread_pool::get_nested_parallelism().
+     *
+     * @return the active nested parallelism policy.
+     *
+     * @throws unspecified any exception thrown by piranha::thread_pool::get_nested_parallelism().
+     */
+    static bool get_nested_parallelism()
+    {
+        return thread_pool::get_nested_parallelism();
+    }
+    /// Reset the nested parallelism policy.
+    /**
+     * Will enable nested parallelism.
+     *
+     * @throws unspecified any exception thrown by set_nested_parallelism().
+     */
+    static void reset_nested_parallelism()
+    {
+        set_nested_parallelism(true);
+    }
 
 
     /// Get the cache line size.
@@ -0,0 +1,179 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#ifndef PIRANHA_THREAD_MANAGEMENT_HPP
+#define PIRANHA_THREAD_MANAGEMENT_HPP
+
+#if defined(__linux__)
+
+extern "C" {
+#include <pthread.h>
+#include <sched.h>
+}
+
+#elif defined(_WIN32)
+
+extern "C" {
+#include <Windows.h>
+}
+#include <climits>
+
+#endif
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <piranha/config.hpp>
+#include <piranha/exceptions.hpp>
+
+namespace piranha
+{
+
+/// Thread management.
+/**
+ * \note
+ * The template parameter in this class is unused: its only purpose is to prevent the instantiation
+ * of the class' methods if they are not explicitly used. Client code should always employ the
+ * piranha::thread_management alias.
+ *
+ * This class provides static methods to manage the affinity of the calling thread. Thread binding is currently
+ * supported on Linux (via \p pthread_setaffinity_np()) and on Windows (via \p SetThreadAffinityMask()). On other
+ * platforms, the methods of this class will throw piranha::not_implemented_error.
+ */
+template <typename = void>
+class thread_management_
+{
+public:
+    /// Bind the calling thread to a processor.
+    /**
+     * Upon successful completion of this method, the calling thread will be confined to run only on the
+     * logical processor with index \p n.
+     *
+     * @param n index of the processor to which the thread will be bound.
+     *
+     * @throws std::invalid_argument if \p n exceeds the maximum processor index supported by the platform.
+     * @throws std::runtime_error if the low-level binding operation fails.
+     * @throws piranha::not_implemented_error if thread binding is not supported on the current platform.
+     */
+    static void bind_to_proc(unsigned n)
+    {
+#if defined(__linux__)
+        if (unlikely(n >= static_cast<unsigned>(CPU_SETSIZE))) {
+            piranha_throw(std::invalid_argument, "processor index " + std::to_string(n)
+                                                     + " is larger than the maximum allowed value ("
+                                                     + std::to_string(CPU_SETSIZE - 1) + ")");
+        }
+        ::cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(n, &cpuset);
+        if (unlikely(::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset))) {
+            piranha_throw(std::runtime_error, "the call to pthread_setaffinity_np() failed while binding to processor "
+                                                  + std::to_string(n));
+        }
+#elif defined(_WIN32)
+        if (unlikely(n >= static_cast<unsigned>(sizeof(::DWORD_PTR) * CHAR_BIT))) {
+            piranha_throw(std::invalid_argument, "processor index " + std::to_string(n)
+                                                     + " is larger than the maximum allowed value ("
+                                                     + std::to_string(sizeof(::DWORD_PTR) * CHAR_BIT - 1u) + ")");
+        }
+        if (unlikely(!::SetThreadAffinityMask(::GetCurrentThread(), ::DWORD_PTR(1) << n))) {
+            piranha_throw(std::runtime_error, "the call to SetThreadAffinityMask() failed while binding to processor "
+                                                  + std::to_string(n));
+        }
+#else
+        (void)n;
+        piranha_throw(not_implemented_error, "thread binding is not supported on this platform");
+#endif
+    }
+    /// Query if the calling thread is bound to a processor.
+    /**
+     * The first member of the returned pair is \p true if the calling thread can run on exactly one logical
+     * processor, in which case the second member is the index of that processor. Otherwise, the return value
+     * is <tt>(false, 0)</tt>.
+     *
+     * @return a pair describing the binding of the calling thread.
+     *
+     * @throws std::runtime_error if the low-level query operation fails.
+     * @throws piranha::not_implemented_error if thread binding is not supported on the current platform.
+     */
+    static std::pair<bool, unsigned> bound_proc()
+    {
+#if defined(__linux__)
+        ::cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (unlikely(::pthread_getaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset))) {
+            piranha_throw(std::runtime_error, "the call to pthread_getaffinity_np() failed");
+        }
+        if (CPU_COUNT(&cpuset) != 1) {
+            return std::make_pair(false, 0u);
+        }
+        for (unsigned i = 0u; i < static_cast<unsigned>(CPU_SETSIZE); ++i) {
+            if (CPU_ISSET(i, &cpuset)) {
+                return std::make_pair(true, i);
+            }
+        }
+        piranha_assert(false);
+        return std::make_pair(false, 0u);
+#elif defined(_WIN32)
+        // NOTE: there is no direct way of reading the affinity mask of a thread: we set it to the process'
+        // mask, which gives back the previous thread mask, and then we restore the original value.
+        ::DWORD_PTR p_mask, s_mask;
+        if (unlikely(!::GetProcessAffinityMask(::GetCurrentProcess(), &p_mask, &s_mask))) {
+            piranha_throw(std::runtime_error, "the call to GetProcessAffinityMask() failed");
+        }
+        const auto t_mask = ::SetThreadAffinityMask(::GetCurrentThread(), p_mask);
+        if (unlikely(!t_mask)) {
+            piranha_throw(std::runtime_error, "the call to SetThreadAffinityMask() failed");
+        }
+        if (unlikely(!::SetThreadAffinityMask(::GetCurrentThread(), t_mask))) {
+            piranha_throw(std::runtime_error, "the call to SetThreadAffinityMask() failed");
+        }
+        // Check that exactly one bit is set.
+        if (t_mask & (t_mask - 1u)) {
+            return std::make_pair(false, 0u);
+        }
+        unsigned retval = 0u;
+        for (auto m = t_mask; m != 1u; m >>= 1u) {
+            ++retval;
+        }
+        return std::make_pair(true, retval);
+#else
+        piranha_throw(not_implemented_error, "thread binding is not supported on this platform");
+#endif
+    }
+};
+
+/// Alias for piranha::thread_management_.
+/**
+ * This is the alias through which the methods in piranha::thread_management_ should be called.
+ */
+using thread_management = thread_management_<>;
+}
+
+#endif
@@ -32,16 +32,19 @@ see https://www.gnu.org/licenses/. */
 #include <algorithm>
 #include <atomic>
 #include <boost/lexical_cast.hpp>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdlib>
+#include <exception>
 #include <functional>
 #include <future>
 #include <ios>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -58,9 +61,12 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/config.hpp>
 #include <piranha/detail/atomic_lock_guard.hpp>
 #include <piranha/detail/init.hpp>
+#include <piranha/detail/small_task.hpp>
+#include <piranha/detail/work_stealing_deque.hpp>
 #include <piranha/exceptions.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/runtime_info.hpp>
+#include <piranha/thread_management.hpp>
 #include <piranha/type_traits.hpp>
 
 namespace piranha
@@ -69,42 +75,365 @@ namespace piranha
 inline namespace impl
 {
 
+// Type-erased nullary task, as stored in the task queues.
+// NOTE: the small buffer optimisation of small_task avoids the allocation of the wrapper
+// for the tasks created by make_task() and by task_group.
+using task_type = detail::small_task;
+
+// Node holding a task submitted to a worker group. The nodes are cached by the workers (see worker_group).
+struct task_node {
+    explicit task_node(unsigned owner) : m_owner(owner) {}
+    task_type m_task;
+    task_node *m_next = nullptr;
+    // Index of the worker in whose cache the node is recycled, or no_owner if the node is deleted after use.
+    const unsigned m_owner;
+    static constexpr unsigned no_owner = std::numeric_limits<unsigned>::max();
+};
+
+// Ring buffer of tasks, used for the tasks pinned to a worker. The storage is preallocated, and it grows
+// geometrically only when more than initial_size tasks are pending: in the steady state, pushing and popping
+// tasks does not allocate.
+class task_ring
+{
+public:
+    static constexpr std::size_t initial_size = 64u;
+    task_ring() : m_data(initial_size), m_head(0u), m_size(0u) {}
+    bool empty() const
+    {
+        return m_size == 0u;
+    }
+    // NOTE: the strong exception safety guarantee holds, as moving tasks does not throw.
+    void push(task_type &&task)
+    {
+        if (m_size == m_data.size()) {
+            std::vector<task_type> new_data(m_data.size() * 2u);
+            for (std::size_t i = 0u; i < m_size; ++i) {
+                new_data[i] = std::move(m_data[(m_head + i) & (m_data.size() - 1u)]);
+            }
+            m_data.swap(new_data);
+            m_head = 0u;
+        }
+        m_data[(m_head + m_size) & (m_data.size() - 1u)] = std::move(task);
+        ++m_size;
+    }
+    task_type pop()
+    {
+        piranha_assert(m_size > 0u);
+        task_type retval(std::move(m_data[m_head]));
+        m_head = (m_head + 1u) & (m_data.size() - 1u);
+        --m_size;
+        return retval;
+    }
+
+private:
+    // NOTE: the size of m_data is always a power of two.
+    std::vector<task_type> m_data;
+    std::size_t m_head;
+    std::size_t m_size;
+};
+
+// The shared state of a group of workers (i.e., the threads of a thread pool) implementing work stealing.
+// Each worker owns a work-stealing deque, into which it pushes the tasks it submits via submit(). The tasks
+// submitted from outside the group go into a shared injection queue. An idle worker first pops from its own deque,
+// then from the injection queue, and finally tries to steal from the deques of the other workers. The counter
+// of pending tasks and the sleeping flags of the workers are used to wake up idle workers when new tasks are
+// submitted.
+// The nodes holding the tasks submitted by a worker are taken from a cache owned by the worker, and they are given
+// back to it after the execution of the task, so that in the steady state the submission of tasks from within the
+// group (e.g., nested parallelism) does not allocate. A node executed by another worker (e.g., after a steal) is
+// pushed onto a lock-free stack of the owner, which the owner moves into its cache when the cache is empty.
+struct worker_group {
+    struct worker_slot {
+        detail::work_stealing_deque<task_node *> m_deque;
+        // NOTE: the mutex and condition variable are used also by the task_queue
+        // of the worker (i.e., they protect the pinned tasks as well).
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        bool m_sleeping = false;
+        // The node cache: m_free is accessed only by the owner, m_free_remote by everybody.
+        task_node *m_free = nullptr;
+        std::atomic<task_node *> m_free_remote{nullptr};
+    };
+    // Deleter giving back a node to the group after the execution of its task.
+    struct node_recycler {
+        void operator()(task_node *node) const noexcept
+        {
+            m_group->recycle(node);
+        }
+        worker_group *m_group;
+    };
+    using task_ptr = std::unique_ptr<task_node, node_recycler>;
+    explicit worker_group(unsigned size) : m_n_pending(0u), m_n_sleeping(0u), m_next(0u)
+    {
+        piranha_assert(size > 0u);
+        m_slots.reserve(static_cast<decltype(m_slots.size())>(size));
+        for (unsigned i = 0u; i < size; ++i) {
+            m_slots.emplace_back(new worker_slot);
+        }
+    }
+    worker_group(const worker_group &) = delete;
+    worker_group(worker_group &&) = delete;
+    worker_group &operator=(const worker_group &) = delete;
+    worker_group &operator=(worker_group &&) = delete;
+    ~worker_group()
+    {
+        // NOTE: the workers drain their deques and the injection queue before exiting.
+        piranha_assert(m_inj_head == nullptr);
+        piranha_assert(m_n_pending.load() == 0u);
+        auto free_list = [](task_node *node) {
+            while (node) {
+                delete std::exchange(node, node->m_next);
+            }
+        };
+        for (auto &sl : m_slots) {
+            free_list(sl->m_free);
+            free_list(sl->m_free_remote.load());
+        }
+    }
+    unsigned size() const
+    {
+        return static_cast<unsigned>(m_slots.size());
+    }
+    worker_slot &slot(unsigned idx)
+    {
+        piranha_assert(idx < m_slots.size());
+        return *m_slots[static_cast<decltype(m_slots.size())>(idx)];
+    }
+    // Submit a task. If the calling thread is a worker of this group, the task is pushed into its deque,
+    // otherwise it is added to the injection queue.
+    void submit(task_type &&task);
+    // Fetch a task for the worker idx. Returns null if no task could be found.
+    task_ptr acquire(unsigned idx)
+    {
+        if (m_n_pending.load() == 0u) {
+            return task_ptr(nullptr, node_recycler{this});
+        }
+        auto take = [this](task_node *p) {
+            m_n_pending.fetch_sub(1u);
+            return task_ptr(p, node_recycler{this});
+        };
+        if (auto p = slot(idx).m_deque.pop()) {
+            return take(p);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_inj_head) {
+                auto p = m_inj_head;
+                m_inj_head = p->m_next;
+                if (!m_inj_head) {
+                    m_inj_tail = nullptr;
+                }
+                return take(p);
+            }
+        }
+        const auto s = size();
+        for (unsigned k = 1u; k < s; ++k) {
+            if (auto p = slot((idx + k) % s).m_deque.steal()) {
+                return take(p);
+            }
+        }
+        return task_ptr(nullptr, node_recycler{this});
+    }
+    bool has_pending() const
+    {
+        return m_n_pending.load() != 0u;
+    }
+    // Check if the worker idx can exit, that is, if its deque and the injection queue are empty.
+    // Must be called from the worker idx.
+    bool can_exit(unsigned idx)
+    {
+        if (!slot(idx).m_deque.empty()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_inj_head == nullptr;
+    }
+    // Wake up a sleeping worker, if any, starting the search from a round-robin index.
+    void wake_one()
+    {
+        if (m_n_sleeping.load() == 0u) {
+            return;
+        }
+        const auto s = size();
+        const auto start = m_next.fetch_add(1u, std::memory_order_relaxed);
+        for (unsigned k = 0u; k < s; ++k) {
+            auto &sl = slot((start + k) % s);
+            std::unique_lock<std::mutex> lock(sl.m_mutex);
+            if (sl.m_sleeping) {
+                // NOTE: reset the flag so that concurrent submitters will pick another worker. The worker
+                // sets it again if it goes back to sleep.
+                sl.m_sleeping = false;
+                lock.unlock();
+                sl.m_cond.notify_one();
+                return;
+            }
+        }
+    }
+    // Data members.
+    // NOTE: these counters are accessed with sequential consistency: a worker increases m_n_sleeping before
+    // checking m_n_pending, a submitter increases m_n_pending before checking m_n_sleeping, so that either the
+    // worker sees the new task or the submitter sees the sleeping worker.
+    std::atomic<unsigned long long> m_n_pending;
+    std::atomic<unsigned> m_n_sleeping;
+    std::atomic<unsigned> m_next;
+    std::mutex m_mutex;
+    // The injection queue, as a list of nodes linked via m_next.
+    task_node *m_inj_head = nullptr;
+    task_node *m_inj_tail = nullptr;
+    std::vector<std::unique_ptr<worker_slot>> m_slots;
+
+private:
+    // Get a node from the cache of the calling worker, or allocate a new one.
+    task_node *new_node();
+    // Destroy the task of a node, and give the node back to its owner (or delete it).
+    void recycle(task_node *node) noexcept;
+};
+
+struct task_queue;
+
+// The worker group, the worker index and the task queue of the calling thread (null if the calling thread
+// is not a worker).
+template <typename = void>
+struct current_worker_ {
+    static thread_local worker_group *s_group;
+    static thread_local unsigned s_idx;
+    static thread_local task_queue *s_queue;
+};
+
+template <typename T>
+thread_local worker_group *current_worker_<T>::s_group = nullptr;
+
+template <typename T>
+thread_local unsigned current_worker_<T>::s_idx = 0u;
+
+template <typename T>
+thread_local task_queue *current_worker_<T>::s_queue = nullptr;
+
+using current_worker = current_worker_<>;
+
+inline task_node *worker_group::new_node()
+{
+    if (current_worker::s_group != this) {
+        return new task_node(task_node::no_owner);
+    }
+    auto &sl = slot(current_worker::s_idx);
+    if (!sl.m_free) {
+        sl.m_free = sl.m_free_remote.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (sl.m_free) {
+        return std::exchange(sl.m_free, sl.m_free->m_next);
+    }
+    return new task_node(current_worker::s_idx);
+}
+
+inline void worker_group::recycle(task_node *node) noexcept
+{
+    node->m_task.reset();
+    if (node->m_owner == task_node::no_owner) {
+        delete node;
+        return;
+    }
+    auto &sl = slot(node->m_owner);
+    if (current_worker::s_group == this && current_worker::s_idx == node->m_owner) {
+        node->m_next = sl.m_free;
+        sl.m_free = node;
+        return;
+    }
+    // NOTE: there is no ABA problem here, as the owner takes the whole stack at once.
+    auto head = sl.m_free_remote.load(std::memory_order_relaxed);
+    do {
+        node->m_next = head;
+    } while (!sl.m_free_remote.compare_exchange_weak(head, node, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+}
+
+inline void worker_group::submit(task_type &&task)
+{
+    piranha_assert(task);
+    task_ptr node(new_node(), node_recycler{this});
+    node->m_next = nullptr;
+    node->m_task = std::move(task);
+    m_n_pending.fetch_add(1u);
+    try {
+        if (current_worker::s_group == this) {
+            // NOTE: release the node only after a successful push, as the deque might need to grow.
+            slot(current_worker::s_idx).m_deque.push(node.get());
+            node.release();
+        } else {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto p = node.release();
+            if (m_inj_tail) {
+                m_inj_tail->m_next = p;
+            } else {
+                m_inj_head = p;
+            }
+            m_inj_tail = p;
+        }
+    } catch (...) {
+        m_n_pending.fetch_sub(1u);
+        throw;
+    }
+    wake_one();
+}
+
 // Task queue class. Inspired by:
 // https://github.com/progschj/ThreadPool
+// If bind is true, the thread consuming the queue will try to bind itself to the processor with index n.
+// The thread is the worker of index idx in the worker group: besides consuming the tasks enqueued in the task queue
+// (which are pinned to this thread), it will consume the tasks submitted to the group, stealing them from the other
+// workers when idle. If no group is provided, a new group containing only this worker will be created.
 struct task_queue {
-    task_queue(unsigned n, bool bind = false) : m_stop(false)
+    task_queue(unsigned n, bool bind = false, std::shared_ptr<worker_group> group = nullptr, unsigned idx = 0u)
+        : m_group(group ? std::move(group) : std::make_shared<worker_group>(1u)), m_idx(idx), m_stop(false),
+          m_cond(m_group->slot(idx).m_cond), m_mutex(m_group->slot(idx).m_mutex)
     {
-        auto runner = [this]() {
+        auto runner = [this, n, bind]() {
+            if (bind) {
+                // NOTE: binding is a best-effort operation (e.g., the processor might not be available
+                // to the process), failures are ignored and the thread will simply be left unbound.
+                // NOTE: logging candidate.
+                try {
+                    thread_management::bind_to_proc(n);
+                } catch (...) {
+                }
+            }
+            auto &group = *this->m_group;
+            auto &slot = group.slot(this->m_idx);
+            current_worker::s_group = &group;
+            current_worker::s_idx = this->m_idx;
+            current_worker::s_queue = this;
             try {
                 while (true) {
-                    std::unique_lock<std::mutex> lock(this->m_mutex);
-                    while (!this->m_stop && this->m_tasks.empty()) {
-                        // Need to wait for something to happen only if the task
-                        // list is empty and we are not stopping.
-                        // NOTE: wait will be noexcept in C++14.
-                        this->m_cond.wait(lock);
+                    if (this->run_one()) {
+                        continue;
                     }
-                    if (this->m_stop && this->m_tasks.empty()) {
+                    std::unique_lock<std::mutex> lock(this->m_mutex);
+                    if (this->m_stop && this->m_tasks.empty() && group.can_exit(this->m_idx)) {
                         // If the stop flag was set, and we do not have more tasks,
                         // just exit.
                         break;
                     }
-                    // NOTE: move constructor of std::function could throw, unfortunately.
-                    std::function<void()> task(std::move(this->m_tasks.front()));
-                    this->m_tasks.pop();
-                    lock.unlock();
-                    task();
+                    // Need to wait for something to happen only if there are no tasks
+                    // and we are not stopping.
+                    group.m_n_sleeping.fetch_add(1u);
+                    while (!this->m_stop && this->m_tasks.empty() && !group.has_pending()) {
+                        slot.m_sleeping = true;
+                        this->m_cond.wait(lock);
+                    }
+                    slot.m_sleeping = false;
+                    group.m_n_sleeping.fetch_sub(1u);
                 }
             } catch (...) {
                 // The errors we could get here are:
                 // - threading primitives,
-                // - move-construction of std::function,
-                // - queue popping (I guess unlikely, as the destructor of std::function
-                //   is noexcept).
+                // - exceptions escaping from the tasks (the tasks created by make_task() and by
+                //   task_group do not throw).
                 // In any case, not much that can be done to recover from this, better to abort.
                 // NOTE: logging candidate.
                 std::abort();
             }
+            current_worker::s_group = nullptr;
+            current_worker::s_queue = nullptr;
 #if defined(MPPP_WITH_MPFR)
             // If mp++ has been configured with mpfr, freee the MPFR caches
             // on thread termination.
@@ -162,29 +491,65 @@ struct task_queue {
                                             std::is_move_constructible<uncvref_t<Args>>>>...,
                     is_returnable<f_ret_type<F, Args...>>>::value,
         int>;
-    // Main enqueue function.
+    // Create a type-erased task from F and args, returning it together with the future that will store its result.
     template <typename F, typename... Args, enabler<F &&, Args &&...> = 0>
-    std::future<f_ret_type<F &&, Args &&...>> enqueue(F &&f, Args &&... args)
+    static std::pair<task_type, std::future<f_ret_type<F &&, Args &&...>>> make_task(F &&f, Args &&... args)
     {
         using ret_type = f_ret_type<F &&, Args &&...>;
         using p_task_type = std::packaged_task<ret_type()>;
         // NOTE: here we have a multi-stage construction of the task:
         // - std::bind() turns F into a nullary functor,
         // - std::packaged_task gives us the std::future machinery,
-        // - std::function (in m_tasks) gives the uniform type interface via type erasure.
-        auto task = std::make_shared<p_task_type>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-        std::future<ret_type> res = task->get_future();
+        // - task_type gives the uniform type interface via type erasure.
+        // The only allocation is the one of the shared state of the packaged task, as the packaged task
+        // fits in the internal buffer of task_type.
+        p_task_type task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<ret_type> res = task.get_future();
+        return std::make_pair(task_type(std::move(task)), std::move(res));
+    }
+    // Main enqueue function.
+    template <typename F, typename... Args, enabler<F &&, Args &&...> = 0>
+    std::future<f_ret_type<F &&, Args &&...>> enqueue(F &&f, Args &&... args)
+    {
+        auto t = make_task(std::forward<F>(f), std::forward<Args>(args)...);
+        push(std::move(t.first));
+        return std::move(t.second);
+    }
+    // Add a task to the queue.
+    void push(task_type &&task)
+    {
         {
             std::unique_lock<std::mutex> lock(m_mutex);
             if (unlikely(m_stop)) {
                 // Enqueueing is not allowed if the queue is stopped.
                 piranha_throw(std::runtime_error, "cannot enqueue task while the task queue is stopping");
             }
-            m_tasks.push([task]() { (*task)(); });
+            m_tasks.push(std::move(task));
         }
         // NOTE: notify_one is noexcept.
         m_cond.notify_one();
-        return res;
+    }
+    // Run one of the tasks available to this worker: a pinned task if there is one (pinned tasks have the
+    // precedence), otherwise a task of the worker group. Returns false if no task was found. Must be called
+    // from the thread consuming this queue.
+    bool run_one()
+    {
+        task_type task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_tasks.empty()) {
+                task = m_tasks.pop();
+            }
+        }
+        if (task) {
+            task();
+            return true;
+        }
+        if (auto g_task = m_group->acquire(m_idx)) {
+            g_task->m_task();
+            return true;
+        }
+        return false;
     }
     // NOTE: we call this only from dtor, it is here in order to be able to test it.
     // So the exception handling in dtor will suffice, keep it in mind if things change.
@@ -205,13 +570,39 @@ struct task_queue {
     }
 
     // Data members.
+    std::shared_ptr<worker_group> m_group;
+    unsigned m_idx;
     bool m_stop;
-    std::condition_variable m_cond;
-    std::mutex m_mutex;
-    std::queue<std::function<void()>> m_tasks;
+    std::condition_variable &m_cond;
+    std::mutex &m_mutex;
+    task_ring m_tasks;
     std::thread m_thread;
 };
 
+// Wait for the future f to become ready. If the calling thread is a worker of a thread pool, instead of blocking it
+// will run the tasks available to it while waiting (help-while-waiting). This allows the threads of the pool to
+// submit tasks and wait for them without deadlocks: the tasks pinned to the waiting thread are run by the waiting
+// thread itself, and the tasks in its deque are either run by the waiting thread or stolen by the idle workers.
+// NOTE: the tasks are run on top of the stack of the waiting task, so the waiting task might resume only after
+// the completion of a task which is not related to it. This is the usual tradeoff of help-while-waiting.
+template <typename T>
+inline void wait_helping(const std::future<T> &f)
+{
+    auto q = current_worker::s_queue;
+    if (q == nullptr) {
+        f.wait();
+        return;
+    }
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (!q->run_one()) {
+            // NOTE: there is nothing to run at the moment. The task we are waiting for is being run by
+            // another thread: wait a little bit and try again, as new tasks might have been submitted
+            // in the meantime.
+            f.wait_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
 // Type to represent thread queues: a vector of task queues paired with a set of thread ids.
 using thread_queues_t = std::pair<std::vector<std::unique_ptr<task_queue>>, std::unordered_set<std::thread::id>>;
 
@@ -222,9 +613,10 @@ inline thread_queues_t get_initial_thread_queues()
     const unsigned candidate = runtime_info::get_hardware_concurrency(), hc = (candidate > 0u) ? candidate : 1u;
     retval.first.reserve(static_cast<decltype(retval.first.size())>(hc));
 
+    auto group = std::make_shared<worker_group>(hc);
     for (unsigned i = 0u; i < hc; ++i) {
         // NOTE: thread binding is disabled on startup.
-        retval.first.emplace_back(::new task_queue(i, false));
+        retval.first.emplace_back(::new task_queue(i, false, group, i));
     }
 
     // Generate the set of thread IDs.
@@ -242,10 +634,31 @@ inline thread_queues_t get_initial_thread_queues()
     return retval;
 }
 
+// The default list of processors used for thread binding. The processors are grouped by NUMA node, so that
+// threads with contiguous indices in the pool are bound to processors belonging to the same node. If the
+// NUMA topology cannot be determined, the list will be [0, 1, ..., hardware_concurrency - 1].
+inline std::vector<unsigned> get_default_cpu_list()
+{
+    std::vector<unsigned> retval;
+    for (const auto &node : runtime_info::get_numa_nodes()) {
+        retval.insert(retval.end(), node.begin(), node.end());
+    }
+    if (retval.empty()) {
+        const unsigned candidate = runtime_info::get_hardware_concurrency(), hc = (candidate > 0u) ? candidate : 1u;
+        for (unsigned i = 0u; i < hc; ++i) {
+            retval.push_back(i);
+        }
+    }
+    return retval;
+}
+
 template <typename = void>
 struct thread_pool_base {
     static thread_queues_t s_queues;
     static std::atomic_flag s_atf;
+    static bool s_bind;
+    static std::vector<unsigned> s_cpu_list;
+    static bool s_nested;
 };
 
 template <typename T>
@@ -254,6 +667,15 @@ thread_queues_t thread_pool_base<T>::s_queues = get_initial_thread_queues();
 template <typename T>
 std::atomic_flag thread_pool_base<T>::s_atf = ATOMIC_FLAG_INIT;
 
+template <typename T>
+bool thread_pool_base<T>::s_bind = false;
+
+template <typename T>
+std::vector<unsigned> thread_pool_base<T>::s_cpu_list = get_default_cpu_list();
+
+template <typename T>
+bool thread_pool_base<T>::s_nested = true;
+
 
 template <typename>
 void thread_pool_shutdown();
@@ -270,9 +692,13 @@ void thread_pool_shutdown();
  * The number of threads created initially is equal to piranha::runtime_info::get_hardware_concurrency().
  * If the hardware concurrency cannot be determined, the size of the thread pool will be one.
  *
- * This class provides methods to enqueue arbitray tasks to the threads in the pool, query the size of the pool,
+ * This class provides methods to enqueue arbitray tasks to specific threads in the pool (enqueue()) or to any thread
+ * in the pool (enqueue_any(), relying on work stealing to balance the load), query the size of the pool,
  * resize the pool and configure the thread binding policy. All methods, unless otherwise specified, are thread-safe,
  * and they provide the strong exception safety guarantee.
+ *
+ * The tasks whose return value is not needed can be submitted via piranha::task_group, which tracks their completion
+ * without the overhead of an \p std::future per task.
  */
 // \todo work around MSVC bug in destruction of statically allocated threads (if needed once we support MSVC), as per:
 // http://stackoverflow.com/questions/10915233/stdthreadjoin-hangs-if-called-after-main-exits-when-using-vs2012-rc
@@ -282,6 +708,7 @@ template <typename T = void>
 class thread_pool_ : private thread_pool_base<>
 {
     friend void piranha::impl::thread_pool_shutdown<T>();
+    friend class task_group;
     using base = thread_pool_base<>;
     // Enabler for use_threads.
     template <typename Int>
@@ -290,6 +717,35 @@ class thread_pool_ : private thread_pool_base<>
     // The return type for enqueue().
     template <typename F, typename... Args>
     using enqueue_t = decltype(std::declval<task_queue &>().enqueue(std::declval<F>(), std::declval<Args>()...));
+    // The queue of the n-th thread. Must be called with s_atf locked.
+    static task_queue &queue_at(unsigned n)
+    {
+        if (unlikely(n >= s_queues.first.size())) {
+            piranha_throw(std::invalid_argument, "the thread index " + std::to_string(n)
+                                                     + " is out of range, the thread pool contains only "
+                                                     + std::to_string(s_queues.first.size()) + " threads");
+        }
+        return *base::s_queues.first[static_cast<decltype(base::s_queues.first.size())>(n)];
+    }
+    // Push a task pinned to the thread of the queue q. Must be called with s_atf locked.
+    static void push_task(task_queue &q, task_type &&task)
+    {
+        if (base::s_nested && current_worker::s_group == q.m_group.get()) {
+            // NOTE: nested submission from a thread of the pool. The threads with the lowest indices might
+            // be busy, let the work-stealing scheduler find the idle ones.
+            q.m_group->submit(std::move(task));
+        } else {
+            q.push(std::move(task));
+        }
+    }
+    // Submit a task to the worker group of the pool. Must be called with s_atf locked.
+    static void push_task_any(task_type &&task)
+    {
+        if (unlikely(base::s_queues.first.empty())) {
+            piranha_throw(std::runtime_error, "cannot enqueue task while the thread pool is stopping");
+        }
+        base::s_queues.first[0]->m_group->submit(std::move(task));
+    }
 
 public:
     /// Enqueue task.
@@ -305,6 +761,11 @@ public:
      * execution queue consumed by the thread to which the task is assigned. The return value is an \p std::future
      * which can be used to retrieve the return value of (or the exception thrown by) the callable.
      *
+     * If this method is called from a thread of the pool and nested parallelism is enabled (see
+     * set_nested_parallelism()), the task will not be pinned to the <tt>n</tt>-th thread: it will be submitted as
+     * in enqueue_any(), so that it can be consumed by any idle thread in the pool (or by the calling thread itself,
+     * while it waits via piranha::future_list).
+     *
      * @param n index of the thread that will consume the task.
      * @param f callable object representing the task.
      * @param args arguments to \p f.
@@ -315,7 +776,7 @@ public:
      * @throws std::runtime_error if a task is being enqueued while the task queue is stopping (e.g., during
      * program shutdown).
      * @throws unspecified any exception thrown by:
-     * - \p std::bind() or the constructor of \p std::packaged_task or \p std::function,
+     * - \p std::bind() or the constructor of \p std::packaged_task,
      * - threading primitives,
      * - memory allocation errors.
      */
@@ -323,14 +784,48 @@ public:
     static enqueue_t<F &&, Args &&...> enqueue(unsigned n, F &&f, Args &&... args)
     {
         detail::atomic_lock_guard lock(s_atf);
-        if (unlikely(n >= s_queues.first.size())) {
-            piranha_throw(std::invalid_argument, "the thread index " + std::to_string(n)
-                                                     + " is out of range, the thread pool contains only "
-                                                     + std::to_string(s_queues.first.size()) + " threads");
-        }
-        return base::s_queues.first[static_cast<decltype(base::s_queues.first.size())>(n)]->enqueue(
-            std::forward<F>(f), std::forward<Args>(args)...);
-    }  
+        auto &q = queue_at(n);
+        auto t = task_queue::make_task(std::forward<F>(f), std::forward<Args>(args)...);
+        push_task(q, std::move(t.first));
+        return std::move(t.second);
+    }
+    /// Enqueue task on any thread.
+    /**
+     * \note
+     * This method is enabled only if the same requirements of enqueue() are satisfied.
+     *
+     * This method will add a task to the pool, leaving the choice of the thread that will consume it to the
+     * scheduler. The threads in the pool are organised in a work-stealing scheduler: if this method is called from
+     * outside the pool, the task is added to a queue shared by all the threads; if it is called from one of the threads
+     * in the pool, the task is pushed into the private deque of the calling thread. Idle threads will steal tasks
+     * from the deques of busy threads. The tasks enqueued via enqueue() are pinned to their thread and they have the
+     * precedence over the tasks enqueued via this method.
+     *
+     * Splitting a computation into more tasks than threads in the pool and submitting them via this method allows
+     * the scheduler to balance the load among the threads dynamically.
+     *
+     * Tasks running in the pool can wait on the futures of tasks enqueued via this method through
+     * piranha::future_list, which lets the waiting thread consume the pending tasks rather than blocking.
+     *
+     * @param f callable object representing the task.
+     * @param args arguments to \p f.
+     *
+     * @return an \p std::future that will store the result of <tt>f(args...)</tt>.
+     *
+     * @throws std::runtime_error if the pool has been shut down (e.g., during program shutdown).
+     * @throws unspecified any exception thrown by:
+     * - \p std::bind() or the constructor of \p std::packaged_task,
+     * - threading primitives,
+     * - memory allocation errors.
+     */
+    template <typename F, typename... Args>
+    static enqueue_t<F &&, Args &&...> enqueue_any(F &&f, Args &&... args)
+    {
+        auto t = task_queue::make_task(std::forward<F>(f), std::forward<Args>(args)...);
+        detail::atomic_lock_guard lock(s_atf);
+        push_task_any(std::move(t.first));
+        return std::move(t.second);
+    }
 
 
     /// Size
@@ -344,16 +839,19 @@ public:
     }
 
 private:
-    // Helper function to create 'new_size' new queues with thread binding set to 'bind'.
-    static thread_queues_t create_new_queues(unsigned new_size, bool bind = false)
+    // Helper function to create 'new_size' new queues with thread binding set to 'bind'. If binding is
+    // requested, the i-th thread will be bound to the processor cpu_list[i % cpu_list.size()].
+    static thread_queues_t create_new_queues(unsigned new_size, bool bind, const std::vector<unsigned> &cpu_list)
     {
+        piranha_assert(!cpu_list.empty());
         thread_queues_t new_queues;
         // Create the task queues.
         new_queues.first.reserve(static_cast<decltype(new_queues.first.size())>(new_size));
 
+        auto group = std::make_shared<worker_group>(new_size);
         for (auto i = 0u; i < new_size; ++i) {
-            new_queues.first.emplace_back(::new task_queue(i, bind));
-        }  
+            new_queues.first.emplace_back(::new task_queue(cpu_list[i % cpu_list.size()], bind, group, i));
+        }
 
         // Fill in the thread ids set.
         for (const auto &ptr : new_queues.first) {
@@ -395,8 +893,7 @@ public:
         }
         // NOTE: need to lock here as we are reading the s_bind member.
         detail::atomic_lock_guard lock(s_atf);
-        //auto new_queues = create_new_queues(new_size, base::s_bind);
-        auto new_queues = create_new_queues(new_size);
+        auto new_queues = create_new_queues(new_size, base::s_bind, base::s_cpu_list);
         // NOTE: here the allocator is not swapped, as std::allocator won't propagate on swap.
         // Besides, all instances of std::allocator are equal, so the operation is well-defined.
         // http://en.cppreference.com/w/cpp/container/vector/swap
@@ -406,6 +903,129 @@ public:
         // in the dtor.
         new_queues.swap(base::s_queues);
     }
+    /// Set the thread binding policy.
+    /**
+     * If \p flag is \p true, this method will recreate the threads in the pool so that the <tt>i</tt>-th thread
+     * is bound to the processor <tt>get_cpu_list()[i % get_cpu_list().size()]</tt>. If \p flag is \p false, the
+     * threads will be recreated without any binding. As in resize(), the pending tasks are consumed before the
+     * threads are replaced. The binding is a best-effort operation: if a thread cannot be bound to its processor
+     * (e.g., because the processor is not available or binding is not supported on the current platform), it will
+     * be left unbound.
+     *
+     * On program startup, thread binding is disabled.
+     *
+     * @param flag the desired thread binding policy.
+     *
+     * @throws unspecified any exception thrown by:
+     * - threading primitives,
+     * - memory allocation errors.
+     */
+    static void set_binding(bool flag)
+    {
+        detail::atomic_lock_guard lock(s_atf);
+        if (flag == base::s_bind) {
+            return;
+        }
+        auto new_queues
+            = create_new_queues(static_cast<unsigned>(base::s_queues.first.size()), flag, base::s_cpu_list);
+        new_queues.swap(base::s_queues);
+        base::s_bind = flag;
+    }
+    /// Get the thread binding policy.
+    /**
+     * @return the flag set by set_binding().
+     */
+    static bool get_binding()
+    {
+        detail::atomic_lock_guard lock(s_atf);
+        return base::s_bind;
+    }
+    /// Set the list of processors used for thread binding.
+    /**
+     * This method sets the list of logical processors to which the threads in the pool are bound when thread
+     * binding is active: the <tt>i</tt>-th thread in the pool will be bound to <tt>cpu_list[i % cpu_list.size()]</tt>.
+     * If thread binding is currently active, the threads in the pool will be recreated with the new binding.
+     *
+     * Since parallel algorithms in piranha usually split their work (and the first touch of the memory they use)
+     * into contiguous ranges assigned to threads with increasing index, listing the processors grouped by NUMA node
+     * keeps contiguous ranges of memory on the same node.
+     *
+     * @param cpu_list the list of processor indices.
+     *
+     * @throws std::invalid_argument if \p cpu_list is empty.
+     * @throws unspecified any exception thrown by:
+     * - threading primitives,
+     * - memory allocation errors.
+     */
+    static void set_cpu_list(const std::vector<unsigned> &cpu_list)
+    {
+        if (unlikely(cpu_list.empty())) {
+            piranha_throw(std::invalid_argument, "the list of processors used for thread binding cannot be empty");
+        }
+        auto new_list(cpu_list);
+        detail::atomic_lock_guard lock(s_atf);
+        if (base::s_bind) {
+            auto new_queues = create_new_queues(static_cast<unsigned>(base::s_queues.first.size()), true, new_list);
+            new_queues.swap(base::s_queues);
+        }
+        new_list.swap(base::s_cpu_list);
+    }
+    /// Get the list of processors used for thread binding.
+    /**
+     * The default value groups the logical processors by NUMA node, as detected by
+     * piranha::runtime_info::get_numa_nodes(). If the NUMA topology cannot be determined, the default value
+     * is <tt>[0, 1, ..., n - 1]</tt>, where \p n is the maximum between 1 and
+     * piranha::runtime_info::get_hardware_concurrency().
+     *
+     * @return the list of processors used for thread binding.
+     *
+     * @throws unspecified any exception thrown by memory allocation errors.
+     */
+    static std::vector<unsigned> get_cpu_list()
+    {
+        detail::atomic_lock_guard lock(s_atf);
+        return base::s_cpu_list;
+    }
+    /// Reset the list of processors used for thread binding.
+    /**
+     * This method will reset the list of processors to its default value (see get_cpu_list()).
+     *
+     * @throws unspecified any exception thrown by set_cpu_list().
+     */
+    static void reset_cpu_list()
+    {
+        set_cpu_list(get_default_cpu_list());
+    }
+    /// Enable or disable nested parallelism.
+    /**
+     * Nested parallelism concerns the tasks submitted and waited upon from within the threads of the pool, e.g.,
+     * when the coefficients of a series multiplied in parallel are themselves series whose multiplication can be
+     * parallelised. If nested parallelism is enabled, use_threads() called from a thread of the pool will suggest
+     * the use of the idle threads of the pool, and the tasks enqueued via enqueue() from a thread of the pool will
+     * be consumed by any idle thread. If nested parallelism is disabled, use_threads() will always return 1 when
+     * called from a thread of the pool.
+     *
+     * In both cases, the threads of the pool waiting on piranha::future_list will consume the available tasks
+     * while waiting, so that nested task submission cannot deadlock the pool.
+     *
+     * On program startup, nested parallelism is enabled.
+     *
+     * @param flag the desired nested parallelism policy.
+     */
+    static void set_nested_parallelism(bool flag)
+    {
+        detail::atomic_lock_guard lock(s_atf);
+        base::s_nested = flag;
+    }
+    /// Get the nested parallelism policy.
+    /**
+     * @return the flag set by set_nested_parallelism().
+     */
+    static bool get_nested_parallelism()
+    {
+        detail::atomic_lock_guard lock(s_atf);
+        return base::s_nested;
+    }
     /// Compute number of threads to use.
     /**
      * \note
@@ -414,9 +1034,12 @@ public:
      * This function computes the suggested number of threads to use, given an amount of total \p work_size units of
      * work and a minimum amount of work units per thread \p min_work_per_thread.
      *
-     * The returned value will always be 1 if the calling thread belongs to the thread pool; otherwise, a number of
-     * threads such that each thread has at least \p min_work_per_thread units of work to consume will be returned.
-     * In any case, the return value is always greater than zero.
+     * The returned value is a number of threads such that each thread has at least \p min_work_per_thread units of
+     * work to consume. If the calling thread does not belong to the thread pool, the returned value will never
+     * exceed the size of the pool. If the calling thread belongs to the thread pool, the returned value will be 1 if
+     * nested parallelism is disabled (see set_nested_parallelism()), otherwise it will never exceed the number of
+     * idle threads in the pool plus one (the calling thread). In any case, the return value is always greater than
+     * zero.
      *
      * @param work_size total number of work units.
      * @param min_work_per_thread minimum number of work units to be consumed by a thread in the pool.
@@ -440,12 +1063,18 @@ public:
                                                      + " for minimum work per thread (it must be strictly positive)");
         }
         detail::atomic_lock_guard lock(s_atf);
-        // Don't use threads if the calling thread belongs to the pool.
+        const auto pool_size = static_cast<unsigned>(base::s_queues.first.size());
+        piranha_assert(pool_size);
+        auto n_threads = pool_size;
         if (base::s_queues.second.find(std::this_thread::get_id()) != base::s_queues.second.end()) {
-            return 1u;
+            // The calling thread belongs to the pool.
+            if (!base::s_nested) {
+                return 1u;
+            }
+            // Nested parallelism: the calling thread can be helped only by the idle threads.
+            const unsigned n_idle = base::s_queues.first[0]->m_group->m_n_sleeping.load();
+            n_threads = std::min(pool_size, n_idle + 1u);
         }
-        const auto n_threads = static_cast<unsigned>(base::s_queues.first.size());
-        piranha_assert(n_threads);
         if (work_size / n_threads >= min_work_per_thread) {
             // Enough work per thread, use them all.
             return n_threads;
@@ -482,12 +1111,13 @@ inline void thread_pool_shutdown()
 template <typename T>
 class future_list
 {
-    // Wait on a valid future, or abort.
+    // Wait on a valid future, or abort. If the calling thread belongs to the thread pool, it will run the
+    // available tasks while waiting.
     static void wait_or_abort(const std::future<T> &fut)
     {
         piranha_assert(fut.valid());
         try {
-            fut.wait();
+            wait_helping(fut);
         } catch (...) {
             // NOTE: logging candidate, with info from exception.
             std::abort();
@@ -547,7 +1177,9 @@ public:
     }
     /// Wait on all the futures.
     /**
-     * This method will call <tt>wait()</tt> on all the valid futures stored within the object.
+     * This method will call <tt>wait()</tt> on all the valid futures stored within the object. If the calling
+     * thread belongs to piranha::thread_pool, it will consume the tasks available to it while waiting, rather than
+     * blocking (see piranha::thread_pool_::set_nested_parallelism()).
      */
     void wait_all()
     {
@@ -577,6 +1209,201 @@ public:
 private:
     std::list<std::future<T>> m_list;
 };
+
+/// Fork-join group of tasks.
+/**
+ * This class is a lightweight alternative to the combination of piranha::thread_pool::enqueue() and
+ * piranha::future_list for tasks whose return value is not needed (e.g., the typical fork-join parallel loop). The
+ * tasks are submitted to piranha::thread_pool via run() or run_any(), and their completion is tracked by a counter
+ * internal to the group (i.e., a latch) rather than by an \p std::future per task. In the steady state, the
+ * submission of a small task does not allocate memory, and the cost of its completion is a single atomic operation.
+ *
+ * The first exception thrown by the tasks of the group is stored, and it can be re-thrown via get_all(). The
+ * other exceptions are ignored.
+ *
+ * The methods of this class must be called from a single thread (usually, the thread that created the group), and
+ * the tasks of a group cannot submit other tasks to the same group. If the calling thread belongs to the thread pool,
+ * wait_all() will consume the tasks available to the thread while waiting, as piranha::future_list::wait_all() does.
+ */
+class task_group
+{
+    // Enabler for run() and run_any().
+    template <typename F, typename... Args>
+    using run_enabler = task_queue::enabler<F, Args...>;
+    // Wrap f and args into a task which notifies the group upon completion.
+    template <typename F, typename... Args>
+    task_type make_task(F &&f, Args &&... args)
+    {
+        return task_type([this, b = std::bind(std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            {
+                // NOTE: destroy the callable before notifying the group, so that it does not outlive the wait.
+                auto tmp(std::move(b));
+                try {
+                    tmp();
+                } catch (...) {
+                    if (!this->m_failed.exchange(true)) {
+                        this->m_eptr = std::current_exception();
+                    }
+                }
+            }
+            this->complete_one();
+        });
+    }
+    // Mark one task as completed.
+    // NOTE: the last task decreases the counter while holding the mutex, and wait_all() locks the mutex before
+    // returning: hence, when wait_all() returns, no task is accessing the group any more, and the group can be
+    // destroyed. The other tasks just decrease the counter.
+    void complete_one() noexcept
+    {
+        auto c = m_count.load();
+        while (c > 1u) {
+            if (m_count.compare_exchange_weak(c, c - 1u)) {
+                return;
+            }
+        }
+        try {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_count.fetch_sub(1u);
+            m_cond.notify_all();
+        } catch (...) {
+            // NOTE: logging candidate.
+            std::abort();
+        }
+    }
+
+public:
+    /// Default constructor.
+    /**
+     * This constructor will initialise an empty group.
+     */
+    task_group() : m_count(0u), m_failed(false) {}
+    /// Deleted copy constructor.
+    task_group(const task_group &) = delete;
+    /// Deleted move constructor.
+    task_group(task_group &&) = delete;
+
+private:
+    task_group &operator=(const task_group &) = delete;
+    task_group &operator=(task_group &&) = delete;
+
+public:
+    /// Destructor.
+    /**
+     * Will call wait_all().
+     */
+    ~task_group()
+    {
+        wait_all();
+    }
+    /// Run a task on a specific thread.
+    /**
+     * \note
+     * This method is enabled only if the requirements of piranha::thread_pool::enqueue() are satisfied.
+     *
+     * This method will add the task <tt>f(args...)</tt> to the group, enqueueing it to the <tt>n</tt>-th thread in
+     * the pool with the same semantics as piranha::thread_pool::enqueue(). The return value of \p f is discarded.
+     *
+     * @param n the index of the thread in the pool that will consume the task.
+     * @param f callable object representing the task.
+     * @param args arguments to \p f.
+     *
+     * @throws std::invalid_argument if the thread index is equal to or larger than the current pool size.
+     * @throws unspecified any exception thrown by piranha::thread_pool::enqueue(), except for the
+     * construction of \p std::packaged_task.
+     */
+    template <typename F, typename... Args, run_enabler<F &&, Args &&...> = 0>
+    void run(unsigned n, F &&f, Args &&... args)
+    {
+        detail::atomic_lock_guard lock(thread_pool::s_atf);
+        auto &q = thread_pool::queue_at(n);
+        auto task = make_task(std::forward<F>(f), std::forward<Args>(args)...);
+        m_count.fetch_add(1u);
+        try {
+            thread_pool::push_task(q, std::move(task));
+        } catch (...) {
+            complete_one();
+            throw;
+        }
+    }
+    /// Run a task on any thread.
+    /**
+     * \note
+     * This method is enabled only if the requirements of piranha::thread_pool::enqueue() are satisfied.
+     *
+     * This method will add the task <tt>f(args...)</tt> to the group, submitting it to the thread pool with
+     * the same semantics as piranha::thread_pool::enqueue_any(). The return value of \p f is discarded.
+     *
+     * @param f callable object representing the task.
+     * @param args arguments to \p f.
+     *
+     * @throws unspecified any exception thrown by piranha::thread_pool::enqueue_any(), except for the
+     * construction of \p std::packaged_task.
+     */
+    template <typename F, typename... Args, run_enabler<F &&, Args &&...> = 0>
+    void run_any(F &&f, Args &&... args)
+    {
+        auto task = make_task(std::forward<F>(f), std::forward<Args>(args)...);
+        detail::atomic_lock_guard lock(thread_pool::s_atf);
+        m_count.fetch_add(1u);
+        try {
+            thread_pool::push_task_any(std::move(task));
+        } catch (...) {
+            complete_one();
+            throw;
+        }
+    }
+    /// Wait for the completion of all the tasks.
+    /**
+     * This method will block until all the tasks added to the group have been completed. If the calling thread
+     * belongs to piranha::thread_pool, it will consume the tasks available to it while waiting, rather than
+     * blocking. The exceptions thrown by the tasks are not re-thrown.
+     */
+    void wait_all()
+    {
+        try {
+            if (auto q = current_worker::s_queue) {
+                while (m_count.load() != 0u) {
+                    if (!q->run_one()) {
+                        // NOTE: as in wait_helping(), nothing to run at the moment: wait a little bit and
+                        // try again.
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_cond.wait_for(lock, std::chrono::microseconds(100),
+                                        [this]() { return m_count.load() == 0u; });
+                    }
+                }
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_count.load() == 0u; });
+        } catch (...) {
+            // NOTE: logging candidate, with info from exception.
+            std::abort();
+        }
+    }
+    /// Wait for the completion of all the tasks and re-throw the first exception.
+    /**
+     * This method will call wait_all(). Then, if a task of the group threw an exception, the exception
+     * will be re-thrown, and it will be removed from the group.
+     *
+     * @throws unspecified the first exception thrown by a task of the group.
+     */
+    void get_all()
+    {
+        wait_all();
+        if (m_failed.load()) {
+            auto eptr = std::move(m_eptr);
+            m_eptr = nullptr;
+            m_failed.store(false);
+            std::rethrow_exception(eptr);
+        }
+    }
+
+private:
+    std::atomic<std::size_t> m_count;
+    std::atomic<bool> m_failed;
+    std::exception_ptr m_eptr;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
 }
 
 #endif
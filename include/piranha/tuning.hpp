@@ -48,6 +48,11 @@ struct base_tuning {
     static std::atomic<bool> s_parallel_memory_set;
     static std::atomic<unsigned long> s_mult_block_size;
     static std::atomic<unsigned long> s_estimate_threshold;
+    static std::atomic<unsigned long> s_dense_mult_threshold;
+    static std::atomic<bool> s_pow_squaring;
+    static std::atomic<bool> s_private_accumulation;
+    static std::atomic<unsigned long> s_compaction_threshold;
+    static std::atomic<bool> s_incremental_rehash;
 };
 
 template <typename T>
@@ -58,6 +63,21 @@ std::atomic<unsigned long> base_tuning<T>::s_mult_block_size(256u);
 
 template <typename T>
 std::atomic<unsigned long> base_tuning<T>::s_estimate_threshold(200u);
+
+template <typename T>
+std::atomic<unsigned long> base_tuning<T>::s_dense_mult_threshold(25u);
+
+template <typename T>
+std::atomic<bool> base_tuning<T>::s_pow_squaring(false);
+
+template <typename T>
+std::atomic<bool> base_tuning<T>::s_private_accumulation(false);
+
+template <typename T>
+std::atomic<unsigned long> base_tuning<T>::s_compaction_threshold(10u);
+
+template <typename T>
+std::atomic<bool> base_tuning<T>::s_incremental_rehash(false);
 }
 
 /// Performance tuning.
@@ -181,6 +201,197 @@ public:
     {
         s_estimate_threshold.store(200u);
     }
+    /// Get the dense multiplication threshold.
+    /**
+     * Some multiplication algorithms (e.g., the multiplication of polynomials with Kronecker monomials) can
+     * accumulate the result into a flat array covering the whole range of exponents of the product, instead of
+     * using a hash table. This is advantageous only if a large enough fraction of the array is expected to be
+     * occupied by the terms of the result.
+     *
+     * This value represents the minimum estimated fill ratio, as a percentage, above which the dense algorithm
+     * will be selected. The default value of this flag is 25.
+     *
+     * @return the dense multiplication threshold.
+     */
+    static unsigned long get_dense_multiplication_threshold()
+    {
+        return s_dense_mult_threshold.load();
+    }
+    /// Set the dense multiplication threshold.
+    /**
+     * @see piranha::tuning::get_dense_multiplication_threshold() for an explanation of the meaning of this value.
+     *
+     * @param thr desired value for the dense multiplication threshold.
+     *
+     * @throws std::invalid_argument if \p thr is not in the [1,100] range.
+     */
+    static void set_dense_multiplication_threshold(unsigned long thr)
+    {
+        if (unlikely(thr < 1u || thr > 100u)) {
+            piranha_throw(std::invalid_argument, "invalid dense multiplication threshold");
+        }
+        s_dense_mult_threshold.store(thr);
+    }
+    /// Reset the dense multiplication threshold.
+    /**
+     * This method will reset the dense multiplication threshold to its default value.
+     *
+     * @see piranha::tuning::get_dense_multiplication_threshold() for an explanation of the meaning of this value.
+     */
+    static void reset_dense_multiplication_threshold()
+    {
+        s_dense_mult_threshold.store(25u);
+    }
+    /// Get the \p pow_squaring flag.
+    /**
+     * By default, piranha::series::pow() computes the natural powers of a series by repeated multiplications
+     * by the series itself. If this flag is \p true, the even powers are instead computed, whenever this is
+     * expected to be cheaper, by squaring the power of half the exponent, so that the specialised squaring
+     * algorithms of the series multipliers can be used.
+     *
+     * The default value of this flag is \p false.
+     *
+     * @return current value of the \p pow_squaring flag.
+     */
+    static bool get_pow_squaring()
+    {
+        return s_pow_squaring.load();
+    }
+    /// Set the \p pow_squaring flag.
+    /**
+     * @see piranha::tuning::get_pow_squaring() for an explanation of the meaning of this flag.
+     *
+     * @param flag desired value for the \p pow_squaring flag.
+     */
+    static void set_pow_squaring(bool flag)
+    {
+        s_pow_squaring.store(flag);
+    }
+    /// Reset the \p pow_squaring flag.
+    /**
+     * This method will reset the \p pow_squaring flag to its default value.
+     *
+     * @see piranha::tuning::get_pow_squaring() for an explanation of the meaning of this flag.
+     */
+    static void reset_pow_squaring()
+    {
+        s_pow_squaring.store(false);
+    }
+    /// Get the \p private_accumulation flag.
+    /**
+     * In multithreaded mode, the plain series multiplication routines of piranha::base_series_multiplier accumulate
+     * the term-by-term products directly into the output series, locking the destination bucket for each
+     * insertion. If this flag is \p true, each thread will instead accumulate its products into a private
+     * hash table with the same number of buckets as the output series, and the private tables will then be
+     * merged into the output series in parallel, each thread taking care of a range of buckets. This
+     * removes the contention on the bucket locks, at the price of a higher memory usage.
+     *
+     * The default value of this flag is \p false.
+     *
+     * @return current value of the \p private_accumulation flag.
+     */
+    static bool get_private_accumulation()
+    {
+        return s_private_accumulation.load();
+    }
+    /// Set the \p private_accumulation flag.
+    /**
+     * @see piranha::tuning::get_private_accumulation() for an explanation of the meaning of this flag.
+     *
+     * @param flag desired value for the \p private_accumulation flag.
+     */
+    static void set_private_accumulation(bool flag)
+    {
+        s_private_accumulation.store(flag);
+    }
+    /// Reset the \p private_accumulation flag.
+    /**
+     * This method will reset the \p private_accumulation flag to its default value.
+     *
+     * @see piranha::tuning::get_private_accumulation() for an explanation of the meaning of this flag.
+     */
+    static void reset_private_accumulation()
+    {
+        s_private_accumulation.store(false);
+    }
+    /// Get the compaction threshold.
+    /**
+     * The table of terms of the result of a series multiplication is sized according to an estimate of the final
+     * number of terms. When most of the terms cancel out or are discarded by truncation, the table can end up
+     * holding a large number of empty buckets. The same can happen in series addition and subtraction when the
+     * operands cancel each other out. After these operations, if the load factor of the table of the result is below
+     * this percentage of the maximum load factor, the table will be shrunk via piranha::series::shrink_to_fit().
+     *
+     * A value of zero disables the automatic compaction. The default value of this flag is 10.
+     *
+     * @return the compaction threshold.
+     */
+    static unsigned long get_compaction_threshold()
+    {
+        return s_compaction_threshold.load();
+    }
+    /// Set the compaction threshold.
+    /**
+     * @see piranha::tuning::get_compaction_threshold() for an explanation of the meaning of this value.
+     *
+     * @param thr desired value for the compaction threshold.
+     *
+     * @throws std::invalid_argument if \p thr is greater than 100.
+     */
+    static void set_compaction_threshold(unsigned long thr)
+    {
+        if (unlikely(thr > 100u)) {
+            piranha_throw(std::invalid_argument, "invalid compaction threshold");
+        }
+        s_compaction_threshold.store(thr);
+    }
+    /// Reset the compaction threshold.
+    /**
+     * This method will reset the compaction threshold to its default value.
+     *
+     * @see piranha::tuning::get_compaction_threshold() for an explanation of the meaning of this value.
+     */
+    static void reset_compaction_threshold()
+    {
+        s_compaction_threshold.store(10u);
+    }
+    /// Get the \p incremental_rehash flag.
+    /**
+     * When the insertion of a term into a series exceeds the maximum load factor of the table of terms, the table
+     * is resized and all the terms are migrated to the new buckets at once, which can cause a long pause in the
+     * accumulation of terms into a large series. If this flag is \p true, the tables of terms which support it
+     * (e.g., piranha::hash_set) will instead be resized incrementally, migrating a few buckets at each subsequent
+     * insertion (see piranha::hash_set::set_incremental_rehash()). This gives a more predictable cost per insertion,
+     * at the price of slightly slower lookups while a resize is in progress.
+     *
+     * The default value of this flag is \p false.
+     *
+     * @return current value of the \p incremental_rehash flag.
+     */
+    static bool get_incremental_rehash()
+    {
+        return s_incremental_rehash.load();
+    }
+    /// Set the \p incremental_rehash flag.
+    /**
+     * @see piranha::tuning::get_incremental_rehash() for an explanation of the meaning of this flag.
+     *
+     * @param flag desired value for the \p incremental_rehash flag.
+     */
+    static void set_incremental_rehash(bool flag)
+    {
+        s_incremental_rehash.store(flag);
+    }
+    /// Reset the \p incremental_rehash flag.
+    /**
+     * This method will reset the \p incremental_rehash flag to its default value.
+     *
+     * @see piranha::tuning::get_incremental_rehash() for an explanation of the meaning of this flag.
+     */
+    static void reset_incremental_rehash()
+    {
+        s_incremental_rehash.store(false);
+    }
 };
 }
 
@@ -32,9 +32,11 @@ see https://www.gnu.org/licenses/. */
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <iterator>
 #include <limits>
+#include <ostream>
 #include <set>
 #include <stdexcept>
 #include <tuple>
@@ -45,6 +47,7 @@ see https://www.gnu.org/licenses/. */
 
 #include <piranha/integer.hpp>
 #include <piranha/kronecker_monomial.hpp>
+#include <piranha/math.hpp>
 #include <piranha/monomial.hpp>
 #include <piranha/polynomial.hpp>
 #include <piranha/rational.hpp>
@@ -165,11 +168,21 @@ struct m_checker : public base_series_multiplier<Series> {
         return base::sanitise_series(std::forward<Args>(args)...);
     }
     template <typename... Args>
+    static void sanitise_accumulation(Args &&... args)
+    {
+        return base::sanitise_accumulation(std::forward<Args>(args)...);
+    }
+    template <typename... Args>
     Series plain_multiplication(Args &&... args) const
     {
         return base::plain_multiplication(std::forward<Args>(args)...);
     }
     template <typename... Args>
+    void plain_multiply_accumulate(Args &&... args) const
+    {
+        base::plain_multiply_accumulate(std::forward<Args>(args)...);
+    }
+    template <typename... Args>
     void finalise_series(Args &&... args) const
     {
         base::finalise_series(std::forward<Args>(args)...);
@@ -263,6 +276,29 @@ struct l_functor_0 {
     const unsigned m_n;
 };
 
+// A limit functor that will include all the terms of the second series, and that will throw when called
+// on the second half of the first series after the destination series of a multiplication has been
+// rehashed (i.e., during the accumulation of the product).
+template <typename Series>
+struct l_functor_throw {
+    l_functor_throw(const Series &retval, unsigned size1, unsigned size2)
+        : m_retval(retval), m_bucket_count(retval._container().bucket_count()), m_size1(size1), m_size2(size2)
+    {
+    }
+    template <typename T>
+    T operator()(const T &i) const
+    {
+        if (m_retval._container().bucket_count() != m_bucket_count && i >= m_size1 / 2u) {
+            throw std::runtime_error("accumulation error");
+        }
+        return T(m_size2);
+    }
+    const Series &m_retval;
+    const typename Series::size_type m_bucket_count;
+    const unsigned m_size1;
+    const unsigned m_size2;
+};
+
 TEST_CASE("base_series_multiplier_blocked_multiplication_test")
 {
     using pt = p_type<rational>;
@@ -518,6 +554,106 @@ TEST_CASE("base_series_multiplier_sanitise_series_test")
     settings::reset_n_threads();
 }
 
+TEST_CASE("base_series_multiplier_sanitise_accumulation_test")
+{
+    using pt = p_type<integer>;
+    using mt = m_checker<pt>;
+    using term_type = typename pt::term_type;
+    using size_type = typename pt::size_type;
+    pt e{"x"};
+    e._container().clear();
+    e._container().rehash(16u);
+    // Insert terms without updating the count, the first one with a zero coefficient.
+    term_type tmp;
+    for (unsigned i = 0u; i < 10u; ++i) {
+        tmp = term_type{i, term_type::key_type{int(i)}};
+        e._container()._unique_insert(tmp, e._container()._bucket(tmp));
+    }
+    tmp = term_type{0, term_type::key_type{0}};
+    const auto b0 = e._container()._bucket(tmp);
+    // Only the count is updated if no bucket is listed.
+    size_type n_new = 10u;
+    std::vector<size_type> buckets;
+    mt::sanitise_accumulation(e, n_new, buckets);
+    CHECK(n_new == 0u);
+    CHECK(e.size() == 10u);
+    // The zero term is removed once its bucket is listed, duplicates are allowed.
+    buckets = {b0, static_cast<size_type>((b0 + 1u) % 16u), b0};
+    mt::sanitise_accumulation(e, n_new, buckets);
+    CHECK(buckets.empty());
+    CHECK(e.size() == 9u);
+    CHECK(std::distance(e._container().begin(), e._container().end()) == 9);
+    CHECK(e._container().find(tmp) == e._container().end());
+    // Overflow in the number of terms.
+    n_new = std::numeric_limits<size_type>::max();
+    CHECK_THROWS_AS(mt::sanitise_accumulation(e, n_new, buckets), std::overflow_error);
+    CHECK(e.size() == 9u);
+}
+
+TEST_CASE("base_series_multiplier_multiply_accumulate_test")
+{
+    settings::set_min_work_per_thread(1u);
+    // Always estimate, so that the destination series is rehashed before the accumulation.
+    tuning::set_estimate_threshold(0u);
+    {
+        using pt = p_type<integer>;
+        using mt = m_checker<pt>;
+        pt x{"x"}, y{"y"}, z{"z"};
+        const auto f = (1 + x + y - z).pow(6), g = (x - y + 2 * z + 3).pow(5);
+        const auto fg = f * g;
+        const auto size1 = static_cast<unsigned>(std::max(f.size(), g.size())),
+                   size2 = static_cast<unsigned>(std::min(f.size(), g.size()));
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            for (bool flag : {false, true}) {
+                tuning::set_private_accumulation(flag);
+                mt m0{f, g};
+                // Accumulation with cancellations.
+                auto h = x * y * z - fg;
+                m0.plain_multiply_accumulate(h);
+                CHECK(h == x * y * z);
+                CHECK(h.size() == 1u);
+                // In case of errors, the destination keeps its terms and it is left in a valid state.
+                const auto h0 = (x - y).pow(3);
+                h = h0;
+                CHECK_THROWS_AS(m0.plain_multiply_accumulate(h, l_functor_throw<pt>{h, size1, size2}),
+                                std::runtime_error);
+                CHECK(!h.empty());
+                CHECK(std::distance(h._container().begin(), h._container().end())
+                      == static_cast<std::ptrdiff_t>(h.size()));
+                CHECK(std::none_of(h._container().begin(), h._container().end(),
+                                   [](const pt::term_type &t) { return math::is_zero(t.m_cf); }));
+                // The destination is still usable.
+                const auto partial = h;
+                m0.plain_multiply_accumulate(h);
+                CHECK(h == partial + fg);
+            }
+        }
+        tuning::reset_private_accumulation();
+    }
+    {
+        // With rational coefficients, the accumulation into an empty series is undone.
+        using pt = p_type<rational>;
+        using mt = m_checker<pt>;
+        pt x{"x"}, y{"y"}, z{"z"};
+        const auto f = (1 + x / 3 + y - z).pow(6), g = (x - y / 5 + 2 * z + 3).pow(5);
+        const auto size1 = static_cast<unsigned>(std::max(f.size(), g.size())),
+                   size2 = static_cast<unsigned>(std::min(f.size(), g.size()));
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            mt m0{f, g};
+            pt h;
+            h.set_symbol_set(f.get_symbol_set());
+            CHECK_THROWS_AS(m0.plain_multiply_accumulate(h, l_functor_throw<pt>{h, size1, size2}),
+                            std::runtime_error);
+            CHECK(h.empty());
+        }
+    }
+    tuning::reset_estimate_threshold();
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
 template <typename T>
 struct multiplication_tester {
 //    template <typename T>
@@ -664,6 +800,160 @@ TEST_CASE("base_series_multiplier_plain_multiplication_test")
     }
 }
 
+// Operands for the private accumulation tester.
+template <typename T>
+inline std::pair<T, T> pa_operands()
+{
+    T x{"x"}, y{"y"}, z{"z"};
+    return std::make_pair((1 + x + y - z).pow(6), (x - y + 2 * z + 3).pow(5));
+}
+
+template <>
+inline std::pair<p_type<rational>, p_type<rational>> pa_operands<p_type<rational>>()
+{
+    p_type<rational> x{"x"}, y{"y"}, z{"z"};
+    return std::make_pair((1 + x / 3 + y - z).pow(6), (x - y / 5 + 2 * z + 3).pow(5));
+}
+
+template <>
+inline std::pair<polynomial<rational, monomial<rational>>, polynomial<rational, monomial<rational>>>
+pa_operands<polynomial<rational, monomial<rational>>>()
+{
+    polynomial<rational, monomial<rational>> x{"x"}, y{"y"}, z{"z"};
+    return std::make_pair((1 + x.pow(1 / 2_q) + y - z / 7).pow(6), (x - y.pow(2 / 3_q) + 2 * z + 3).pow(5));
+}
+
+struct private_accumulation_tester {
+    template <typename T>
+    void operator()(const T &) const
+    {
+        const auto ops = pa_operands<T>();
+        const auto &f = ops.first, &g = ops.second;
+        settings::set_n_threads(1u);
+        const auto ref = f * g, ref_sq = f * f;
+        for (unsigned nt = 2u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            for (bool flag : {false, true}) {
+                tuning::set_private_accumulation(flag);
+                CHECK(f * g == ref);
+                CHECK(g * f == ref);
+                CHECK(f * f == ref_sq);
+                // Cancellations.
+                CHECK(f * g - g * f == 0);
+                CHECK(f * (g - g) == 0);
+                // Accumulation into a non-empty series.
+                auto h = g;
+                math::multiply_accumulate(h, f, g);
+                CHECK(h == g + ref);
+                h = -ref;
+                math::multiply_accumulate(h, f, g);
+                CHECK(h == T{});
+            }
+        }
+    }
+};
+
+// Integral coefficient whose addition throws once a countdown set by the test reaches zero.
+struct throwing_cf {
+    throwing_cf() = default;
+    throwing_cf(const int &n) : m_value(n) {}
+    explicit throwing_cf(const integer &n) : m_value(n) {}
+    friend std::ostream &operator<<(std::ostream &os, const throwing_cf &c)
+    {
+        return os << c.m_value;
+    }
+    throwing_cf operator-() const
+    {
+        return throwing_cf{-m_value};
+    }
+    friend bool operator==(const throwing_cf &a, const throwing_cf &b)
+    {
+        return a.m_value == b.m_value;
+    }
+    friend bool operator!=(const throwing_cf &a, const throwing_cf &b)
+    {
+        return a.m_value != b.m_value;
+    }
+    throwing_cf &operator+=(const throwing_cf &other)
+    {
+        if (s_countdown.load() > 0 && s_countdown.fetch_sub(1) == 1) {
+            throw std::runtime_error("throwing_cf");
+        }
+        m_value += other.m_value;
+        return *this;
+    }
+    throwing_cf &operator-=(const throwing_cf &other)
+    {
+        m_value -= other.m_value;
+        return *this;
+    }
+    throwing_cf &operator*=(const throwing_cf &other)
+    {
+        m_value *= other.m_value;
+        return *this;
+    }
+    friend throwing_cf operator+(const throwing_cf &a, const throwing_cf &b)
+    {
+        return throwing_cf{a.m_value + b.m_value};
+    }
+    friend throwing_cf operator-(const throwing_cf &a, const throwing_cf &b)
+    {
+        return throwing_cf{a.m_value - b.m_value};
+    }
+    friend throwing_cf operator*(const throwing_cf &a, const throwing_cf &b)
+    {
+        return throwing_cf{a.m_value * b.m_value};
+    }
+    integer m_value;
+    static std::atomic<int> s_countdown;
+};
+
+std::atomic<int> throwing_cf::s_countdown(0);
+
+TEST_CASE("base_series_multiplier_private_accumulation_test")
+{
+    // Check that the private accumulation mode gives the same results as the locking mode.
+    settings::set_min_work_per_thread(1u);
+    tuple_for_each(std::tuple<p_type<integer>, p_type<rational>, polynomial<rational, monomial<rational>>>{},
+                   private_accumulation_tester{});
+    {
+        // Errors thrown by the coefficients while the private tables are being filled or merged.
+        using pt = p_type<throwing_cf>;
+        pt x{"x"}, y{"y"}, z{"z"};
+        // NOTE: throwing_cf does not support exponentiation, build the operands via repeated multiplications.
+        pt f{1}, g{1};
+        settings::set_n_threads(1u);
+        for (int i = 0; i < 6; ++i) {
+            f *= 1 + x + y - z;
+        }
+        for (int i = 0; i < 5; ++i) {
+            g *= x - y + z + z + 3;
+        }
+        const auto ref = f * g;
+        tuning::set_private_accumulation(true);
+        for (unsigned nt = 2u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            // NOTE: the estimation of the size of the result performs only a handful of additions,
+            // the countdown will thus run out during the accumulation.
+            throwing_cf::s_countdown.store(1000);
+            CHECK_THROWS_AS(f * g, std::runtime_error);
+            throwing_cf::s_countdown.store(1000);
+            auto h = g;
+            CHECK_THROWS_AS(math::multiply_accumulate(h, f, g), std::runtime_error);
+            CHECK(std::distance(h._container().begin(), h._container().end())
+                  == static_cast<std::ptrdiff_t>(h.size()));
+            CHECK(std::none_of(h._container().begin(), h._container().end(),
+                               [](const pt::term_type &t) { return math::is_zero(t.m_cf); }));
+            // Everything works again once the countdown is disarmed.
+            throwing_cf::s_countdown.store(0);
+            CHECK(f * g == ref);
+        }
+    }
+    tuning::reset_private_accumulation();
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
 TEST_CASE("base_series_multiplier_finalise_test")
 {
     {
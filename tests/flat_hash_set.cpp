@@ -0,0 +1,334 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#include <piranha/flat_hash_set.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <piranha/integer.hpp>
+#include <piranha/kronecker_monomial.hpp>
+#include <piranha/math/pow.hpp>
+#include <piranha/polynomial.hpp>
+#include <piranha/rational.hpp>
+#include <piranha/series.hpp>
+#include <piranha/settings.hpp>
+#include <piranha/term.hpp>
+#include <piranha/thread_pool.hpp>
+#include <piranha/type_traits.hpp>
+
+#include "catch.hpp"
+
+using namespace piranha;
+
+// Polynomial type using the flat hash set as term container.
+using flat_poly = polynomial<integer, k_monomial>;
+
+namespace piranha
+{
+
+template <>
+struct series_container<flat_poly, term<integer, k_monomial>> {
+    using type = flat_hash_set<term<integer, k_monomial>>;
+};
+}
+
+static std::mt19937 rng;
+
+static const int ntries = 1000;
+
+// A hash function sending all the small values into the same bucket, so that
+// the overflow arrays are exercised.
+struct clustering_hash {
+    std::size_t operator()(unsigned n) const
+    {
+        return static_cast<std::size_t>(n) << 24;
+    }
+};
+
+TEST_CASE("flat_hash_set_basic_test")
+{
+    flat_hash_set<int> h;
+    CHECK(h.empty());
+    CHECK(h.bucket_count() == 0u);
+    CHECK(h.begin() == h.end());
+    CHECK(h.find(0) == h.end());
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(h.insert(i).second);
+        CHECK(!h.insert(i).second);
+    }
+    CHECK(h.size() == 1000u);
+    CHECK(h.load_factor() <= h.max_load_factor());
+    std::size_t count = 0u;
+    for (auto it = h.begin(); it != h.end(); ++it, ++count) {
+        CHECK(h.find(*it) == it);
+    }
+    CHECK(count == 1000u);
+    std::size_t sp_count = 0u;
+    for (const auto &p : h.evaluate_sparsity()) {
+        sp_count += p.first * p.second;
+    }
+    CHECK(sp_count == 1000u);
+    // Copy, move, swap.
+    auto h2(h);
+    CHECK(h2.size() == 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(h2.find(i) != h2.end());
+    }
+    auto h3(std::move(h2));
+    CHECK(h2.size() == 0u);
+    CHECK(h3.size() == 1000u);
+    h2.swap(h3);
+    CHECK(h2.size() == 1000u);
+    CHECK(h3.empty());
+    // Erase every other element.
+    for (int i = 0; i < 1000; i += 2) {
+        h.erase(h.find(i));
+    }
+    CHECK(h.size() == 500u);
+    for (int i = 0; i < 1000; ++i) {
+        CHECK((h.find(i) == h.end()) == (i % 2 == 0));
+    }
+    // Erase via the return value of erase().
+    for (auto it = h.begin(); it != h.end();) {
+        it = h.erase(it);
+    }
+    CHECK(h.empty());
+    h.clear();
+    CHECK(h.bucket_count() == 0u);
+    flat_hash_set<int> h4{1, 2, 3, 3};
+    CHECK(h4.size() == 3u);
+    CHECK_THROWS_AS(h4.rehash(10u, 0u), std::invalid_argument);
+}
+
+TEST_CASE("flat_hash_set_overflow_test")
+{
+    using h_set = flat_hash_set<unsigned, clustering_hash>;
+    h_set h;
+    for (unsigned i = 0u; i < 200u; ++i) {
+        CHECK(h.insert(i).second);
+    }
+    // Everything ends up in the first bucket.
+    CHECK(h._get_bucket_list(0u).size() == 200u);
+    // The control bytes are well distributed, even if the hash values differ only in their highest bits.
+    const auto &g0 = h._get_bucket_list(0u);
+    CHECK(std::set<unsigned>(g0.m_ctrl, g0.m_ctrl + 16).size() > 8u);
+    for (unsigned i = 0u; i < 200u; ++i) {
+        CHECK(h.find(i) != h.end());
+    }
+    // Erase from both the slots and the overflow array.
+    for (unsigned i = 0u; i < 200u; i += 3u) {
+        h.erase(h.find(i));
+    }
+    for (unsigned i = 0u; i < 200u; ++i) {
+        CHECK((h.find(i) == h.end()) == (i % 3u == 0u));
+    }
+    auto h2(h);
+    for (auto it = h2.begin(); it != h2.end();) {
+        it = h2.erase(it);
+    }
+    CHECK(h2.empty());
+    CHECK(h.size() == 133u);
+    // The clustered hash values are detected.
+    const auto hq = h.evaluate_hash_quality();
+    CHECK(hq.m_n_elements == 133u);
+    CHECK(hq.m_n_occupied == 1u);
+    CHECK(hq.m_max_chain == 133u);
+    CHECK(hq.m_n_overflow == 133u - 16u);
+    CHECK(hq.hash_collisions() == 0u);
+    CHECK(hq.is_degenerate());
+}
+
+TEST_CASE("flat_hash_set_low_level_test")
+{
+    flat_hash_set<int> h(100u);
+    for (int i = 0; i < 1000; ++i) {
+        const auto idx = h._bucket(i);
+        CHECK(h._find(i, idx) == h.end());
+        h._unique_insert(i, idx);
+        CHECK(h._find(i, idx) != h.end());
+    }
+    h._update_size(1000u);
+    std::size_t count = 0u;
+    for (std::size_t i = 0u; i < h.bucket_count(); ++i) {
+        std::vector<int> to_erase;
+        for (const auto &n : h._get_bucket_list(i)) {
+            CHECK(h._bucket(n) == i);
+            if (n % 2) {
+                to_erase.push_back(n);
+            }
+            ++count;
+        }
+        for (auto n : to_erase) {
+            h._erase(h._find(n, i));
+        }
+    }
+    CHECK(count == 1000u);
+    h._update_size(500u);
+    for (int i = 0; i < 1000; ++i) {
+        CHECK((h.find(i) == h.end()) == (i % 2 == 1));
+    }
+    for (auto it = h._m_begin(); it != h._m_end(); ++it) {
+        CHECK(*it % 2 == 0);
+    }
+}
+
+TEST_CASE("flat_hash_set_mt_test")
+{
+    thread_pool::resize(4u);
+    CHECK_THROWS_AS(flat_hash_set<int>(10000, std::hash<int>(), std::equal_to<int>(), 0u), std::invalid_argument);
+    using size_type = flat_hash_set<int>::size_type;
+    std::uniform_int_distribution<size_type> size_dist(0u, 10000u);
+    std::uniform_int_distribution<unsigned> thread_dist(1u, 4u);
+    for (int i = 0; i < ntries; ++i) {
+        auto bcount = size_dist(rng);
+        flat_hash_set<int> h(bcount, std::hash<int>(), std::equal_to<int>(), thread_dist(rng));
+        CHECK(h.bucket_count() >= bcount);
+        for (int j = 0; j < 100; ++j) {
+            h.insert(j);
+        }
+        bcount = size_dist(rng);
+        h.rehash(bcount, thread_dist(rng));
+        CHECK(h.size() == 100u);
+        if (h.bucket_count() < bcount) {
+            CHECK(bcount == 0u);
+        }
+    }
+    // Parallel copy.
+    settings::set_min_work_per_thread(1u);
+    flat_hash_set<unsigned, clustering_hash> h;
+    for (unsigned i = 0u; i < 10000u; ++i) {
+        h.insert(i);
+    }
+    auto h2(h);
+    CHECK(h2.size() == 10000u);
+    for (unsigned i = 0u; i < 10000u; ++i) {
+        CHECK(h2.find(i) != h2.end());
+    }
+    settings::reset_min_work_per_thread();
+    // Shrink after erasing most of the elements.
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        flat_hash_set<int> h3(100000u);
+        for (int i = 0; i < 10000; ++i) {
+            h3.insert(i);
+        }
+        for (auto it = h3.begin(); it != h3.end();) {
+            it = (*it % 10) ? h3.erase(it) : std::next(it);
+        }
+        const auto b_count = h3.bucket_count();
+        h3.shrink_to_fit(nt);
+        CHECK(h3.bucket_count() < b_count);
+        CHECK(h3.load_factor() <= h3.max_load_factor());
+        CHECK(h3.load_factor() > h3.max_load_factor() / 2.);
+        CHECK(h3.size() == 1000u);
+        for (int i = 0; i < 10000; ++i) {
+            CHECK((h3.find(i) == h3.end()) == (i % 10 != 0));
+        }
+    }
+}
+
+TEST_CASE("flat_hash_set_bulk_insert_test")
+{
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        flat_hash_set<unsigned, clustering_hash> h;
+        h.insert(0u);
+        std::vector<unsigned> v;
+        for (unsigned i = 0u; i < 2000u; ++i) {
+            v.push_back(i % 1000u);
+        }
+        CHECK(h.bulk_insert(v.begin(), v.end(), false, nt) == 999u);
+        CHECK(h.size() == 1000u);
+        v.clear();
+        for (unsigned i = 1000u; i < 10000u; ++i) {
+            v.push_back(i);
+        }
+        CHECK(h.bulk_insert(v.begin(), v.end(), true, nt) == 9000u);
+        CHECK(h.size() == 10000u);
+        CHECK(h.load_factor() <= h.max_load_factor());
+        for (unsigned i = 0u; i < 10000u; ++i) {
+            CHECK(h.find(i) != h.end());
+        }
+    }
+}
+
+TEST_CASE("flat_hash_set_concurrent_insertion_test")
+{
+    using h_set = flat_hash_set<unsigned, clustering_hash>;
+    h_set h(100u);
+    h._concurrent_begin();
+    thread_pool::resize(4u);
+    future_list<void> f_list;
+    for (unsigned t = 0u; t < 4u; ++t) {
+        f_list.push_back(thread_pool::enqueue(t, [&h]() {
+            h_set::_concurrent_inserter ins(h);
+            for (unsigned i = 0u; i < 1000u; ++i) {
+                ins.insert(i, [](const unsigned &, const unsigned &) {});
+            }
+        }));
+    }
+    f_list.wait_all();
+    f_list.get_all();
+    h._concurrent_end();
+    CHECK(h.size() == 1000u);
+    for (unsigned i = 0u; i < 1000u; ++i) {
+        CHECK(h.find(i) != h.end());
+    }
+    CHECK_THROWS_AS(h._concurrent_end(), std::invalid_argument);
+}
+
+TEST_CASE("flat_hash_set_series_test")
+{
+    CHECK((std::is_same<uncvref_t<decltype(std::declval<const flat_poly &>()._container())>,
+                        flat_hash_set<term<integer, k_monomial>>>::value));
+    using ref_poly = polynomial<rational, k_monomial>;
+    flat_poly x{"x"}, y{"y"}, z{"z"}, t{"t"};
+    ref_poly rx{"x"}, ry{"y"}, rz{"z"}, rt{"t"};
+    auto f = piranha::pow(1 + x + y + 2 * z * z + 3 * t * t * t, 8);
+    auto g = piranha::pow(1 - x - y - 2 * z * z - 3 * t * t * t, 8);
+    auto rf = piranha::pow(1 + rx + ry + 2 * rz * rz + 3 * rt * rt * rt, 8);
+    auto rg = piranha::pow(1 - rx - ry - 2 * rz * rz - 3 * rt * rt * rt, 8);
+    CHECK(f == rf);
+    const auto ref = rf * rg;
+    for (unsigned i = 1u; i <= 4u; ++i) {
+        settings::set_n_threads(i);
+        const auto res = f * g;
+        CHECK(res.size() == ref.size());
+        CHECK(res == ref);
+        // Cancellations.
+        CHECK((f * g - g * f).empty());
+    }
+    settings::reset_n_threads();
+}
@@ -39,6 +39,7 @@ see https://www.gnu.org/licenses/. */
 #include <cstddef>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <new>
@@ -48,11 +49,14 @@ see https://www.gnu.org/licenses/. */
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <piranha/config.hpp>
 #include <piranha/exceptions.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/s11n.hpp>
+#include <piranha/settings.hpp>
 #include <piranha/thread_pool.hpp>
 #include <piranha/type_traits.hpp>
 
@@ -96,6 +100,21 @@ struct hash<custom_string> {
 };
 }
 
+// Hasher for custom_string for which the hash values are cached in the set.
+struct cached_string_hash {
+    std::size_t operator()(const custom_string &s) const
+    {
+        return std::hash<std::string>{}(s);
+    }
+};
+
+namespace piranha
+{
+template <>
+struct hash_set_cache_hash<custom_string, cached_string_hash> : std::true_type {
+};
+}
+
 typedef boost::mpl::vector<int, /*integer,*/ custom_string> key_types;  // integer doesn't have an inpiut operator>>. lexical_cast fails
 
 const int N = 10000;
@@ -675,6 +694,665 @@ TEST_CASE("hash_set_mt_test")
     }
 }
 
+TEST_CASE("hash_set_mt_rehash_test")
+{
+    // Parallel migration of the elements, both when growing and when shrinking the set.
+    const auto old_size = thread_pool::size();
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        hash_set<custom_string> h;
+        for (int i = 0; i < N * 10; ++i) {
+            h.insert(boost::lexical_cast<custom_string>(i));
+        }
+        for (auto n_buckets : {h.bucket_count() * 4u, h.bucket_count() / 2u, h.bucket_count() * 16u,
+                               hash_set<custom_string>::size_type(3u)}) {
+            h.rehash(n_buckets, nt);
+            CHECK(h.size() == unsigned(N * 10));
+            for (int i = 0; i < N * 10; ++i) {
+                CHECK(h.find(boost::lexical_cast<custom_string>(i)) != h.end());
+            }
+        }
+    }
+    // Random testing.
+    std::uniform_int_distribution<int> size_dist(0, N);
+    std::uniform_int_distribution<unsigned> thread_dist(1u, 4u);
+    for (int i = 0; i < ntries / 10; ++i) {
+        hash_set<int> h;
+        const auto size = size_dist(rng);
+        for (int j = 0; j < size; ++j) {
+            h.insert(j);
+        }
+        h.rehash(static_cast<hash_set<int>::size_type>(size_dist(rng)), thread_dist(rng));
+        CHECK(h.size() == static_cast<hash_set<int>::size_type>(size));
+        for (int j = 0; j < size; ++j) {
+            CHECK(h.find(j) != h.end());
+        }
+    }
+    // The automatic resize migrates in parallel according to the minimum work per thread.
+    settings::set_min_work_per_thread(1u);
+    {
+        hash_set<int> h;
+        for (int i = 0; i < N * 10; ++i) {
+            CHECK(h.insert(i).second);
+        }
+        CHECK(h.size() == unsigned(N * 10));
+        for (int i = 0; i < N * 10; ++i) {
+            CHECK(h.find(i) != h.end());
+        }
+    }
+    settings::reset_min_work_per_thread();
+    thread_pool::resize(old_size);
+}
+
+TEST_CASE("hash_set_cache_hash_test")
+{
+    using h_set = hash_set<custom_string, cached_string_hash>;
+    CHECK((!hash_set_cache_hash<custom_string, std::hash<custom_string>>::value));
+    CHECK((hash_set_cache_hash<custom_string, cached_string_hash>::value));
+    h_set h;
+    for (int i = 0; i < N; ++i) {
+        CHECK(h.insert(boost::lexical_cast<custom_string>(i)).second);
+        CHECK(!h.insert(boost::lexical_cast<custom_string>(i)).second);
+    }
+    CHECK(h.size() == unsigned(N));
+    // Low-level interface with precomputed hashes.
+    for (int i = 0; i < N; ++i) {
+        const auto s = boost::lexical_cast<custom_string>(i);
+        const auto hv = h._hash(s);
+        CHECK(hv == cached_string_hash{}(s));
+        const auto idx = h._bucket_from_hash(hv);
+        CHECK(idx == h._bucket(s));
+        CHECK(h._find(s, idx, hv) == h.find(s));
+        CHECK(h._find(s, idx, hv) != h.end());
+    }
+    h_set h_ll;
+    h_ll.rehash(h_ll.bucket_count() + 1000u);
+    for (int i = 0; i < 100; ++i) {
+        const auto s = boost::lexical_cast<custom_string>(i);
+        const auto hv = h_ll._hash(s);
+        const auto idx = h_ll._bucket_from_hash(hv);
+        CHECK(h_ll._find(s, idx, hv) == h_ll.end());
+        h_ll._unique_insert(s, idx, hv);
+        h_ll._update_size(h_ll.size() + 1u);
+    }
+    for (int i = 0; i < 100; ++i) {
+        CHECK(h_ll.find(boost::lexical_cast<custom_string>(i)) != h_ll.end());
+    }
+    // Rehashing, both serial and parallel, and copies.
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        h.rehash(h.bucket_count() * 4u, nt);
+        h.rehash(h.bucket_count() / 8u, nt);
+        CHECK(h.size() == unsigned(N));
+        for (int i = 0; i < N; ++i) {
+            CHECK(h.find(boost::lexical_cast<custom_string>(i)) != h.end());
+        }
+    }
+    auto h2(h);
+    CHECK(h2.size() == unsigned(N));
+    // Erase, including the first elements of the buckets.
+    for (int i = 0; i < N; i += 2) {
+        h2.erase(h2.find(boost::lexical_cast<custom_string>(i)));
+    }
+    CHECK(h2.size() == unsigned(N / 2));
+    for (int i = 0; i < N; ++i) {
+        CHECK((h2.find(boost::lexical_cast<custom_string>(i)) == h2.end()) == (i % 2 == 0));
+    }
+    h = std::move(h2);
+    CHECK(h.size() == unsigned(N / 2));
+    for (int i = 1; i < N; i += 2) {
+        CHECK(h.find(boost::lexical_cast<custom_string>(i)) != h.end());
+    }
+}
+
+// A hash function sending consecutive values into the same bucket, so that
+// long overflow chains are built.
+struct chaining_hash {
+    std::size_t operator()(int n) const
+    {
+        return static_cast<std::size_t>(n) / 16u;
+    }
+};
+
+TEST_CASE("hash_set_node_pool_test")
+{
+    using h_set = hash_set<int, chaining_hash>;
+    h_set h;
+    for (int i = 0; i < N; ++i) {
+        CHECK(h.insert(i).second);
+    }
+    CHECK(h.evaluate_sparsity().rbegin()->first >= 16u);
+    // Erase and re-insert, so that the nodes are recycled.
+    for (int k = 0; k < 3; ++k) {
+        for (int i = k; i < N; i += 3) {
+            h.erase(h.find(i));
+        }
+        CHECK(h.size() == unsigned(N - (N - k + 2) / 3));
+        for (int i = 0; i < N; ++i) {
+            CHECK((h.find(i) == h.end()) == (i % 3 == k));
+        }
+        for (int i = k; i < N; i += 3) {
+            CHECK(h.insert(i).second);
+        }
+        CHECK(h.size() == unsigned(N));
+    }
+    // Copy, move, swap and clear.
+    auto h2(h);
+    CHECK(h2.size() == unsigned(N));
+    h_set h3(std::move(h));
+    CHECK(h.empty());
+    h.swap(h2);
+    CHECK(h2.empty());
+    for (int i = 0; i < N; ++i) {
+        CHECK(h.find(i) != h.end());
+        CHECK(h3.find(i) != h3.end());
+    }
+    h3.clear();
+    CHECK(h3.empty());
+    for (int i = 0; i < N; ++i) {
+        CHECK(h3.insert(i).second);
+    }
+    h = h3;
+    CHECK(h.size() == unsigned(N));
+    // More sets in use than the slots of the thread-local cache, some of them destroyed and re-created.
+    std::vector<h_set> hv(20u);
+    for (int k = 0; k < 3; ++k) {
+        for (int i = 0; i < N; ++i) {
+            CHECK(hv[static_cast<unsigned>(i) % 20u].insert(i).second);
+        }
+        for (int i = 0; i < N; i += 2) {
+            auto &hs = hv[static_cast<unsigned>(i) % 20u];
+            hs.erase(hs.find(i));
+        }
+        for (unsigned j = 0u; j < 20u; ++j) {
+            CHECK(hv[j].size() == (j % 2u ? unsigned(N / 20) : 0u));
+            hv[j] = h_set{};
+        }
+    }
+    // Concurrent insertions and erasures in different buckets via the low-level interface.
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        h_set hc;
+        hc.rehash(static_cast<h_set::size_type>(N / 16));
+        auto inserter = [&hc, nt](unsigned t) {
+            for (int i = 0; i < N; ++i) {
+                const auto idx = hc._bucket(i);
+                if (idx % nt == t) {
+                    hc._unique_insert(i, idx);
+                }
+            }
+        };
+        future_list<void> f_list;
+        for (unsigned t = 0u; t < nt; ++t) {
+            f_list.push_back(thread_pool::enqueue(t, inserter, t));
+        }
+        f_list.wait_all();
+        f_list.get_all();
+        hc._update_size(unsigned(N));
+        for (int i = 0; i < N; ++i) {
+            CHECK(hc.find(i) != hc.end());
+        }
+        auto eraser = [&hc, nt](unsigned t) {
+            for (int i = 0; i < N; i += 2) {
+                const auto idx = hc._bucket(i);
+                if (idx % nt == t) {
+                    hc._erase(hc._find(i, idx));
+                }
+            }
+        };
+        future_list<void> f_list2;
+        for (unsigned t = 0u; t < nt; ++t) {
+            f_list2.push_back(thread_pool::enqueue(t, eraser, t));
+        }
+        f_list2.wait_all();
+        f_list2.get_all();
+        hc._update_size(unsigned(N / 2));
+        for (int i = 0; i < N; ++i) {
+            CHECK((hc.find(i) == hc.end()) == (i % 2 == 0));
+        }
+    }
+}
+
+// Struct whose copy constructor fails for a specific value.
+struct copy_failure {
+    explicit copy_failure(int n) : m_n(n) {}
+    copy_failure(const copy_failure &other) : m_n(other.m_n)
+    {
+        if (m_n == N / 2) {
+            throw std::runtime_error("fail!");
+        }
+    }
+    copy_failure(copy_failure &&) noexcept = default;
+    copy_failure &operator=(const copy_failure &) = default;
+    copy_failure &operator=(copy_failure &&) noexcept = default;
+    ~copy_failure() noexcept {}
+    bool operator==(const copy_failure &other) const
+    {
+        return m_n == other.m_n;
+    }
+    int m_n;
+};
+
+struct copy_failure_hash {
+    std::size_t operator()(const copy_failure &c) const
+    {
+        return static_cast<std::size_t>(c.m_n);
+    }
+};
+
+TEST_CASE("hash_set_mt_copy_test")
+{
+    // Force the parallel copy of small sets.
+    settings::set_min_work_per_thread(1u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        thread_pool::resize(nt);
+        const auto h = make_hash_set<custom_string>();
+        auto h2(h);
+        CHECK(h2.size() == h.size());
+        CHECK(h2.bucket_count() == h.bucket_count());
+        for (const auto &x : h) {
+            CHECK(h2.find(x) != h2.end());
+        }
+        hash_set<custom_string> h3;
+        h3 = h2;
+        CHECK(h3.size() == h.size());
+        // Sets with fewer buckets than threads.
+        hash_set<int> h4{1, 2};
+        auto h5(h4);
+        CHECK(h5.size() == 2u);
+        CHECK(h5.find(1) != h5.end());
+        CHECK(h5.find(2) != h5.end());
+        // Failures during the copy.
+        hash_set<copy_failure, copy_failure_hash> h6;
+        for (int i = 0; i < N; ++i) {
+            h6.insert(copy_failure(i));
+        }
+        CHECK_THROWS_AS((hash_set<copy_failure, copy_failure_hash>(h6)), std::runtime_error);
+    }
+    settings::reset_min_work_per_thread();
+    thread_pool::resize(4u);
+}
+
+// Element with a mutable counter, used to test concurrent insertions.
+struct counted_int {
+    counted_int() : m_n(0), m_count(1) {}
+    explicit counted_int(int n) : m_n(n), m_count(1) {}
+    bool operator==(const counted_int &other) const
+    {
+        return m_n == other.m_n;
+    }
+    int m_n;
+    mutable int m_count;
+};
+
+struct counted_int_hash {
+    std::size_t operator()(const counted_int &c) const
+    {
+        return static_cast<std::size_t>(c.m_n);
+    }
+};
+
+TEST_CASE("hash_set_concurrent_insertion_test")
+{
+    using h_set = hash_set<counted_int, counted_int_hash>;
+    const auto combiner = [](const counted_int &c, const counted_int &) { ++c.m_count; };
+    h_set h;
+    CHECK_THROWS_AS(h._concurrent_begin(), std::invalid_argument);
+    CHECK_THROWS_AS(h_set::_concurrent_inserter{h}, std::invalid_argument);
+    CHECK_THROWS_AS(h._concurrent_end(), std::invalid_argument);
+    h.insert(counted_int(-1));
+    h.rehash(static_cast<h_set::size_type>(N));
+    h._concurrent_begin();
+    CHECK_THROWS_AS(h._concurrent_begin(), std::invalid_argument);
+    thread_pool::resize(4u);
+    future_list<void> f_list;
+    for (unsigned t = 0u; t < 4u; ++t) {
+        f_list.push_back(thread_pool::enqueue(t, [&h, &combiner, t]() {
+            h_set::_concurrent_inserter ins(h);
+            for (int i = 0; i < N; ++i) {
+                // Each thread visits the elements in a different order.
+                ins.insert(counted_int((i + static_cast<int>(t) * (N / 4)) % N), combiner);
+            }
+        }));
+    }
+    f_list.wait_all();
+    f_list.get_all();
+    // The size is reconciled only at the end of the session.
+    CHECK(h.size() == 1u);
+    h._concurrent_end();
+    CHECK(h.size() == unsigned(N + 1));
+    CHECK(h.find(counted_int(-1))->m_count == 1);
+    for (int i = 0; i < N; ++i) {
+        const auto it = h.find(counted_int(i));
+        REQUIRE(it != h.end());
+        CHECK(it->m_count == 4);
+    }
+    // Single-threaded use, and termination of the session via clear().
+    h._concurrent_begin();
+    {
+        h_set::_concurrent_inserter ins(h);
+        CHECK(!ins.insert(counted_int(-1), combiner));
+        CHECK(ins.insert(counted_int(N), combiner));
+    }
+    h._concurrent_end();
+    CHECK(h.size() == unsigned(N + 2));
+    CHECK(h.find(counted_int(-1))->m_count == 2);
+    h._concurrent_begin();
+    h.clear();
+    CHECK_THROWS_AS(h._concurrent_end(), std::invalid_argument);
+}
+
+// A hash function producing values which differ only in the high bits.
+struct high_bits_hash {
+    std::size_t operator()(int n) const
+    {
+        return static_cast<std::size_t>(n) << 20;
+    }
+};
+
+TEST_CASE("hash_set_hash_quality_test")
+{
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        hash_set<int> h0;
+        auto hq = h0.evaluate_hash_quality(nt);
+        CHECK(hq.m_n_elements == 0u);
+        CHECK(hq.m_n_buckets == 0u);
+        CHECK(!hq.is_degenerate());
+        CHECK_THROWS_AS(h0.evaluate_hash_quality(0u), std::invalid_argument);
+        // Well-distributed hash values.
+        hash_set<int> h1;
+        for (int i = 0; i < N; ++i) {
+            h1.insert(i);
+        }
+        hq = h1.evaluate_hash_quality(nt);
+        CHECK(hq.m_n_elements == unsigned(N));
+        CHECK(hq.m_n_buckets == h1.bucket_count());
+        CHECK(hq.m_n_distinct_hashes == unsigned(N));
+        CHECK(hq.hash_collisions() == 0u);
+        CHECK(hq.m_n_occupied + hq.reduction_collisions() == unsigned(N));
+        CHECK(hq.m_n_overflow == unsigned(N) - hq.m_n_occupied);
+        CHECK(hq.m_max_chain >= 1u);
+        CHECK(hq.m_mean_chain >= 1.);
+        CHECK(!hq.is_degenerate());
+        // Consistency with evaluate_sparsity().
+        for (const auto &p : h1.evaluate_sparsity()) {
+            if (p.second) {
+                CHECK(p.first <= hq.m_max_chain);
+            }
+        }
+        // Identical hash values.
+        hash_set<int, chaining_hash> h2;
+        for (int i = 0; i < N; ++i) {
+            h2.insert(i);
+        }
+        hq = h2.evaluate_hash_quality(nt);
+        CHECK(hq.m_n_distinct_hashes == unsigned(N / 16));
+        CHECK(hq.hash_collisions() == unsigned(N - N / 16));
+        CHECK(hq.m_max_chain == 16u);
+        CHECK(hq.is_degenerate());
+        // Hash values differing only in the high bits.
+        hash_set<int, high_bits_hash> h3;
+        for (int i = 0; i < 1000; ++i) {
+            h3.insert(i);
+        }
+        hq = h3.evaluate_hash_quality(nt);
+        CHECK(hq.hash_collisions() == 0u);
+        CHECK(hq.reduction_collisions() == 999u);
+        CHECK(hq.m_n_occupied == 1u);
+        CHECK(hq.m_max_chain == 1000u);
+        CHECK(hq.overflow_share() == 999. / 1000.);
+        CHECK(hq.constant_index_bits() == 10u);
+        CHECK(hq.is_degenerate());
+        std::ostringstream oss;
+        oss << hq;
+        CHECK(!oss.str().empty());
+    }
+}
+
+TEST_CASE("hash_set_bulk_insert_test")
+{
+    using h_set = hash_set<int, chaining_hash>;
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        h_set h;
+        CHECK_THROWS_AS(h.bulk_insert(h.begin(), h.begin(), false, 0u), std::invalid_argument);
+        std::vector<int> v;
+        CHECK(h.bulk_insert(v.begin(), v.end(), false, nt) == 0u);
+        CHECK(h.bucket_count() == 0u);
+        for (int i = 0; i < N; i += 2) {
+            h.insert(i);
+        }
+        // Duplicates both within the range and with respect to the content of the set.
+        for (int i = 0; i < N * 2; ++i) {
+            v.push_back(i % N);
+        }
+        CHECK(h.bulk_insert(v.begin(), v.end(), false, nt) == unsigned(N / 2));
+        CHECK(h.size() == unsigned(N));
+        CHECK(h.load_factor() <= h.max_load_factor());
+        for (int i = 0; i < N; ++i) {
+            CHECK(h.find(i) != h.end());
+        }
+        // Unique insertion.
+        v.clear();
+        for (int i = N; i < N * 2; ++i) {
+            v.push_back(i);
+        }
+        CHECK(h.bulk_insert(v.begin(), v.end(), true, nt) == unsigned(N));
+        CHECK(h.size() == unsigned(N * 2));
+        CHECK(std::distance(h.begin(), h.end()) == N * 2);
+        for (int i = 0; i < N * 2; ++i) {
+            CHECK(h.find(i) != h.end());
+        }
+        // Moving elements.
+        hash_set<custom_string> h2;
+        std::vector<custom_string> v2;
+        for (int i = 0; i < N; ++i) {
+            v2.push_back(boost::lexical_cast<custom_string>(i));
+        }
+        CHECK(h2.bulk_insert(std::make_move_iterator(v2.begin()), std::make_move_iterator(v2.end()), true, nt)
+              == unsigned(N));
+        for (int i = 0; i < N; ++i) {
+            CHECK(h2.find(boost::lexical_cast<custom_string>(i)) != h2.end());
+        }
+    }
+    // Failures leave the set empty.
+    hash_set<copy_failure, copy_failure_hash> h3;
+    h3.insert(copy_failure(-1));
+    std::vector<copy_failure> v3;
+    for (int i = 0; i < N; ++i) {
+        v3.emplace_back(i);
+    }
+    CHECK_THROWS_AS(h3.bulk_insert(v3.begin(), v3.end(), false, 4u), std::runtime_error);
+    CHECK(h3.empty());
+}
+
+TEST_CASE("hash_set_shrink_to_fit_test")
+{
+    using h_set = hash_set<int, chaining_hash>;
+    h_set h;
+    CHECK_THROWS_AS(h.shrink_to_fit(0u), std::invalid_argument);
+    h.shrink_to_fit();
+    CHECK(h.bucket_count() == 0u);
+    // Erase all elements but a few, shrink and check the content.
+    thread_pool::resize(4u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        h_set h2(static_cast<h_set::size_type>(N * 10));
+        for (int i = 0; i < N * 10; ++i) {
+            h2.insert(i);
+        }
+        const auto b_count = h2.bucket_count();
+        for (auto it = h2.begin(); it != h2.end();) {
+            it = (*it % 100) ? h2.erase(it) : std::next(it);
+        }
+        CHECK(h2.size() == unsigned(N / 10));
+        h2.shrink_to_fit(nt);
+        CHECK(h2.bucket_count() < b_count);
+        CHECK(h2.bucket_count() >= h2.size());
+        CHECK(h2.load_factor() > h2.max_load_factor() / 2.);
+        CHECK(h2.size() == unsigned(N / 10));
+        for (int i = 0; i < N * 10; ++i) {
+            CHECK((h2.find(i) == h2.end()) == (i % 100 != 0));
+        }
+        // Shrinking again has no effect.
+        const auto b_count2 = h2.bucket_count();
+        h2.shrink_to_fit(nt);
+        CHECK(h2.bucket_count() == b_count2);
+        // The set is still usable.
+        h2.insert(1);
+        CHECK(h2.find(1) != h2.end());
+        // Shrinking an empty set clears it.
+        h2.clear();
+        h2.rehash(100u);
+        h2.shrink_to_fit(nt);
+        CHECK(h2.bucket_count() == 0u);
+    }
+}
+
+TEST_CASE("hash_set_incremental_rehash_test")
+{
+    using h_set = hash_set<int, chaining_hash>;
+    h_set h;
+    CHECK(!h.get_incremental_rehash());
+    h.set_incremental_rehash(true);
+    CHECK(h.get_incremental_rehash());
+    // Insert until a resize starts, and check that the set behaves normally while the old buckets are migrated.
+    int n = 0;
+    for (; !h.rehash_in_progress(); ++n) {
+        CHECK(h.insert(n).second);
+    }
+    CHECK(h.size() == unsigned(n));
+    CHECK(h.load_factor() <= h.max_load_factor());
+    const auto b_count = h.bucket_count();
+    for (; h.rehash_in_progress(); ++n) {
+        for (int i = 0; i < n; ++i) {
+            CHECK(h.find(i) != h.end());
+            CHECK(!h.insert(i).second);
+        }
+        std::size_t count = 0u;
+        for (auto it = h.begin(); it != h.end(); ++it, ++count) {
+            CHECK(h.find(*it) == it);
+        }
+        CHECK(count == h.size());
+        // Copies and moves.
+        h_set h2(h);
+        CHECK(!h2.rehash_in_progress());
+        CHECK(h2.get_incremental_rehash());
+        CHECK(h2.size() == h.size());
+        for (int i = 0; i < n; ++i) {
+            CHECK(h2.find(i) != h2.end());
+        }
+        h_set h3(std::move(h2));
+        CHECK(h3.size() == h.size());
+        CHECK(h.insert(n).second);
+    }
+    // The migration is over well before the next resize.
+    CHECK(h.bucket_count() == b_count);
+    CHECK(h.size() < b_count);
+    // Erase during the migration.
+    for (; !h.rehash_in_progress(); ++n) {
+        h.insert(n);
+    }
+    for (auto it = h.begin(); it != h.end();) {
+        it = (*it % 3) ? h.erase(it) : std::next(it);
+    }
+    std::size_t count = 0u;
+    for (auto it = h.begin(); it != h.end(); ++it, ++count) {
+        CHECK(*it % 3 == 0);
+    }
+    CHECK(count == h.size());
+    const auto size = h.size();
+    CHECK(h.rehash_in_progress());
+    h.complete_rehash();
+    CHECK(!h.rehash_in_progress());
+    CHECK(h.size() == size);
+    for (int i = 0; i < n; ++i) {
+        CHECK((h.find(i) == h.end()) == (i % 3 != 0));
+    }
+    // The diagnostics account for a pending rehash without completing it.
+    for (; !h.rehash_in_progress(); ++n) {
+        h.insert(n);
+    }
+    const auto sp = h.evaluate_sparsity();
+    const auto hq = h.evaluate_hash_quality(), hq2 = h.evaluate_hash_quality(2u);
+    CHECK(h.rehash_in_progress());
+    h.complete_rehash();
+    CHECK(sp == h.evaluate_sparsity());
+    const auto hq3 = h.evaluate_hash_quality();
+    CHECK(hq.m_n_elements == hq3.m_n_elements);
+    CHECK(hq.m_n_occupied == hq3.m_n_occupied);
+    CHECK(hq.m_max_chain == hq3.m_max_chain);
+    CHECK(hq.m_n_overflow == hq3.m_n_overflow);
+    CHECK(hq2.m_n_occupied == hq3.m_n_occupied);
+    // Bucket-level access requires the migration to be completed beforehand.
+    for (; !h.rehash_in_progress(); ++n) {
+        h.insert(n);
+    }
+    h.complete_rehash();
+    count = 0u;
+    for (h_set::size_type i = 0u; i < h.bucket_count(); ++i) {
+        for (auto it = h._get_bucket_list(i).begin(); it != h._get_bucket_list(i).end(); ++it, ++count) {
+            CHECK(h._bucket(*it) == i);
+        }
+    }
+    CHECK(!h.rehash_in_progress());
+    CHECK(count == h.size());
+    // So do rehash() and the disabling of the mode.
+    for (; !h.rehash_in_progress(); ++n) {
+        h.insert(n);
+    }
+    h.rehash(h.bucket_count() * 2u);
+    CHECK(!h.rehash_in_progress());
+    CHECK(h.get_incremental_rehash());
+    for (; !h.rehash_in_progress(); ++n) {
+        h.insert(n);
+    }
+    h.set_incremental_rehash(false);
+    CHECK(!h.rehash_in_progress());
+    for (int i = 0; i < N; ++i, ++n) {
+        h.insert(n);
+        CHECK(!h.rehash_in_progress());
+    }
+    // Low-level insertion, as performed by series.
+    h_set h4;
+    h4.set_incremental_rehash(true);
+    bool in_progress = false;
+    for (int i = 0; i < N; ++i) {
+        if (!h4.bucket_count() || h4.size() + 1u > h4.bucket_count()) {
+            h4._increase_size();
+        }
+        const auto hv = h4._hash(i);
+        const auto idx = h4._bucket_from_hash(hv);
+        CHECK(h4._find(i, idx, hv) == h4.end());
+        in_progress = in_progress || h4.rehash_in_progress();
+        h4._rehash_step();
+        h4._unique_insert(i, idx, hv);
+        h4._update_size(h4.size() + 1u);
+    }
+    CHECK(in_progress);
+    for (int i = 0; i < N; ++i) {
+        const auto hv = h4._hash(i);
+        CHECK(h4._find(i, h4._bucket_from_hash(hv), hv) != h4.end());
+    }
+    // The low-level insertion alone never migrates buckets.
+    h4.complete_rehash();
+    const auto b_count4 = h4.bucket_count();
+    for (int i = N; !h4.rehash_in_progress(); ++i) {
+        h4.insert(i);
+    }
+    const auto hv4 = h4._hash(-1);
+    h4._unique_insert(-1, h4._bucket_from_hash(hv4), hv4);
+    h4._update_size(h4.size() + 1u);
+    CHECK(h4.rehash_in_progress());
+    CHECK(h4.bucket_count() == b_count4 * 2u);
+    h4.complete_rehash();
+    CHECK(!h4.rehash_in_progress());
+    CHECK(h4.find(-1) != h4.end());
+    h4.clear();
+    CHECK(!h4.rehash_in_progress());
+    CHECK(h4.get_incremental_rehash());
+}
+
 #if defined(PIRANHA_WITH_BOOST_S11N)
 
 TEST_CASE("hash_set_serialization_test")
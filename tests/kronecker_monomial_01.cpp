@@ -47,6 +47,7 @@ see https://www.gnu.org/licenses/. */
 
 #include <piranha/detail/demangle.hpp>
 #include <piranha/exceptions.hpp>
+#include <piranha/hash_set.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/is_key.hpp>
 #include <piranha/key/key_degree.hpp>
@@ -505,6 +506,30 @@ TEST_CASE("kronecker_monomial_hash_test")
     tuple_for_each(int_types{}, hash_tester{});
 }
 
+TEST_CASE("kronecker_monomial_hash_quality_test")
+{
+    // The hash of a Kronecker monomial is the code itself: contiguous codes are spread perfectly
+    // among the buckets, while codes differing only in the high bits all end up in the same bucket.
+    hash_set<k_monomial> h1, h2;
+    for (k_monomial::value_type i = 0; i < 1000; ++i) {
+        k_monomial k;
+        k.set_int(i);
+        h1.insert(k);
+        k.set_int(static_cast<k_monomial::value_type>(i << 16));
+        h2.insert(k);
+    }
+    const auto hq1 = h1.evaluate_hash_quality();
+    CHECK(hq1.hash_collisions() == 0u);
+    CHECK(hq1.reduction_collisions() == 0u);
+    CHECK(hq1.m_max_chain == 1u);
+    CHECK(!hq1.is_degenerate());
+    const auto hq2 = h2.evaluate_hash_quality();
+    CHECK(hq2.hash_collisions() == 0u);
+    CHECK(hq2.reduction_collisions() == 999u);
+    CHECK(hq2.constant_index_bits() == 10u);
+    CHECK(hq2.is_degenerate());
+}
+
 struct unpack_tester {
     template <typename T>
     void operator()(const T &) const
@@ -45,6 +45,7 @@ see https://www.gnu.org/licenses/. */
 #include <mp++/config.hpp>
 
 #include <piranha/exceptions.hpp>
+#include <piranha/hash_set.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/key/key_degree.hpp>
 #include <piranha/key/key_is_one.hpp>
@@ -256,6 +257,9 @@ struct hash_tester {
 TEST_CASE("monomial_hash_test")
 {
     tuple_for_each(expo_types{}, hash_tester{});
+    // Hash values of monomial terms are cached in hash_set, the ones of Kronecker monomials are not.
+    CHECK((hash_set_cache_hash<term<integer, monomial<int>>, std::hash<term<integer, monomial<int>>>>::value));
+    CHECK((!hash_set_cache_hash<term<integer, k_monomial>, std::hash<term<integer, k_monomial>>>::value));
 }
 
 struct compatibility_tester {
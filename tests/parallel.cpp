@@ -0,0 +1,198 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#include <piranha/parallel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <piranha/thread_pool.hpp>
+
+#include "catch.hpp"
+
+using namespace piranha;
+
+static const partitioning parts[] = {partitioning::adaptive, partitioning::contiguous};
+
+TEST_CASE("parallel_for_test")
+{
+    thread_pool::resize(4u);
+    // Invalid arguments.
+    auto noop = [](int, int) {};
+    CHECK_THROWS_AS(parallel_for(0u, 0, 10, noop), std::invalid_argument);
+    CHECK_THROWS_AS(parallel_for(1u, 0, 10, noop, 0), std::invalid_argument);
+    CHECK_THROWS_AS(parallel_for(1u, 0, 10, noop, -1), std::invalid_argument);
+    CHECK_THROWS_AS(parallel_for(1u, 10, 0, noop), std::invalid_argument);
+    for (auto p : parts) {
+        // Empty range.
+        bool called = false;
+        parallel_for(4u, 3, 3, [&called](int, int) { called = true; }, 1, p);
+        CHECK(!called);
+        // Every element is visited exactly once, with subranges of at least grain elements.
+        for (unsigned nt = 1u; nt <= 6u; ++nt) {
+            for (std::size_t grain : {1u, 7u, 100u, 20000u}) {
+                std::vector<std::atomic<int>> v(10000u);
+                std::mutex mutex;
+                std::vector<std::pair<std::size_t, std::size_t>> ranges;
+                parallel_for(nt, std::size_t(0), v.size(),
+                             [&v, &mutex, &ranges](std::size_t b, std::size_t e) {
+                                 for (auto i = b; i != e; ++i) {
+                                     ++v[i];
+                                 }
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 ranges.emplace_back(b, e);
+                             },
+                             grain, p);
+                CHECK(std::all_of(v.begin(), v.end(), [](const std::atomic<int> &n) { return n.load() == 1; }));
+                std::sort(ranges.begin(), ranges.end());
+                // Only the last subrange can be smaller than the grain size.
+                std::size_t n_small = 0u;
+                for (const auto &r : ranges) {
+                    n_small += (r.second - r.first < grain);
+                }
+                CHECK(n_small <= 1u);
+                // No more threads than grains are used.
+                if (grain == 20000u) {
+                    CHECK(ranges.size() == 1u);
+                }
+            }
+        }
+        // Signed ranges.
+        std::atomic<long> sum(0);
+        parallel_for(4u, -1000, 1001,
+                     [&sum](int b, int e) {
+                         for (; b != e; ++b) {
+                             sum += b;
+                         }
+                     },
+                     3, p);
+        CHECK(sum.load() == 0);
+        // Small unsigned type.
+        std::atomic<unsigned> count(0);
+        parallel_for(3u, static_cast<unsigned char>(5), static_cast<unsigned char>(255),
+                     [&count](unsigned char b, unsigned char e) { count += static_cast<unsigned>(e - b); },
+                     static_cast<unsigned char>(1), p);
+        CHECK(count.load() == 250u);
+        // Exceptions are propagated, and they cancel the loop.
+        for (unsigned nt = 1u; nt <= 6u; ++nt) {
+            std::atomic<unsigned> n_calls(0);
+            CHECK_THROWS_AS(parallel_for(nt, 0, 1000,
+                                         [&n_calls](int b, int) {
+                                             ++n_calls;
+                                             if (b == 0) {
+                                                 throw std::runtime_error("");
+                                             }
+                                         },
+                                         1, p),
+                            std::runtime_error);
+            CHECK(n_calls.load() <= 1000u);
+        }
+    }
+}
+
+TEST_CASE("parallel_for_nested_test")
+{
+    // Nested loops from the threads of the pool must not deadlock, even if there are more outer iterations than
+    // threads.
+    for (unsigned pool_size = 1u; pool_size <= 4u; ++pool_size) {
+        thread_pool::resize(pool_size);
+        std::vector<std::atomic<int>> v(100u * 100u);
+        parallel_for(pool_size, 0u, 100u,
+                     [&v, pool_size](unsigned b, unsigned e) {
+                         for (; b != e; ++b) {
+                             parallel_for(pool_size, 0u, 100u,
+                                          [&v, b](unsigned ib, unsigned ie) {
+                                              for (; ib != ie; ++ib) {
+                                                  ++v[b * 100u + ib];
+                                              }
+                                          });
+                         }
+                     });
+        CHECK(std::all_of(v.begin(), v.end(), [](const std::atomic<int> &n) { return n.load() == 1; }));
+    }
+}
+
+TEST_CASE("parallel_reduce_test")
+{
+    thread_pool::resize(4u);
+    auto sum_range = [](unsigned long b, unsigned long e) {
+        unsigned long retval = 0u;
+        for (; b != e; ++b) {
+            retval += b;
+        }
+        return retval;
+    };
+    auto add = [](unsigned long a, unsigned long b) { return a + b; };
+    CHECK_THROWS_AS(parallel_reduce(0u, 0ul, 10ul, 0ul, sum_range, add), std::invalid_argument);
+    CHECK_THROWS_AS(parallel_reduce(1u, 10ul, 0ul, 0ul, sum_range, add), std::invalid_argument);
+    for (auto p : parts) {
+        // Empty range.
+        CHECK(parallel_reduce(4u, 5ul, 5ul, 42ul, sum_range, add, 1ul, p) == 42ul);
+        for (unsigned nt = 1u; nt <= 6u; ++nt) {
+            for (unsigned long grain : {1ul, 13ul, 1000ul}) {
+                CHECK(parallel_reduce(nt, 0ul, 10000ul, 1ul, sum_range, add, grain, p) == 49995001ul);
+            }
+        }
+        // Non-trivial type.
+        auto r = parallel_reduce(3u, 0, 100, std::string("x"), [](int b, int e) { return std::string(e - b, 'a'); },
+                                 [](std::string a, const std::string &b) { return a + b; }, 1, p);
+        CHECK(r.size() == 101u);
+        CHECK(std::count(r.begin(), r.end(), 'a') == 100);
+        // Exceptions.
+        CHECK_THROWS_AS(parallel_reduce(4u, 0, 100, 0,
+                                        [](int b, int) -> int {
+                                            if (b == 0) {
+                                                throw std::runtime_error("");
+                                            }
+                                            return 1;
+                                        },
+                                        [](int a, int b) { return a + b; }, 1, p),
+                        std::runtime_error);
+    }
+    // In contiguous mode the partial results are combined in order.
+    auto r = parallel_reduce(4u, 0, 10, std::vector<int>{},
+                             [](int b, int e) {
+                                 std::vector<int> retval;
+                                 for (; b != e; ++b) {
+                                     retval.push_back(b);
+                                 }
+                                 return retval;
+                             },
+                             [](std::vector<int> a, const std::vector<int> &b) {
+                                 a.insert(a.end(), b.begin(), b.end());
+                                 return a;
+                             },
+                             1, partitioning::contiguous);
+    CHECK((r == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
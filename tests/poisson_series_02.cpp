@@ -57,6 +57,8 @@ see https://www.gnu.org/licenses/. */
 #endif
 #include <piranha/s11n.hpp>
 #include <piranha/series.hpp>
+#include <piranha/settings.hpp>
+#include <piranha/tuning.hpp>
 
 #include "catch.hpp"
 
@@ -436,4 +438,84 @@ TEST_CASE("poisson_series_multiplier_test")
         settings::reset_n_threads();
         settings::reset_min_work_per_thread();
     }
+    // Squaring.
+    {
+        using ps = poisson_series<polynomial<rational, monomial<short>>>;
+        settings::set_min_work_per_thread(1u);
+        ps x{"x"}, y{"y"}, z{"z"};
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            auto f = x * cos(x) + y * sin(x) - z * cos(x + y) + 3 * sin(2 * y) + 1;
+            f = f * (f + x);
+            const auto g = f;
+            CHECK(f * f == f * g);
+            const auto h = x * cos(x) + y * sin(x);
+            CHECK(h * h
+                  == 1 / 2_q * piranha::pow(x, 2) + 1 / 2_q * piranha::pow(x, 2) * cos(2 * x)
+                         + 1 / 2_q * piranha::pow(y, 2) - 1 / 2_q * piranha::pow(y, 2) * cos(2 * x)
+                         + x * y * sin(2 * x));
+        }
+        settings::reset_n_threads();
+        settings::reset_min_work_per_thread();
+    }
+}
+
+TEST_CASE("poisson_series_zoned_multiplier_test")
+{
+    // Check the consistency of the results across thread counts, block sizes (which determine the number of rounds
+    // in multithreaded mode) and estimation thresholds.
+    settings::set_min_work_per_thread(1u);
+    {
+        using ps = poisson_series<polynomial<rational, monomial<short>>>;
+        ps x{"x"}, y{"y"}, z{"z"};
+        const auto f = piranha::pow(x * cos(x) + y * sin(x + z) / 3 - z * cos(x - y) + 1, 3),
+                   g = piranha::pow(y * cos(x) - x * sin(2 * y + z) + z / 5, 3);
+        settings::set_n_threads(1u);
+        const auto ref = f * g, ref_sq = f * f;
+        CHECK(ref_sq == f * ps(f));
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            for (unsigned long bs : {16ul, 256ul}) {
+                tuning::set_multiplication_block_size(bs);
+                for (unsigned long e_thr : {0ul, 100000ul}) {
+                    tuning::set_estimate_threshold(e_thr);
+                    CHECK(f * g == ref);
+                    CHECK(g * f == ref);
+                    CHECK(f * f == ref_sq);
+                    // Complete cancellation.
+                    CHECK(f * g - g * f == 0);
+                    CHECK(cos(x) * sin(x) - sin(2 * x) / 2 == 0);
+                }
+            }
+        }
+        tuning::reset_estimate_threshold();
+        tuning::reset_multiplication_block_size();
+    }
+    {
+        // Integral coefficients: the halving must happen after the accumulation.
+        using ps = poisson_series<integer>;
+        ps x{"x"}, y{"y"};
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            CHECK(cos(x) * cos(x) == 0);
+            CHECK((cos(x) + cos(y)) * (cos(x) + cos(y)) == cos(x + y) + cos(x - y) + 1);
+            CHECK(ps(3) * ps(5) == 15);
+        }
+    }
+    {
+        using ps = poisson_series<double>;
+        ps x{"x"}, y{"y"};
+        const auto f = piranha::pow(cos(x) + 2. * sin(x + y) - cos(2 * y) + 1., 4);
+        settings::set_n_threads(1u);
+        const auto ref = f * f;
+        for (unsigned nt = 2u; nt <= 4u; ++nt) {
+            settings::set_n_threads(nt);
+            tuning::set_multiplication_block_size(16u);
+            CHECK(f * f == ref);
+            CHECK(f * ps(f) == ref);
+            tuning::reset_multiplication_block_size();
+        }
+    }
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
 }
@@ -33,13 +33,21 @@ see https://www.gnu.org/licenses/. */
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <piranha/base_series_multiplier.hpp>
 #include <piranha/integer.hpp>
 #include <piranha/kronecker_monomial.hpp>
+#include <piranha/math.hpp>
 #include <piranha/monomial.hpp>
 #include <piranha/rational.hpp>
+#include <piranha/series_multiplier.hpp>
 #include <piranha/settings.hpp>
+#include <piranha/symbol_utils.hpp>
+#include <piranha/tuning.hpp>
 
 #include "catch.hpp"
 
@@ -151,3 +159,441 @@ TEST_CASE("polynomial_multiplier_multiplier_finalise_test")
     }
     settings::reset_n_threads();
 }
+
+TEST_CASE("polynomial_multiplier_dense_test")
+{
+    // Check that the dense and sparse Kronecker multiplication algorithms produce the same results,
+    // also with negative exponents and rational coefficients.
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        {
+            pt1 x("x"), y("y"), z("z"), t("t");
+            auto f = 1 + x + y + z + t;
+            auto tmp2 = f;
+            for (int i = 1; i < 10; ++i) {
+                f *= tmp2;
+            }
+            auto g = f + 1;
+            // Force the sparse algorithm.
+            tuning::set_dense_multiplication_threshold(100u);
+            const auto sparse = f * g;
+            // Force the dense algorithm.
+            tuning::set_dense_multiplication_threshold(1u);
+            const auto dense = f * g;
+            CHECK(dense == sparse);
+            CHECK(dense.size() == 10626u);
+            // Cancellations and negative exponents.
+            const auto h = (x.pow(-3) * y - 2 * z.pow(2) * t.pow(-1) + 1) * f;
+            const auto k = (x.pow(-3) * y + 2 * z.pow(2) * t.pow(-1) - 1) * g;
+            tuning::set_dense_multiplication_threshold(100u);
+            const auto sparse2 = h * k;
+            tuning::set_dense_multiplication_threshold(1u);
+            CHECK(h * k == sparse2);
+            CHECK((f - f) * g == pt1{});
+        }
+        {
+            pt2 x("x"), y("y"), z("z");
+            auto f = x / 3 + y * 2 / 5 - z + 1;
+            auto tmp2 = f;
+            for (int i = 1; i < 10; ++i) {
+                f *= tmp2;
+            }
+            auto g = f - 1 / 7_q;
+            tuning::set_dense_multiplication_threshold(100u);
+            const auto sparse = f * g;
+            tuning::set_dense_multiplication_threshold(1u);
+            CHECK(f * g == sparse);
+        }
+        tuning::reset_dense_multiplication_threshold();
+    }
+    settings::reset_n_threads();
+}
+
+TEST_CASE("polynomial_multiplier_truncated_kronecker_test")
+{
+    // Check the truncated Kronecker multiplication against the truncation of the untruncated product.
+    using p_type = polynomial<integer, k_monomial>;
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        p_type x("x"), y("y"), z("z"), t("t");
+        auto f = 1 + x + y + z + t;
+        auto tmp2 = f;
+        for (int i = 1; i < 10; ++i) {
+            f *= tmp2;
+        }
+        auto g = f - x.pow(-2) * y + 3 * t * z;
+        const auto full = f * g;
+        for (int d = 0; d <= 22; d += 3) {
+            p_type::set_auto_truncate_degree(d);
+            CHECK(f * g == full.truncate_degree(d));
+            p_type::set_auto_truncate_degree(d, {"x", "z"});
+            CHECK(f * g == full.truncate_degree(d, {"x", "z"}));
+        }
+        p_type::unset_auto_truncate_degree();
+        CHECK(f * g == full);
+    }
+    settings::reset_n_threads();
+}
+
+TEST_CASE("polynomial_multiplier_heap_test")
+{
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    {
+        pt1 x("x"), y("y"), z("z"), t("t");
+        auto f = 1 + x + y + z + t;
+        auto tmp2 = f;
+        for (int i = 1; i < 6; ++i) {
+            f *= tmp2;
+        }
+        auto g = f - x.pow(-2) * y + 3 * t * z;
+        const auto full = f * g;
+        CHECK(series_multiplier<pt1>(f, g)._heap_multiplication() == full);
+        CHECK(series_multiplier<pt1>(g, f)._heap_multiplication() == full);
+        CHECK(series_multiplier<pt1>(f - f, g)._heap_multiplication() == pt1{});
+        CHECK(series_multiplier<pt1>(f, g)._heap_multiplication(0u) == pt1{});
+        // The lowest-degree terms of the product.
+        for (int d = -2; d <= 14; d += 4) {
+            const auto tr = full.truncate_degree(d);
+            CHECK(series_multiplier<pt1>(f, g)._heap_multiplication(tr.size()) == tr);
+        }
+        CHECK((series_multiplier<pt1>(x - y, x + y)._heap_multiplication() == x * x - y * y));
+    }
+    {
+        pt2 x("x"), y("y"), z("z");
+        auto f = x / 3 + y * 2 / 5 - z + 1;
+        auto tmp2 = f;
+        for (int i = 1; i < 6; ++i) {
+            f *= tmp2;
+        }
+        auto g = f - 1 / 7_q;
+        CHECK(series_multiplier<pt2>(f, g)._heap_multiplication() == f * g);
+    }
+}
+
+TEST_CASE("polynomial_multiplier_no_estimation_test")
+{
+    // Check the sparse Kronecker multiplication without estimation, where the initial size of the result
+    // is too small and the overflow containers are used.
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    settings::set_min_work_per_thread(1u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        {
+            pt1 x("x"), y("y"), z("z"), t("t");
+            auto f = 1 + x + y + z + t;
+            auto tmp2 = f;
+            for (int i = 1; i < 5; ++i) {
+                f *= tmp2;
+            }
+            auto g = f - x.pow(-2) * y + 3 * t * z;
+            tuning::set_estimate_threshold(0u);
+            const auto est = f * g;
+            tuning::set_estimate_threshold(100000u);
+            CHECK(f * g == est);
+            CHECK(f * (-g) == -est);
+            CHECK((f * g).size() == est.size());
+            pt1::set_auto_truncate_degree(6);
+            CHECK(f * g == est.truncate_degree(6));
+            pt1::unset_auto_truncate_degree();
+            CHECK(f * (g - g) == pt1{});
+        }
+        {
+            pt2 x("x"), y("y"), z("z");
+            auto f = x / 3 + y * 2 / 5 - z + 1;
+            auto tmp2 = f;
+            for (int i = 1; i < 5; ++i) {
+                f *= tmp2;
+            }
+            tuning::set_estimate_threshold(0u);
+            const auto est = f * f;
+            tuning::set_estimate_threshold(100000u);
+            CHECK(f * f == est);
+        }
+        tuning::reset_estimate_threshold();
+    }
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
+TEST_CASE("polynomial_multiplier_squaring_test")
+{
+    // Check the squaring of a polynomial against the multiplication by a distinct copy.
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    using pt3 = polynomial<integer, monomial<int>>;
+    settings::set_min_work_per_thread(1u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        for (unsigned long e_thr : {0ul, 100000ul}) {
+            tuning::set_estimate_threshold(e_thr);
+            for (unsigned long d_thr : {1ul, 100ul}) {
+                tuning::set_dense_multiplication_threshold(d_thr);
+                {
+                    pt1 x("x"), y("y"), z("z"), t("t");
+                    auto f = 1 + x + y + z + t;
+                    f = f.pow(4) - x.pow(-2) * y + 3 * t * z;
+                    const auto g = f;
+                    CHECK(f * f == f * g);
+                    CHECK(f * f == g * f);
+                    CHECK((f * f).size() == (f * g).size());
+                    const auto h = x - y;
+                    CHECK(h * h == x * x - 2 * x * y + y * y);
+                }
+                {
+                    pt2 x("x"), y("y"), z("z");
+                    auto f = (x / 3 + y * 2 / 5 - z + 1).pow(4);
+                    const auto g = f;
+                    CHECK(f * f == f * g);
+                    CHECK((-f) * (-f) == f * g);
+                }
+                {
+                    pt3 x("x"), y("y"), z("z");
+                    auto f = (x + y - z * 2 + 1).pow(5);
+                    const auto g = f;
+                    CHECK(f * f == f * g);
+                    pt3 zero;
+                    CHECK(zero * zero == pt3{});
+                }
+            }
+        }
+        tuning::reset_dense_multiplication_threshold();
+        tuning::reset_estimate_threshold();
+        // Power cache built via squaring.
+        {
+            pt1 x("x"), y("y"), z("z");
+            const auto f = x + 2 * y - z + 1;
+            pt1::clear_pow_cache();
+            std::vector<pt1> cmp;
+            for (int i = 0; i < 12; ++i) {
+                cmp.push_back(f.pow(i));
+            }
+            pt1::clear_pow_cache();
+            tuning::set_pow_squaring(true);
+            for (int i = 11; i >= 0; --i) {
+                CHECK(f.pow(i) == cmp[static_cast<std::vector<pt1>::size_type>(i)]);
+            }
+            tuning::reset_pow_squaring();
+            pt1::clear_pow_cache();
+        }
+    }
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
+TEST_CASE("polynomial_multiplier_multiply_accumulate_test")
+{
+    // Check the accumulation of products directly into an existing polynomial.
+    auto run_checks = [](const auto &f, const auto &g, const auto &h0) {
+        using p_type = typename std::decay<decltype(f)>::type;
+        // Accumulation into a non-empty polynomial.
+        auto h = h0;
+        math::multiply_accumulate(h, f, g);
+        CHECK(h == h0 + f * g);
+        // Accumulation into an empty polynomial.
+        p_type e;
+        math::multiply_accumulate(e, f, g);
+        CHECK(e == f * g);
+        // Complete cancellation.
+        h = -(f * g);
+        math::multiply_accumulate(h, f, g);
+        CHECK(h == p_type{});
+        CHECK(h.size() == 0u);
+        // Squaring.
+        h = h0;
+        math::multiply_accumulate(h, f, f);
+        CHECK(h == h0 + f * f);
+        // Aliasing.
+        h = f;
+        math::multiply_accumulate(h, h, g);
+        CHECK(h == f + f * g);
+        // Low-level interface.
+        h = h0;
+        series_multiplier<p_type>(f, g)._multiply_accumulate(h);
+        CHECK(h == h0 + f * g);
+        p_type wrong{"w"};
+        CHECK_THROWS_AS(series_multiplier<p_type>(f, g)._multiply_accumulate(wrong), std::invalid_argument);
+    };
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    using pt3 = polynomial<integer, monomial<int>>;
+    settings::set_min_work_per_thread(1u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        for (unsigned long e_thr : {0ul, 100000ul}) {
+            tuning::set_estimate_threshold(e_thr);
+            for (unsigned long d_thr : {1ul, 100ul}) {
+                tuning::set_dense_multiplication_threshold(d_thr);
+                {
+                    pt1 x("x"), y("y"), z("z"), t("t");
+                    const auto f = (1 + x + y + z + t).pow(4), g = (1 - x + y * 2 - z + t).pow(3);
+                    run_checks(f, g, (x + y + z - t).pow(5));
+                    // Truncated multiplication.
+                    pt1::set_auto_truncate_degree(5);
+                    auto h = (x + y).pow(3);
+                    math::multiply_accumulate(h, f, g);
+                    CHECK(h == (x + y).pow(3) + f * g);
+                    pt1::unset_auto_truncate_degree();
+                }
+                {
+                    pt2 x("x"), y("y"), z("z");
+                    const auto f = (x / 3 + y * 2 / 5 - z + 1).pow(4), g = (x - y / 7 + z / 2).pow(3);
+                    run_checks(f, g, (x / 5 + z).pow(5));
+                }
+                {
+                    pt3 x("x"), y("y"), z("z");
+                    const auto f = (x + y - z * 2 + 1).pow(5), g = (x - y + 3).pow(4);
+                    run_checks(f, g, (x + y + z).pow(6));
+                }
+            }
+        }
+        tuning::reset_dense_multiplication_threshold();
+        tuning::reset_estimate_threshold();
+        {
+            // Polynomial coefficients: only the top-level accumulation goes through the polynomial
+            // specialisation of math::multiply_accumulate().
+            using cf4 = polynomial<integer, k_monomial>;
+            using pt4 = polynomial<cf4, k_monomial>;
+            pt4 x("x"), y("y");
+            const cf4 a("a"), b("b");
+            const auto f = (x * a + y * b + 1).pow(4), g = (x * b - y * a + 2).pow(3);
+            const auto h0 = (x + y).pow(2) * a;
+            auto h = h0;
+            math::multiply_accumulate(h, f, g);
+            CHECK(h == h0 + f * g);
+            CHECK(detail::poly_nested_fma_count() == 0u);
+        }
+    }
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
+TEST_CASE("polynomial_multiplier_batch_multiply_test")
+{
+    // Check the one-to-many multiplication via prepared operands.
+    auto run_checks = [](const auto &f, const auto &gs) {
+        using p_type = typename std::decay<decltype(f)>::type;
+        prepared_operand<p_type> p(f);
+        CHECK(&p.get_series() == &f);
+        CHECK(p._term_pointers().size() == f.size());
+        auto res = batch_multiply(p, gs.begin(), gs.end());
+        REQUIRE(res.size() == gs.size());
+        for (decltype(res.size()) i = 0u; i < res.size(); ++i) {
+            CHECK(res[i] == f * gs[i]);
+        }
+        // Direct use of the multiplier.
+        for (const auto &g : gs) {
+            if (g.get_symbol_set() == f.get_symbol_set()) {
+                CHECK(series_multiplier<p_type>(p, g)() == f * g);
+            }
+        }
+        // Empty range.
+        CHECK(batch_multiply(p, gs.end(), gs.end()).empty());
+    };
+    using pt1 = polynomial<integer, k_monomial>;
+    using pt2 = polynomial<rational, k_monomial>;
+    using pt3 = polynomial<integer, monomial<int>>;
+    using pt4 = polynomial<double, monomial<rational>>;
+    settings::set_min_work_per_thread(1u);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        settings::set_n_threads(nt);
+        {
+            pt1 x("x"), y("y"), z("z"), t("t");
+            const auto f = (1 + x + y + z + t).pow(4);
+            std::vector<pt1> gs{(1 - x + y * 2 - z + t).pow(3), (x + y).pow(2), pt1{}, pt1{3}, x - z, f,
+                                (x + t).pow(6), (y - t * 4).pow(2)};
+            run_checks(f, gs);
+            // Bounds are cached for integral exponents.
+            CHECK(prepared_operand<pt1>(f)._bounds().size() == 4u);
+            CHECK(prepared_operand<pt1>(f)._bounds()[0] == std::make_pair(integer(0), integer(4)));
+            // Operands with different symbol sets.
+            gs.push_back(pt1{"a"} * x);
+            run_checks(f, gs);
+            // Empty prepared operand.
+            run_checks(pt1{}, gs);
+        }
+        {
+            pt2 x("x"), y("y"), z("z");
+            const auto f = (x / 3 + y * 2 / 5 - z + 1).pow(4);
+            std::vector<pt2> gs{(x - y / 7 + z / 2).pow(3), (x / 5 + z).pow(2), x * y * z, f, pt2{1} / 2};
+            run_checks(f, gs);
+        }
+        {
+            pt3 x("x"), y("y"), z("z");
+            const auto f = (x + y - z * 2 + 1).pow(5);
+            std::vector<pt3> gs{(x - y + 3).pow(4), (x + y + z).pow(6), z.pow(-2), f, pt3{}};
+            run_checks(f, gs);
+            // Overflow detection with cached bounds.
+            const auto big = x.pow(std::numeric_limits<int>::max());
+            prepared_operand<pt3> pb(big);
+            std::vector<pt3> ov{x};
+            CHECK_THROWS_AS(batch_multiply(pb, ov.begin(), ov.end()), std::overflow_error);
+        }
+        {
+            // No bounds for rational exponents.
+            pt4 x("x"), y("y");
+            const auto f = (x + y / 2 + 1).pow(3);
+            CHECK(prepared_operand<pt4>(f)._bounds().empty());
+            std::vector<pt4> gs{(x - y).pow(2), x * 3, f};
+            run_checks(f, gs);
+        }
+    }
+    settings::reset_n_threads();
+    settings::reset_min_work_per_thread();
+}
+
+struct incremental_rehash_tester {
+    template <typename Key>
+    void operator()(const Key &) const
+    {
+        using p_type = polynomial<integer, Key>;
+        using term_type = typename p_type::term_type;
+        // Build a polynomial term by term with the incremental rehash mode on, stopping while a rehash is pending.
+        auto build = [](int offset) {
+            p_type retval;
+            retval.set_symbol_set(symbol_fset{"x", "y", "z"});
+            for (int i = 0; retval.size() < 500u || !retval._container().rehash_in_progress(); ++i) {
+                retval.insert(term_type(integer(1 + (i + offset) % 7), Key{i % 10, (i / 10) % 10, i / 100 + offset}));
+            }
+            return retval;
+        };
+        tuning::set_incremental_rehash(true);
+        settings::set_min_work_per_thread(1u);
+        for (unsigned nt = 1u; nt <= 4u; ++nt) {
+            auto f = build(0), g = build(3), h = build(5);
+            // The copies do not inherit the pending rehash.
+            const p_type f0(f), g0(g), h0(h);
+            CHECK(!f0._container().rehash_in_progress());
+            settings::set_n_threads(1u);
+            const auto ref = f0 * g0, ref_sq = f0 * f0;
+            settings::set_n_threads(nt);
+            CHECK(f._container().rehash_in_progress());
+            CHECK(g._container().rehash_in_progress());
+            CHECK(f * g == ref);
+            // The operands are not modified by the multiplication.
+            CHECK(f._container().rehash_in_progress());
+            CHECK(g._container().rehash_in_progress());
+            CHECK(series_multiplier<p_type>(prepared_operand<p_type>(f), g)() == ref);
+            f = build(0);
+            g = build(3);
+            CHECK(h._container().rehash_in_progress());
+            math::multiply_accumulate(h, f, g);
+            CHECK(h == h0 + ref);
+            f = build(0);
+            CHECK(f * f == ref_sq);
+        }
+        settings::reset_n_threads();
+        settings::reset_min_work_per_thread();
+        tuning::reset_incremental_rehash();
+    }
+};
+
+TEST_CASE("polynomial_multiplier_incremental_rehash_test")
+{
+    // Multiplication of operands and accumulation into destinations with a pending incremental rehash.
+    boost::mpl::for_each<boost::mpl::vector<monomial<int>, kronecker_monomial<std::int_least64_t>>>(
+        incremental_rehash_tester());
+}
@@ -28,7 +28,10 @@ see https://www.gnu.org/licenses/. */
 
 #include <piranha/runtime_info.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 #include <piranha/memory.hpp>
 #include <piranha/settings.hpp>
@@ -41,6 +44,15 @@ TEST_CASE("runtime_info_print_test")
 {
     std::cout << "Concurrency: " << runtime_info::get_hardware_concurrency() << '\n';
     std::cout << "Cache line size: " << runtime_info::get_cache_line_size() << '\n';
+    const auto nodes = runtime_info::get_numa_nodes();
+    std::cout << "NUMA nodes: " << nodes.size() << '\n';
+    for (decltype(nodes.size()) i = 0u; i < nodes.size(); ++i) {
+        std::cout << "  node " << i << ":";
+        for (auto cpu : nodes[i]) {
+            std::cout << ' ' << cpu;
+        }
+        std::cout << '\n';
+    }
     std::cout << "Memory alignment primitives: "
               <<
 #if defined(PIRANHA_HAVE_MEMORY_ALIGNMENT_PRIMITIVES)
@@ -56,3 +68,29 @@ TEST_CASE("runtime_info_settings_test")
                 || runtime_info::get_hardware_concurrency() == 0u));
     CHECK(runtime_info::get_cache_line_size() == settings::get_cache_line_size());
 }
+
+TEST_CASE("runtime_info_numa_test")
+{
+    using v_type = std::vector<unsigned>;
+    CHECK(detail::parse_cpu_list("").empty());
+    CHECK(detail::parse_cpu_list(" \n").empty());
+    CHECK(detail::parse_cpu_list("0") == v_type{0u});
+    CHECK(detail::parse_cpu_list("3\n") == v_type{3u});
+    CHECK(detail::parse_cpu_list("0-3") == (v_type{0u, 1u, 2u, 3u}));
+    CHECK(detail::parse_cpu_list("0-1,8,10-11") == (v_type{0u, 1u, 8u, 10u, 11u}));
+    CHECK(detail::parse_cpu_list(" 4 , 2-2 ") == (v_type{4u, 2u}));
+    CHECK_THROWS_AS(detail::parse_cpu_list("a"), std::invalid_argument);
+    CHECK_THROWS_AS(detail::parse_cpu_list("1,"), std::invalid_argument);
+    CHECK_THROWS_AS(detail::parse_cpu_list("3-1"), std::invalid_argument);
+    CHECK_THROWS_AS(detail::parse_cpu_list("-1"), std::invalid_argument);
+    CHECK_THROWS_AS(detail::parse_cpu_list("1-"), std::invalid_argument);
+    CHECK_THROWS_AS(detail::parse_cpu_list("99999999999999999999"), std::invalid_argument);
+    // The detected nodes are non-empty and do not share processors.
+    v_type all;
+    for (const auto &node : runtime_info::get_numa_nodes()) {
+        CHECK(!node.empty());
+        all.insert(all.end(), node.begin(), node.end());
+    }
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+}
@@ -29,6 +29,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/series.hpp>
 #include <boost/lexical_cast.hpp>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
@@ -36,6 +37,8 @@ see https://www.gnu.org/licenses/. */
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <mp++/config.hpp>
 #include <mp++/exceptions.hpp>
@@ -62,6 +65,7 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/series_multiplier.hpp>
 #include <piranha/settings.hpp>
 #include <piranha/symbol_utils.hpp>
+#include <piranha/tuning.hpp>
 #include <piranha/type_traits.hpp>
 
 #include "catch.hpp"
@@ -336,6 +340,13 @@ struct table_info_tester {
             CHECK((q.table_sparsity() == s_type{{1u, 1u}}));
             CHECK(q.table_load_factor() != 0.);
             CHECK(q.table_bucket_count() != 0u);
+            CHECK(p.table_hash_quality().m_n_elements == 0u);
+            const auto hq = q.table_hash_quality();
+            CHECK(hq.m_n_elements == 1u);
+            CHECK(hq.m_n_buckets == q.table_bucket_count());
+            CHECK(hq.m_n_occupied == 1u);
+            CHECK(hq.m_max_chain == 1u);
+            CHECK(!hq.is_degenerate());
         }
     };
     template <typename Cf>
@@ -350,6 +361,196 @@ TEST_CASE("series_table_info_test")
     tuple_for_each(cf_types{}, table_info_tester());
 }
 
+struct shrink_to_fit_tester {
+    template <typename Cf>
+    struct runner {
+        template <typename Expo>
+        void operator()(const Expo &) const
+        {
+            typedef g_series_type<Cf, Expo> p_type1;
+            typedef typename p_type1::term_type term_type;
+            typedef typename term_type::key_type key_type;
+            p_type1 p;
+            p.shrink_to_fit();
+            CHECK(p.table_bucket_count() == 0u);
+            p.set_symbol_set(symbol_fset{"x"});
+            for (int i = 0; i < 1000; ++i) {
+                p.insert(term_type(Cf(1), key_type{Expo(i)}));
+            }
+            auto q(p);
+            q.insert(term_type(Cf(1), key_type{Expo(1000)}));
+            // Almost all the terms cancel out, the table is compacted automatically.
+            auto r = q - p;
+            CHECK(r.size() == 1u);
+            CHECK(r.table_bucket_count() == 1u);
+            r = p - p;
+            CHECK(r.empty());
+            CHECK(r.table_bucket_count() == 0u);
+            // Disable the automatic compaction.
+            tuning::set_compaction_threshold(0u);
+            r = q - p;
+            CHECK(r.size() == 1u);
+            CHECK(r.table_bucket_count() > 1u);
+            r.shrink_to_fit();
+            CHECK(r.size() == 1u);
+            CHECK(r.table_bucket_count() == 1u);
+            CHECK(r == q - p);
+            tuning::reset_compaction_threshold();
+            // A table which is not sparse is not compacted.
+            const auto b_count = q.table_bucket_count();
+            q.shrink_to_fit();
+            CHECK(q.table_bucket_count() == b_count);
+            CHECK(q.size() == 1001u);
+        }
+    };
+    template <typename Cf>
+    void operator()(const Cf &) const
+    {
+        tuple_for_each(expo_types{}, runner<Cf>());
+    }
+};
+
+TEST_CASE("series_shrink_to_fit_test")
+{
+    tuple_for_each(cf_types{}, shrink_to_fit_tester());
+}
+
+struct incremental_rehash_tester {
+    template <typename Cf>
+    struct runner {
+        template <typename Expo>
+        void operator()(const Expo &) const
+        {
+            typedef g_series_type<Cf, Expo> p_type1;
+            typedef typename p_type1::term_type term_type;
+            typedef typename term_type::key_type key_type;
+            // Reference series accumulated with the default resizing strategy.
+            p_type1 ref;
+            ref.set_symbol_set(symbol_fset{"x"});
+            for (int i = 0; i < 3000; ++i) {
+                ref.insert(term_type(Cf(i % 3 - 1), key_type{Expo(i % 2000)}));
+            }
+            tuning::set_incremental_rehash(true);
+            p_type1 p;
+            p.set_symbol_set(symbol_fset{"x"});
+            bool in_progress = false;
+            for (int i = 0; i < 3000; ++i) {
+                p.insert(term_type(Cf(i % 3 - 1), key_type{Expo(i % 2000)}));
+                in_progress = in_progress || p._container().rehash_in_progress();
+            }
+            CHECK(in_progress);
+            CHECK(p._container().get_incremental_rehash());
+            CHECK(p == ref);
+            CHECK(p.size() == ref.size());
+            // Accumulation via in-place arithmetics.
+            p_type1 acc;
+            for (int i = 0; i < 100; ++i) {
+                p_type1 tmp;
+                tmp.set_symbol_set(symbol_fset{"x"});
+                for (int j = 0; j < 30; ++j) {
+                    tmp.insert(term_type(Cf((i * 30 + j) % 3 - 1), key_type{Expo((i * 30 + j) % 2000)}));
+                }
+                acc += tmp;
+            }
+            CHECK(acc == ref);
+            acc -= ref;
+            CHECK(acc.empty());
+            tuning::reset_incremental_rehash();
+            // The flag is applied when the table grows.
+            for (int i = 0; i < 10000; ++i) {
+                p.insert(term_type(Cf(1), key_type{Expo(10000 + i)}));
+            }
+            CHECK(!p._container().get_incremental_rehash());
+            CHECK(!p._container().rehash_in_progress());
+            CHECK(p.size() == ref.size() + 10000u);
+        }
+    };
+    template <typename Cf>
+    void operator()(const Cf &) const
+    {
+        tuple_for_each(expo_types{}, runner<Cf>());
+    }
+};
+
+TEST_CASE("series_incremental_rehash_test")
+{
+    tuple_for_each(cf_types{}, incremental_rehash_tester());
+}
+
+struct bulk_insert_tester {
+    template <typename Cf>
+    struct runner {
+        template <typename Expo>
+        void operator()(const Expo &) const
+        {
+            typedef g_series_type<Cf, Expo> p_type1;
+            typedef typename p_type1::term_type term_type;
+            typedef typename term_type::key_type key_type;
+            // Reference series built term by term.
+            p_type1 ref;
+            ref.set_symbol_set(symbol_fset{"x"});
+            std::vector<term_type> terms;
+            for (int i = 0; i < 1000; ++i) {
+                // Duplicate terms, some of which cancel out.
+                terms.emplace_back(Cf(i % 3 - 1), key_type{Expo(i % 500)});
+                ref.insert(terms.back());
+            }
+            p_type1 p;
+            p.set_symbol_set(symbol_fset{"x"});
+            p.bulk_insert(terms.begin(), terms.end());
+            CHECK(p == ref);
+            CHECK(p.table_load_factor() <= 1.);
+            // Negative sign.
+            p.template bulk_insert<false>(terms.begin(), terms.end());
+            CHECK(p.empty());
+            p.template bulk_insert<false>(terms.begin(), terms.end());
+            CHECK(p == -ref);
+            // Unique insertion, moving the terms.
+            std::vector<term_type> u_terms;
+            for (int i = 500; i < 1000; ++i) {
+                u_terms.emplace_back(Cf(i), key_type{Expo(i)});
+            }
+            p.bulk_insert(std::make_move_iterator(u_terms.begin()), std::make_move_iterator(u_terms.end()), true);
+            CHECK(p.size() == ref.size() + 500u);
+            // Incompatible terms.
+            terms.emplace_back(Cf(1), key_type{Expo(1), Expo(2)});
+            CHECK_THROWS_AS(p.bulk_insert(terms.begin(), terms.end()), std::invalid_argument);
+            CHECK(p.empty());
+            // Parallel insertion.
+            settings::set_min_work_per_thread(1u);
+            for (unsigned nt = 1u; nt <= 4u; ++nt) {
+                settings::set_n_threads(nt);
+                p_type1 q;
+                q.set_symbol_set(symbol_fset{"x"});
+                q.bulk_insert(terms.begin(), terms.end() - 1);
+                CHECK(q == ref);
+            }
+            settings::reset_n_threads();
+            settings::reset_min_work_per_thread();
+            // Filter and trim.
+            CHECK(ref.filter([](const std::pair<Cf, p_type1> &) { return true; }) == ref);
+            CHECK(ref.filter([](const std::pair<Cf, p_type1> &) { return false; }).empty());
+            p_type1 r;
+            r.set_symbol_set(symbol_fset{"x", "y"});
+            for (int i = 0; i < 100; ++i) {
+                r.insert(term_type(Cf(1), key_type{Expo(i), Expo(0)}));
+            }
+            CHECK(r.trim().get_symbol_set() == symbol_fset{"x"});
+            CHECK(r.trim().size() == 100u);
+        }
+    };
+    template <typename Cf>
+    void operator()(const Cf &) const
+    {
+        tuple_for_each(expo_types{}, runner<Cf>());
+    }
+};
+
+TEST_CASE("series_bulk_insert_test")
+{
+    tuple_for_each(cf_types{}, bulk_insert_tester());
+}
+
 struct fake_int_01 {
     fake_int_01();
     explicit fake_int_01(int);
@@ -530,3 +731,44 @@ TEST_CASE("series_pow_test")
     p_type3::clear_pow_cache();
 #endif
 }
+
+TEST_CASE("series_product_test")
+{
+    using p_type = polynomial<rational, monomial<int>>;
+    p_type x{"x"}, y{"y"}, z{"z"};
+    // Variadic overload.
+    CHECK(piranha::product(x) == x);
+    CHECK(piranha::product(x, y) == x * y);
+    CHECK(piranha::product(x + 1, y - 2, z / 3) == (x + 1) * (y - 2) * (z / 3));
+    CHECK(piranha::product(x, y, z).get_symbol_set() == symbol_fset{"x", "y", "z"});
+    const auto f = (x + y + z + 1).pow(3), g = x - z / 2, h = y + 1;
+    CHECK(piranha::product(f, g, h, f, g) == f * g * h * f * g);
+    CHECK(piranha::product(g, f, g, h) == f * g * g * h);
+    CHECK(piranha::product(f, f) == f * f);
+    CHECK(piranha::product(f, p_type{}, g) == 0);
+    // Range overload.
+    std::vector<p_type> v;
+    CHECK(piranha::product(v.begin(), v.end()) == 1);
+    v.push_back(g);
+    CHECK(piranha::product(v.begin(), v.end()) == g);
+    v.push_back(f);
+    v.push_back(h);
+    v.push_back(g);
+    v.push_back(x + 2);
+    CHECK(piranha::product(v.begin(), v.end()) == g * f * h * g * (x + 2));
+    CHECK(piranha::product(v.cbegin(), v.cend()) == g * f * h * g * (x + 2));
+    // Type checks.
+    CHECK((std::is_same<decltype(piranha::product(x, y)), p_type>::value));
+    CHECK((std::is_same<decltype(piranha::product(v.begin(), v.end())), p_type>::value));
+    // Sparse and dense factors, with the size of all the pairwise products estimated by the multiplier.
+    tuning::set_estimate_threshold(0u);
+    const auto d = (x + y + 1).pow(4), sp = x.pow(10) + y.pow(7) * z + z.pow(13) - 3;
+    CHECK(piranha::product(sp, d, sp, d, h) == sp * d * sp * d * h);
+    CHECK(piranha::product(d, sp, d) == d * sp * d);
+    for (unsigned nt = 1u; nt <= 3u; ++nt) {
+        settings::set_n_threads(nt);
+        CHECK(piranha::product(sp, d, f, sp) == sp * d * f * sp);
+    }
+    settings::reset_n_threads();
+    tuning::reset_estimate_threshold();
+}
@@ -31,6 +31,7 @@ see https://www.gnu.org/licenses/. */
 #include <stdexcept>
 
 #include <piranha/runtime_info.hpp>
+#include <piranha/thread_pool.hpp>
 
 #include "catch.hpp"
 
@@ -84,3 +85,29 @@ TEST_CASE("settings_min_work_per_thread_test")
     CHECK_NOTHROW(settings::reset_min_work_per_thread());
     CHECK(settings::get_min_work_per_thread() == def);
 }
+
+TEST_CASE("settings_thread_binding_test")
+{
+    CHECK(!settings::get_thread_binding());
+    settings::set_thread_binding(true);
+    CHECK(settings::get_thread_binding());
+    CHECK(settings::get_thread_binding() == thread_pool::get_binding());
+    settings::set_thread_binding(true);
+    CHECK(settings::get_thread_binding());
+    settings::reset_thread_binding();
+    CHECK(!settings::get_thread_binding());
+    CHECK(!thread_pool::get_binding());
+}
+
+TEST_CASE("settings_nested_parallelism_test")
+{
+    CHECK(settings::get_nested_parallelism());
+    settings::set_nested_parallelism(false);
+    CHECK(!settings::get_nested_parallelism());
+    CHECK(settings::get_nested_parallelism() == thread_pool::get_nested_parallelism());
+    settings::set_nested_parallelism(false);
+    CHECK(!settings::get_nested_parallelism());
+    settings::reset_nested_parallelism();
+    CHECK(settings::get_nested_parallelism());
+    CHECK(thread_pool::get_nested_parallelism());
+}
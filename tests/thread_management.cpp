@@ -0,0 +1,78 @@
+/* Copyright 2009-2017 Francesco Biscani (bluescarni@gmail.com)
+
+This file is part of the Piranha library.
+
+The Piranha library is free software; you can redistribute it and/or modify
+it under the terms of either:
+
+  * the GNU Lesser General Public License as published by the Free
+    Software Foundation; either version 3 of the License, or (at your
+    option) any later version.
+
+or
+
+  * the GNU General Public License as published by the Free Software
+    Foundation; either version 3 of the License, or (at your option) any
+    later version.
+
+or both in parallel, as here.
+
+The Piranha library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received copies of the GNU General Public License and the
+GNU Lesser General Public License along with the Piranha library.  If not,
+see https://www.gnu.org/licenses/. */
+
+#include <piranha/thread_management.hpp>
+
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <piranha/exceptions.hpp>
+#include <piranha/runtime_info.hpp>
+
+#include "catch.hpp"
+
+using namespace piranha;
+
+TEST_CASE("thread_management_bind_test")
+{
+#if defined(__linux__) || defined(_WIN32)
+    // Run the bindings in a separate thread, so that the affinity of the main thread is not altered.
+    // NOTE: the Catch assertion macros are not thread-safe, collect the results and check them here.
+    bool invalid_thrown = false;
+    std::vector<std::pair<unsigned, std::pair<bool, unsigned>>> results;
+    std::thread t([&invalid_thrown, &results]() {
+        try {
+            thread_management::bind_to_proc(std::numeric_limits<unsigned>::max());
+        } catch (const std::invalid_argument &) {
+            invalid_thrown = true;
+        }
+        const unsigned hc = runtime_info::get_hardware_concurrency();
+        for (unsigned i = 0u; i < hc; ++i) {
+            try {
+                thread_management::bind_to_proc(i);
+            } catch (const std::runtime_error &) {
+                // The processor might not be available to the process.
+                continue;
+            }
+            results.emplace_back(i, thread_management::bound_proc());
+        }
+    });
+    t.join();
+    CHECK(invalid_thrown);
+    for (const auto &r : results) {
+        CHECK(r.second.first);
+        CHECK(r.second.second == r.first);
+    }
+#else
+    CHECK_THROWS_AS(thread_management::bind_to_proc(0u), not_implemented_error);
+    CHECK_THROWS_AS(thread_management::bound_proc(), not_implemented_error);
+#endif
+}
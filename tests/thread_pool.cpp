@@ -29,10 +29,16 @@ see https://www.gnu.org/licenses/. */
 #include <piranha/thread_pool.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <boost/algorithm/string/predicate.hpp>
 #include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
 #include <limits>
 #include <list>
+#include <memory>
 #include <stdexcept>
 #include <thread>
 #include <utility>
@@ -40,11 +46,14 @@ see https://www.gnu.org/licenses/. */
 
 #include <mp++/config.hpp>
 
+#include <piranha/detail/small_task.hpp>
+#include <piranha/detail/work_stealing_deque.hpp>
 #include <piranha/integer.hpp>
 #if defined(MPPP_WITH_MPFR)
 #include <piranha/real.hpp>
 #endif
 #include <piranha/runtime_info.hpp>
+#include <piranha/thread_management.hpp>
 #include <piranha/type_traits.hpp>
 
 #include "catch.hpp"
@@ -343,9 +352,18 @@ TEST_CASE("thread_pool_use_threads_test")
     auto f1 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(100u, 3u); });
     auto f2 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(100u, 1u); });
     auto f3 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(100u, 0u); });
-    CHECK(f1.get() == 1u);
-    CHECK(f2.get() == 1u);
+    // With nested parallelism, the calling thread can use only the idle threads.
+    const auto r1 = f1.get(), r2 = f2.get();
+    CHECK(r1 >= 1u);
+    CHECK(r1 <= 4u);
+    CHECK(r2 >= 1u);
+    CHECK(r2 <= 4u);
     CHECK_THROWS_AS(f3.get(), std::invalid_argument);
+    thread_pool::set_nested_parallelism(false);
+    CHECK(thread_pool::use_threads(100u, 3u) == 4u);
+    CHECK(thread_pool::enqueue(0u, []() { return thread_pool::use_threads(100u, 3u); }).get() == 1u);
+    CHECK(thread_pool::enqueue(0u, []() { return thread_pool::use_threads(100u, 1u); }).get() == 1u);
+    thread_pool::set_nested_parallelism(true);
     thread_pool::resize(1u);
     CHECK(thread_pool::use_threads(100u, 3u) == 1u);
     CHECK_THROWS_AS(thread_pool::use_threads(100u, 0u), std::invalid_argument);
@@ -363,7 +381,400 @@ TEST_CASE("thread_pool_use_threads_test")
     auto f7 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(integer(100u), integer(3u)); });
     auto f8 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(integer(100u), integer(1u)); });
     auto f9 = thread_pool::enqueue(0u, []() { return thread_pool::use_threads(integer(100u), integer(0u)); });
-    CHECK(f7.get() == 1u);
-    CHECK(f8.get() == 1u);
+    const auto r7 = f7.get(), r8 = f8.get();
+    CHECK(r7 >= 1u);
+    CHECK(r7 <= 4u);
+    CHECK(r8 >= 1u);
+    CHECK(r8 <= 4u);
     CHECK_THROWS_AS(f9.get(), std::invalid_argument);
+    thread_pool::set_nested_parallelism(false);
+    CHECK(thread_pool::enqueue(0u, []() { return thread_pool::use_threads(integer(100u), integer(3u)); }).get()
+          == 1u);
+    thread_pool::set_nested_parallelism(true);
+}
+
+TEST_CASE("thread_pool_binding_test")
+{
+    std::cout << "thread_pool_binding_test" << std::endl << std::flush;
+    thread_pool::resize(4u);
+    CHECK(!thread_pool::get_binding());
+    const auto def_list = thread_pool::get_cpu_list();
+    CHECK(!def_list.empty());
+    // All the detected processors appear exactly once in the default list.
+    auto sorted_list(def_list);
+    std::sort(sorted_list.begin(), sorted_list.end());
+    CHECK(std::adjacent_find(sorted_list.begin(), sorted_list.end()) == sorted_list.end());
+    CHECK_THROWS_MATCHES(
+        thread_pool::set_cpu_list({}), std::invalid_argument,
+        test::ExceptionMatcher<std::invalid_argument>(
+            std::string("the list of processors used for thread binding cannot be empty")));
+    CHECK(thread_pool::get_cpu_list() == def_list);
+    // Check if binding works at all on this machine: if it does, the threads in the pool must
+    // be bound to the processors in the list.
+    bool can_bind = true;
+    try {
+        std::thread([&can_bind]() {
+            try {
+                thread_management::bind_to_proc(0u);
+            } catch (...) {
+                can_bind = false;
+            }
+        }).join();
+    } catch (...) {
+        can_bind = false;
+    }
+    // NOTE: if the process can run on a single processor only, failed bindings cannot be told apart
+    // from successful ones.
+    const bool single_proc = thread_management::bound_proc().first;
+    auto check_bound = [can_bind, single_proc](bool bound) {
+        const auto list = thread_pool::get_cpu_list();
+        for (unsigned i = 0u; i < thread_pool::size(); ++i) {
+            const auto p = thread_pool::enqueue(i, []() { return thread_management::bound_proc(); }).get();
+            if (!bound) {
+                continue;
+            }
+            if (can_bind && list[i % list.size()] == 0u) {
+                CHECK(p.first);
+                CHECK(p.second == 0u);
+            }
+            if (p.first && !single_proc) {
+                CHECK(p.second == list[i % list.size()]);
+            }
+        }
+    };
+    thread_pool::set_binding(true);
+    CHECK(thread_pool::get_binding());
+    CHECK(thread_pool::size() == 4u);
+    check_bound(true);
+    // Binding survives resizing.
+    thread_pool::resize(3u);
+    CHECK(thread_pool::get_binding());
+    check_bound(true);
+    // Changing the list recreates the bound threads.
+    thread_pool::set_cpu_list({0u});
+    CHECK(thread_pool::get_cpu_list() == std::vector<unsigned>{0u});
+    CHECK(thread_pool::size() == 3u);
+    check_bound(true);
+    // Processors which do not exist are silently ignored.
+    thread_pool::set_cpu_list({0u, std::numeric_limits<unsigned>::max()});
+    CHECK(thread_pool::enqueue(1u, adder, 1, 2).get() == 3);
+    thread_pool::reset_cpu_list();
+    CHECK(thread_pool::get_cpu_list() == def_list);
+    thread_pool::set_binding(true);
+    CHECK(thread_pool::get_binding());
+    thread_pool::set_binding(false);
+    CHECK(!thread_pool::get_binding());
+    CHECK(thread_pool::size() == 3u);
+    check_bound(false);
+    CHECK(thread_pool::enqueue(2u, adder, 4, -5).get() == -1);
+    thread_pool::resize(4u);
+}
+
+TEST_CASE("thread_pool_work_stealing_deque_test")
+{
+    std::cout << "thread_pool_work_stealing_deque_test" << std::endl << std::flush;
+    {
+        detail::work_stealing_deque<int *> d;
+        CHECK(d.empty());
+        CHECK(d.pop() == nullptr);
+        CHECK(d.steal() == nullptr);
+        std::vector<int> vals(100);
+        // Push enough elements to trigger the growth of the buffer.
+        for (auto &n : vals) {
+            d.push(&n);
+        }
+        CHECK(!d.empty());
+        // LIFO for the owner, FIFO for the thieves.
+        CHECK(d.pop() == &vals[99]);
+        CHECK(d.steal() == &vals[0]);
+        CHECK(d.pop() == &vals[98]);
+        CHECK(d.steal() == &vals[1]);
+        for (int i = 97; i >= 2; --i) {
+            CHECK(d.pop() == &vals[static_cast<std::size_t>(i)]);
+        }
+        CHECK(d.empty());
+        CHECK(d.pop() == nullptr);
+        CHECK(d.steal() == nullptr);
+    }
+    // Concurrent stealing: every element must be consumed exactly once.
+    detail::work_stealing_deque<int *> d;
+    const int n_elements = 100000;
+    std::vector<int> vals(static_cast<std::size_t>(n_elements));
+    std::vector<std::atomic<int>> counts(static_cast<std::size_t>(n_elements));
+    for (auto &c : counts) {
+        c.store(0);
+    }
+    std::atomic<bool> done(false);
+    auto consume = [&vals, &counts](int *p) { ++counts[static_cast<std::size_t>(p - vals.data())]; };
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i) {
+        thieves.emplace_back([&d, &done, &consume]() {
+            while (!done.load()) {
+                if (auto p = d.steal()) {
+                    consume(p);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < n_elements; ++i) {
+        d.push(&vals[static_cast<std::size_t>(i)]);
+        if (i % 3 == 0) {
+            if (auto p = d.pop()) {
+                consume(p);
+            }
+        }
+    }
+    while (auto p = d.pop()) {
+        consume(p);
+    }
+    done.store(true);
+    for (auto &t : thieves) {
+        t.join();
+    }
+    CHECK(std::all_of(counts.begin(), counts.end(), [](const std::atomic<int> &c) { return c.load() == 1; }));
+}
+
+TEST_CASE("thread_pool_enqueue_any_test")
+{
+    std::cout << "thread_pool_enqueue_any_test" << std::endl << std::flush;
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        thread_pool::resize(nt);
+        CHECK(thread_pool::enqueue_any(adder, 1, 2).get() == 3);
+        CHECK_THROWS_AS(thread_pool::enqueue_any([]() { throw std::runtime_error(""); }).get(), std::runtime_error);
+        future_list<int> f_list;
+        for (int i = 0; i < 10000; ++i) {
+            f_list.push_back(thread_pool::enqueue_any([](int n) { return n; }, i));
+        }
+        f_list.wait_all();
+        f_list.get_all();
+        // Reference wrappers work as in enqueue().
+        thread_pool::enqueue_any(ref_test_functor{}, std::ref(nn)).get();
+        thread_pool::enqueue_any(cref_test_functor{}, std::cref(nn)).get();
+        // Keep a thread busy with a pinned task: the other threads must consume all the tasks
+        // enqueued with enqueue_any(), stealing them if necessary.
+        std::atomic<bool> release(false);
+        auto blocker = thread_pool::enqueue(0u, [&release]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        std::atomic<unsigned> counter(0u);
+        future_list<void> f_list2;
+        for (int i = 0; i < 100; ++i) {
+            f_list2.push_back(thread_pool::enqueue_any([&counter]() { ++counter; }));
+        }
+        if (nt > 1u) {
+            f_list2.wait_all();
+            CHECK(counter.load() == 100u);
+        }
+        release.store(true);
+        blocker.get();
+        f_list2.wait_all();
+        CHECK(counter.load() == 100u);
+        // Tasks enqueued from within the pool.
+        auto nested = thread_pool::enqueue_any([]() {
+            std::vector<std::future<int>> v;
+            for (int i = 0; i < 100; ++i) {
+                v.push_back(thread_pool::enqueue_any([i]() { return i; }));
+            }
+            return v.size();
+        });
+        CHECK(nested.get() == 100u);
+        // Resizing with pending tasks.
+        for (int i = 0; i < 1000; ++i) {
+            thread_pool::enqueue_any(adder, 1, 2);
+        }
+    }
+    thread_pool::resize(4u);
+}
+
+TEST_CASE("thread_pool_nested_test")
+{
+    std::cout << "thread_pool_nested_test" << std::endl << std::flush;
+    CHECK(thread_pool::get_nested_parallelism());
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        thread_pool::resize(nt);
+        for (auto nested : {true, false}) {
+            thread_pool::set_nested_parallelism(nested);
+            CHECK(thread_pool::get_nested_parallelism() == nested);
+            // Every thread of the pool enqueues tasks on every thread of the pool (itself included) and waits
+            // for them: this must not deadlock, whatever the nested parallelism policy.
+            future_list<int> outer;
+            for (unsigned i = 0u; i < nt; ++i) {
+                outer.push_back(thread_pool::enqueue(i, [nt]() {
+                    future_list<int> inner;
+                    for (unsigned j = 0u; j < 4u * nt; ++j) {
+                        inner.push_back(thread_pool::enqueue(j % nt, [j]() { return static_cast<int>(j); }));
+                        inner.push_back(thread_pool::enqueue_any([j]() { return static_cast<int>(j); }));
+                    }
+                    inner.wait_all();
+                    inner.get_all();
+                    return 1;
+                }));
+            }
+            outer.wait_all();
+            outer.get_all();
+            // Two levels of nesting, with exceptions.
+            future_list<void> outer2;
+            for (unsigned i = 0u; i < nt; ++i) {
+                outer2.push_back(thread_pool::enqueue(i, [nt]() {
+                    future_list<void> inner;
+                    for (unsigned j = 0u; j < nt; ++j) {
+                        inner.push_back(thread_pool::enqueue(j, [nt]() {
+                            future_list<void> inner2;
+                            inner2.push_back(thread_pool::enqueue(0u, []() { throw std::runtime_error(""); }));
+                            inner2.push_back(thread_pool::enqueue(nt - 1u, []() {}));
+                            inner2.wait_all();
+                            inner2.get_all();
+                        }));
+                    }
+                    inner.wait_all();
+                    inner.get_all();
+                }));
+            }
+            outer2.wait_all();
+            CHECK_THROWS_AS(outer2.get_all(), std::runtime_error);
+        }
+    }
+    thread_pool::set_nested_parallelism(true);
+    thread_pool::resize(4u);
+}
+
+TEST_CASE("thread_pool_small_task_test")
+{
+    std::cout << "thread_pool_small_task_test" << std::endl << std::flush;
+    using detail::small_task;
+    // Small callables and packaged tasks are stored inline.
+    CHECK(small_task::is_small<std::packaged_task<int()>>());
+    CHECK(small_task::is_small<decltype([](int *p) { ++*p; })>());
+    CHECK(!small_task::is_small<std::array<char, small_task::buffer_size + 1u>>());
+    CHECK(!std::is_copy_constructible<small_task>::value);
+    CHECK(std::is_nothrow_move_constructible<small_task>::value);
+    CHECK(std::is_nothrow_move_assignable<small_task>::value);
+    small_task t0;
+    CHECK(!t0);
+    int n = 0;
+    small_task t1([&n]() { ++n; });
+    CHECK(t1);
+    t1();
+    t1();
+    CHECK(n == 2);
+    // Move semantics, with inline and heap storage.
+    small_task t2(std::move(t1));
+    CHECK(!t1);
+    t2();
+    CHECK(n == 3);
+    std::array<int, 100> big{};
+    big[99] = 10;
+    small_task t3([big, &n]() { n += big[99]; });
+    t3();
+    CHECK(n == 13);
+    t1 = std::move(t3);
+    CHECK(!t3);
+    t1();
+    CHECK(n == 23);
+    t1 = std::move(t2);
+    t1();
+    CHECK(n == 24);
+    t1.reset();
+    CHECK(!t1);
+    // Move-only callables, and destruction of the captured state.
+    auto ptr = std::make_shared<int>(1);
+    {
+        small_task t4([p = std::unique_ptr<int>(new int(5)), ptr, &n]() { n += *p; });
+        CHECK(ptr.use_count() == 2);
+        t4();
+        CHECK(n == 29);
+        small_task t5(std::move(t4));
+        CHECK(ptr.use_count() == 2);
+    }
+    CHECK(ptr.use_count() == 1);
+    // Exceptions propagate.
+    small_task t6([]() { throw std::runtime_error(""); });
+    CHECK_THROWS_AS(t6(), std::runtime_error);
+    // Packaged tasks.
+    std::packaged_task<int()> pt([]() { return 42; });
+    auto fut = pt.get_future();
+    small_task t7(std::move(pt));
+    t7();
+    CHECK(fut.get() == 42);
+}
+
+TEST_CASE("thread_pool_task_group_test")
+{
+    std::cout << "thread_pool_task_group_test" << std::endl << std::flush;
+    CHECK(!std::is_copy_constructible<task_group>::value);
+    CHECK(!std::is_move_constructible<task_group>::value);
+    for (unsigned nt = 1u; nt <= 4u; ++nt) {
+        thread_pool::resize(nt);
+        task_group tg;
+        // Empty group.
+        tg.wait_all();
+        tg.get_all();
+        std::atomic<int> counter(0);
+        for (int i = 0; i < 10000; ++i) {
+            tg.run(static_cast<unsigned>(i) % nt, [&counter](int m) { counter += m; }, 1);
+            tg.run_any([&counter]() { ++counter; });
+        }
+        tg.wait_all();
+        tg.get_all();
+        CHECK(counter.load() == 20000);
+        // Return values are discarded, reference wrappers work as in enqueue().
+        tg.run(0u, adder, 1, 2);
+        tg.run(0u, ref_test_functor{}, std::ref(nn));
+        tg.run_any(cref_test_functor{}, std::cref(nn));
+        tg.get_all();
+        // Invalid thread index.
+        CHECK_THROWS_AS(tg.run(nt, []() {}), std::invalid_argument);
+        tg.get_all();
+        // Exceptions: the first one is re-thrown, and then removed from the group.
+        tg.run(0u, []() { throw std::runtime_error(""); });
+        tg.run_any([]() { throw std::runtime_error(""); });
+        tg.run_any([&counter]() { ++counter; });
+        tg.wait_all();
+        CHECK(counter.load() == 20001);
+        CHECK_THROWS_AS(tg.get_all(), std::runtime_error);
+        tg.get_all();
+        // Keep a thread busy with a pinned task, so that the tasks pinned to it pile up.
+        std::atomic<bool> release(false);
+        tg.run(0u, [&release]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        for (int i = 0; i < 1000; ++i) {
+            tg.run(0u, [&counter]() { ++counter; });
+        }
+        release.store(true);
+        tg.get_all();
+        CHECK(counter.load() == 21001);
+        // Nested groups, with large callables.
+        std::array<int, 100> big{};
+        big[0] = 1;
+        for (unsigned i = 0u; i < nt; ++i) {
+            tg.run(i, [&counter, nt, big]() {
+                task_group inner;
+                for (unsigned j = 0u; j < 10u * nt; ++j) {
+                    inner.run(j % nt, [&counter, big]() { counter += big[0]; });
+                    inner.run_any([&counter]() { ++counter; });
+                }
+                inner.get_all();
+            });
+        }
+        tg.get_all();
+        CHECK(counter.load() == 21001 + 20 * static_cast<int>(nt * nt));
+        // The destructor waits for the pending tasks.
+        std::atomic<int> c2(0);
+        {
+            task_group tg2;
+            for (int i = 0; i < 100; ++i) {
+                tg2.run_any([&c2]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    ++c2;
+                });
+            }
+        }
+        CHECK(c2.load() == 100);
+    }
+    thread_pool::resize(4u);
 }
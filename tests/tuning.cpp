@@ -88,3 +88,94 @@ TEST_CASE("tuning_estimation_threshold_test")
     tuning::reset_estimate_threshold();
     CHECK(tuning::get_estimate_threshold() == 200u);
 }
+
+TEST_CASE("tuning_dense_multiplication_threshold_test")
+{
+    CHECK(tuning::get_dense_multiplication_threshold() == 25u);
+    tuning::set_dense_multiplication_threshold(50u);
+    CHECK(tuning::get_dense_multiplication_threshold() == 50u);
+    std::thread t1([]() noexcept {
+        while (tuning::get_dense_multiplication_threshold() != 75u) {
+        }
+    });
+    std::thread t2([]() { tuning::set_dense_multiplication_threshold(75u); });
+    t1.join();
+    t2.join();
+    CHECK_THROWS_AS(tuning::set_dense_multiplication_threshold(0u), std::invalid_argument);
+    CHECK_THROWS_AS(tuning::set_dense_multiplication_threshold(101u), std::invalid_argument);
+    CHECK(tuning::get_dense_multiplication_threshold() == 75u);
+    tuning::reset_dense_multiplication_threshold();
+    CHECK(tuning::get_dense_multiplication_threshold() == 25u);
+}
+
+TEST_CASE("tuning_pow_squaring_test")
+{
+    CHECK(!tuning::get_pow_squaring());
+    tuning::set_pow_squaring(true);
+    CHECK(tuning::get_pow_squaring());
+    std::thread t1([]() noexcept {
+        while (tuning::get_pow_squaring()) {
+        }
+    });
+    std::thread t2([]() noexcept { tuning::set_pow_squaring(false); });
+    t1.join();
+    t2.join();
+    CHECK(!tuning::get_pow_squaring());
+    tuning::set_pow_squaring(true);
+    tuning::reset_pow_squaring();
+    CHECK(!tuning::get_pow_squaring());
+}
+
+TEST_CASE("tuning_private_accumulation_test")
+{
+    CHECK(!tuning::get_private_accumulation());
+    tuning::set_private_accumulation(true);
+    CHECK(tuning::get_private_accumulation());
+    std::thread t1([]() noexcept {
+        while (tuning::get_private_accumulation()) {
+        }
+    });
+    std::thread t2([]() noexcept { tuning::set_private_accumulation(false); });
+    t1.join();
+    t2.join();
+    CHECK(!tuning::get_private_accumulation());
+    tuning::set_private_accumulation(true);
+    tuning::reset_private_accumulation();
+    CHECK(!tuning::get_private_accumulation());
+}
+
+TEST_CASE("tuning_compaction_threshold_test")
+{
+    CHECK(tuning::get_compaction_threshold() == 10u);
+    tuning::set_compaction_threshold(0u);
+    CHECK(tuning::get_compaction_threshold() == 0u);
+    std::thread t1([]() noexcept {
+        while (tuning::get_compaction_threshold() != 50u) {
+        }
+    });
+    std::thread t2([]() { tuning::set_compaction_threshold(50u); });
+    t1.join();
+    t2.join();
+    CHECK_THROWS_AS(tuning::set_compaction_threshold(101u), std::invalid_argument);
+    CHECK(tuning::get_compaction_threshold() == 50u);
+    tuning::reset_compaction_threshold();
+    CHECK(tuning::get_compaction_threshold() == 10u);
+}
+
+TEST_CASE("tuning_incremental_rehash_test")
+{
+    CHECK(!tuning::get_incremental_rehash());
+    tuning::set_incremental_rehash(true);
+    CHECK(tuning::get_incremental_rehash());
+    std::thread t1([]() noexcept {
+        while (tuning::get_incremental_rehash()) {
+        }
+    });
+    std::thread t2([]() noexcept { tuning::set_incremental_rehash(false); });
+    t1.join();
+    t2.join();
+    CHECK(!tuning::get_incremental_rehash());
+    tuning::set_incremental_rehash(true);
+    tuning::reset_incremental_rehash();
+    CHECK(!tuning::get_incremental_rehash());
+}